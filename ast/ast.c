@@ -1,10 +1,9 @@
 // ast.c (adicione ao seu projeto)
 #include "ast.h"
-#include <stdlib.h>
 #include <string.h>
 
-AstNode *ast_new_number(Token tok, long long val) {
-  AstNode *node = malloc(sizeof(AstNode)); // aloca nó base
+AstNode *ast_new_number(const ModalAllocator *a, Token tok, long long val) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode)); // aloca nó base
   if (!node)
     return NULL;
   *node = (AstNode){
@@ -12,8 +11,18 @@ AstNode *ast_new_number(Token tok, long long val) {
   return node;
 }
 
-AstNode *ast_new_ident(Token tok) {
-  AstNode *node = malloc(sizeof(AstNode));
+AstNode *ast_new_float(const ModalAllocator *a, Token tok, double val) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+  *node = (AstNode){.kind = AST_NUMBER_LIT,
+                    .token = tok,
+                    .data = {.number = {.f64 = val, .is_float = 1}}};
+  return node;
+}
+
+AstNode *ast_new_ident(const ModalAllocator *a, Token tok) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
   if (!node)
     return NULL;
   *node = (AstNode){.kind = AST_IDENT,
@@ -22,8 +31,9 @@ AstNode *ast_new_ident(Token tok) {
   return node;
 }
 
-AstNode *ast_new_binop(Token op_tok, AstNode *left, AstNode *right) {
-  AstNode *node = malloc(sizeof(AstNode));
+AstNode *ast_new_binop(const ModalAllocator *a, Token op_tok, AstNode *left,
+                       AstNode *right) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
   if (!node)
     return NULL;
   *node = (AstNode){.kind = AST_BIN_OP,
@@ -32,69 +42,120 @@ AstNode *ast_new_binop(Token op_tok, AstNode *left, AstNode *right) {
   return node;
 }
 
-AstNode *ast_new_block(Token open_tok, AstNode **stmts, size_t count) {
-  AstNode *node = malloc(sizeof(AstNode));
+AstNode *ast_new_unary(const ModalAllocator *a, Token op_tok, AstNode *expr) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+  *node = (AstNode){.kind = AST_UNARY_OP,
+                    .token = op_tok,
+                    .data = {.unary = {expr, op_tok.kind}}};
+  return node;
+}
+
+AstNode *ast_new_block(const ModalAllocator *a, Token open_tok,
+                       AstNode **stmts, size_t count) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
   if (!node)
     return NULL;
 
-  AstNode **children = malloc(count * sizeof(AstNode *));
-  if (!children) {
-    free(node);
+  AstNode **children = modal_alloc(a, count * sizeof(AstNode *));
+  if (!children && count) { // bloco vazio pode voltar NULL de alloc(0)
+    modal_free(a, node, sizeof(AstNode));
     return NULL;
   }
-  memcpy(children, stmts, count * sizeof(AstNode *));
+  if (count)
+    memcpy(children, stmts, count * sizeof(AstNode *));
 
   *node = (AstNode){.kind = AST_BLOCK,
                     .token = open_tok,
-                    .data = {.block_or_group = {children, count}}};
+                    .data = {.block_or_group = {children, count, 0}}};
   return node;
 }
 
-void ast_free(AstNode *node) {
-  if (!node)
+void ast_free(const ModalAllocator *a, AstNode *node) {
+  if (!node || node->hc)
     return;             // null safe — por quê? Evita crash em erros parciais
   switch (node->kind) { // por tipo — por quê? Libera filhos só onde tem
   case AST_BIN_OP:
-    ast_free(node->data.binop.left);
-    ast_free(node->data.binop.right);
+  case AST_RANGE:
+    ast_free(a, node->data.binop.left);
+    ast_free(a, node->data.binop.right);
     break;
   case AST_UNARY_OP:
-    ast_free(node->data.unary.expr);
+    ast_free(a, node->data.unary.expr);
     break;
   case AST_BLOCK:
   case AST_PAREN_GROUP:
     for (size_t i = 0; i < node->data.block_or_group.count; i++) {
       ast_free(
-          node->data.block_or_group
+          a, node->data.block_or_group
               .stmts[i]); // recursão em filhos — por quê? Libera árvore toda
     }
-    free(node->data.block_or_group
-             .stmts); // array depois — por quê? Ordem certa evita dangling
+    modal_free(a, node->data.block_or_group.stmts,
+               node->data.block_or_group.count *
+                   sizeof(AstNode *)); // array depois — por quê? Ordem certa
+                                       // evita dangling
     break;
   case AST_TEST_STMT:
-    ast_free(node->data.test.block);
+    ast_free(a, node->data.test.block); // nome é do fonte ou do StrPool
+    break;
   case AST_ASSERT_STMT:
-    // TODO: liberar nome/body/expr se tiverem — por quê? Ainda não definidos no
-    // ast.h
+    ast_free(a, node->data.unary.expr);
+    ast_free(a, node->data.unary.message);
+    break;
+  case AST_ASYNC_BLOCK:
+  case AST_DEFER_STMT:
+    ast_free(a, node->data.unary.expr);
+    break;
+  case AST_FORMAT: // textos são do fonte ou do StrPool
+    for (size_t i = 0; i < node->data.format.count; i++)
+      ast_free(a, node->data.format.parts[i].expr);
+    modal_free(a, node->data.format.parts,
+               node->data.format.count * sizeof(FmtPart));
+    break;
+  case AST_VAR_DECL:
+    ast_free(a, node->data.var.init);
+    break;
+  case AST_PIPELINE:
+    ast_free(a, node->data.pipeline.source);
+    for (size_t i = 0; i < node->data.pipeline.count; i++)
+      ast_free(a, node->data.pipeline.stages[i].expr);
+    modal_free(a, node->data.pipeline.stages,
+               node->data.pipeline.count * sizeof(PipeStage));
+    break;
+  case AST_CALL:
+    for (size_t i = 0; i < node->data.call.count; i++)
+      ast_free(a, node->data.call.args[i]);
+    modal_free(a, node->data.call.args,
+               node->data.call.count * sizeof(AstNode *));
+    break;
+  case AST_USE:
+    modal_free(a, node->data.use.text, node->data.use.text_len + 1);
+    break;
+  case AST_STRUCT_DECL:
+    for (size_t i = 0; i < node->data.record.count; i++)
+      ast_free(a, node->data.record.fields[i]);
+    modal_free(a, node->data.record.fields,
+               node->data.record.count * sizeof(AstNode *));
     break;
   default:
     break; // lits/idents não tem filhos
   }
-  free(node); // nó base por último — por quê? Clean up completo
+  modal_free(a, node,
+             sizeof(AstNode)); // nó base por último — por quê? Clean up
+                               // completo
 }
 
-AstNode *ast_new_test(Token token, AstNode *block) {
-  AstNode *node = malloc(sizeof(AstNode));
+AstNode *ast_new_test(const ModalAllocator *a, Token token, const char *name,
+                      size_t len, AstNode *block) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
   if (!node)
     return NULL;
 
-  const char *name_without_quotes = token.start + 1;
-  size_t len = token.len - 2;
-
   *node = (AstNode){.kind = AST_TEST_STMT,
                     .token = token,
                     .data = {.test = {
-                                 .name = name_without_quotes,
+                                 .name = name,
                                  .len = len,
                                  .block = block,
                              }}};
@@ -102,12 +163,230 @@ AstNode *ast_new_test(Token token, AstNode *block) {
 }
 
 // assert e test simples (expande depois)
-AstNode *ast_new_assert(AstNode *expr) {
-  AstNode *node = malloc(sizeof(AstNode));
+AstNode *ast_new_assert(const ModalAllocator *a, AstNode *expr,
+                        AstNode *message) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
   if (!node)
     return NULL;
   *node = (AstNode){.kind = AST_ASSERT_STMT,
                     .token = expr->token, // usa token da expr pra loc
-                    .data = {.unary = {expr}}};
+                    .data = {.unary = {.expr = expr, .message = message}}};
+  return node;
+}
+
+AstNode *ast_new_async(const ModalAllocator *a, Token tok, AstNode *block) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+  *node = (AstNode){
+      .kind = AST_ASYNC_BLOCK, .token = tok, .data = {.unary = {block}}};
   return node;
 }
+
+AstNode *ast_new_await(const ModalAllocator *a, Token tok) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+  *node = (AstNode){.kind = AST_AWAIT_STMT, .token = tok};
+  return node;
+}
+
+AstNode *ast_new_var(const ModalAllocator *a, Token name, AstNode *init,
+                     int autofree) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+  *node = (AstNode){.kind = AST_VAR_DECL,
+                    .token = name,
+                    .data = {.var = {.name = name.start,
+                                     .len = name.len,
+                                     .init = init,
+                                     .autofree = autofree,
+                                     .slot = -1}}};
+  return node;
+}
+
+AstNode *ast_new_defer(const ModalAllocator *a, Token tok, AstNode *stmt) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+  *node =
+      (AstNode){.kind = AST_DEFER_STMT, .token = tok, .data = {.unary = {stmt}}};
+  return node;
+}
+
+AstNode *ast_new_record(const ModalAllocator *a, Token name, AstNode **fields,
+                        size_t count, int is_union, int reorder) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+
+  AstNode **copy = modal_alloc(a, count * sizeof(AstNode *));
+  if (!copy && count) {
+    modal_free(a, node, sizeof(AstNode));
+    return NULL;
+  }
+  if (count)
+    memcpy(copy, fields, count * sizeof(AstNode *));
+
+  *node = (AstNode){.kind = AST_STRUCT_DECL,
+                    .token = name,
+                    .data = {.record = {.name = name.start,
+                                        .len = name.len,
+                                        .fields = copy,
+                                        .count = count,
+                                        .is_union = is_union,
+                                        .reorder = reorder}}};
+  return node;
+}
+
+AstNode *ast_new_field(const ModalAllocator *a, Token name, Token type,
+                       long long count, int hot) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+  *node = (AstNode){.kind = AST_FIELD,
+                    .token = name,
+                    .data = {.field = {.name = name.start,
+                                       .len = name.len,
+                                       .type = type.start,
+                                       .type_len = type.len,
+                                       .count = count,
+                                       .hot = hot}}};
+  return node;
+}
+
+AstNode *ast_new_sizeof(const ModalAllocator *a, Token type) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+  *node = (AstNode){.kind = AST_SIZEOF,
+                    .token = type,
+                    .data = {.ident = {.name = type.start, .len = type.len}}};
+  return node;
+}
+
+AstNode *ast_new_call(const ModalAllocator *a, Token name, AstNode **args,
+                      size_t count) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+
+  AstNode **copy = modal_alloc(a, count * sizeof(AstNode *));
+  if (!copy && count) {
+    modal_free(a, node, sizeof(AstNode));
+    return NULL;
+  }
+  if (count)
+    memcpy(copy, args, count * sizeof(AstNode *));
+
+  *node = (AstNode){.kind = AST_CALL,
+                    .token = name,
+                    .data = {.call = {.name = name.start,
+                                      .len = name.len,
+                                      .args = copy,
+                                      .count = count}}};
+  return node;
+}
+
+AstNode *ast_new_range(const ModalAllocator *a, Token op_tok, AstNode *lo,
+                       AstNode *hi) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+  *node = (AstNode){.kind = AST_RANGE,
+                    .token = op_tok,
+                    .data = {.binop = {lo, hi, op_tok.kind}}};
+  return node;
+}
+
+AstNode *ast_new_format(const ModalAllocator *a, Token tok, FmtPart *parts,
+                        size_t count) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+
+  FmtPart *copy = modal_alloc(a, count * sizeof(FmtPart));
+  if (!copy && count) {
+    modal_free(a, node, sizeof(AstNode));
+    return NULL;
+  }
+  size_t fixed_len = 0;
+  for (size_t i = 0; i < count; i++) {
+    copy[i] = parts[i];
+    fixed_len += parts[i].len;
+  }
+
+  *node = (AstNode){.kind = AST_FORMAT,
+                    .token = tok,
+                    .data = {.format = {.parts = copy,
+                                        .count = count,
+                                        .fixed_len = fixed_len}}};
+  return node;
+}
+
+AstNode *ast_new_pipeline(const ModalAllocator *a, Token tok, AstNode *source,
+                          PipeStage *stages, size_t count,
+                          PipeTerminal terminal) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+
+  PipeStage *copy = modal_alloc(a, count * sizeof(PipeStage));
+  if (!copy && count) {
+    modal_free(a, node, sizeof(AstNode));
+    return NULL;
+  }
+  if (count)
+    memcpy(copy, stages, count * sizeof(PipeStage));
+
+  *node = (AstNode){.kind = AST_PIPELINE,
+                    .token = tok,
+                    .data = {.pipeline = {.source = source,
+                                          .stages = copy,
+                                          .count = count,
+                                          .terminal = terminal}}};
+  return node;
+}
+
+AstNode *ast_new_use(const ModalAllocator *a, Token path, char *text,
+                     size_t text_len) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+  *node = (AstNode){.kind = AST_USE,
+                    .token = path,
+                    .data = {.use = {.path = path.start + 1,
+                                     .len = (size_t)path.len - 2,
+                                     .text = text,
+                                     .text_len = text_len}}};
+  return node;
+}
+
+// Assinatura vem depois, de quem leu o protótipo
+AstNode *ast_new_extern_fn(const ModalAllocator *a, Token name) {
+  AstNode *node = modal_alloc(a, sizeof(AstNode));
+  if (!node)
+    return NULL;
+  *node = (AstNode){.kind = AST_EXTERN_FN,
+                    .token = name,
+                    .data = {.native = {.name = name.start,
+                                        .len = (size_t)name.len,
+                                        .ret = FFI_VOID}}};
+  return node;
+}
+
+int ast_list_push(const ModalAllocator *a, AstNode ***items, size_t *count,
+                  size_t *cap, AstNode *node) {
+  if (*count == *cap) {
+    size_t grown_cap = *cap ? *cap * 2 : 8;
+    AstNode **grown = modal_realloc(a, *items, *cap * sizeof(AstNode *),
+                                    grown_cap * sizeof(AstNode *));
+    if (!grown)
+      return 0;
+    *items = grown;
+    *cap = grown_cap;
+  }
+  (*items)[(*count)++] = node;
+  return 1;
+}
@@ -2,7 +2,9 @@
 #ifndef AST_H
 #define AST_H
 
+#include "../lib/runtime/ffi.h"     // FfiType
 #include "../tokenizer/tokenizer.h" // Token
+#include <stdint.h>
 
 typedef enum {
   AST_NUMBER_LIT,
@@ -13,18 +15,72 @@ typedef enum {
   AST_BLOCK,
   AST_TEST_STMT,
   AST_ASSERT_STMT,
-  // futuro: AST_FN_DEF, AST_VAR_DECL, AST_STRUCT etc.
+  AST_ASYNC_BLOCK, // async { ... } — data.unary.expr é o bloco
+  AST_AWAIT_STMT,  // await — espera todos os async filhos
+  AST_VAR_DECL,    // x = expr / autofree x = expr
+  AST_DEFER_STMT,  // defer stmt — data.unary.expr roda no fim do escopo
+  AST_STRUCT_DECL, // struct/union Nome [reorder] { campos }
+  AST_FIELD,       // [hot] nome: Tipo[N]
+  AST_SIZEOF,      // sizeof(Tipo) — layout.c dobra pra AST_NUMBER_LIT
+  AST_CALL,        // nome(args) — builtin (vetores etc.) ou função C
+  AST_USE,         // use "foo.h" — dono do texto do header
+  AST_EXTERN_FN,   // protótipo de função C vindo de um use
+  AST_VEC_LIT,     // vetor constante, saída do constant folding
+  AST_RANGE,       // a..b (meio aberto) — data.binop
+  AST_PIPELINE,    // fonte | estágio ... | terminal
+  AST_FORMAT,      // f"x = {x}": plano de formatação, mensagem de assert
+  // futuro: AST_FN_DEF etc.
 } AstNodeKind;
 
 typedef struct AstNode AstNode;
 
+// Estágios de pipeline: map/filter levam expressão sobre `it`; o terminal
+// reduz tudo a um valor — sem terminal não tem pipeline
+typedef enum { PIPE_MAP, PIPE_FILTER } PipeStageKind;
+typedef enum {
+  PIPE_SUM,
+  PIPE_COUNT,
+  PIPE_MIN,
+  PIPE_MAX,
+  PIPE_ANY,
+  PIPE_ALL
+} PipeTerminal;
+
+typedef struct {
+  PipeStageKind kind;
+  AstNode *expr;
+} PipeStage;
+
+// Como um buraco de f-string vira texto: {x} pelo tipo do valor, {x:d}
+// inteiro, {x:x} hexa, {x:.3} f64 com 3 casas
+typedef enum { FMT_AUTO, FMT_INT, FMT_HEX, FMT_F64 } FmtKind;
+#define FMT_MAX_PREC 30
+
+// Trecho literal (já sem escapes) seguido de um buraco — expr NULL: só texto
+typedef struct {
+  const char *text; // fatia do fonte ou do StrPool
+  size_t len;
+  AstNode *expr;
+  FmtKind kind;
+  int prec; // FMT_F64
+} FmtPart;
+
+// Slots de pilha por bloco pros autofree que não escapam; o resto cai na
+// região do escopo
+#define AST_STACK_SLOTS 8
+
 struct AstNode {
   AstNodeKind kind;
+  uint32_t cov; // slot do --coverage (lib/compiler/coverage.c); 0: nenhum
+  uint32_t hc;  // id no hash-consing (ast/intern.c); 0: nó só desta árvore
+  uint32_t ty;  // slot no array de tipos (ast/types.h); 0: sem tipo
   Token token; // token principal (pra localização + valor)
 
   union {
     struct {           // AST_NUMBER_LIT
-      long long value; // ou double se quiser float
+      long long value; // !is_float
+      double f64;      // is_float: 2.5, 1e-3 (ast/literal.c)
+      int is_float;
     } number;
 
     struct {            // AST_IDENT
@@ -40,35 +96,163 @@ struct AstNode {
 
     struct { // AST_UNARY_OP
       AstNode *expr;
-      Kind op; // -, ! etc.
+      Kind op;          // -, ! etc.
+      AstNode *message; // AST_ASSERT_STMT: o `, f"..."`; NULL sem
     } unary;
 
     struct {           // AST_PAREN_GROUP / AST_BLOCK
       AstNode **stmts; // array dinâmico (ou lista)
       size_t count;
+      unsigned stack_slots; // autofree promovidos pra pilha (escape.c)
     } block_or_group;
 
+    struct {            // AST_VAR_DECL
+      const char *name; // aponta pro token, como ident
+      size_t len;
+      AstNode *init;
+      int autofree; // storage da região do escopo em vez do heap
+      int slot;     // >= 0: não escapa, vive na pilha do executor
+    } var;
+
+    struct {            // AST_STRUCT_DECL (struct ou union)
+      const char *name;
+      size_t len;
+      AstNode **fields; // AST_FIELD na ordem declarada
+      size_t count;
+      int is_union;
+      int reorder; // compilador escolhe a ordem (layout.c)
+      int state;   // layout.c: 0 pendente, 1 resolvendo, 2 pronto
+      long long size, align;
+      long long declared_size; // tamanho na ordem do fonte, pro relatório
+      int imported; // veio de um use: não entra na interface do módulo
+    } record;
+
+    struct {            // AST_CALL
+      const char *name; // aponta pro token
+      size_t len;
+      AstNode **args;
+      size_t count;
+      AstNode *native; // AST_EXTERN_FN ligado por cimport.c; não é dono
+    } call;
+
+    struct {            // AST_USE
+      const char *path; // sem aspas, aponta pro token
+      size_t len;
+      char *text; // header inteiro; nomes dos nós importados apontam pra cá
+      size_t text_len;
+    } use;
+
+    struct {            // AST_EXTERN_FN
+      const char *name; // aponta pro texto do AST_USE
+      size_t len;
+      FfiType ret;
+      FfiType params[FFI_MAX_ARGS];
+      size_t count;
+      const char *unsupported; // por que não dá pra chamar; NULL se dá
+      void *addr;              // dlsym, na primeira chamada que aparece
+    } native;
+
+    struct {            // AST_PIPELINE
+      AstNode *source;  // range ou vetor
+      PipeStage *stages;
+      size_t count;
+      PipeTerminal terminal;
+    } pipeline;
+
+    struct {           // AST_FORMAT
+      FmtPart *parts;
+      size_t count;
+      size_t fixed_len; // soma dos trechos literais
+    } format;
+
+    struct {       // AST_VEC_LIT
+      int type;    // SimdType (lib/runtime/simd.h)
+      int lanes;
+      long long values[8];
+    } vec;
+
+    struct { // AST_FIELD
+      const char *name;
+      size_t len;
+      const char *type; // primitivo (i32, f64...) ou struct/union
+      size_t type_len;
+      long long count; // T[N]; 1 se não é array
+      int hot;         // vai pra primeira linha de cache no modo reorder
+      long long size, align, offset; // layout.c preenche
+    } field;
+
     struct {
       const char *name;
       size_t len;
       AstNode *block;
+      int native; // chama C: o resultado depende de fora, não vai pro cache
     } test;
 
     // AST_TEST_STMT, AST_ASSERT_STMT podem herdar fields de block + nome
   } data;
 };
 
-AstNode *ast_new_number_lit(Token tok, long long val);
-AstNode *ast_new_ident(Token tok);
-AstNode *ast_new_binop(Token op_tok, AstNode *left, AstNode *right);
-AstNode *ast_new_block(Token open_brace, AstNode **stmts, size_t count);
-AstNode *ast_new_test(Token token, AstNode *block);
-AstNode *ast_new_assert(AstNode *expr);
-AstNode *ast_new_number(Token tok, long long val);
-void ast_free(AstNode *node);
+// Construtores recebem o alocador do contexto — por quê? A AST vive na
+// memória de quem embute o compilador, sem malloc global
+AstNode *ast_new_number_lit(const ModalAllocator *a, Token tok, long long val);
+AstNode *ast_new_ident(const ModalAllocator *a, Token tok);
+AstNode *ast_new_binop(const ModalAllocator *a, Token op_tok, AstNode *left,
+                       AstNode *right);
+AstNode *ast_new_unary(const ModalAllocator *a, Token op_tok, AstNode *expr);
+AstNode *ast_new_block(const ModalAllocator *a, Token open_brace,
+                       AstNode **stmts, size_t count);
+// name/len: conteúdo já decodificado (parser_string); vive com o fonte ou
+// no StrPool
+AstNode *ast_new_test(const ModalAllocator *a, Token token, const char *name,
+                      size_t len, AstNode *block);
+// message: AST_FORMAT ou NULL
+AstNode *ast_new_assert(const ModalAllocator *a, AstNode *expr,
+                        AstNode *message);
+AstNode *ast_new_async(const ModalAllocator *a, Token tok, AstNode *block);
+AstNode *ast_new_await(const ModalAllocator *a, Token tok);
+AstNode *ast_new_var(const ModalAllocator *a, Token name, AstNode *init,
+                     int autofree);
+AstNode *ast_new_defer(const ModalAllocator *a, Token tok, AstNode *stmt);
+AstNode *ast_new_record(const ModalAllocator *a, Token name, AstNode **fields,
+                        size_t count, int is_union, int reorder);
+AstNode *ast_new_field(const ModalAllocator *a, Token name, Token type,
+                       long long count, int hot);
+AstNode *ast_new_sizeof(const ModalAllocator *a, Token type);
+AstNode *ast_new_range(const ModalAllocator *a, Token op_tok, AstNode *lo,
+                       AstNode *hi);
+AstNode *ast_new_pipeline(const ModalAllocator *a, Token tok, AstNode *source,
+                          PipeStage *stages, size_t count,
+                          PipeTerminal terminal);
+AstNode *ast_new_call(const ModalAllocator *a, Token name, AstNode **args,
+                      size_t count);
+// Copia parts; as exprs passam a ser do nó
+AstNode *ast_new_format(const ModalAllocator *a, Token tok, FmtPart *parts,
+                        size_t count);
+AstNode *ast_new_use(const ModalAllocator *a, Token path, char *text,
+                     size_t text_len);
+AstNode *ast_new_extern_fn(const ModalAllocator *a, Token name);
+AstNode *ast_new_number(const ModalAllocator *a, Token tok, long long val);
+AstNode *ast_new_float(const ModalAllocator *a, Token tok, double val);
+// Nó com hc é da AstIntern: fica pro ast_intern_free
+void ast_free(const ModalAllocator *a, AstNode *node);
+
+// Anexa node a um array que cresce em dobro (stmts do programa, campos...);
+// 0 se faltou memória — node continua sendo de quem chamou
+int ast_list_push(const ModalAllocator *a, AstNode ***items, size_t *count,
+                  size_t *cap, AstNode *node);
+
+// Hash estrutural da subárvore (ast_hash.c) — ignora espaços, comentários e
+// posições; dois nós com mesmo hash têm mesma forma e mesmos literais
+uint64_t ast_hash(const AstNode *node);
+// Mesmo FNV-1a sobre bytes crus: fonte e caminho dos módulos (iface.c)
+uint64_t ast_hash_bytes(const void *data, size_t len);
+
+// Análise de escape dos autofree (escape.c): decide quais vão pra slot de
+// pilha; parse_program roda no fim de um parse sem erro
+void ast_escape_analyze(AstNode *node);
 
 // ... mais construtores
 
-void ast_free(AstNode *node); // recursivo, libera filhos primeiro
+// ast_free é recursivo, libera filhos primeiro
 
 #endif
@@ -0,0 +1,138 @@
+#include "ast.h"
+#include <string.h>
+
+// FNV-1a 64 bits — por quê? Simples, sem tabela, bom o bastante pra chave de
+// cache (não é criptográfico)
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t mix_bytes(uint64_t h, const void *data, size_t len) {
+  const unsigned char *b = data;
+  for (size_t i = 0; i < len; i++) {
+    h ^= b[i];
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+static uint64_t mix_u64(uint64_t h, uint64_t v) {
+  return mix_bytes(h, &v, sizeof(v));
+}
+
+uint64_t ast_hash_bytes(const void *data, size_t len) {
+  return mix_bytes(FNV_OFFSET, data, len);
+}
+
+static uint64_t hash_node(uint64_t h, const AstNode *node) {
+  if (!node)
+    return mix_u64(h, (uint64_t)-1); // filho ausente também conta
+
+  h = mix_u64(h, (uint64_t)node->kind);
+
+  switch (node->kind) {
+  case AST_NUMBER_LIT:
+    if (node->data.number.is_float) { // 1.0 e 1 são testes diferentes
+      uint64_t bits;
+      memcpy(&bits, &node->data.number.f64, sizeof(bits));
+      return mix_u64(mix_u64(h, 1), bits);
+    }
+    return mix_u64(h, (uint64_t)node->data.number.value);
+  case AST_IDENT:
+  case AST_SIZEOF:
+    h = mix_u64(h, node->data.ident.len);
+    return mix_bytes(h, node->data.ident.name, node->data.ident.len);
+  case AST_BIN_OP:
+    // op vem do lexema — por quê? Todo + - * / é OPERATOR no Kind
+    h = mix_bytes(h, node->token.start, (size_t)node->token.len);
+    h = hash_node(h, node->data.binop.left);
+    return hash_node(h, node->data.binop.right);
+  case AST_UNARY_OP:
+    h = mix_bytes(h, node->token.start, (size_t)node->token.len);
+    return hash_node(h, node->data.unary.expr);
+  case AST_ASSERT_STMT: // mensagem muda, test roda de novo (mostra a nova)
+    h = hash_node(h, node->data.unary.expr);
+    return hash_node(h, node->data.unary.message);
+  case AST_ASYNC_BLOCK:
+  case AST_DEFER_STMT:
+    return hash_node(h, node->data.unary.expr);
+  case AST_FORMAT:
+    h = mix_u64(h, node->data.format.count);
+    for (size_t i = 0; i < node->data.format.count; i++) {
+      const FmtPart *part = &node->data.format.parts[i];
+      h = mix_u64(h, part->len);
+      h = mix_bytes(h, part->text, part->len);
+      h = mix_u64(h, (uint64_t)part->kind);
+      h = mix_u64(h, (uint64_t)part->prec);
+      h = hash_node(h, part->expr);
+    }
+    return h;
+  case AST_BLOCK:
+  case AST_PAREN_GROUP:
+    h = mix_u64(h, node->data.block_or_group.count);
+    for (size_t i = 0; i < node->data.block_or_group.count; i++)
+      h = hash_node(h, node->data.block_or_group.stmts[i]);
+    return h;
+  case AST_VAR_DECL:
+    // slot fica de fora — por quê? Sai da análise, não do fonte
+    h = mix_u64(h, (uint64_t)node->data.var.autofree);
+    h = mix_u64(h, node->data.var.len);
+    h = mix_bytes(h, node->data.var.name, node->data.var.len);
+    return hash_node(h, node->data.var.init);
+  case AST_RANGE:
+    h = hash_node(h, node->data.binop.left);
+    return hash_node(h, node->data.binop.right);
+  case AST_PIPELINE:
+    h = hash_node(h, node->data.pipeline.source);
+    h = mix_u64(h, node->data.pipeline.count);
+    for (size_t i = 0; i < node->data.pipeline.count; i++) {
+      h = mix_u64(h, (uint64_t)node->data.pipeline.stages[i].kind);
+      h = hash_node(h, node->data.pipeline.stages[i].expr);
+    }
+    return mix_u64(h, (uint64_t)node->data.pipeline.terminal);
+  case AST_CALL:
+    h = mix_u64(h, node->data.call.native != NULL); // C ou builtin
+    h = mix_u64(h, node->data.call.len);
+    h = mix_bytes(h, node->data.call.name, node->data.call.len);
+    h = mix_u64(h, node->data.call.count);
+    for (size_t i = 0; i < node->data.call.count; i++)
+      h = hash_node(h, node->data.call.args[i]);
+    return h;
+  case AST_VEC_LIT:
+    h = mix_u64(h, (uint64_t)node->data.vec.type);
+    for (int i = 0; i < node->data.vec.lanes; i++)
+      h = mix_u64(h, (uint64_t)node->data.vec.values[i]);
+    return h;
+  case AST_STRUCT_DECL:
+    h = mix_u64(h, (uint64_t)node->data.record.is_union);
+    h = mix_u64(h, (uint64_t)node->data.record.reorder);
+    h = mix_bytes(h, node->data.record.name, node->data.record.len);
+    h = mix_u64(h, node->data.record.count);
+    for (size_t i = 0; i < node->data.record.count; i++)
+      h = hash_node(h, node->data.record.fields[i]);
+    return h;
+  case AST_FIELD:
+    h = mix_u64(h, (uint64_t)node->data.field.hot);
+    h = mix_u64(h, (uint64_t)node->data.field.count);
+    h = mix_u64(h, node->data.field.len);
+    h = mix_bytes(h, node->data.field.name, node->data.field.len);
+    h = mix_u64(h, node->data.field.type_len);
+    return mix_bytes(h, node->data.field.type, node->data.field.type_len);
+  case AST_USE: // header mudou, hash muda
+    h = mix_bytes(h, node->data.use.path, node->data.use.len);
+    return mix_bytes(h, node->data.use.text, node->data.use.text_len);
+  case AST_EXTERN_FN:
+    h = mix_bytes(h, node->data.native.name, node->data.native.len);
+    h = mix_u64(h, (uint64_t)node->data.native.ret);
+    for (size_t i = 0; i < node->data.native.count; i++)
+      h = mix_u64(h, (uint64_t)node->data.native.params[i]);
+    return h;
+  case AST_TEST_STMT:
+    h = mix_u64(h, node->data.test.len);
+    h = mix_bytes(h, node->data.test.name, node->data.test.len);
+    return hash_node(h, node->data.test.block);
+  default:
+    return h;
+  }
+}
+
+uint64_t ast_hash(const AstNode *node) { return hash_node(FNV_OFFSET, node); }
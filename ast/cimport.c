@@ -0,0 +1,1277 @@
+#include "cimport.h"
+#include "iface.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Leitor de declarações C: só o que um header de biblioteca expõe pro
+// Modal — protótipos, struct/union, typedef, enum e #define de inteiro. Não
+// é pré-processador: #include/#if são ignorados e o header é lido como
+// está; declaração que não entende é pulada até o próximo ';'. Tamanhos de
+// LP64 (long = 8), como Linux/macOS em x86-64 e aarch64
+
+typedef struct {
+  const char *name;
+  size_t len;
+  long long value;
+} CConst;
+
+typedef struct {
+  FfiType scalar;
+  const char *record; // struct/union por valor (nome da tag)
+  size_t record_len;
+  int known; // 0: tipo que não conhecemos — só serve atrás de ponteiro
+} CType;
+
+typedef struct {
+  const char *name;
+  size_t len;
+  CType type;
+} CTypedef;
+
+struct CImport {
+  CConst *consts;
+  size_t nconsts, consts_cap;
+  CTypedef *typedefs;
+  size_t ntypedefs, typedefs_cap;
+};
+
+typedef enum { CT_EOF, CT_IDENT, CT_NUMBER, CT_STRING, CT_PUNCT } CTokKind;
+
+typedef struct {
+  CTokKind kind;
+  const char *start;
+  size_t len;
+} CTok;
+
+typedef struct {
+  Parser *p;
+  Token where; // path do use: erro dentro do header aponta pra cá
+  const char *pos, *end;
+  int bol; // começo de linha: '#' abre diretiva
+  CTok cur;
+  AstNode ***stmts; // topo do programa, onde as declarações entram
+  size_t *count, *cap;
+} CReader;
+
+// ----- tabelas -----
+
+static const CConst *find_const(const CImport *im, const char *name,
+                                size_t len) {
+  for (size_t i = 0; im && i < im->nconsts; i++)
+    if (im->consts[i].len == len && memcmp(im->consts[i].name, name, len) == 0)
+      return &im->consts[i];
+  return NULL;
+}
+
+static void add_const(CReader *r, const char *name, size_t len,
+                      long long value) {
+  CImport *im = r->p->imports;
+  if (find_const(im, name, len))
+    return; // o primeiro vence, como um #define repetido igual
+  if (im->nconsts == im->consts_cap) {
+    size_t cap = im->consts_cap ? im->consts_cap * 2 : 32;
+    CConst *grown = modal_realloc(r->p->alloc, im->consts,
+                                  im->consts_cap * sizeof(CConst),
+                                  cap * sizeof(CConst));
+    if (!grown)
+      return;
+    im->consts = grown;
+    im->consts_cap = cap;
+  }
+  im->consts[im->nconsts++] = (CConst){name, len, value};
+}
+
+static const CTypedef *find_typedef(const CImport *im, const char *name,
+                                    size_t len) {
+  for (size_t i = 0; i < im->ntypedefs; i++)
+    if (im->typedefs[i].len == len &&
+        memcmp(im->typedefs[i].name, name, len) == 0)
+      return &im->typedefs[i];
+  return NULL;
+}
+
+static void add_typedef(CReader *r, const char *name, size_t len, CType type) {
+  CImport *im = r->p->imports;
+  if (find_typedef(im, name, len))
+    return;
+  if (im->ntypedefs == im->typedefs_cap) {
+    size_t cap = im->typedefs_cap ? im->typedefs_cap * 2 : 16;
+    CTypedef *grown = modal_realloc(r->p->alloc, im->typedefs,
+                                    im->typedefs_cap * sizeof(CTypedef),
+                                    cap * sizeof(CTypedef));
+    if (!grown)
+      return;
+    im->typedefs = grown;
+    im->typedefs_cap = cap;
+  }
+  im->typedefs[im->ntypedefs++] = (CTypedef){name, len, type};
+}
+
+static const struct {
+  const char *name;
+  FfiType type;
+} stdint_names[] = {
+    {"int8_t", FFI_I8},     {"uint8_t", FFI_U8},     {"int16_t", FFI_I16},
+    {"uint16_t", FFI_U16},  {"int32_t", FFI_I32},    {"uint32_t", FFI_U32},
+    {"int64_t", FFI_I64},   {"uint64_t", FFI_U64},   {"size_t", FFI_U64},
+    {"ssize_t", FFI_I64},   {"ptrdiff_t", FFI_I64},  {"intptr_t", FFI_I64},
+    {"uintptr_t", FFI_U64}, {"off_t", FFI_I64},      {"intmax_t", FFI_I64},
+    {"uintmax_t", FFI_U64}, {"wchar_t", FFI_I32},
+};
+
+// Tipo pelo nome (typedef do header ou <stdint.h>); 0 se não conhece
+static int named_type(const CImport *im, const char *name, size_t len,
+                      CType *out) {
+  const CTypedef *td = find_typedef(im, name, len);
+  if (td) {
+    *out = td->type;
+    return 1;
+  }
+  for (size_t i = 0; i < sizeof(stdint_names) / sizeof(stdint_names[0]); i++)
+    if (strlen(stdint_names[i].name) == len &&
+        memcmp(stdint_names[i].name, name, len) == 0) {
+      *out = (CType){.scalar = stdint_names[i].type, .known = 1};
+      return 1;
+    }
+  return 0;
+}
+
+static Token name_token(const CReader *r, const char *name, size_t len) {
+  Token t = r->where; // linha/offset do use; o texto é o do header
+  t.kind = IDENTIFIER;
+  t.start = name;
+  t.len = (int)len;
+  return t;
+}
+
+static void push_decl(CReader *r, AstNode *node) {
+  if (node && !ast_list_push(r->p->alloc, r->stmts, r->count, r->cap, node))
+    ast_free(r->p->alloc, node);
+}
+
+// ----- léxico -----
+
+static void handle_directive(CReader *r, const char *start, const char *end);
+
+static int at(const CReader *r, size_t i, char c) {
+  return r->pos + i < r->end && r->pos[i] == c;
+}
+
+static void skip_space(CReader *r) {
+  while (r->pos < r->end) {
+    char c = *r->pos;
+    if (c == '\n') {
+      r->bol = 1;
+      r->pos++;
+    } else if (isspace((unsigned char)c)) {
+      r->pos++;
+    } else if (c == '\\' && at(r, 1, '\n')) {
+      r->pos += 2;
+    } else if (c == '/' && at(r, 1, '/')) {
+      while (r->pos < r->end && *r->pos != '\n')
+        r->pos++;
+    } else if (c == '/' && at(r, 1, '*')) {
+      r->pos += 2;
+      while (r->pos < r->end && !(*r->pos == '*' && at(r, 1, '/')))
+        r->pos++;
+      r->pos = r->pos < r->end ? r->pos + 2 : r->end;
+    } else {
+      return;
+    }
+  }
+}
+
+// Diretiva é tratada aqui mesmo — por quê? Pode aparecer no meio de struct
+// ou enum e nenhum outro lugar precisa saber dela
+static void advance_tok(CReader *r) {
+  for (;;) {
+    skip_space(r);
+    if (r->pos >= r->end) {
+      r->cur = (CTok){CT_EOF, r->end, 0};
+      return;
+    }
+    const char *s = r->pos;
+    if (*s != '#' || !r->bol)
+      break;
+    while (r->pos < r->end && *r->pos != '\n') {
+      if (*r->pos == '\\' && at(r, 1, '\n'))
+        r->pos++;
+      r->pos++;
+    }
+    handle_directive(r, s + 1, r->pos);
+  }
+
+  r->bol = 0;
+  const char *s = r->pos;
+  char c = *s;
+  CTokKind kind = CT_PUNCT;
+  if (isalpha((unsigned char)c) || c == '_') {
+    while (r->pos < r->end &&
+           (isalnum((unsigned char)*r->pos) || *r->pos == '_'))
+      r->pos++;
+    kind = CT_IDENT;
+  } else if (isdigit((unsigned char)c)) {
+    while (r->pos < r->end && (isalnum((unsigned char)*r->pos) ||
+                               *r->pos == '.' || *r->pos == '\''))
+      r->pos++;
+    kind = CT_NUMBER;
+  } else if (c == '"' || c == '\'') {
+    r->pos++;
+    while (r->pos < r->end && *r->pos != c && *r->pos != '\n')
+      r->pos += *r->pos == '\\' && r->pos + 1 < r->end ? 2 : 1;
+    if (r->pos < r->end && *r->pos == c)
+      r->pos++;
+    kind = c == '"' ? CT_STRING : CT_NUMBER; // 'a' é inteiro em C
+  } else if (c == '.' && at(r, 1, '.') && at(r, 2, '.')) {
+    r->pos += 3;
+  } else {
+    r->pos++;
+  }
+  r->cur = (CTok){kind, s, (size_t)(r->pos - s)};
+}
+
+static int is_punct(const CReader *r, char c) {
+  return r->cur.kind == CT_PUNCT && r->cur.len == 1 && *r->cur.start == c;
+}
+
+static int is_kw(const CReader *r, const char *kw) {
+  size_t len = strlen(kw);
+  return r->cur.kind == CT_IDENT && r->cur.len == len &&
+         memcmp(r->cur.start, kw, len) == 0;
+}
+
+// Pula de '(' até o ')' correspondente
+static void skip_parens(CReader *r) {
+  if (!is_punct(r, '('))
+    return;
+  int depth = 0;
+  do {
+    if (is_punct(r, '('))
+      depth++;
+    else if (is_punct(r, ')'))
+      depth--;
+    advance_tok(r);
+  } while (depth > 0 && r->cur.kind != CT_EOF);
+}
+
+// Declaração que não entendemos: até o ';' do mesmo nível ou o fim de um
+// corpo { }. Não passa de um '}' que fecha quem chamou
+static void skip_decl(CReader *r) {
+  int depth = 0;
+  while (r->cur.kind != CT_EOF) {
+    if (is_punct(r, '(') || is_punct(r, '[') || is_punct(r, '{')) {
+      depth++;
+    } else if (is_punct(r, ')') || is_punct(r, ']') || is_punct(r, '}')) {
+      if (depth == 0)
+        return;
+      int closes_body = --depth == 0 && is_punct(r, '}');
+      advance_tok(r);
+      if (closes_body) {
+        if (is_punct(r, ';'))
+          advance_tok(r);
+        return;
+      }
+      continue;
+    } else if (depth == 0 && is_punct(r, ';')) {
+      advance_tok(r);
+      return;
+    }
+    advance_tok(r);
+  }
+}
+
+// ----- expressões constantes (enum, #define, tamanho de array) -----
+
+static int cexpr(CReader *r, long long *out);
+
+static int char_literal(const char *s, size_t len, long long *out) {
+  if (len < 3 || s[len - 1] != '\'')
+    return 0;
+  const char *c = s + 1;
+  if (*c != '\\') {
+    *out = (unsigned char)*c;
+    return len == 3;
+  }
+  c++;
+  switch (*c) {
+  case 'n':
+    *out = '\n';
+    break;
+  case 't':
+    *out = '\t';
+    break;
+  case 'r':
+    *out = '\r';
+    break;
+  case 'x':
+    *out = (long long)strtoul(c + 1, NULL, 16);
+    break;
+  default:
+    if (*c >= '0' && *c <= '7')
+      *out = (long long)strtoul(c, NULL, 8);
+    else
+      *out = (unsigned char)*c; // \\ \' \"
+  }
+  return 1;
+}
+
+// Inteiro de C: 0x, 0b, octal, sufixos u/l, separador '. Float não é constante
+static int int_literal(const char *s, size_t len, long long *out) {
+  if (*s == '\'')
+    return char_literal(s, len, out);
+  while (len && strchr("uUlL", s[len - 1]))
+    len--;
+  unsigned base = 10;
+  size_t i = 0;
+  if (len > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+    base = 16, i = 2;
+  else if (len > 2 && s[0] == '0' && (s[1] == 'b' || s[1] == 'B'))
+    base = 2, i = 2;
+  else if (len > 1 && s[0] == '0')
+    base = 8, i = 1;
+  unsigned long long v = 0;
+  for (; i < len; i++) {
+    if (s[i] == '\'')
+      continue;
+    int d = isdigit((unsigned char)s[i]) ? s[i] - '0'
+            : isxdigit((unsigned char)s[i])
+                ? tolower((unsigned char)s[i]) - 'a' + 10
+                : 99;
+    if ((unsigned)d >= base || v > (ULLONG_MAX - (unsigned)d) / base)
+      return 0; // 1.5, 1e3, estouro
+    v = v * base + (unsigned)d;
+  }
+  *out = (long long)v;
+  return 1;
+}
+
+static int is_type_word(const CReader *r) {
+  static const char *words[] = {"int",   "unsigned", "signed", "long",
+                                "short", "char",     "const"};
+  for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++)
+    if (is_kw(r, words[i]))
+      return 1;
+  CType t;
+  return r->cur.kind == CT_IDENT &&
+         named_type(r->p->imports, r->cur.start, r->cur.len, &t);
+}
+
+static int cexpr_unary(CReader *r, long long *out) {
+  if (is_punct(r, '-') || is_punct(r, '~') || is_punct(r, '+') ||
+      is_punct(r, '!')) {
+    char op = *r->cur.start;
+    advance_tok(r);
+    long long v;
+    if (!cexpr_unary(r, &v))
+      return 0;
+    *out = op == '-'   ? (long long)(0 - (unsigned long long)v)
+           : op == '~' ? ~v
+           : op == '!' ? !v
+                       : v;
+    return 1;
+  }
+  if (is_punct(r, '(')) {
+    advance_tok(r);
+    if (is_type_word(r)) { // (int)5, (uint32_t)-1: cast é ignorado
+      while (r->cur.kind == CT_IDENT || is_punct(r, '*'))
+        advance_tok(r);
+      if (!is_punct(r, ')'))
+        return 0;
+      advance_tok(r);
+      return cexpr_unary(r, out);
+    }
+    if (!cexpr(r, out) || !is_punct(r, ')'))
+      return 0;
+    advance_tok(r);
+    return 1;
+  }
+  if (r->cur.kind == CT_NUMBER) {
+    int ok = int_literal(r->cur.start, r->cur.len, out);
+    advance_tok(r);
+    return ok;
+  }
+  if (r->cur.kind == CT_IDENT) {
+    const CConst *c = find_const(r->p->imports, r->cur.start, r->cur.len);
+    advance_tok(r);
+    if (!c)
+      return 0;
+    *out = c->value;
+    return 1;
+  }
+  return 0;
+}
+
+// Binários por precedência de C, do mais forte pro mais fraco
+static const char *levels[] = {"*/%", "+-", "<>", "&", "^", "|"};
+
+static int is_shift(const CReader *r, char c) {
+  return is_punct(r, c) && r->pos < r->end && *r->pos == c;
+}
+
+static int cexpr_level(CReader *r, int level, long long *out) {
+  if (level < 0)
+    return cexpr_unary(r, out);
+  if (!cexpr_level(r, level - 1, out))
+    return 0;
+  for (;;) {
+    if (r->cur.kind != CT_PUNCT || r->cur.len != 1 ||
+        !strchr(levels[level], *r->cur.start))
+      return 1;
+    char op = *r->cur.start;
+    if (level == 2) { // só << e >>; < sozinho não é constante
+      if (!is_shift(r, op))
+        return 0;
+      advance_tok(r);
+    } else if ((op == '&' || op == '|') && is_shift(r, op)) {
+      return 0; // && e || ficam de fora
+    }
+    advance_tok(r);
+
+    long long b;
+    if (!cexpr_level(r, level - 1, &b))
+      return 0;
+    unsigned long long ua = (unsigned long long)*out,
+                       ub = (unsigned long long)b;
+    switch (op) {
+    case '*':
+      *out = (long long)(ua * ub);
+      break;
+    case '/':
+    case '%':
+      if (b == 0 || (*out == LLONG_MIN && b == -1))
+        return 0;
+      *out = op == '/' ? *out / b : *out % b;
+      break;
+    case '+':
+      *out = (long long)(ua + ub);
+      break;
+    case '-':
+      *out = (long long)(ua - ub);
+      break;
+    case '<':
+    case '>':
+      if (b < 0 || b > 63)
+        return 0;
+      *out = op == '<' ? (long long)(ua << b) : *out >> b;
+      break;
+    case '&':
+      *out &= b;
+      break;
+    case '^':
+      *out ^= b;
+      break;
+    default:
+      *out |= b;
+    }
+  }
+}
+
+static int cexpr(CReader *r, long long *out) {
+  return cexpr_level(r, (int)(sizeof(levels) / sizeof(levels[0])) - 1, out);
+}
+
+// #define NOME <inteiro>; o resto (#include, #if, macro com parâmetro) some
+static void handle_directive(CReader *r, const char *start, const char *end) {
+  CReader d = *r;
+  d.pos = start;
+  d.end = end;
+  d.bol = 0;
+  advance_tok(&d);
+  if (!is_kw(&d, "define"))
+    return;
+  advance_tok(&d);
+  if (d.cur.kind != CT_IDENT)
+    return;
+  CTok name = d.cur;
+  if (name.start + name.len < end && name.start[name.len] == '(')
+    return; // macro com parâmetros
+  advance_tok(&d);
+  long long v;
+  if (d.cur.kind != CT_EOF && cexpr(&d, &v) && d.cur.kind == CT_EOF)
+    add_const(r, name.start, name.len, v);
+}
+
+// ----- declarações -----
+
+typedef struct {
+  CType type;
+  int is_typedef, is_static, ok;
+  AstNode *record; // struct/union anônima definida aqui, ainda sem dono
+} CSpecs;
+
+typedef struct {
+  const char *name;
+  size_t len;
+  CType type;      // já com o ponteiro aplicado
+  long long count; // array: produto das dimensões; 0 = [] sem tamanho
+  int is_func, variadic, bitfield, ok;
+  CType params[FFI_MAX_ARGS];
+  size_t nparams; // pode passar de FFI_MAX_ARGS; só os primeiros ficam
+} CDecl;
+
+static const CType ptr_type = {.scalar = FFI_PTR, .known = 1};
+
+static void parse_specs(CReader *r, CSpecs *s);
+static void parse_declarator(CReader *r, CType base, CDecl *d);
+
+static int skip_qualifier(CReader *r) {
+  static const char *quals[] = {
+      "const",         "volatile",  "restrict",       "__restrict",
+      "__restrict__",  "extern",    "register",       "_Noreturn",
+      "__extension__", "auto",      "_Thread_local",  "__inline",
+      "__inline__",    "inline",    "__const",        "__volatile__",
+      "_Nonnull",      "_Nullable", "__THROW",        "__wur",
+  };
+  if (is_kw(r, "__attribute__") || is_kw(r, "__declspec") ||
+      is_kw(r, "__asm__") || is_kw(r, "__asm") || is_kw(r, "_Alignas") ||
+      is_kw(r, "alignas")) {
+    advance_tok(r);
+    skip_parens(r);
+    return 1;
+  }
+  for (size_t i = 0; i < sizeof(quals) / sizeof(quals[0]); i++)
+    if (is_kw(r, quals[i])) {
+      advance_tok(r);
+      return 1;
+    }
+  return 0;
+}
+
+// Campo de struct: primitivo Modal, ponteiro ou outra struct por valor
+static int field_type(const CType *t, const char **name, size_t *len) {
+  if (!t->known || (!t->record && t->scalar == FFI_VOID))
+    return 0;
+  if (t->record) {
+    *name = t->record;
+    *len = t->record_len;
+  } else {
+    *name = ffi_type_name(t->scalar);
+    *len = strlen(*name);
+  }
+  return 1;
+}
+
+// { campos } — cur é '{'. NULL se tem algo que o layout não reproduz
+// (bitfield, membro anônimo, array sem tamanho): melhor sem sizeof que
+// com sizeof errado
+static AstNode *parse_record_body(CReader *r, const char *tag, size_t len,
+                                  int is_union) {
+  const ModalAllocator *a = r->p->alloc;
+  AstNode **fields = NULL;
+  size_t count = 0, cap = 0;
+  int bad = 0;
+
+  advance_tok(r);
+  while (!is_punct(r, '}') && r->cur.kind != CT_EOF) {
+    const char *before = r->cur.start;
+    CSpecs fs;
+    parse_specs(r, &fs);
+    if (fs.record) { // struct { struct { ... } x; } — sem nome pra tag
+      ast_free(a, fs.record);
+      bad = 1;
+    }
+    bad |= !fs.ok;
+    while (!is_punct(r, ';') && r->cur.kind != CT_EOF) {
+      CDecl d;
+      parse_declarator(r, fs.type, &d);
+      const char *type;
+      size_t type_len;
+      if (!d.name || d.is_func || d.bitfield || !d.ok || d.count == 0 ||
+          !field_type(&d.type, &type, &type_len)) {
+        bad = 1;
+      } else {
+        AstNode *f = ast_new_field(a, name_token(r, d.name, d.len),
+                                   name_token(r, type, type_len), d.count, 0);
+        if (!f || !ast_list_push(a, &fields, &count, &cap, f)) {
+          ast_free(a, f);
+          bad = 1;
+        }
+      }
+      if (!is_punct(r, ','))
+        break;
+      advance_tok(r);
+    }
+    if (is_punct(r, ';'))
+      advance_tok(r);
+    else
+      skip_decl(r);
+    if (r->cur.start == before && !is_punct(r, '}'))
+      advance_tok(r); // nada andou: evita laço infinito
+  }
+  if (is_punct(r, '}'))
+    advance_tok(r);
+
+  AstNode *rec = NULL;
+  if (!bad && count)
+    rec = ast_new_record(a, name_token(r, tag, len), fields, count, is_union,
+                         0); // ordem de C: reorder mudaria o ABI
+  if (rec)
+    rec->data.record.imported = 1;
+  if (!rec)
+    for (size_t i = 0; i < count; i++)
+      ast_free(a, fields[i]);
+  modal_free(a, fields, cap * sizeof(AstNode *));
+  return rec;
+}
+
+static void parse_record_spec(CReader *r, CSpecs *s, int is_union) {
+  advance_tok(r);
+  while (skip_qualifier(r))
+    ;
+  const char *tag = NULL;
+  size_t len = 0;
+  if (r->cur.kind == CT_IDENT) {
+    tag = r->cur.start;
+    len = r->cur.len;
+    advance_tok(r);
+  }
+  s->type = (CType){.record = tag, .record_len = len, .known = tag != NULL};
+  if (!is_punct(r, '{'))
+    return; // struct Foo x; / struct Foo; — definida em outro lugar
+
+  AstNode *rec = parse_record_body(r, tag, len, is_union);
+  if (!rec) {
+    s->type.known = 0;
+    return;
+  }
+  if (tag) // tag é escopo de arquivo em C, mesmo dentro de outra struct
+    push_decl(r, rec);
+  else
+    s->record = rec;
+  s->type.known = 1;
+}
+
+static void parse_enum_spec(CReader *r, CSpecs *s) {
+  advance_tok(r);
+  while (skip_qualifier(r))
+    ;
+  if (r->cur.kind == CT_IDENT)
+    advance_tok(r);
+  s->type = (CType){.scalar = FFI_I32, .known = 1};
+  if (!is_punct(r, '{'))
+    return;
+
+  advance_tok(r);
+  long long next = 0;
+  int lost = 0; // valor que não deu pra avaliar: os seguintes também somem
+  while (!is_punct(r, '}') && r->cur.kind != CT_EOF) {
+    if (r->cur.kind != CT_IDENT) {
+      advance_tok(r);
+      continue;
+    }
+    CTok name = r->cur;
+    advance_tok(r);
+    if (is_punct(r, '=')) {
+      advance_tok(r);
+      long long v;
+      if (cexpr(r, &v)) {
+        next = v;
+        lost = 0;
+      } else {
+        lost = 1;
+      }
+    }
+    if (!lost)
+      add_const(r, name.start, name.len, next);
+    next = (long long)((unsigned long long)next + 1);
+    while (!is_punct(r, ',') && !is_punct(r, '}') && r->cur.kind != CT_EOF)
+      advance_tok(r);
+    if (is_punct(r, ','))
+      advance_tok(r);
+  }
+  if (is_punct(r, '}'))
+    advance_tok(r);
+}
+
+// Especificadores até o nome do declarador: tipo base, typedef, static
+static void parse_specs(CReader *r, CSpecs *s) {
+  *s = (CSpecs){.ok = 1};
+  int n_long = 0, n_short = 0, n_char = 0, n_int = 0, n_signed = 0,
+      n_unsigned = 0, n_void = 0, n_bool = 0, n_float = 0, n_double = 0;
+  int named = 0; // tipo já veio de struct/enum/typedef
+
+  while (r->cur.kind == CT_IDENT) {
+    if (is_kw(r, "typedef")) {
+      s->is_typedef = 1;
+    } else if (is_kw(r, "static")) {
+      s->is_static = 1;
+    } else if (skip_qualifier(r)) {
+      continue;
+    } else if (is_kw(r, "struct") || is_kw(r, "union")) {
+      parse_record_spec(r, s, is_kw(r, "union"));
+      named = 1;
+      continue;
+    } else if (is_kw(r, "enum")) {
+      parse_enum_spec(r, s);
+      named = 1;
+      continue;
+    } else if (is_kw(r, "long")) {
+      n_long++;
+    } else if (is_kw(r, "short")) {
+      n_short++;
+    } else if (is_kw(r, "char")) {
+      n_char++;
+    } else if (is_kw(r, "int")) {
+      n_int++;
+    } else if (is_kw(r, "signed") || is_kw(r, "__signed__")) {
+      n_signed++;
+    } else if (is_kw(r, "unsigned")) {
+      n_unsigned++;
+    } else if (is_kw(r, "void")) {
+      n_void++;
+    } else if (is_kw(r, "_Bool") || is_kw(r, "bool")) {
+      n_bool++;
+    } else if (is_kw(r, "float")) {
+      n_float++;
+    } else if (is_kw(r, "double")) {
+      n_double++;
+    } else if (!named && !(n_long | n_short | n_char | n_int | n_signed |
+                           n_unsigned | n_void | n_bool | n_float |
+                           n_double)) {
+      // Nome de tipo: typedef/stdint, ou um que não conhecemos (FILE)
+      if (!named_type(r->p->imports, r->cur.start, r->cur.len, &s->type))
+        s->type = (CType){.known = 0};
+      named = 1;
+    } else {
+      break; // nome do declarador
+    }
+    advance_tok(r);
+  }
+
+  if (named)
+    return;
+  FfiType t;
+  if (n_void)
+    t = FFI_VOID;
+  else if (n_bool)
+    t = FFI_BOOL;
+  else if (n_float)
+    t = FFI_F32;
+  else if (n_double) {
+    t = FFI_F64;
+    if (n_long) { // long double: sem representação aqui
+      s->type = (CType){.known = 0};
+      return;
+    }
+  } else if (n_char)
+    t = n_unsigned ? FFI_U8 : n_signed || CHAR_MIN < 0 ? FFI_I8 : FFI_U8;
+  else if (n_short)
+    t = n_unsigned ? FFI_U16 : FFI_I16;
+  else if (n_long)
+    t = n_unsigned ? FFI_U64 : FFI_I64; // LP64
+  else if (n_int || n_signed || n_unsigned)
+    t = n_unsigned ? FFI_U32 : FFI_I32;
+  else {
+    s->ok = 0; // só qualificador (ou nada): não é declaração que entendemos
+    s->type = (CType){.known = 0};
+    return;
+  }
+  s->type = (CType){.scalar = t, .known = 1};
+}
+
+static void parse_params(CReader *r, CDecl *d) {
+  advance_tok(r); // '('
+  d->is_func = 1;
+  if (is_punct(r, ')')) { // f(): sem protótipo, trata como sem argumento
+    advance_tok(r);
+    return;
+  }
+  for (;;) {
+    if (r->cur.kind == CT_PUNCT && r->cur.len == 3) { // ...
+      d->variadic = 1;
+      advance_tok(r);
+      break;
+    }
+    CSpecs ps;
+    parse_specs(r, &ps);
+    if (ps.record) {
+      ast_free(r->p->alloc, ps.record);
+      ps.type.known = 0;
+    }
+    CDecl pd;
+    parse_declarator(r, ps.type, &pd);
+    if (pd.count != 1 || pd.is_func) // array e função decaem pra ponteiro
+      pd.type = ptr_type;
+    if (!ps.ok || !pd.ok)
+      pd.type.known = 0;
+    if (d->nparams == 0 && is_punct(r, ')') && !pd.name &&
+        !pd.type.record && pd.type.known && pd.type.scalar == FFI_VOID)
+      break; // f(void)
+    if (d->nparams < FFI_MAX_ARGS)
+      d->params[d->nparams] = pd.type;
+    d->nparams++;
+    if (!is_punct(r, ','))
+      break;
+    advance_tok(r);
+  }
+  if (is_punct(r, ')'))
+    advance_tok(r);
+  else
+    d->ok = 0;
+}
+
+static void parse_declarator(CReader *r, CType base, CDecl *d) {
+  *d = (CDecl){.type = base, .count = 1, .ok = 1};
+  while (is_punct(r, '*')) {
+    d->type = ptr_type;
+    advance_tok(r);
+    while (skip_qualifier(r))
+      ;
+  }
+
+  int grouped = 0;
+  if (r->cur.kind == CT_IDENT) {
+    d->name = r->cur.start;
+    d->len = r->cur.len;
+    advance_tok(r);
+  } else if (is_punct(r, '(') && r->pos < r->end) {
+    // (*nome)(...): ponteiro pra função — pro Modal é só um ponteiro
+    CReader la = *r;
+    advance_tok(&la);
+    if (is_punct(&la, '*')) {
+      *r = la;
+      while (is_punct(r, '*') || skip_qualifier(r))
+        if (is_punct(r, '*'))
+          advance_tok(r);
+      if (r->cur.kind == CT_IDENT) {
+        d->name = r->cur.start;
+        d->len = r->cur.len;
+        advance_tok(r);
+      }
+      while (is_punct(r, '[')) { // (*tabela[4])(...)
+        skip_decl(r);
+        if (is_punct(r, ']'))
+          advance_tok(r);
+      }
+      if (!is_punct(r, ')')) {
+        d->ok = 0;
+        return;
+      }
+      advance_tok(r);
+      d->type = ptr_type;
+      grouped = 1;
+    }
+  }
+
+  for (;;) {
+    if (is_punct(r, '[')) {
+      advance_tok(r);
+      long long n = 0;
+      if (!is_punct(r, ']') && (!cexpr(r, &n) || n <= 0))
+        d->ok = 0;
+      d->count = n ? d->count * n : 0;
+      while (!is_punct(r, ']') && r->cur.kind != CT_EOF)
+        advance_tok(r);
+      advance_tok(r);
+    } else if (is_punct(r, '(')) {
+      if (grouped || d->is_func)
+        skip_parens(r); // parâmetros do ponteiro pra função
+      else
+        parse_params(r, d);
+    } else if (is_punct(r, ':')) {
+      advance_tok(r);
+      long long bits;
+      cexpr(r, &bits);
+      d->bitfield = 1;
+    } else if (!skip_qualifier(r)) {
+      return;
+    }
+  }
+}
+
+// Tipo que atravessa a chamada como escalar; *why se não
+static int call_type(const CType *t, FfiType *out, const char **why) {
+  if (!t->known) {
+    *why = "tipo desconhecido na assinatura";
+    return 0;
+  }
+  if (t->record) {
+    *why = "struct/union por valor";
+    return 0;
+  }
+  *out = t->scalar;
+  return 1;
+}
+
+static AstNode *find_extern(AstNode **stmts, size_t count, const char *name,
+                            size_t len) {
+  for (size_t i = 0; i < count; i++) {
+    AstNode *n = stmts[i];
+    if (n && n->kind == AST_EXTERN_FN && n->data.native.len == len &&
+        memcmp(n->data.native.name, name, len) == 0)
+      return n;
+  }
+  return NULL;
+}
+
+static void add_extern(CReader *r, const CDecl *d, CType ret) {
+  if (find_extern(*r->stmts, *r->count, d->name, d->len))
+    return; // redeclaração
+  AstNode *fn = ast_new_extern_fn(r->p->alloc, name_token(r, d->name, d->len));
+  if (!fn)
+    return;
+
+  const char *why = NULL;
+  int ok = call_type(&ret, &fn->data.native.ret, &why);
+  size_t n = d->nparams < FFI_MAX_ARGS ? d->nparams : FFI_MAX_ARGS;
+  for (size_t i = 0; ok && i < n; i++)
+    ok = call_type(&d->params[i], &fn->data.native.params[i], &why);
+  fn->data.native.count = n;
+  if (ok && d->variadic) {
+    ok = 0;
+    why = "variádica";
+  }
+  if (ok)
+    ok = ffi_signature_ok(fn->data.native.ret, fn->data.native.params,
+                          d->nparams, &why);
+  fn->data.native.unsupported = ok ? NULL : why;
+  push_decl(r, fn);
+}
+
+static void parse_external(CReader *r) {
+  CSpecs s;
+  parse_specs(r, &s);
+  AstNode *anon = s.record;
+
+  while (!is_punct(r, ';') && r->cur.kind != CT_EOF) {
+    CDecl d;
+    parse_declarator(r, s.type, &d);
+    if (!d.ok || !d.name)
+      break;
+    if (s.is_typedef) {
+      CType t = d.is_func ? ptr_type : d.type;
+      if (d.count != 1)
+        t.known = 0; // typedef de array: não vira tipo de campo
+      if (anon && t.known && !t.record && s.type.record == NULL &&
+          d.type.scalar != FFI_PTR) {
+        // typedef struct { ... } Nome; — a struct ganha o nome
+        anon->token.start = d.name;
+        anon->token.len = (int)d.len;
+        anon->data.record.name = d.name;
+        anon->data.record.len = d.len;
+        t = (CType){.record = d.name, .record_len = d.len, .known = 1};
+        push_decl(r, anon);
+        anon = NULL;
+      }
+      add_typedef(r, d.name, d.len, t);
+    } else if (d.is_func && !s.is_static && s.ok) {
+      add_extern(r, &d, d.type); // static/inline não tem símbolo pro dlsym
+    }
+    if (is_punct(r, '{') || is_punct(r, '='))
+      break; // corpo (static inline) ou inicializador: skip_decl pula
+    if (!is_punct(r, ','))
+      break;
+    advance_tok(r);
+  }
+  ast_free(r->p->alloc, anon); // struct anônima sem typedef: sem nome, some
+
+  if (is_punct(r, ';'))
+    advance_tok(r);
+  else
+    skip_decl(r);
+}
+
+static int has_record(AstNode **stmts, size_t count, const char *name,
+                      size_t len) {
+  for (size_t i = 0; i < count; i++)
+    if (stmts[i] && stmts[i]->kind == AST_STRUCT_DECL &&
+        stmts[i]->data.record.len == len &&
+        memcmp(stmts[i]->data.record.name, name, len) == 0)
+      return 1;
+  return 0;
+}
+
+static int is_scalar_name(const char *name, size_t len) {
+  for (int t = FFI_BOOL; t <= FFI_F64; t++)
+    if (strlen(ffi_type_name((FfiType)t)) == len &&
+        memcmp(ffi_type_name((FfiType)t), name, len) == 0)
+      return 1;
+  return 0;
+}
+
+// Struct do header que usa outra que não veio (bitfield, membro anônimo,
+// definida em header que não lemos) some junto — por quê? Header de sistema
+// tem dezenas dessas; erro só se o Modal pedir o tipo
+static void prune_records(CReader *r, size_t first) {
+  AstNode **stmts = *r->stmts;
+  for (int changed = 1; changed;) {
+    changed = 0;
+    for (size_t i = first; i < *r->count; i++) {
+      AstNode *rec = stmts[i];
+      if (rec->kind != AST_STRUCT_DECL)
+        continue;
+      int broken = 0;
+      for (size_t f = 0; f < rec->data.record.count && !broken; f++) {
+        const AstNode *field = rec->data.record.fields[f];
+        broken = !is_scalar_name(field->data.field.type,
+                                 field->data.field.type_len) &&
+                 !has_record(stmts, *r->count, field->data.field.type,
+                             field->data.field.type_len);
+      }
+      if (!broken)
+        continue;
+      ast_free(r->p->alloc, rec);
+      memmove(&stmts[i], &stmts[i + 1], (*r->count - i - 1) * sizeof(*stmts));
+      (*r->count)--;
+      i--;
+      changed = 1;
+    }
+  }
+}
+
+static void parse_header(CReader *r) {
+  advance_tok(r);
+  while (r->cur.kind != CT_EOF && !r->p->halted) {
+    const char *before = r->cur.start;
+    if (is_kw(r, "extern")) { // extern "C" { ... }
+      CReader la = *r;
+      advance_tok(&la);
+      if (la.cur.kind == CT_STRING) {
+        *r = la;
+        advance_tok(r);
+        if (is_punct(r, '{'))
+          advance_tok(r);
+        continue;
+      }
+    }
+    if (is_punct(r, '}') || is_punct(r, ';')) {
+      advance_tok(r); // fecha extern "C" (ou sobra de #ifdef __cplusplus)
+      continue;
+    }
+    parse_external(r);
+    if (r->cur.start == before)
+      advance_tok(r);
+  }
+}
+
+// ----- use -----
+
+// Relativo ao diretório do .modal — por quê? `modal dir/x.modal` tem que
+// achar dir/x.h de qualquer cwd; se não existir lá, tenta o caminho como está
+static char *read_header(Parser *p, const char *path, size_t len,
+                         size_t *out_len) {
+  char full[4096];
+  const char *slash = p->filename ? strrchr(p->filename, '/') : NULL;
+  int dir_len = slash && *path != '/' ? (int)(slash - p->filename + 1) : 0;
+  if ((size_t)dir_len + len >= sizeof(full))
+    return NULL;
+
+  FILE *f = NULL;
+  for (int attempt = 0; attempt < 2 && !f; attempt++) {
+    int prefix = attempt == 0 ? dir_len : 0;
+    if (attempt == 1 && dir_len == 0)
+      break;
+    snprintf(full, sizeof(full), "%.*s%.*s", prefix, p->filename, (int)len,
+             path);
+    f = fopen(full, "rb");
+  }
+  if (!f)
+    return NULL;
+
+  char *text = NULL;
+  long size = -1;
+  if (fseek(f, 0, SEEK_END) == 0)
+    size = ftell(f);
+  if (size >= 0 && fseek(f, 0, SEEK_SET) == 0)
+    text = modal_alloc(p->alloc, (size_t)size + 1);
+  if (text && fread(text, 1, (size_t)size, f) != (size_t)size) {
+    modal_free(p->alloc, text, (size_t)size + 1);
+    text = NULL;
+  }
+  fclose(f);
+  if (!text)
+    return NULL;
+  text[size] = '\0';
+  *out_len = (size_t)size;
+  parser_note_file(p, full, ast_hash_bytes(text, (size_t)size));
+  return text;
+}
+
+int parse_use(Parser *p, AstNode ***stmts, size_t *count, size_t *cap) {
+  parser_advance(p); // use
+  if (p->current.kind != STRING) {
+    parser_error_at(p, &p->current,
+                    "espera \"arquivo.h\" ou \"arquivo.modal\" depois de 'use'");
+    return 0;
+  }
+  Token path = p->current;
+  parser_advance(p);
+  if (p->current.kind == OPERATOR && p->current.len == 1 &&
+      *p->current.start == ';')
+    parser_advance(p);
+
+  const char *name = path.start + 1;
+  size_t name_len = (size_t)path.len - 2;
+  if (name_len > 6 && memcmp(name + name_len - 6, ".modal", 6) == 0) {
+    const ModuleIface *m =
+        p->find_module ? p->find_module(p->modules, name, name_len) : NULL;
+    if (!m) {
+      parser_error_at(p, &path,
+                      "módulo %.*s só é importável por arquivo lido do disco",
+                      path.len, path.start);
+      return 1;
+    }
+    return iface_import(p, m, path, stmts, count, cap);
+  }
+
+  size_t len = 0;
+  char *text = read_header(p, name, name_len, &len);
+  if (!text) {
+    parser_error_at(p, &path, "não consegui ler o header %.*s", path.len,
+                    path.start);
+    return 1; // o use em si está certo: nada pra pular
+  }
+  AstNode *use = ast_new_use(p->alloc, path, text, len);
+  if (!use) {
+    modal_free(p->alloc, text, len + 1);
+    return 0;
+  }
+  if (!ast_list_push(p->alloc, stmts, count, cap, use)) {
+    ast_free(p->alloc, use);
+    return 0;
+  }
+
+  if (!p->imports) {
+    p->imports = modal_alloc(p->alloc, sizeof(CImport));
+    if (!p->imports)
+      return 0;
+    *p->imports = (CImport){0};
+  }
+  CReader r = {.p = p,
+               .where = path,
+               .pos = text,
+               .end = text + len,
+               .bol = 1,
+               .stmts = stmts,
+               .count = count,
+               .cap = cap};
+  size_t first = *count;
+  parse_header(&r);
+  prune_records(&r, first);
+  return 1;
+}
+
+void cimport_free(Parser *p) {
+  CImport *im = p->imports;
+  if (!im)
+    return;
+  modal_free(p->alloc, im->consts, im->consts_cap * sizeof(CConst));
+  modal_free(p->alloc, im->typedefs, im->typedefs_cap * sizeof(CTypedef));
+  modal_free(p->alloc, im, sizeof(CImport));
+  p->imports = NULL;
+}
+
+// ----- ligação -----
+
+static void bind_call(Parser *p, AstNode *program, AstNode *call,
+                      AstNode *test) {
+  AstNode *fn = find_extern(program->data.block_or_group.stmts,
+                            program->data.block_or_group.count,
+                            call->data.call.name, call->data.call.len);
+  if (!fn)
+    return; // builtin (ou erro de runtime, como antes)
+  int len = (int)call->data.call.len;
+  const char *name = call->data.call.name;
+
+  if (fn->data.native.unsupported) {
+    parser_error_at(p, &call->token, "função C '%.*s' não dá pra chamar: %s",
+                    len, name, fn->data.native.unsupported);
+    return;
+  }
+  if (call->data.call.count != fn->data.native.count) {
+    parser_error_at(p, &call->token,
+                    "'%.*s' espera %zu argumento(s), recebeu %zu", len, name,
+                    fn->data.native.count, call->data.call.count);
+    return;
+  }
+  if (!fn->data.native.addr) {
+    char symbol[256];
+    if ((size_t)len < sizeof(symbol)) {
+      memcpy(symbol, name, (size_t)len);
+      symbol[len] = '\0';
+      fn->data.native.addr = ffi_lookup(p->natives, symbol);
+    }
+    if (!fn->data.native.addr) {
+      parser_error_at(p, &call->token,
+                      "símbolo '%.*s' não encontrado (faltou --link?)", len,
+                      name);
+      return;
+    }
+  }
+  call->data.call.native = fn;
+  if (test)
+    test->data.test.native = 1;
+}
+
+static void resolve_node(Parser *p, AstNode *program, AstNode *node,
+                         AstNode *test) {
+  if (!node)
+    return;
+  switch (node->kind) {
+  case AST_IDENT: {
+    const CConst *c =
+        find_const(p->imports, node->data.ident.name, node->data.ident.len);
+    if (c) { // constante de C vira literal, como o sizeof
+      node->kind = AST_NUMBER_LIT;
+      node->data.number.value = c->value;
+      node->data.number.is_float = 0;
+    }
+    return;
+  }
+  case AST_VAR_DECL:
+    if (find_const(p->imports, node->data.var.name, node->data.var.len))
+      parser_error_at(p, &node->token,
+                      "'%.*s' é constante do header, não dá pra atribuir",
+                      (int)node->data.var.len, node->data.var.name);
+    resolve_node(p, program, node->data.var.init, test);
+    return;
+  case AST_CALL:
+    for (size_t i = 0; i < node->data.call.count; i++)
+      resolve_node(p, program, node->data.call.args[i], test);
+    bind_call(p, program, node, test);
+    return;
+  case AST_BIN_OP:
+  case AST_RANGE:
+    resolve_node(p, program, node->data.binop.left, test);
+    resolve_node(p, program, node->data.binop.right, test);
+    return;
+  case AST_ASSERT_STMT:
+    resolve_node(p, program, node->data.unary.expr, test);
+    resolve_node(p, program, node->data.unary.message, test);
+    return;
+  case AST_UNARY_OP:
+  case AST_ASYNC_BLOCK:
+  case AST_DEFER_STMT:
+    resolve_node(p, program, node->data.unary.expr, test);
+    return;
+  case AST_FORMAT:
+    for (size_t i = 0; i < node->data.format.count; i++)
+      resolve_node(p, program, node->data.format.parts[i].expr, test);
+    return;
+  case AST_PIPELINE:
+    resolve_node(p, program, node->data.pipeline.source, test);
+    for (size_t i = 0; i < node->data.pipeline.count; i++)
+      resolve_node(p, program, node->data.pipeline.stages[i].expr, test);
+    return;
+  case AST_TEST_STMT:
+    resolve_node(p, program, node->data.test.block, node);
+    return;
+  case AST_BLOCK:
+  case AST_PAREN_GROUP:
+    for (size_t i = 0; i < node->data.block_or_group.count; i++)
+      resolve_node(p, program, node->data.block_or_group.stmts[i], test);
+    return;
+  default:
+    return;
+  }
+}
+
+void resolve_externs(Parser *p, AstNode *program) {
+  if (!p->imports || !program || program->kind != AST_BLOCK)
+    return; // sem use, nada pra ligar
+  for (size_t i = 0; i < program->data.block_or_group.count; i++)
+    resolve_node(p, program, program->data.block_or_group.stmts[i], NULL);
+}
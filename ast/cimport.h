@@ -0,0 +1,24 @@
+// cimport.h — use "foo.h": declarações C viram símbolos do Modal
+#ifndef CIMPORT_H
+#define CIMPORT_H
+
+#include "parser.h"
+
+// `use` já é o token atual. "x.modal" sai de p->find_module (iface.h);
+// senão lê o header (relativo ao arquivo .modal) e empurra pro topo do
+// programa o AST_USE, dono do texto, seguido das struct/union (layout de C,
+// sem reorder) e dos protótipos (AST_EXTERN_FN).
+// Constantes (#define NOME inteiro, enum) e typedefs ficam em p->imports
+// até resolve_externs. 0 se o próprio `use` está malformado (quem chama
+// sincroniza); header ilegível é reportado e não pede sincronização
+int parse_use(Parser *p, AstNode ***stmts, size_t *count, size_t *cap);
+
+// Fim do parse: liga cada chamada ao protótipo (aridade, assinatura e
+// endereço via dlsym em p->natives), troca constante de C pelo valor e
+// marca os tests que chamam C
+void resolve_externs(Parser *p, AstNode *program);
+
+// Libera p->imports; parse_program chama sempre, com ou sem erro
+void cimport_free(Parser *p);
+
+#endif
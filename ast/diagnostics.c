@@ -0,0 +1,308 @@
+#include "diagnostics.h"
+#include <stdio.h>
+#include <string.h>
+
+// Buffer de saída que cresce — tudo vai pra cá antes do fwrite
+typedef struct {
+  const ModalAllocator *alloc;
+  char *data;
+  size_t len, cap;
+  int failed;
+} StrBuf;
+
+static int sb_reserve(StrBuf *sb, size_t extra) {
+  if (sb->failed)
+    return 0;
+  if (sb->len + extra + 1 <= sb->cap)
+    return 1;
+  size_t cap = sb->cap ? sb->cap : 256;
+  while (cap < sb->len + extra + 1)
+    cap *= 2;
+  char *data = modal_realloc(sb->alloc, sb->data, sb->cap, cap);
+  if (!data) {
+    sb->failed = 1;
+    return 0;
+  }
+  sb->data = data;
+  sb->cap = cap;
+  return 1;
+}
+
+static void sb_append(StrBuf *sb, const char *s, size_t n) {
+  if (!sb_reserve(sb, n))
+    return;
+  memcpy(sb->data + sb->len, s, n);
+  sb->len += n;
+}
+
+static void sb_fill(StrBuf *sb, char c, size_t n) {
+  if (!sb_reserve(sb, n))
+    return;
+  memset(sb->data + sb->len, c, n);
+  sb->len += n;
+}
+
+static void sb_printf(StrBuf *sb, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  va_list copy;
+  va_copy(copy, args);
+  int n = vsnprintf(NULL, 0, fmt, copy);
+  va_end(copy);
+  if (n > 0 && sb_reserve(sb, (size_t)n)) {
+    vsnprintf(sb->data + sb->len, (size_t)n + 1, fmt, args);
+    sb->len += (size_t)n;
+  }
+  va_end(args);
+}
+
+static void sb_flush(StrBuf *sb, FILE *out) {
+  if (sb->len)
+    fwrite(sb->data, 1, sb->len, out);
+  fflush(out);
+  modal_free(sb->alloc, sb->data, sb->cap);
+  *sb = (StrBuf){.alloc = sb->alloc};
+}
+
+static char *dup_range(const ModalAllocator *a, const char *s, size_t n) {
+  char *out = modal_alloc(a, n + 1);
+  if (!out)
+    return NULL;
+  if (n)
+    memcpy(out, s, n);
+  out[n] = '\0';
+  return out;
+}
+
+void diag_init(Diagnostics *d, const ModalAllocator *alloc,
+               const char *filename, size_t max_errors) {
+  *d = (Diagnostics){
+      .alloc = alloc ? alloc : modal_heap_allocator(),
+      .filename = filename,
+      .max_errors = max_errors,
+      .last_line = -1,
+  };
+}
+
+void diag_free(Diagnostics *d) {
+  for (size_t i = 0; i < d->count; i++) {
+    Diagnostic *it = &d->items[i];
+    modal_free(d->alloc, it->message, strlen(it->message) + 1);
+    if (it->source_line)
+      modal_free(d->alloc, it->source_line, (size_t)it->source_len + 1);
+    if (it->file)
+      modal_free(d->alloc, it->file, strlen(it->file) + 1);
+  }
+  modal_free(d->alloc, d->items, d->cap * sizeof(Diagnostic));
+  d->items = NULL;
+  d->count = d->cap = 0;
+}
+
+int diag_limit_reached(const Diagnostics *d) {
+  return d->max_errors && d->error_count >= d->max_errors;
+}
+
+int diag_drops(const Diagnostics *d, DiagSeverity severity, const Token *tok) {
+  return severity == DIAG_ERROR &&
+         (tok->line == d->last_line || diag_limit_reached(d));
+}
+
+int diag_report(Diagnostics *d, DiagSeverity severity, const Token *tok,
+                const char *line_start, int line_len, const char *fmt,
+                va_list args) {
+  return diag_report_file(d, severity, NULL, tok, line_start, line_len, fmt,
+                          args);
+}
+
+int diag_report_file(Diagnostics *d, DiagSeverity severity, const char *file,
+                     const Token *tok, const char *line_start, int line_len,
+                     const char *fmt, va_list args) {
+  if (diag_drops(d, severity, tok)) {
+    d->dropped++;
+    return 0;
+  }
+
+  if (d->count == d->cap) {
+    size_t cap = d->cap ? d->cap * 2 : 8;
+    Diagnostic *items = modal_realloc(d->alloc, d->items,
+                                      d->cap * sizeof(Diagnostic),
+                                      cap * sizeof(Diagnostic));
+    if (!items) {
+      d->dropped++;
+      return 0;
+    }
+    d->items = items;
+    d->cap = cap;
+  }
+
+  char stack_msg[256];
+  va_list copy;
+  va_copy(copy, args);
+  int n = vsnprintf(stack_msg, sizeof(stack_msg), fmt, copy);
+  va_end(copy);
+  if (n < 0)
+    n = 0;
+
+  char *message = modal_alloc(d->alloc, (size_t)n + 1);
+  if (!message) {
+    d->dropped++;
+    return 0;
+  }
+  if ((size_t)n < sizeof(stack_msg))
+    memcpy(message, stack_msg, (size_t)n + 1);
+  else
+    vsnprintf(message, (size_t)n + 1, fmt, args);
+
+  d->items[d->count++] = (Diagnostic){
+      .severity = severity,
+      .line = tok->line,
+      .col = tok->col,
+      .len = tok->len,
+      .message = message,
+      .source_line =
+          line_start ? dup_range(d->alloc, line_start, (size_t)line_len) : NULL,
+      .source_len = line_start ? line_len : 0,
+      .file = file ? dup_range(d->alloc, file, strlen(file)) : NULL,
+  };
+
+  if (severity == DIAG_ERROR) {
+    d->error_count++;
+    d->last_line = tok->line;
+  }
+  return 1;
+}
+
+static const char *severity_label(DiagSeverity s) {
+  switch (s) {
+  case DIAG_WARNING:
+    return "Aviso";
+  case DIAG_NOTE:
+    return "Nota";
+  default:
+    return "Erro";
+  }
+}
+
+static const char *severity_json(DiagSeverity s) {
+  switch (s) {
+  case DIAG_WARNING:
+    return "warning";
+  case DIAG_NOTE:
+    return "note";
+  default:
+    return "error";
+  }
+}
+
+void diag_render(const Diagnostics *d, FILE *out) {
+  StrBuf sb = {.alloc = d->alloc};
+
+  for (size_t i = 0; i < d->count; i++) {
+    const Diagnostic *it = &d->items[i];
+    sb_printf(&sb, "%s [%s:%d:%d]: %s\n", severity_label(it->severity),
+              it->file ? it->file : d->filename, it->line, it->col,
+              it->message);
+    if (!it->source_line)
+      continue;
+
+    // linha numerada — por quê? Legível
+    sb_printf(&sb, "%3d | %s\n", it->line, it->source_line);
+    sb_append(&sb, "    | ", 6);
+
+    // Copia os tabs da linha pro alinhamento do ^ bater no terminal
+    int pad = it->col - 1;
+    if (pad > it->source_len)
+      pad = it->source_len;
+    for (int c = 0; c < pad; c++) {
+      char ch = it->source_line[c];
+      if (ch == '\t')
+        sb_append(&sb, "\t", 1);
+      else
+        sb_append(&sb, " ", 1);
+    }
+    sb_append(&sb, "^", 1);
+    if (it->len > 1)
+      sb_fill(&sb, '~', (size_t)it->len - 1);
+    sb_append(&sb, "\n", 1);
+  }
+
+  if (d->dropped)
+    sb_printf(&sb, "(%zu diagnóstico(s) suprimido(s): mesma linha ou acima "
+                   "de --max-errors)\n",
+              d->dropped);
+
+  sb_flush(&sb, out);
+}
+
+static void json_string(StrBuf *sb, const char *s) {
+  sb_append(sb, "\"", 1);
+  for (; *s; s++) {
+    unsigned char c = (unsigned char)*s;
+    switch (c) {
+    case '"':
+      sb_append(sb, "\\\"", 2);
+      break;
+    case '\\':
+      sb_append(sb, "\\\\", 2);
+      break;
+    case '\n':
+      sb_append(sb, "\\n", 2);
+      break;
+    case '\t':
+      sb_append(sb, "\\t", 2);
+      break;
+    default:
+      if (c < 0x20)
+        sb_printf(sb, "\\u%04x", c);
+      else
+        sb_append(sb, (const char *)&c, 1);
+    }
+  }
+  sb_append(sb, "\"", 1);
+}
+
+void diag_render_json(const Diagnostics *d, FILE *out) {
+  diag_render_json_many(&d, 1, out);
+}
+
+void diag_render_json_many(const Diagnostics *const *ds, size_t n,
+                           FILE *out) {
+  if (!n)
+    return;
+  StrBuf sb = {.alloc = ds[0]->alloc};
+
+  sb_append(&sb, "[", 1);
+  int first = 1;
+  for (size_t k = 0; k < n; k++) {
+    const Diagnostics *d = ds[k];
+    for (size_t i = 0; i < d->count; i++) {
+      const Diagnostic *it = &d->items[i];
+      if (!first)
+        sb_append(&sb, ",", 1);
+      first = 0;
+      sb_printf(&sb, "{\"severity\":\"%s\",\"file\":",
+                severity_json(it->severity));
+      json_string(&sb, it->file       ? it->file
+                       : d->filename ? d->filename
+                                     : "");
+      sb_printf(&sb, ",\"line\":%d,\"col\":%d,\"len\":%d,\"message\":",
+                it->line, it->col, it->len);
+      json_string(&sb, it->message);
+      sb_append(&sb, "}", 1);
+    }
+  }
+  sb_append(&sb, "]\n", 2);
+
+  sb_flush(&sb, out);
+}
+
+void diag_render_json_error(const char *file, const char *message,
+                            FILE *out) {
+  StrBuf sb = {.alloc = modal_heap_allocator()};
+  sb_printf(&sb, "[{\"severity\":\"error\",\"file\":");
+  json_string(&sb, file);
+  sb_printf(&sb, ",\"line\":0,\"col\":0,\"len\":0,\"message\":");
+  json_string(&sb, message);
+  sb_append(&sb, "}]\n", 3);
+  sb_flush(&sb, out);
+}
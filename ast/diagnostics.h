@@ -0,0 +1,72 @@
+// diagnostics.h
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include "../builtin/allocators.h"
+#include "../tokenizer/tokenizer.h" // Token
+#include <stdarg.h>
+#include <stdio.h>
+
+typedef enum {
+  DIAG_ERROR,
+  DIAG_WARNING,
+  DIAG_NOTE,
+} DiagSeverity;
+
+typedef struct {
+  DiagSeverity severity;
+  int line;
+  int col;
+  int len;            // tamanho do token apontado (vira ^~~~)
+  char *message;      // já formatada, dona da memória
+  char *source_line;  // cópia da linha — por quê? O buffer pode não
+  int source_len;     // existir mais quando renderizar
+  char *file;         // NULL = Diagnostics.filename; senão o #include
+} Diagnostic;
+
+// Diagnósticos acumulados em memória e renderizados de uma vez no fim. Só o
+// primeiro erro de cada linha entra — por quê? Recovery do parser gera
+// cascata na mesma linha que não ajuda ninguém
+typedef struct {
+  const ModalAllocator *alloc;
+  const char *filename;
+  Diagnostic *items;
+  size_t count, cap;
+  size_t error_count;
+  size_t max_errors; // 0 = sem limite
+  size_t dropped;    // deduplicados ou acima do limite
+  int last_line;
+} Diagnostics;
+
+void diag_init(Diagnostics *d, const ModalAllocator *alloc,
+               const char *filename, size_t max_errors);
+void diag_free(Diagnostics *d);
+
+// line_start/line_len: linha do fonte onde tok está (pode ser NULL/0).
+// Retorna 1 se entrou na lista
+int diag_report(Diagnostics *d, DiagSeverity severity, const Token *tok,
+                const char *line_start, int line_len, const char *fmt,
+                va_list args);
+// Idem, num arquivo que não é o do parse (token vindo de #include)
+int diag_report_file(Diagnostics *d, DiagSeverity severity, const char *file,
+                     const Token *tok, const char *line_start, int line_len,
+                     const char *fmt, va_list args);
+
+// Chegou no --max-errors? Parser usa pra parar cedo
+int diag_limit_reached(const Diagnostics *d);
+// O diag_report desse tok vai só pro dropped (mesma linha do último erro,
+// ou acima do limite)? Quem chama pula o trabalho de achar a linha
+int diag_drops(const Diagnostics *d, DiagSeverity severity, const Token *tok);
+
+// Texto com a linha do fonte e ^, num único fwrite
+void diag_render(const Diagnostics *d, FILE *out);
+// Array JSON compacto, um objeto por diagnóstico, também num único fwrite
+void diag_render_json(const Diagnostics *d, FILE *out);
+// Um array só pros diagnósticos de vários arquivos (programa com módulos)
+void diag_render_json_many(const Diagnostics *const *ds, size_t n,
+                           FILE *out);
+// Um erro sem posição (arquivo que nem abriu) no mesmo formato — por quê?
+// Com --json-diagnostics o stderr inteiro tem que continuar JSON
+void diag_render_json_error(const char *file, const char *message, FILE *out);
+
+#endif
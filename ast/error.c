@@ -1,39 +1,51 @@
 #include "parser.h"
-#include <ctype.h> // isprint pra sanitizar output
+#include "preproc.h"
 #include <stdarg.h>
 #include <stdio.h>
 
-// Mostra erro com linha do fonte e ^
+// Guarda o erro com a linha do fonte; quem renderiza é diag_render no fim
 void parser_error_at(Parser *p, Token *tok, const char *fmt, ...) {
   p->had_error = 1; // flag global — por quê? Pra main saber se parse deu bom
+  if (p->halted)
+    return; // depois da parada é tudo EOF: "espera '}'" não diz nada
 
-  fprintf(stderr, "Erro [%s:%d:%d]: ", p->filename, tok->line, tok->col);
+  // Pega linha do buffer — por quê? Mostra contexto todo no render. Erro
+  // que vai ser descartado não procura: achar a linha anda até o começo
+  // dela, e uma linha longa com um erro por token ficava quadrática
+  const char *line_start = NULL, *file = NULL;
+  int line_len = 0;
+  if (!diag_drops(&p->diag, DIAG_ERROR, tok) &&
+      !pp_locate(p, tok, &file, &line_start, &line_len) &&
+      !tokenizer_line_at(p->lexer, tok, &line_start, &line_len))
+    line_start = NULL; // modo stream: linha já saiu da janela
 
   va_list args;
   va_start(args, fmt);
-  vfprintf(
-      stderr, fmt,
-      args); // mensagem flexível — por quê? Como printf, fácil usar %s %d etc.
+  diag_report_file(&p->diag, DIAG_ERROR, file, tok, line_start, line_len, fmt,
+                   args);
   va_end(args);
-  fprintf(stderr, "\n");
 
-  // Pega linha do buffer
-  const char *line_start = tok->start;
-  while (line_start > p->lexer->buffer && *(line_start - 1) != '\n') {
-    line_start--; // volta até começo da linha — por quê? Mostra contexto todo
+  // --max-errors: para o parse aqui — por quê? Arquivo gerado quebrado não
+  // precisa de 10 mil erros, o resto vira EOF
+  if (diag_limit_reached(&p->diag)) {
+    p->halted = 1;
+    p->current = token_make(TOK_EOF, p->current.start, 0, p->current.line,
+                            p->current.col);
   }
-  const char *line_end = tok->start;
-  while (*line_end && *line_end != '\n')
-    line_end++; // até fim
+}
 
-  fprintf(stderr, "%3d | %.*s\n", tok->line, (int)(line_end - line_start),
-          line_start); // linha numerada — por quê? Legível
+void parser_warn_at(Parser *p, Token *tok, const char *fmt, ...) {
+  const char *line_start = NULL, *file = NULL;
+  int line_len = 0;
+  if (!pp_locate(p, tok, &file, &line_start, &line_len) &&
+      !tokenizer_line_at(p->lexer, tok, &line_start, &line_len))
+    line_start = NULL;
 
-  fprintf(stderr, "      | "); // alinhamento
-  for (int i = 1; i < tok->col; i++)
-    fputc(' ', stderr); // espaços até coluna
-  fputc('^', stderr);   // o ^
-  fprintf(stderr, "\n");
+  va_list args;
+  va_start(args, fmt);
+  diag_report_file(&p->diag, DIAG_WARNING, file, tok, line_start, line_len,
+                   fmt, args);
+  va_end(args);
 }
 
 // Pula até próximo sync point (ex: ; ou })
@@ -45,6 +57,13 @@ void parser_synchronize(Parser *p) {
     switch (p->current.kind) { // keywords que começam novo stmt
     case TEST:
     case ASSERT:
+    case ASYNC:
+    case AWAIT:
+    case DEFER:
+    case AUTOFREE:
+    case STRUCT:
+    case UNION:
+    case USE:
     case LBRACE:
     case RBRACE:
       return; // sync aqui — por quê? Continua parseando o resto do arquivo
@@ -0,0 +1,187 @@
+#include "ast.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Um autofree escapa do escopo quando o valor precisa viver além do frame
+// nativo do executor: um `async` posterior captura o nome (a tarefa filha
+// pode rodar depois do bloco sair) ou um `await` posterior suspende a
+// corrotina com o binding vivo. Os outros viram slot de pilha
+
+// Nomes citados pelos async depois do statement atual — por quê juntar?
+// Perguntar a cada autofree pelo resto do bloco era quadrático
+typedef struct {
+  const char *name; // NULL: vazio
+  size_t len;
+} Name;
+
+typedef struct {
+  Name *slots; // potência de 2
+  size_t count, cap;
+  int oom; // sem memória: todo autofree escapa, o que é sempre correto
+} NameSet;
+
+static Name *name_slot(const NameSet *set, const char *name, size_t len) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < len; i++)
+    h = (h ^ (uint8_t)name[i]) * 0x100000001b3ULL;
+  size_t mask = set->cap - 1;
+  for (size_t j = (size_t)h & mask;; j = (j + 1) & mask) {
+    Name *n = &set->slots[j];
+    if (!n->name || (n->len == len && memcmp(n->name, name, len) == 0))
+      return n;
+  }
+}
+
+static int name_seen(const NameSet *set, const char *name, size_t len) {
+  return set->oom || (set->cap && name_slot(set, name, len)->name);
+}
+
+static void name_add(NameSet *set, const char *name, size_t len) {
+  if (set->oom)
+    return;
+  if ((set->count + 1) * 2 > set->cap) {
+    NameSet bigger = {.cap = set->cap ? set->cap * 2 : 16};
+    bigger.slots = calloc(bigger.cap, sizeof(Name));
+    if (!bigger.slots) {
+      set->oom = 1;
+      return;
+    }
+    for (size_t i = 0; i < set->cap; i++)
+      if (set->slots[i].name)
+        *name_slot(&bigger, set->slots[i].name, set->slots[i].len) =
+            set->slots[i];
+    bigger.count = set->count;
+    free(set->slots);
+    *set = bigger;
+  }
+  Name *n = name_slot(set, name, len);
+  if (!n->name) {
+    *n = (Name){name, len};
+    set->count++;
+  }
+}
+
+// Todo nome lido ou escrito em node: x = x + 1 conta os dois
+static void collect_names(NameSet *set, const AstNode *node) {
+  if (!node)
+    return;
+  switch (node->kind) {
+  case AST_IDENT:
+    name_add(set, node->data.ident.name, node->data.ident.len);
+    return;
+  case AST_BIN_OP:
+  case AST_RANGE:
+    collect_names(set, node->data.binop.left);
+    collect_names(set, node->data.binop.right);
+    return;
+  case AST_ASSERT_STMT:
+    collect_names(set, node->data.unary.expr);
+    collect_names(set, node->data.unary.message);
+    return;
+  case AST_UNARY_OP:
+  case AST_ASYNC_BLOCK:
+  case AST_DEFER_STMT:
+    collect_names(set, node->data.unary.expr);
+    return;
+  case AST_FORMAT:
+    for (size_t i = 0; i < node->data.format.count; i++)
+      collect_names(set, node->data.format.parts[i].expr);
+    return;
+  case AST_CALL:
+    for (size_t i = 0; i < node->data.call.count; i++)
+      collect_names(set, node->data.call.args[i]);
+    return;
+  case AST_PIPELINE:
+    collect_names(set, node->data.pipeline.source);
+    for (size_t i = 0; i < node->data.pipeline.count; i++)
+      collect_names(set, node->data.pipeline.stages[i].expr);
+    return;
+  case AST_VAR_DECL:
+    name_add(set, node->data.var.name, node->data.var.len);
+    collect_names(set, node->data.var.init);
+    return;
+  case AST_BLOCK:
+  case AST_PAREN_GROUP:
+    for (size_t i = 0; i < node->data.block_or_group.count; i++)
+      collect_names(set, node->data.block_or_group.stmts[i]);
+    return;
+  default:
+    return;
+  }
+}
+
+// O que um statement faz com os autofree de antes dele: os nomes que os
+// async dele capturam vão pra set; retorna 1 se ele suspende (await)
+static int escape_effects(const AstNode *node, NameSet *set) {
+  if (!node)
+    return 0;
+  switch (node->kind) {
+  case AST_AWAIT_STMT:
+    return 1;
+  case AST_ASYNC_BLOCK:
+    collect_names(set, node->data.unary.expr);
+    return escape_effects(node->data.unary.expr, set);
+  case AST_BLOCK: {
+    int suspends = 0;
+    for (size_t i = 0; i < node->data.block_or_group.count; i++)
+      suspends |= escape_effects(node->data.block_or_group.stmts[i], set);
+    return suspends;
+  }
+  default:
+    return 0; // defer não suspende (parse_defer garante)
+  }
+}
+
+// De trás pra frente: quando chega no autofree, set e suspends já têm tudo
+// que vem depois dele. Os slots saem na ordem do bloco, numa segunda volta
+static void analyze_block(AstNode *block) {
+  AstNode **stmts = block->data.block_or_group.stmts;
+  size_t count = block->data.block_or_group.count;
+
+  NameSet set = {0};
+  int suspends = 0;
+  for (size_t i = count; i-- > 0;) {
+    AstNode *stmt = stmts[i];
+    if (!stmt)
+      continue;
+    ast_escape_analyze(stmt);
+    if (stmt->kind == AST_VAR_DECL && stmt->data.var.autofree)
+      stmt->data.var.slot =
+          suspends ||
+                  name_seen(&set, stmt->data.var.name, stmt->data.var.len)
+              ? -1
+              : 0;
+    suspends |= escape_effects(stmt, &set);
+  }
+  free(set.slots);
+
+  unsigned *slots = &block->data.block_or_group.stack_slots;
+  *slots = 0;
+  for (size_t i = 0; i < count; i++) {
+    AstNode *stmt = stmts[i];
+    if (stmt && stmt->kind == AST_VAR_DECL && stmt->data.var.autofree)
+      stmt->data.var.slot =
+          stmt->data.var.slot == 0 && *slots < AST_STACK_SLOTS
+              ? (int)(*slots)++
+              : -1;
+  }
+}
+
+void ast_escape_analyze(AstNode *node) {
+  if (!node)
+    return;
+  switch (node->kind) {
+  case AST_BLOCK:
+    analyze_block(node);
+    break;
+  case AST_TEST_STMT:
+    ast_escape_analyze(node->data.test.block);
+    break;
+  case AST_ASYNC_BLOCK:
+  case AST_DEFER_STMT:
+    ast_escape_analyze(node->data.unary.expr);
+    break;
+  default:
+    break;
+  }
+}
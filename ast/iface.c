@@ -0,0 +1,419 @@
+#include "iface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IFACE_MAGIC "MODALMI2"
+
+typedef struct {
+  char magic[8];
+  char version[16]; // MODAL_VERSION com '\0' no fim
+  uint64_t source_hash, export_hash;
+  uint64_t ndeps, nfiles, nrecords, nfields, ntests, strings_len;
+} IfaceHeader;
+
+void iface_init(ModuleIface *m) { *m = (ModuleIface){0}; }
+
+void iface_free(ModuleIface *m) {
+  free(m->deps);
+  free(m->files);
+  free(m->records);
+  free(m->fields);
+  free(m->tests);
+  free(m->strings);
+  iface_init(m);
+}
+
+// Cresce *items em dobro até caber need (malloc direto, como o TestCache —
+// a interface não pertence à AST)
+static int grow(void **items, size_t *cap, size_t need, size_t size) {
+  if (need <= *cap)
+    return 1;
+  size_t n = *cap ? *cap : 16;
+  while (n < need)
+    n *= 2;
+  void *p = realloc(*items, n * size);
+  if (!p)
+    return 0;
+  *items = p;
+  *cap = n;
+  return 1;
+}
+
+static int add_str(ModuleIface *m, const char *s, size_t len, IfaceStr *out) {
+  if (!grow((void **)&m->strings, &m->strings_cap, m->strings_len + len + 1,
+            1))
+    return 0;
+  memcpy(m->strings + m->strings_len, s, len);
+  m->strings[m->strings_len + len] = '\0';
+  *out = (IfaceStr){(uint32_t)m->strings_len, (uint32_t)len};
+  m->strings_len += len + 1;
+  return 1;
+}
+
+static const char *str_at(const ModuleIface *m, IfaceStr s) {
+  return m->strings + s.off;
+}
+
+// ----- export hash -----
+
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t mix(uint64_t h, const void *data, size_t len) {
+  const unsigned char *b = data;
+  for (size_t i = 0; i < len; i++) {
+    h ^= b[i];
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+static uint64_t mix_str(uint64_t h, const ModuleIface *m, IfaceStr s) {
+  h = mix(h, &s.len, sizeof(s.len));
+  return mix(h, str_at(m, s), s.len);
+}
+
+// Nomes e números, não offsets no blob — por quê? Renomear um test muda o
+// blob, mas não o que o dependente enxerga
+static uint64_t export_hash(const ModuleIface *m) {
+  uint64_t h = ast_hash_bytes(IFACE_MAGIC, 8);
+  for (size_t i = 0; i < m->nrecords; i++) {
+    const IfaceRecord *r = &m->records[i];
+    h = mix_str(h, m, r->name);
+    h = mix(h, &r->is_union, sizeof(r->is_union));
+    h = mix(h, &r->size, sizeof(r->size));
+    h = mix(h, &r->align, sizeof(r->align));
+    h = mix(h, &r->count, sizeof(r->count));
+    for (uint32_t j = 0; j < r->count; j++) {
+      const IfaceField *f = &m->fields[r->first + j];
+      h = mix_str(h, m, f->name);
+      h = mix_str(h, m, f->type);
+      h = mix(h, &f->count, sizeof(f->count));
+      h = mix(h, &f->offset, sizeof(f->offset));
+    }
+  }
+  return h;
+}
+
+// ----- build -----
+
+static int add_record(ModuleIface *m, const AstNode *rec) {
+  if (!grow((void **)&m->records, &m->records_cap, m->nrecords + 1,
+            sizeof(IfaceRecord)) ||
+      !grow((void **)&m->fields, &m->fields_cap,
+            m->nfields + rec->data.record.count, sizeof(IfaceField)))
+    return 0;
+
+  IfaceRecord r = {.is_union = (uint32_t)rec->data.record.is_union,
+                   .reorder = (uint32_t)rec->data.record.reorder,
+                   .size = rec->data.record.size,
+                   .align = rec->data.record.align,
+                   .declared_size = rec->data.record.declared_size,
+                   .first = (uint32_t)m->nfields,
+                   .count = (uint32_t)rec->data.record.count};
+  if (!add_str(m, rec->data.record.name, rec->data.record.len, &r.name))
+    return 0;
+  for (size_t i = 0; i < rec->data.record.count; i++) {
+    const AstNode *f = rec->data.record.fields[i];
+    IfaceField out = {.count = f->data.field.count,
+                      .size = f->data.field.size,
+                      .align = f->data.field.align,
+                      .offset = f->data.field.offset,
+                      .hot = (uint32_t)f->data.field.hot};
+    if (!add_str(m, f->data.field.name, f->data.field.len, &out.name) ||
+        !add_str(m, f->data.field.type, f->data.field.type_len, &out.type))
+      return 0;
+    m->fields[m->nfields++] = out;
+  }
+  m->records[m->nrecords++] = r;
+  return 1;
+}
+
+static int add_test(ModuleIface *m, const AstNode *test) {
+  if (!grow((void **)&m->tests, &m->tests_cap, m->ntests + 1,
+            sizeof(IfaceTest)))
+    return 0;
+  IfaceTest t = {.native = (uint32_t)test->data.test.native,
+                 .hash = ast_hash(test)};
+  if (!add_str(m, test->data.test.name, test->data.test.len, &t.name))
+    return 0;
+  m->tests[m->ntests++] = t;
+  return 1;
+}
+
+int iface_build(ModuleIface *m, const AstNode *program, uint64_t source_hash) {
+  iface_free(m);
+  m->source_hash = source_hash;
+  if (!program || program->kind != AST_BLOCK)
+    return 0;
+
+  for (size_t i = 0; i < program->data.block_or_group.count; i++) {
+    const AstNode *stmt = program->data.block_or_group.stmts[i];
+    int ok = 1;
+    if (stmt && stmt->kind == AST_STRUCT_DECL && !stmt->data.record.imported)
+      ok = add_record(m, stmt);
+    else if (stmt && stmt->kind == AST_TEST_STMT)
+      ok = add_test(m, stmt);
+    if (!ok)
+      return 0;
+  }
+  m->export_hash = export_hash(m);
+  return 1;
+}
+
+int iface_add_dep(ModuleIface *m, const char *name, size_t len, Token where,
+                  uint64_t export_hash) {
+  if (!grow((void **)&m->deps, &m->deps_cap, m->ndeps + 1, sizeof(IfaceDep)))
+    return 0;
+  IfaceDep d = {.line = where.line,
+                .col = where.col,
+                .offset = where.offset,
+                .export_hash = export_hash};
+  if (!add_str(m, name, len, &d.name))
+    return 0;
+  m->deps[m->ndeps++] = d;
+  return 1;
+}
+
+int iface_add_files(ModuleIface *m, const FileDeps *deps) {
+  if (!grow((void **)&m->files, &m->files_cap, m->nfiles + deps->count,
+            sizeof(IfaceFile)))
+    return 0;
+  for (size_t i = 0; i < deps->count; i++) {
+    IfaceFile f = {.hash = deps->hashes[i]};
+    if (!add_str(m, deps->paths[i], strlen(deps->paths[i]), &f.path))
+      return 0;
+    m->files[m->nfiles++] = f;
+  }
+  return 1;
+}
+
+// ----- disco -----
+
+static void make_header(IfaceHeader *h, const ModuleIface *m) {
+  memset(h, 0, sizeof(*h));
+  memcpy(h->magic, IFACE_MAGIC, sizeof(h->magic));
+  strncpy(h->version, MODAL_VERSION, sizeof(h->version) - 1);
+  if (!m)
+    return;
+  h->source_hash = m->source_hash;
+  h->export_hash = m->export_hash;
+  h->ndeps = m->ndeps;
+  h->nfiles = m->nfiles;
+  h->nrecords = m->nrecords;
+  h->nfields = m->nfields;
+  h->ntests = m->ntests;
+  h->strings_len = m->strings_len;
+}
+
+int iface_write(const ModuleIface *m, const char *path) {
+  size_t len = strlen(path);
+  char *tmp = malloc(len + 5);
+  if (!tmp)
+    return 0;
+  memcpy(tmp, path, len);
+  memcpy(tmp + len, ".tmp", 5);
+
+  FILE *f = fopen(tmp, "wb");
+  if (!f) {
+    free(tmp);
+    return 0;
+  }
+  IfaceHeader h;
+  make_header(&h, m);
+  int ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+           fwrite(m->deps, sizeof(IfaceDep), m->ndeps, f) == m->ndeps &&
+           fwrite(m->files, sizeof(IfaceFile), m->nfiles, f) == m->nfiles &&
+           fwrite(m->records, sizeof(IfaceRecord), m->nrecords, f) ==
+               m->nrecords &&
+           fwrite(m->fields, sizeof(IfaceField), m->nfields, f) ==
+               m->nfields &&
+           fwrite(m->tests, sizeof(IfaceTest), m->ntests, f) == m->ntests &&
+           fwrite(m->strings, 1, m->strings_len, f) == m->strings_len;
+  ok = (fclose(f) == 0) && ok;
+
+  if (ok)
+    ok = rename(tmp, path) == 0;
+  else
+    remove(tmp);
+  free(tmp);
+  return ok;
+}
+
+static int read_array(FILE *f, void **items, size_t *cap, size_t count,
+                      size_t size) {
+  if (!count)
+    return 1;
+  return grow(items, cap, count, size) && fread(*items, size, count, f) == count;
+}
+
+static int str_ok(const ModuleIface *m, IfaceStr s) {
+  return (size_t)s.off + s.len < m->strings_len;
+}
+
+// Não confia no disco: todo trecho e toda fatia dentro dos limites
+static int validate(const ModuleIface *m) {
+  for (size_t i = 0; i < m->ndeps; i++)
+    if (!str_ok(m, m->deps[i].name))
+      return 0;
+  for (size_t i = 0; i < m->nfiles; i++)
+    if (!str_ok(m, m->files[i].path))
+      return 0;
+  for (size_t i = 0; i < m->nrecords; i++) {
+    const IfaceRecord *r = &m->records[i];
+    if (!str_ok(m, r->name) || r->first > m->nfields ||
+        r->count > m->nfields - r->first)
+      return 0;
+  }
+  for (size_t i = 0; i < m->nfields; i++)
+    if (!str_ok(m, m->fields[i].name) || !str_ok(m, m->fields[i].type))
+      return 0;
+  for (size_t i = 0; i < m->ntests; i++)
+    if (!str_ok(m, m->tests[i].name))
+      return 0;
+  return 1;
+}
+
+int iface_read(ModuleIface *m, const char *path) {
+  iface_init(m);
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return 0;
+
+  IfaceHeader want, got;
+  make_header(&want, NULL);
+  long size = -1;
+  if (fseek(f, 0, SEEK_END) == 0)
+    size = ftell(f);
+  int ok = size >= (long)sizeof(got) && fseek(f, 0, SEEK_SET) == 0 &&
+           fread(&got, sizeof(got), 1, f) == 1 &&
+           memcmp(got.magic, want.magic, sizeof(want.magic)) == 0 &&
+           memcmp(got.version, want.version, sizeof(want.version)) == 0;
+
+  // Contagens contra o tamanho do arquivo antes de alocar
+  if (ok) {
+    uint64_t body = (uint64_t)size - sizeof(got);
+    uint64_t need = 0;
+    uint64_t parts[6][2] = {{got.ndeps, sizeof(IfaceDep)},
+                            {got.nfiles, sizeof(IfaceFile)},
+                            {got.nrecords, sizeof(IfaceRecord)},
+                            {got.nfields, sizeof(IfaceField)},
+                            {got.ntests, sizeof(IfaceTest)},
+                            {got.strings_len, 1}};
+    for (int i = 0; ok && i < 6; i++) {
+      ok = parts[i][0] <= body / parts[i][1] &&
+           need + parts[i][0] * parts[i][1] <= body;
+      need += ok ? parts[i][0] * parts[i][1] : 0;
+    }
+    ok = ok && need == body;
+  }
+  if (ok) {
+    m->source_hash = got.source_hash;
+    m->export_hash = got.export_hash;
+    m->ndeps = got.ndeps;
+    m->nfiles = got.nfiles;
+    m->nrecords = got.nrecords;
+    m->nfields = got.nfields;
+    m->ntests = got.ntests;
+    m->strings_len = got.strings_len;
+    ok = read_array(f, (void **)&m->deps, &m->deps_cap, m->ndeps,
+                    sizeof(IfaceDep)) &&
+         read_array(f, (void **)&m->files, &m->files_cap, m->nfiles,
+                    sizeof(IfaceFile)) &&
+         read_array(f, (void **)&m->records, &m->records_cap, m->nrecords,
+                    sizeof(IfaceRecord)) &&
+         read_array(f, (void **)&m->fields, &m->fields_cap, m->nfields,
+                    sizeof(IfaceField)) &&
+         read_array(f, (void **)&m->tests, &m->tests_cap, m->ntests,
+                    sizeof(IfaceTest)) &&
+         read_array(f, (void **)&m->strings, &m->strings_cap, m->strings_len,
+                    1) &&
+         validate(m);
+  }
+  fclose(f);
+  if (!ok)
+    iface_free(m);
+  return ok;
+}
+
+// ----- import -----
+
+static Token name_token(Token where, const char *text, IfaceStr s) {
+  Token t = where; // linha/offset do use; o texto é o da cópia
+  t.kind = IDENTIFIER;
+  t.start = text + s.off;
+  t.len = (int)s.len;
+  return t;
+}
+
+static AstNode *import_record(Parser *p, const ModuleIface *m,
+                              const IfaceRecord *r, const char *text,
+                              Token where) {
+  const ModalAllocator *a = p->alloc;
+  AstNode **fields = modal_alloc(a, r->count * sizeof(AstNode *));
+  if (!fields && r->count)
+    return NULL;
+
+  size_t count = 0;
+  for (; count < r->count; count++) {
+    const IfaceField *f = &m->fields[r->first + count];
+    AstNode *field = ast_new_field(a, name_token(where, text, f->name),
+                                   name_token(where, text, f->type), f->count,
+                                   (int)f->hot);
+    if (!field)
+      break;
+    field->data.field.size = f->size;
+    field->data.field.align = f->align;
+    field->data.field.offset = f->offset;
+    fields[count] = field;
+  }
+
+  AstNode *rec = NULL;
+  if (count == r->count)
+    rec = ast_new_record(a, name_token(where, text, r->name), fields, count,
+                         (int)r->is_union, (int)r->reorder);
+  if (rec) {
+    rec->data.record.state = 2; // layout do módulo, nada a resolver
+    rec->data.record.size = r->size;
+    rec->data.record.align = r->align;
+    rec->data.record.declared_size = r->declared_size;
+    rec->data.record.imported = 1;
+  } else {
+    for (size_t i = 0; i < count; i++)
+      ast_free(a, fields[i]);
+  }
+  modal_free(a, fields, r->count * sizeof(AstNode *));
+  return rec;
+}
+
+int iface_import(Parser *p, const ModuleIface *m, Token where,
+                 AstNode ***stmts, size_t *count, size_t *cap) {
+  const ModalAllocator *a = p->alloc;
+  char *text = modal_alloc(a, m->strings_len + 1);
+  if (!text)
+    return 0;
+  if (m->strings_len)
+    memcpy(text, m->strings, m->strings_len);
+  text[m->strings_len] = '\0';
+
+  AstNode *use = ast_new_use(a, where, text, m->strings_len);
+  if (!use) {
+    modal_free(a, text, m->strings_len + 1);
+    return 0;
+  }
+  if (!ast_list_push(a, stmts, count, cap, use)) {
+    ast_free(a, use);
+    return 0;
+  }
+
+  for (size_t i = 0; i < m->nrecords; i++) {
+    AstNode *rec = import_record(p, m, &m->records[i], text, where);
+    if (!rec)
+      return 0;
+    if (!ast_list_push(a, stmts, count, cap, rec)) {
+      ast_free(a, rec);
+      return 0;
+    }
+  }
+  return 1;
+}
@@ -0,0 +1,89 @@
+// iface.h — interface binária de um módulo (use "x.modal")
+#ifndef IFACE_H
+#define IFACE_H
+
+#include "parser.h"
+#include <stdint.h>
+
+// Trecho do blob de strings; structs daqui vão crus pro disco, então nada
+// de padding implícito (campos reserved)
+typedef struct {
+  uint32_t off, len;
+} IfaceStr;
+
+typedef struct {
+  IfaceStr name, type;
+  int64_t count, size, align, offset;
+  uint32_t hot, reserved;
+} IfaceField;
+
+typedef struct {
+  IfaceStr name;
+  uint32_t is_union, reorder;
+  int64_t size, align, declared_size;
+  uint32_t first, count; // fatia de fields
+} IfaceRecord;
+
+typedef struct {
+  IfaceStr name;
+  uint32_t native, reserved;
+  uint64_t hash; // ast_hash do test já dobrado: a chave do TestCache
+} IfaceTest;
+
+// Um use "x.modal": o texto como escrito e onde (pra erro sem relexar)
+typedef struct {
+  IfaceStr name;
+  int32_t line, col;
+  int64_t offset;
+  uint64_t export_hash; // do x.modal quando este módulo foi compilado
+} IfaceDep;
+
+// Arquivo que o parse leu além do fonte (#include, use "x.h"): mudou o
+// conteúdo, a interface não vale mais mesmo com o fonte intacto
+typedef struct {
+  IfaceStr path; // como o parser resolveu (relativo ao cwd de quem compilou)
+  uint64_t hash; // ast_hash_bytes do conteúdo
+} IfaceFile;
+
+// O que sobra de um módulo pra quem importa: struct/union próprias já com
+// layout, os tests (nome e hash) e os imports — por quê? O dependente
+// parseia sem relexar o corpo do módulo, e módulo intacto com os tests no
+// cache nem é parseado
+typedef struct ModuleIface {
+  uint64_t source_hash; // bytes do fonte
+  uint64_t export_hash; // só os records: se não muda, dependente não reparseia
+  IfaceDep *deps;
+  IfaceFile *files;
+  IfaceRecord *records;
+  IfaceField *fields;
+  IfaceTest *tests;
+  char *strings; // cada trecho termina em '\0'
+  size_t ndeps, nfiles, nrecords, nfields, ntests, strings_len;
+  size_t deps_cap, files_cap, records_cap, fields_cap, tests_cap,
+      strings_cap;
+} ModuleIface;
+
+void iface_init(ModuleIface *m);
+void iface_free(ModuleIface *m);
+
+// Records não importados e tests do topo de program, que já passou pelo
+// eval_fold_constants (o hash tem que bater com o do runner). 0 sem memória
+int iface_build(ModuleIface *m, const AstNode *program, uint64_t source_hash);
+// Acrescenta um import; where é o STRING do use
+int iface_add_dep(ModuleIface *m, const char *name, size_t len, Token where,
+                  uint64_t export_hash);
+// Acrescenta os arquivos lidos no parse (Parser.deps)
+int iface_add_files(ModuleIface *m, const FileDeps *deps);
+
+// 0 se ausente, corrompido ou de outro MODAL_VERSION (m fica vazio)
+int iface_read(ModuleIface *m, const char *path);
+// tmp + rename, como o cache de tests
+int iface_write(const ModuleIface *m, const char *path);
+
+// Pro parse_use de um módulo: empurra um AST_USE dono de uma cópia das
+// strings e as struct/union exportadas, já resolvidas (state 2, imported).
+// Os nomes apontam pro texto da cópia; linha/coluna são as do use
+int iface_import(Parser *p, const ModuleIface *m, Token where,
+                 AstNode ***stmts, size_t *count, size_t *cap);
+
+#endif
@@ -0,0 +1,422 @@
+#include "intern.h"
+#include <string.h>
+
+void ast_intern_init(AstIntern *t, const ModalAllocator *alloc) {
+  *t = (AstIntern){.alloc = alloc ? alloc : modal_heap_allocator()};
+}
+
+// Só o que é do nó: os filhos são compartilhados e têm dono próprio
+static void free_shell(const ModalAllocator *a, AstNode *node, size_t size) {
+  if (node->kind == AST_CALL)
+    modal_free(a, node->data.call.args,
+               node->data.call.count * sizeof(AstNode *));
+  else if (node->kind == AST_PIPELINE)
+    modal_free(a, node->data.pipeline.stages,
+               node->data.pipeline.count * sizeof(PipeStage));
+  modal_free(a, node, size);
+}
+
+void ast_intern_free(AstIntern *t) {
+  for (size_t i = 0; i < t->count; i++) {
+    AstShared *s = t->nodes[i];
+    modal_free(t->alloc, s->memo, sizeof(AstMemo));
+    free_shell(t->alloc, &s->node, sizeof(AstShared));
+  }
+  modal_free(t->alloc, t->nodes, t->cap * sizeof(AstShared *));
+  modal_free(t->alloc, t->slots, t->nslots * sizeof(uint32_t));
+  ast_intern_init(t, t->alloc);
+}
+
+// ----- chave -----
+
+static uint64_t mix(uint64_t h, uint64_t v) {
+  h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  return h;
+}
+
+// Filho entra pelo id — por quê? Já é canônico: mesmo id, mesma subárvore,
+// sem descer de novo
+static uint64_t child_id(const AstNode *child) { return child->hc; }
+
+static uint64_t op_bytes(const Token *tok) {
+  uint64_t v = 0;
+  memcpy(&v, tok->start, tok->len < 8 ? (size_t)tok->len : 8);
+  return v;
+}
+
+static uint64_t key_hash(const AstNode *n) {
+  uint64_t h = mix(0, (uint64_t)n->kind);
+  switch (n->kind) {
+  case AST_NUMBER_LIT:
+    if (n->data.number.is_float) { // 1.0 e 1 são nós diferentes
+      uint64_t bits;
+      memcpy(&bits, &n->data.number.f64, sizeof(bits));
+      return mix(mix(h, 1), bits);
+    }
+    return mix(h, (uint64_t)n->data.number.value);
+  case AST_VEC_LIT:
+    h = mix(mix(h, (uint64_t)n->data.vec.type), (uint64_t)n->data.vec.lanes);
+    for (int i = 0; i < n->data.vec.lanes; i++)
+      h = mix(h, (uint64_t)n->data.vec.values[i]);
+    return h;
+  case AST_IDENT:
+    return mix(h, ast_hash_bytes(n->data.ident.name, n->data.ident.len));
+  case AST_BIN_OP:
+  case AST_RANGE:
+    h = mix(h, op_bytes(&n->token)); // todo + - * / é OPERATOR no Kind
+    h = mix(h, child_id(n->data.binop.left));
+    return mix(h, child_id(n->data.binop.right));
+  case AST_UNARY_OP:
+    return mix(mix(h, op_bytes(&n->token)), child_id(n->data.unary.expr));
+  case AST_CALL:
+    h = mix(h, ast_hash_bytes(n->data.call.name, n->data.call.len));
+    for (size_t i = 0; i < n->data.call.count; i++)
+      h = mix(h, child_id(n->data.call.args[i]));
+    return h;
+  case AST_PIPELINE:
+    h = mix(h, (uint64_t)n->data.pipeline.terminal);
+    h = mix(h, child_id(n->data.pipeline.source));
+    for (size_t i = 0; i < n->data.pipeline.count; i++) {
+      h = mix(h, (uint64_t)n->data.pipeline.stages[i].kind);
+      h = mix(h, child_id(n->data.pipeline.stages[i].expr));
+    }
+    return h;
+  default:
+    return h;
+  }
+}
+
+static int same_op(const AstNode *a, const AstNode *b) {
+  return a->token.len == b->token.len &&
+         memcmp(a->token.start, b->token.start, (size_t)a->token.len) == 0;
+}
+
+static int same_name(const char *a, size_t alen, const char *b, size_t blen) {
+  return alen == blen && memcmp(a, b, alen) == 0;
+}
+
+// Filhos já canônicos: igualdade deles é igualdade de ponteiro
+static int same_key(const AstNode *a, const AstNode *b) {
+  if (a->kind != b->kind)
+    return 0;
+  switch (a->kind) {
+  case AST_NUMBER_LIT:
+    if (a->data.number.is_float != b->data.number.is_float)
+      return 0;
+    if (a->data.number.is_float) // bits: 0.0 e -0.0 não são o mesmo nó
+      return memcmp(&a->data.number.f64, &b->data.number.f64,
+                    sizeof(double)) == 0;
+    return a->data.number.value == b->data.number.value;
+  case AST_VEC_LIT:
+    return a->data.vec.type == b->data.vec.type &&
+           a->data.vec.lanes == b->data.vec.lanes &&
+           memcmp(a->data.vec.values, b->data.vec.values,
+                  (size_t)a->data.vec.lanes * sizeof(long long)) == 0;
+  case AST_IDENT:
+    return same_name(a->data.ident.name, a->data.ident.len, b->data.ident.name,
+                     b->data.ident.len);
+  case AST_BIN_OP:
+  case AST_RANGE:
+    return same_op(a, b) && a->data.binop.left == b->data.binop.left &&
+           a->data.binop.right == b->data.binop.right;
+  case AST_UNARY_OP:
+    return same_op(a, b) && a->data.unary.expr == b->data.unary.expr;
+  case AST_CALL:
+    return same_name(a->data.call.name, a->data.call.len, b->data.call.name,
+                     b->data.call.len) &&
+           a->data.call.count == b->data.call.count &&
+           (!a->data.call.count ||
+            memcmp(a->data.call.args, b->data.call.args,
+                   a->data.call.count * sizeof(AstNode *)) == 0);
+  case AST_PIPELINE:
+    if (a->data.pipeline.terminal != b->data.pipeline.terminal ||
+        a->data.pipeline.source != b->data.pipeline.source ||
+        a->data.pipeline.count != b->data.pipeline.count)
+      return 0;
+    for (size_t i = 0; i < a->data.pipeline.count; i++)
+      if (a->data.pipeline.stages[i].kind != b->data.pipeline.stages[i].kind ||
+          a->data.pipeline.stages[i].expr != b->data.pipeline.stages[i].expr)
+        return 0;
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+// ----- tabela -----
+
+static int table_grow(AstIntern *t) {
+  size_t n = t->nslots ? t->nslots * 2 : 64;
+  uint32_t *slots = modal_alloc(t->alloc, n * sizeof(uint32_t));
+  if (!slots)
+    return 0;
+  memset(slots, 0, n * sizeof(uint32_t));
+  for (size_t i = 0; i < t->count; i++) {
+    size_t j = t->nodes[i]->hash & (n - 1);
+    while (slots[j])
+      j = (j + 1) & (n - 1);
+    slots[j] = (uint32_t)(i + 1);
+  }
+  modal_free(t->alloc, t->slots, t->nslots * sizeof(uint32_t));
+  t->slots = slots;
+  t->nslots = n;
+  return 1;
+}
+
+static int nodes_grow(AstIntern *t) {
+  size_t cap = t->cap ? t->cap * 2 : 64;
+  AstShared **nodes = modal_realloc(t->alloc, t->nodes,
+                                    t->cap * sizeof(AstShared *),
+                                    cap * sizeof(AstShared *));
+  if (!nodes)
+    return 0;
+  t->nodes = nodes;
+  t->cap = cap;
+  return 1;
+}
+
+static void add_free(AstShared *s, const AstNode *ident) {
+  if (s->nfree < 0)
+    return;
+  for (int i = 0; i < s->nfree; i++)
+    if (s->free[i] == ident)
+      return;
+  if (s->nfree == AST_SHARED_MAX_FREE) {
+    s->nfree = -1;
+    return;
+  }
+  s->free[s->nfree++] = ident;
+}
+
+static int is_it(const AstNode *ident) {
+  return same_name(ident->data.ident.name, ident->data.ident.len, "it", 2);
+}
+
+// Livres e tamanho do filho somam no pai; `it` de estágio é do pipeline
+static void take_child(AstShared *s, const AstNode *child, int stage) {
+  const AstShared *c = ast_shared(child);
+  uint64_t size = (uint64_t)s->size + c->size;
+  s->size = size > UINT32_MAX ? UINT32_MAX : (uint32_t)size;
+  s->loops |= c->loops;
+  if (c->nfree < 0) {
+    s->nfree = -1;
+    return;
+  }
+  for (int i = 0; i < c->nfree; i++)
+    if (!stage || !is_it(c->free[i]))
+      add_free(s, c->free[i]);
+}
+
+static void fill_meta(AstShared *s) {
+  AstNode *n = &s->node;
+  s->size = 1;
+  switch (n->kind) {
+  case AST_IDENT:
+    s->free[s->nfree++] = n;
+    return;
+  case AST_BIN_OP:
+  case AST_RANGE:
+    take_child(s, n->data.binop.left, 0);
+    take_child(s, n->data.binop.right, 0);
+    return;
+  case AST_UNARY_OP:
+    take_child(s, n->data.unary.expr, 0);
+    return;
+  case AST_CALL:
+    for (size_t i = 0; i < n->data.call.count; i++)
+      take_child(s, n->data.call.args[i], 0);
+    return;
+  case AST_PIPELINE:
+    s->loops = 1;
+    take_child(s, n->data.pipeline.source, 0);
+    for (size_t i = 0; i < n->data.pipeline.count; i++)
+      take_child(s, n->data.pipeline.stages[i].expr, 1);
+    return;
+  default:
+    return; // literal
+  }
+}
+
+// Canônico de node (filhos já canônicos); node sai liberado se virou
+// duplicata ou foi movido pra tabela. Sem memória: node fica como está
+static AstNode *share(AstIntern *t, AstNode *node) {
+  if (t->count >= UINT32_MAX - 1)
+    return node;
+  if ((t->count + 1) * 4 >= t->nslots * 3 && !table_grow(t))
+    return node;
+  t->seen++;
+  TypeId type = types_of(t->types, node);
+  uint64_t hash = mix(key_hash(node), type);
+  size_t i = hash & (t->nslots - 1);
+  for (; t->slots[i]; i = (i + 1) & (t->nslots - 1)) {
+    AstShared *s = t->nodes[t->slots[i] - 1];
+    if (s->hash == hash && same_key(&s->node, node) &&
+        types_of(t->types, &s->node) == type) {
+      if (s->refs < UINT32_MAX)
+        s->refs++;
+      free_shell(t->alloc, node, sizeof(AstNode));
+      return &s->node;
+    }
+  }
+
+  if (t->count == t->cap && !nodes_grow(t)) {
+    t->seen--;
+    return node;
+  }
+  AstShared *s = modal_alloc(t->alloc, sizeof(AstShared));
+  if (!s) {
+    t->seen--;
+    return node;
+  }
+  *s = (AstShared){.node = *node, .hash = hash, .refs = 1};
+  s->node.hc = (uint32_t)(t->count + 1);
+  fill_meta(s);
+  t->nodes[t->count++] = s;
+  t->slots[i] = s->node.hc;
+  modal_free(t->alloc, node, sizeof(AstNode)); // args/estágios foram junto
+  return &s->node;
+}
+
+static int shared(const AstNode *node) { return node && node->hc; }
+
+static AstNode *intern_expr(AstIntern *t, AstNode *node);
+static void intern_stmt(AstIntern *t, AstNode *node);
+
+// Filhos de uma expressão viram canônicos; 1 se todos viraram — aí o
+// próprio nó pode ser compartilhado
+static int intern_children(AstIntern *t, AstNode *node) {
+  int all = 1;
+  switch (node->kind) {
+  case AST_NUMBER_LIT:
+  case AST_VEC_LIT:
+  case AST_IDENT:
+    return 1;
+  case AST_BIN_OP:
+  case AST_RANGE:
+    node->data.binop.left = intern_expr(t, node->data.binop.left);
+    node->data.binop.right = intern_expr(t, node->data.binop.right);
+    return shared(node->data.binop.left) && shared(node->data.binop.right);
+  case AST_UNARY_OP:
+    node->data.unary.expr = intern_expr(t, node->data.unary.expr);
+    return shared(node->data.unary.expr);
+  case AST_CALL:
+    for (size_t i = 0; i < node->data.call.count; i++) {
+      node->data.call.args[i] = intern_expr(t, node->data.call.args[i]);
+      all &= shared(node->data.call.args[i]);
+    }
+    return all && !node->data.call.native; // C pode ter efeito
+  case AST_PIPELINE:
+    node->data.pipeline.source = intern_expr(t, node->data.pipeline.source);
+    all = shared(node->data.pipeline.source);
+    for (size_t i = 0; i < node->data.pipeline.count; i++) {
+      PipeStage *st = &node->data.pipeline.stages[i];
+      st->expr = intern_expr(t, st->expr);
+      all &= shared(st->expr);
+    }
+    return all;
+  default:
+    intern_stmt(t, node);
+    return 0;
+  }
+}
+
+static AstNode *intern_expr(AstIntern *t, AstNode *node) {
+  if (!node || node->hc)
+    return node;
+  return intern_children(t, node) ? share(t, node) : node;
+}
+
+static void intern_stmt(AstIntern *t, AstNode *node) {
+  if (!node)
+    return;
+  switch (node->kind) {
+  case AST_BLOCK:
+  case AST_PAREN_GROUP:
+    for (size_t i = 0; i < node->data.block_or_group.count; i++)
+      intern_stmt(t, node->data.block_or_group.stmts[i]);
+    return;
+  case AST_TEST_STMT:
+    intern_stmt(t, node->data.test.block);
+    return;
+  case AST_ASYNC_BLOCK:
+  case AST_DEFER_STMT:
+    intern_stmt(t, node->data.unary.expr);
+    return;
+  case AST_ASSERT_STMT:
+    node->data.unary.expr = intern_expr(t, node->data.unary.expr);
+    intern_stmt(t, node->data.unary.message);
+    return;
+  case AST_FORMAT:
+    for (size_t i = 0; i < node->data.format.count; i++)
+      node->data.format.parts[i].expr =
+          intern_expr(t, node->data.format.parts[i].expr);
+    return;
+  case AST_VAR_DECL:
+    node->data.var.init = intern_expr(t, node->data.var.init);
+    return;
+  case AST_NUMBER_LIT:
+  case AST_VEC_LIT:
+  case AST_IDENT:
+  case AST_BIN_OP:
+  case AST_RANGE:
+  case AST_UNARY_OP:
+  case AST_CALL:
+  case AST_PIPELINE:
+    intern_children(t, node); // expressão solta: o nó é statement
+    return;
+  default:
+    return; // struct, use, extern: nada pra dividir
+  }
+}
+
+// Memo só onde compensa: repetido, poucos livres, nada de `it` (muda a
+// cada elemento) e caro o bastante pra valer a conferência
+static int wants_memo(const AstShared *s) {
+  if (s->refs < 2 || s->nfree < 0 ||
+      (!s->loops && s->size < AST_MEMO_MIN_SIZE))
+    return 0;
+  for (int i = 0; i < s->nfree; i++)
+    if (is_it(s->free[i]))
+      return 0;
+  return 1;
+}
+
+void ast_intern_program(AstIntern *t, AstNode *root) {
+  intern_stmt(t, root);
+  for (size_t i = 0; i < t->count; i++) {
+    AstShared *s = t->nodes[i];
+    if (s->memo || !wants_memo(s))
+      continue;
+    s->memo = modal_alloc(t->alloc, sizeof(AstMemo));
+    if (s->memo) {
+      memset(s->memo, 0, sizeof(AstMemo));
+      atomic_init(&s->memo->busy, 0);
+    }
+  }
+}
+
+void ast_intern_stats(const AstIntern *t, AstInternStats *s) {
+  s->seen += t->seen;
+  s->unique += t->count;
+  s->bytes_before += t->seen * sizeof(AstNode);
+  s->bytes_after += t->count * sizeof(AstShared) +
+                    t->cap * sizeof(AstShared *) +
+                    t->nslots * sizeof(uint32_t);
+  for (size_t i = 0; i < t->count; i++) {
+    const AstMemo *m = t->nodes[i]->memo;
+    if (!m)
+      continue;
+    s->memo++;
+    s->hits += m->hits;
+    s->bytes_after += sizeof(AstMemo);
+  }
+}
+
+void ast_intern_report(const AstInternStats *s, FILE *out) {
+  double ratio = s->unique ? (double)s->seen / (double)s->unique : 1.0;
+  fprintf(out,
+          "hash-cons: %zu expressões -> %zu nós (%.2fx), %zu KiB -> %zu KiB; "
+          "memo em %zu nós, %llu acertos\n",
+          s->seen, s->unique, ratio, s->bytes_before / 1024,
+          s->bytes_after / 1024, s->memo, (unsigned long long)s->hits);
+}
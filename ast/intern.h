@@ -0,0 +1,82 @@
+// intern.h — hash-consing das expressões: subárvore pura que se repete
+// vira um nó só, apontado por todo lugar que a escreveu
+#ifndef INTERN_H
+#define INTERN_H
+
+#include "../lib/compiler/value.h"
+#include "ast.h"
+#include "types.h"
+#include <stdatomic.h>
+#include <stdio.h>
+
+// Identificadores livres que um nó compartilhado guarda pro memo; com mais
+// que isso o nó é dividido igual, só não memoriza
+#define AST_SHARED_MAX_FREE 3
+// Subárvore menor que isso avalia mais rápido do que o memo confere os
+// argumentos; pipeline sempre compensa (laço)
+#define AST_MEMO_MIN_SIZE 8
+
+// Último resultado de um nó compartilhado, pelo valor dos livres. busy —
+// por quê? Tarefas async avaliam o mesmo nó em threads diferentes: quem não
+// pega o memo avalia sem ele, ninguém espera
+typedef struct {
+  _Atomic int busy;
+  int filled, ok;
+  uint64_t hits; // só com busy na mão
+  Value args[AST_SHARED_MAX_FREE];
+  Value result;
+} AstMemo;
+
+// Nó canônico: o AstNode vem primeiro, então o ponteiro que a árvore vê é
+// o bloco inteiro (ast_shared). node.hc é o id na tabela, nunca 0
+typedef struct {
+  AstNode node;
+  uint64_t hash;
+  uint32_t refs;  // quantas vezes o fonte escreveu essa subárvore
+  uint32_t size;  // nós da subárvore expandida, satura
+  int nfree;      // -1: mais que AST_SHARED_MAX_FREE
+  int loops;      // tem pipeline dentro
+  const AstNode *free[AST_SHARED_MAX_FREE]; // AST_IDENT canônicos
+  AstMemo *memo;  // NULL: avalia sempre
+} AstShared;
+
+static inline AstShared *ast_shared(const AstNode *node) {
+  return (AstShared *)node;
+}
+
+// Dona dos nós compartilhados de uma AST — ast_free pula nó com hc, quem
+// libera é ast_intern_free, depois da árvore. Uma thread por tabela
+typedef struct {
+  const ModalAllocator *alloc;
+  AstShared **nodes; // id - 1
+  size_t count, cap;
+  uint32_t *slots; // ids, endereçamento aberto, potência de 2; 0 vazio
+  size_t nslots;
+  size_t seen; // expressões que passaram por aqui, antes do dedup
+  // Tipo do checker entra na chave — por quê? `x` i64 num test e f64 no
+  // outro não podem virar um nó só. NULL: só a forma
+  const TypeTable *types;
+} AstIntern;
+
+typedef struct {
+  size_t seen, unique; // nós de expressão antes e depois
+  size_t bytes_before, bytes_after;
+  size_t memo;   // nós com memo
+  uint64_t hits; // avaliações que saíram do memo
+} AstInternStats;
+
+void ast_intern_init(AstIntern *t, const ModalAllocator *alloc);
+void ast_intern_free(AstIntern *t);
+
+// Troca toda expressão pura de root (literal, ident, operador, range,
+// pipeline, chamada que não é C) pela cópia canônica, chave (kind, op,
+// ids dos filhos, literal, tipo). Statement fica como está — cobertura e
+// perfil contam por nó — e os duplicados são liberados. Roda depois do
+// eval_fold_constants; sem memória o resto só fica sem compartilhar
+void ast_intern_program(AstIntern *t, AstNode *root);
+
+// Soma os números de t em s (memo inclusive: chame depois dos tests)
+void ast_intern_stats(const AstIntern *t, AstInternStats *s);
+void ast_intern_report(const AstInternStats *s, FILE *out);
+
+#endif
@@ -0,0 +1,336 @@
+#include "layout.h"
+#include <limits.h>
+#include <string.h>
+
+// Primitivos: alinhamento = tamanho, como no ABI x86-64/aarch64
+typedef struct {
+  const char *name;
+  long long size;
+} Primitive;
+
+static const Primitive primitives[] = {
+    {"i8", 1},  {"u8", 1},  {"bool", 1}, {"i16", 2},   {"u16", 2},
+    {"i32", 4}, {"u32", 4}, {"f32", 4},  {"i64", 8},   {"u64", 8},
+    {"f64", 8}, {"ptr", 8}, {"isize", 8}, {"usize", 8},
+};
+
+static const Primitive *find_primitive(const char *name, size_t len) {
+  for (size_t i = 0; i < sizeof(primitives) / sizeof(primitives[0]); i++)
+    if (strlen(primitives[i].name) == len &&
+        memcmp(primitives[i].name, name, len) == 0)
+      return &primitives[i];
+  return NULL;
+}
+
+static AstNode *find_record(AstNode *program, const char *name, size_t len) {
+  for (size_t i = 0; i < program->data.block_or_group.count; i++) {
+    AstNode *stmt = program->data.block_or_group.stmts[i];
+    if (stmt && stmt->kind == AST_STRUCT_DECL && stmt->data.record.len == len &&
+        memcmp(stmt->data.record.name, name, len) == 0)
+      return stmt;
+  }
+  return NULL;
+}
+
+// 0 se v + a - 1 não cabe em long long; o resultado nunca passa disso
+static int align_up(long long v, long long a, long long *out) {
+  long long end;
+  if (__builtin_add_overflow(v, a - 1, &end))
+    return 0;
+  *out = end / a * a;
+  return 1;
+}
+
+// Conta de tamanho estourou long long — por quê barrar? `u64[1 << 62]`
+// dava 0 bytes e o sizeof dobrava 0, em cima de overflow com sinal (UB)
+static int too_big(Parser *p, Token *where, AstNode *rec) {
+  parser_error_at(p, where, "%s grande demais: '%.*s' passa de %lld bytes",
+                  rec->data.record.is_union ? "union" : "struct",
+                  (int)rec->data.record.len, rec->data.record.name, LLONG_MAX);
+  rec->data.record.size = -1;
+  rec->data.record.state = 2;
+  return 0;
+}
+
+static int resolve_record(Parser *p, AstNode *program, AstNode *rec);
+
+static int type_layout(Parser *p, AstNode *program, Token *where,
+                       const char *name, size_t len, long long *size,
+                       long long *align) {
+  const Primitive *prim = find_primitive(name, len);
+  if (prim) {
+    *size = *align = prim->size;
+    return 1;
+  }
+
+  AstNode *rec = find_record(program, name, len);
+  if (!rec) {
+    parser_error_at(p, where, "tipo desconhecido '%.*s'", (int)len, name);
+    return 0;
+  }
+  if (rec->data.record.state == 1) {
+    parser_error_at(p, where, "'%.*s' contém a si mesma por valor", (int)len,
+                    name);
+    return 0;
+  }
+  if (!resolve_record(p, program, rec))
+    return 0;
+  *size = rec->data.record.size;
+  *align = rec->data.record.align;
+  return 1;
+}
+
+// Offsets na ordem dada; size sai com o padding final. 0 se estourou
+static int place_fields(AstNode **order, size_t count, int is_union,
+                        long long *size, long long *align_out) {
+  long long end = 0, align = 1;
+  for (size_t i = 0; i < count; i++) {
+    AstNode *f = order[i];
+    if (f->data.field.align > align)
+      align = f->data.field.align;
+    if (is_union) {
+      f->data.field.offset = 0;
+      if (f->data.field.size > end)
+        end = f->data.field.size;
+    } else if (!align_up(end, f->data.field.align, &f->data.field.offset) ||
+               __builtin_add_overflow(f->data.field.offset,
+                                      f->data.field.size, &end))
+      return 0;
+  }
+  *align_out = align;
+  return align_up(end, align, size);
+}
+
+// Hot antes de frio, e dentro de cada grupo alinhamento decrescente — por
+// quê? Com alinhamentos potência de 2, decrescente só deixa padding no fim;
+// hot na frente cai na primeira linha de cache
+static int colder(const AstNode *a, const AstNode *b) {
+  if (a->data.field.hot != b->data.field.hot)
+    return a->data.field.hot < b->data.field.hot;
+  return a->data.field.align < b->data.field.align;
+}
+
+static int reorder_fields(Parser *p, AstNode *rec) {
+  size_t count = rec->data.record.count;
+  AstNode **order = modal_alloc(p->alloc, count * sizeof(AstNode *));
+  if (!order)
+    return 1; // sem memória: fica na ordem do fonte
+  for (size_t i = 0; i < count; i++) { // inserção estável
+    AstNode *f = rec->data.record.fields[i];
+    size_t j = i;
+    for (; j > 0 && colder(order[j - 1], f); j--)
+      order[j] = order[j - 1];
+    order[j] = f;
+  }
+
+  // Hot na frente pode pôr mais padding que a ordem do fonte
+  long long align;
+  if (!place_fields(order, count, 0, &rec->data.record.size, &align)) {
+    modal_free(p->alloc, order, count * sizeof(AstNode *));
+    return too_big(p, &rec->token, rec);
+  }
+
+  long long hot_end = 0;
+  for (size_t i = 0; i < count && order[i]->data.field.hot; i++)
+    hot_end = order[i]->data.field.offset + order[i]->data.field.size;
+  if (hot_end > LAYOUT_CACHE_LINE)
+    parser_warn_at(p, &rec->token,
+                   "campos hot de '%.*s' ocupam %lld bytes, passam da "
+                   "primeira linha de cache (%d)",
+                   (int)rec->data.record.len, rec->data.record.name, hot_end,
+                   LAYOUT_CACHE_LINE);
+  modal_free(p->alloc, order, count * sizeof(AstNode *));
+  return 1;
+}
+
+static int resolve_record(Parser *p, AstNode *program, AstNode *rec) {
+  if (rec->data.record.state == 2)
+    return rec->data.record.size >= 0;
+  rec->data.record.state = 1;
+  rec->data.record.size = -1; // falhou, se sair antes do fim
+
+  AstNode **fields = rec->data.record.fields;
+  size_t count = rec->data.record.count;
+  for (size_t i = 0; i < count; i++) {
+    AstNode *f = fields[i];
+    for (size_t j = 0; j < i; j++)
+      if (fields[j]->data.field.len == f->data.field.len &&
+          memcmp(fields[j]->data.field.name, f->data.field.name,
+                 f->data.field.len) == 0) {
+        parser_error_at(p, &f->token, "campo '%.*s' repetido",
+                        (int)f->data.field.len, f->data.field.name);
+        rec->data.record.state = 2;
+        return 0;
+      }
+
+    long long size, align;
+    if (!type_layout(p, program, &f->token, f->data.field.type,
+                     f->data.field.type_len, &size, &align)) {
+      rec->data.record.state = 2;
+      return 0;
+    }
+    if (__builtin_mul_overflow(size, f->data.field.count,
+                               &f->data.field.size))
+      return too_big(p, &f->token, rec);
+    f->data.field.align = align;
+  }
+
+  int is_union = rec->data.record.is_union;
+  if (!place_fields(fields, count, is_union, &rec->data.record.declared_size,
+                    &rec->data.record.align))
+    return too_big(p, &rec->token, rec);
+  rec->data.record.size = rec->data.record.declared_size;
+  if (rec->data.record.reorder && !is_union && !reorder_fields(p, rec))
+    return 0;
+
+  rec->data.record.state = 2;
+  return 1;
+}
+
+// Dobra sizeof e barra struct fora do topo
+static void fold_node(Parser *p, AstNode *program, AstNode *node, int top) {
+  if (!node)
+    return;
+  switch (node->kind) {
+  case AST_SIZEOF: {
+    long long size, align;
+    if (!type_layout(p, program, &node->token, node->data.ident.name,
+                     node->data.ident.len, &size, &align))
+      return;
+    node->kind = AST_NUMBER_LIT;
+    node->data.number.value = size;
+    node->data.number.is_float = 0;
+    return;
+  }
+  case AST_STRUCT_DECL:
+    if (!top)
+      parser_error_at(p, &node->token, "struct/union só no topo do arquivo");
+    return;
+  case AST_BIN_OP:
+  case AST_RANGE:
+    fold_node(p, program, node->data.binop.left, 0);
+    fold_node(p, program, node->data.binop.right, 0);
+    return;
+  case AST_ASSERT_STMT:
+    fold_node(p, program, node->data.unary.expr, 0);
+    fold_node(p, program, node->data.unary.message, 0);
+    return;
+  case AST_UNARY_OP:
+  case AST_ASYNC_BLOCK:
+  case AST_DEFER_STMT:
+    fold_node(p, program, node->data.unary.expr, 0);
+    return;
+  case AST_FORMAT:
+    for (size_t i = 0; i < node->data.format.count; i++)
+      fold_node(p, program, node->data.format.parts[i].expr, 0);
+    return;
+  case AST_VAR_DECL:
+    fold_node(p, program, node->data.var.init, 0);
+    return;
+  case AST_CALL:
+    for (size_t i = 0; i < node->data.call.count; i++)
+      fold_node(p, program, node->data.call.args[i], 0);
+    return;
+  case AST_PIPELINE:
+    fold_node(p, program, node->data.pipeline.source, 0);
+    for (size_t i = 0; i < node->data.pipeline.count; i++)
+      fold_node(p, program, node->data.pipeline.stages[i].expr, 0);
+    return;
+  case AST_TEST_STMT:
+    fold_node(p, program, node->data.test.block, 0);
+    return;
+  case AST_BLOCK:
+  case AST_PAREN_GROUP:
+    for (size_t i = 0; i < node->data.block_or_group.count; i++)
+      fold_node(p, program, node->data.block_or_group.stmts[i], 0);
+    return;
+  default:
+    return;
+  }
+}
+
+void resolve_layouts(Parser *p, AstNode *program) {
+  if (!program || program->kind != AST_BLOCK)
+    return;
+
+  for (size_t i = 0; i < program->data.block_or_group.count; i++) {
+    AstNode *rec = program->data.block_or_group.stmts[i];
+    if (!rec || rec->kind != AST_STRUCT_DECL)
+      continue;
+    const char *name = rec->data.record.name;
+    size_t len = rec->data.record.len;
+    if (find_primitive(name, len)) {
+      parser_error_at(p, &rec->token, "'%.*s' é um tipo primitivo", (int)len,
+                      name);
+      continue;
+    }
+    if (find_record(program, name, len) != rec) {
+      parser_error_at(p, &rec->token, "'%.*s' já foi declarada", (int)len,
+                      name);
+      continue;
+    }
+    resolve_record(p, program, rec);
+  }
+
+  for (size_t i = 0; i < program->data.block_or_group.count; i++)
+    fold_node(p, program, program->data.block_or_group.stmts[i], 1);
+}
+
+static void report_record(const AstNode *rec, FILE *out) {
+  const char *what = rec->data.record.is_union ? "union" : "struct";
+  fprintf(out, "%s %.*s%s — %lld bytes, align %lld", what,
+          (int)rec->data.record.len, rec->data.record.name,
+          rec->data.record.reorder ? " reorder" : "", rec->data.record.size,
+          rec->data.record.align);
+  if (rec->data.record.declared_size != rec->data.record.size)
+    fprintf(out, " (na ordem do fonte: %lld bytes)",
+            rec->data.record.declared_size);
+  fprintf(out, "\n  offset   tam  campo\n");
+
+  // Ordem da memória sem alocar: escolhe o próximo menor offset a cada passo
+  // (union: tudo em 0, sai na ordem do fonte)
+  size_t count = rec->data.record.count;
+  int is_union = rec->data.record.is_union;
+  long long cursor = 0, last = -1;
+  for (size_t n = 0; n < count; n++) {
+    const AstNode *next = is_union ? rec->data.record.fields[n] : NULL;
+    for (size_t i = 0; !is_union && i < count; i++) {
+      const AstNode *f = rec->data.record.fields[i];
+      if (f->data.field.offset > last &&
+          (!next || f->data.field.offset < next->data.field.offset))
+        next = f;
+    }
+    if (!next)
+      break;
+    if (next->data.field.offset > cursor)
+      fprintf(out, "  %6lld %5lld  (padding)\n", cursor,
+              next->data.field.offset - cursor);
+
+    fprintf(out, "  %6lld %5lld  %.*s: %.*s", next->data.field.offset,
+            next->data.field.size, (int)next->data.field.len,
+            next->data.field.name, (int)next->data.field.type_len,
+            next->data.field.type);
+    if (next->data.field.count > 1)
+      fprintf(out, "[%lld]", next->data.field.count);
+    fprintf(out, "%s\n", next->data.field.hot ? "  hot" : "");
+
+    last = next->data.field.offset;
+    long long end = last + next->data.field.size;
+    if (end > cursor)
+      cursor = end;
+  }
+  if (rec->data.record.size > cursor)
+    fprintf(out, "  %6lld %5lld  (padding)\n", cursor,
+            rec->data.record.size - cursor);
+}
+
+void layout_report(const AstNode *program, FILE *out) {
+  if (!program || program->kind != AST_BLOCK)
+    return;
+  for (size_t i = 0; i < program->data.block_or_group.count; i++) {
+    const AstNode *stmt = program->data.block_or_group.stmts[i];
+    if (stmt && stmt->kind == AST_STRUCT_DECL &&
+        stmt->data.record.state == 2)
+      report_record(stmt, out);
+  }
+}
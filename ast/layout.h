@@ -0,0 +1,19 @@
+// layout.h
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include "parser.h"
+#include <stdio.h>
+
+#define LAYOUT_CACHE_LINE 64
+
+// Resolve as struct/union do topo: tamanho, alinhamento e offset de cada
+// campo, e dobra todo sizeof(T) numa constante. parse_program chama depois
+// de um parse sem erro; tipo desconhecido ou struct recursiva vira erro
+void resolve_layouts(Parser *p, AstNode *program);
+
+// Uma struct por bloco: campos na ordem da memória com offset, tamanho e
+// padding; no modo reorder, quanto a ordem do fonte custaria
+void layout_report(const AstNode *program, FILE *out);
+
+#endif
@@ -0,0 +1,20 @@
+// literal.h — valor de um token NUMBER (inteiro ou f64)
+#ifndef LITERAL_H
+#define LITERAL_H
+
+#include <stddef.h>
+
+typedef struct {
+  int is_float; // tinha '.' ou expoente
+  long long i;  // !is_float
+  double f64;   // is_float, arredondado certo (o double mais próximo)
+} Literal;
+
+// Lê s[0, len) — sem '\0' no fim, como todo Token. Inteiro decimal, 0x, 0b
+// ou 0o (estes até 64 bits sem sinal: 0xFFFFFFFFFFFFFFFF é -1), '_' entre
+// dígitos, float com '.' e/ou expoente. NULL se ok; senão a mensagem, e *bad
+// é o offset do caractere culpado
+const char *literal_parse(const char *s, size_t len, Literal *out,
+                          size_t *bad);
+
+#endif
@@ -1,24 +1,168 @@
 #include "ast.h"
 #include "parser.h"
-#include <stdlib.h>
+#include <string.h>
 
+// test "nome" { ... } — o `test` já foi consumido por parse_statement
 AstNode *parse_test_decl(Parser *p) {
-  parser_consume(p, (Kind)STRING, "espera nome depois de 'test'");
-  parser_consume(p, IDENTIFIER, "espera nome depois de 'test'");
-  AstNode *name = ast_new_ident(p->previous);
+  if (p->current.kind == IDENTIFIER) {
+    parser_error_at(p, &p->current,
+                    "nome do test precisa ser string (use aspas: test "
+                    "\"nome\" { ... })");
+    return NULL;
+  }
+
+  if (p->current.kind != STRING) {
+    parser_error_at(p, &p->current, "espera nome depois de 'test'");
+    return NULL;
+  }
+
+  Token name = p->current;
+  const char *text;
+  size_t len;
+  if (!parser_string(p, &name, &text, &len))
+    return NULL;
+  if (len == 0) {
+    parser_error_at(p, &name, "test precisa ter um nome");
+    return NULL;
+  }
+  parser_advance(p);
+
+  if (p->current.kind != LBRACE) {
+    parser_error_at(p, &p->current, "espera '{' depois do nome do test");
+    return NULL;
+  }
 
   AstNode *body = parse_block(p);
+  if (!body)
+    return NULL;
+
+  return ast_new_test(p->alloc, name, text, len, body);
+}
+
+static int is_op(const Token *tok, char c) {
+  return tok->kind == OPERATOR && tok->len == 1 && *tok->start == c;
+}
 
-  if (!name || !body) {
-    ast_free(name);
-    ast_free(body);
+static int is_word(const Token *tok, const char *word) {
+  size_t len = strlen(word);
+  return tok->kind == IDENTIFIER && (size_t)tok->len == len &&
+         memcmp(tok->start, word, len) == 0;
+}
+
+// [hot] nome: Tipo[N]
+static AstNode *parse_field(Parser *p) {
+  int hot = 0;
+  if (is_word(&p->current, "hot")) {
+    hot = 1;
+    parser_advance(p);
+  }
+
+  if (p->current.kind != IDENTIFIER) {
+    parser_error_at(p, &p->current, "espera nome do campo");
     return NULL;
   }
+  Token name = p->current;
+  parser_advance(p);
 
-  // TODO: Cria AST_TEST_STMT (expanda ast.h com .test.name + .test.body)
-  // Por agora, usa AST_BLOCK como placeholder com nome dentro — ajusta depois
-  AstNode **stmts = malloc(2 * sizeof(AstNode *)); // nome + body
-  stmts[0] = name;
-  stmts[1] = body;
-  return ast_new_test(p->previous, *stmts);
+  if (!is_op(&p->current, ':')) {
+    parser_error_at(p, &p->current, "espera ':' depois de '%.*s'", name.len,
+                    name.start);
+    return NULL;
+  }
+  parser_advance(p);
+
+  if (p->current.kind != IDENTIFIER) {
+    parser_error_at(p, &p->current, "espera tipo do campo '%.*s'", name.len,
+                    name.start);
+    return NULL;
+  }
+  Token type = p->current;
+  parser_advance(p);
+
+  long long count = 1;
+  if (is_op(&p->current, '[')) {
+    parser_advance(p);
+    if (p->current.kind != NUMBER) {
+      parser_error_at(p, &p->current, "tamanho do array precisa ser número");
+      return NULL;
+    }
+    Literal lit;
+    if (!parser_literal(p, &p->current, &lit))
+      return NULL;
+    if (lit.is_float) {
+      parser_error_at(p, &p->current, "tamanho do array precisa ser inteiro");
+      return NULL;
+    }
+    count = lit.i;
+    if (count <= 0) {
+      parser_error_at(p, &p->current, "array de tamanho zero");
+      return NULL;
+    }
+    parser_advance(p);
+    if (!is_op(&p->current, ']')) {
+      parser_error_at(p, &p->current, "espera ']'");
+      return NULL;
+    }
+    parser_advance(p);
+  }
+
+  // Separador opcional, como o ; dos statements
+  if (is_op(&p->current, ';') || is_op(&p->current, ','))
+    parser_advance(p);
+
+  return ast_new_field(p->alloc, name, type, count, hot);
+}
+
+// struct Nome [reorder] { campos } — `struct`/`union` já foi consumido
+AstNode *parse_record_decl(Parser *p, int is_union) {
+  const char *what = is_union ? "union" : "struct";
+  if (p->current.kind != IDENTIFIER) {
+    parser_error_at(p, &p->current, "espera nome depois de '%s'", what);
+    return NULL;
+  }
+  Token name = p->current;
+  parser_advance(p);
+
+  int reorder = 0;
+  if (is_word(&p->current, "reorder")) {
+    reorder = 1;
+    parser_advance(p);
+  }
+
+  if (!parser_match(p, LBRACE)) {
+    parser_error_at(p, &p->current, "espera '{' depois do nome da %s", what);
+    return NULL;
+  }
+
+  AstNode **fields = NULL;
+  size_t count = 0, cap = 0;
+  while (p->current.kind != RBRACE && p->current.kind != TOK_EOF) {
+    AstNode *field = parse_field(p);
+    if (!field)
+      break;
+    if (count == cap) {
+      size_t grown_cap = cap ? cap * 2 : 8;
+      AstNode **grown =
+          modal_realloc(p->alloc, fields, cap * sizeof(AstNode *),
+                        grown_cap * sizeof(AstNode *));
+      if (!grown) {
+        ast_free(p->alloc, field);
+        break;
+      }
+      fields = grown;
+      cap = grown_cap;
+    }
+    fields[count++] = field;
+  }
+
+  AstNode *decl = NULL;
+  if (!p->had_error) {
+    parser_consume(p, RBRACE, "espera '}' no fim dos campos");
+    decl = ast_new_record(p->alloc, name, fields, count, is_union, reorder);
+  }
+  if (!decl) // erro: campos já parseados não têm dono
+    for (size_t i = 0; i < count; i++)
+      ast_free(p->alloc, fields[i]);
+  modal_free(p->alloc, fields, cap * sizeof(AstNode *));
+  return decl;
 }
@@ -1,33 +1,130 @@
 #include "parser.h"
-#include <stdlib.h>
+#include <string.h>
+
+// nome( [expr {, expr}] ) — o nome já foi consumido
+static AstNode *parse_call(Parser *p, Token name) {
+  parser_advance(p); // '('
+  AstNode *args[16];
+  size_t count = 0;
+  int height = 0;
+  if (p->current.kind != RPAREN) {
+    for (;;) {
+      AstNode *arg = parse_expression(p);
+      if (!arg || p->had_error) {
+        ast_free(p->alloc, arg);
+        goto fail;
+      }
+      if (count == sizeof(args) / sizeof(args[0])) {
+        ast_free(p->alloc, arg);
+        parser_error_at(p, &name, "argumentos demais em '%.*s'", name.len,
+                        name.start);
+        goto fail;
+      }
+      args[count++] = arg;
+      if (p->height > height)
+        height = p->height;
+      if (p->current.kind != OPERATOR || *p->current.start != ',')
+        break;
+      parser_advance(p);
+    }
+  }
+  parser_consume(p, RPAREN, "espera ')' no fim dos argumentos");
+  if (p->had_error)
+    goto fail;
+
+  AstNode *call = ast_new_call(p->alloc, name, args, count);
+  p->height = height + 1;
+  if (call)
+    return call;
+fail:
+  for (size_t i = 0; i < count; i++)
+    ast_free(p->alloc, args[i]);
+  return NULL;
+}
 
 static AstNode *parse_primary(Parser *p) {
+  p->height = 1; // folha; call e ( ) acertam depois
   if (parser_match(p, NUMBER)) {
-    long long val = strtoll(p->previous.start, NULL, 10);
-    return ast_new_number(p->previous, val);
+    Literal lit;
+    if (!parser_literal(p, &p->previous, &lit))
+      return NULL;
+    return lit.is_float ? ast_new_float(p->alloc, p->previous, lit.f64)
+                        : ast_new_number(p->alloc, p->previous, lit.i);
   }
   if (parser_match(p, IDENTIFIER)) {
-    return ast_new_ident(p->previous);
+    if (p->current.kind == LPAREN)
+      return parse_call(p, p->previous);
+    return ast_new_ident(p->alloc, p->previous);
+  }
+  if (parser_match(p, SIZEOF)) {
+    parser_consume(p, LPAREN, "espera '(' depois de 'sizeof'");
+    if (p->current.kind != IDENTIFIER) {
+      parser_error_at(p, &p->current, "sizeof espera um tipo");
+      return NULL;
+    }
+    Token type = p->current;
+    parser_advance(p);
+    parser_consume(p, RPAREN, "espera ')'");
+    return ast_new_sizeof(p->alloc, type); // layout.c dobra depois
   }
   if (parser_match(p, LPAREN)) {
     AstNode *expr = parse_expression(p); // recursão
     parser_consume(p, RPAREN, "espera ')'");
     return expr; // ou ast_new_paren se quiser preservar parens
   }
+  if (p->current.kind == FORMAT) {
+    parser_error_at(p, &p->current,
+                    "f-string só como mensagem: assert cond, f\"...\"");
+    return NULL;
+  }
   parser_error_at(p, &p->current, "espera expressão primária");
   return NULL;
 }
 
+static AstNode *parse_unary(Parser *p) { // -x
+  if (p->current.kind == OPERATOR && p->current.len == 1 &&
+      *p->current.start == '-') {
+    Token op_tok = p->current;
+    parser_advance(p);
+    if (!parser_enter(p))
+      return NULL;
+    AstNode *expr = parse_unary(p);
+    p->depth--;
+    p->height++;
+    return ast_new_unary(p->alloc, op_tok, expr);
+  }
+  return parse_primary(p);
+}
+
+// left op right, com a altura do left de antes do right — acima de
+// PARSER_MAX_HEIGHT vira erro e a cadeia para ali
+static AstNode *parse_binop(Parser *p, Token op_tok, AstNode *left,
+                            int left_height, AstNode *right) {
+  int height = (left_height > p->height ? left_height : p->height) + 1;
+  if (height > PARSER_MAX_HEIGHT) {
+    parser_error_at(p, &op_tok, "expressão passa de %d níveis",
+                    PARSER_MAX_HEIGHT);
+    ast_free(p->alloc, left);
+    ast_free(p->alloc, right);
+    return NULL;
+  }
+  p->height = height;
+  return ast_new_binop(p->alloc, op_tok, left, right);
+}
+
 static AstNode *parse_factor(Parser *p) { // * /
-  AstNode *left = parse_primary(p);
+  AstNode *left = parse_unary(p);
   while (p->current.kind == OPERATOR) {
     char op = *p->current.start;
     if (op != '*' && op != '/')
       break;
     Token op_tok = p->current;
     parser_advance(p);
-    AstNode *right = parse_primary(p);
-    left = ast_new_binop(op_tok, left, right);
+    int height = p->height;
+    AstNode *right = parse_unary(p);
+    left = parse_binop(p, op_tok, left, height, right);
+    if (!left)
+      break;
   }
   return left;
 }
@@ -40,12 +137,130 @@ static AstNode *parse_term(Parser *p) { // + -
       break;
     Token op_tok = p->current;
     parser_advance(p);
+    int height = p->height;
     AstNode *right = parse_factor(p);
-    left = ast_new_binop(op_tok, left, right);
+    left = parse_binop(p, op_tok, left, height, right);
+    if (!left)
+      break;
   }
   return left;
 }
 
+static int is_comparison(const Token *tok) {
+  if (tok->kind != OPERATOR)
+    return 0;
+  char c = *tok->start;
+  if (tok->len == 2) // == != <= >=
+    return tok->start[1] == '=' && (c == '=' || c == '!' || c == '<' ||
+                                    c == '>');
+  return tok->len == 1 && (c == '<' || c == '>');
+}
+
+static AstNode *parse_comparison(Parser *p) { // == != < <= > >=
+  AstNode *left = parse_term(p);
+  while (is_comparison(&p->current)) {
+    Token op_tok = p->current;
+    parser_advance(p);
+    int height = p->height;
+    AstNode *right = parse_term(p);
+    left = parse_binop(p, op_tok, left, height, right);
+    if (!left)
+      break;
+  }
+  return left;
+}
+
+static AstNode *parse_range(Parser *p) { // a..b
+  AstNode *lo = parse_comparison(p);
+  if (p->current.kind != DOTDOT)
+    return lo;
+  Token op_tok = p->current;
+  parser_advance(p);
+  int height = p->height;
+  AstNode *hi = parse_comparison(p);
+  if (height > p->height)
+    p->height = height;
+  p->height++;
+  return ast_new_range(p->alloc, op_tok, lo, hi);
+}
+
+static int stage_is(const Token *tok, const char *name) {
+  size_t len = strlen(name);
+  return (size_t)tok->len == len && memcmp(tok->start, name, len) == 0;
+}
+
+static const struct {
+  const char *name;
+  PipeTerminal terminal;
+} terminals[] = {{"sum", PIPE_SUM}, {"count", PIPE_COUNT}, {"min", PIPE_MIN},
+                 {"max", PIPE_MAX}, {"any", PIPE_ANY},     {"all", PIPE_ALL}};
+
+// fonte | map expr | filter expr | ... | terminal — `it` é o elemento atual
+static AstNode *parse_pipeline(Parser *p) {
+  AstNode *source = parse_range(p);
+  if (p->current.kind != PIPE || !source)
+    return source;
+
+  Token tok = p->current;
+  PipeStage stages[32];
+  size_t count = 0;
+  int terminal = -1;
+  int height = p->height;
+
+  while (terminal < 0 && p->current.kind == PIPE && !p->had_error) {
+    parser_advance(p);
+    Token name = p->current;
+    if (name.kind != IDENTIFIER) {
+      parser_error_at(p, &name, "espera estágio depois de '|'");
+      break;
+    }
+    parser_advance(p);
+
+    if (stage_is(&name, "map") || stage_is(&name, "filter")) {
+      if (count == sizeof(stages) / sizeof(stages[0])) {
+        parser_error_at(p, &name, "estágios demais no pipeline");
+        break;
+      }
+      AstNode *expr = parse_comparison(p);
+      if (!expr)
+        break;
+      if (p->height > height)
+        height = p->height;
+      stages[count++] = (PipeStage){
+          stage_is(&name, "map") ? PIPE_MAP : PIPE_FILTER, expr};
+      continue;
+    }
+    for (size_t i = 0; i < sizeof(terminals) / sizeof(terminals[0]); i++)
+      if (stage_is(&name, terminals[i].name))
+        terminal = (int)terminals[i].terminal;
+    if (terminal < 0)
+      parser_error_at(p, &name, "estágio desconhecido '%.*s'", name.len,
+                      name.start);
+  }
+
+  if (terminal >= 0 && p->current.kind == PIPE)
+    parser_error_at(p, &p->current, "nada depois do estágio terminal");
+  else if (terminal < 0 && !p->had_error)
+    parser_error_at(p, &p->current, "pipeline termina em sum, count, min, "
+                                    "max, any ou all");
+
+  p->height = height + 1;
+  AstNode *node = NULL;
+  if (!p->had_error)
+    node = ast_new_pipeline(p->alloc, tok, source, stages, count,
+                            (PipeTerminal)terminal);
+  if (!node) {
+    ast_free(p->alloc, source);
+    for (size_t i = 0; i < count; i++)
+      ast_free(p->alloc, stages[i].expr);
+  }
+  return node;
+}
+
 AstNode *parse_expression(Parser *p) { // entry point das expr
-  return parse_term(p); // por agora, term é o topo (expande com == > etc.)
+  if (!parser_enter(p)) // ( e argumentos aninham por aqui
+    return NULL;
+  AstNode *expr = parse_pipeline(p);
+  p->depth--;
+  return expr;
 }
@@ -0,0 +1,294 @@
+#include "ast.h"
+#include "parser.h"
+#include "preproc.h"
+#include <stdlib.h>
+#include <string.h>
+
+// f"x = {x}, f = {f:.3}" vira um plano fixo no parse: trechos literais já
+// decodificados + buracos com a expressão e o jeito de formatar. Quem roda
+// (lib/compiler/format.c) só mede e escreve, sem reinterpretar texto nenhum
+
+#define HOLE_STACK 256 // buraco maior que isso é lexado de uma cópia no heap
+
+typedef struct {
+  FmtPart *items;
+  int64_t *closes; // offset do '}' de cada buraco; -1: trecho sem buraco
+  size_t count, cap;
+  Token *toks; // tokens de todos os buracos, cada um fechado por um '}'
+  size_t ntoks, toks_cap;
+} FormatBuild;
+
+// Posição dentro do token com linha/coluna certas — string pode ter '\n'.
+// Só anda pra frente: os trechos são visitados em ordem
+typedef struct {
+  const Token *tok;
+  size_t off;
+  int line, col;
+} Cursor;
+
+static Token cursor_at(Cursor *c, size_t off, size_t len) {
+  for (; c->off < off; c->off++) {
+    if (c->tok->start[c->off] == '\n') {
+      c->line++;
+      c->col = 1;
+    } else {
+      c->col++;
+    }
+  }
+  Token t = *c->tok;
+  t.start += off;
+  t.offset += (int64_t)off;
+  t.len = (int)len;
+  t.line = c->line;
+  t.col = c->col;
+  return t;
+}
+
+static int grow(void **items, size_t *cap, size_t need, size_t size) {
+  if (need <= *cap)
+    return 1;
+  size_t n = *cap ? *cap * 2 : 8;
+  while (n < need)
+    n *= 2;
+  void *p = realloc(*items, n * size);
+  if (!p)
+    return 0;
+  *items = p;
+  *cap = n;
+  return 1;
+}
+
+static int push_part(FormatBuild *b, FmtPart part, int64_t close) {
+  size_t cap = b->cap;
+  if (!grow((void **)&b->closes, &cap, b->count + 1, sizeof(int64_t)) ||
+      !grow((void **)&b->items, &b->cap, b->count + 1, sizeof(FmtPart)))
+    return 0;
+  b->items[b->count] = part;
+  b->closes[b->count++] = close;
+  return 1;
+}
+
+static int push_tok(FormatBuild *b, Token t) {
+  if (!grow((void **)&b->toks, &b->toks_cap, b->ntoks + 1, sizeof(Token)))
+    return 0;
+  b->toks[b->ntoks++] = t;
+  return 1;
+}
+
+// Trecho literal tok[from, to) -> part->text, com os escapes decodificados
+static int literal(Parser *p, Cursor *c, size_t from, size_t to,
+                   FmtPart *part) {
+  const char *err;
+  size_t bad;
+  part->text = strpool_text(p->strings, c->tok->start + from, to - from,
+                            &part->len, &err, &bad);
+  if (part->text)
+    return 1;
+  Token at = cursor_at(c, from + bad, err ? 2 : to - from);
+  parser_error_at(p, &at, "%s", err ? err : "sem memória pra string");
+  return 0;
+}
+
+// Depois do último ':' solto (não '::'): d, x ou .N
+static int parse_spec(Parser *p, Cursor *c, size_t from, size_t to,
+                      FmtPart *part) {
+  const char *s = c->tok->start;
+  while (from < to && s[from] == ' ')
+    from++;
+  while (to > from && s[to - 1] == ' ')
+    to--;
+  size_t n = to - from;
+  if (n == 1 && (s[from] == 'd' || s[from] == 'x')) {
+    part->kind = s[from] == 'd' ? FMT_INT : FMT_HEX;
+    return 1;
+  }
+  if (n >= 2 && n <= 3 && s[from] == '.') {
+    int prec = 0;
+    size_t i = from + 1;
+    for (; i < to && s[i] >= '0' && s[i] <= '9'; i++)
+      prec = prec * 10 + (s[i] - '0');
+    if (i == to && prec <= FMT_MAX_PREC) {
+      part->kind = FMT_F64;
+      part->prec = prec;
+      return 1;
+    }
+  }
+  Token at = cursor_at(c, from, n ? n : 1);
+  parser_error_at(p, &at, "formato '%.*s' inválido (use d, x ou .N, N até %d)",
+                  (int)n, s + from, FMT_MAX_PREC);
+  return 0;
+}
+
+static size_t spec_colon(const char *s, size_t from, size_t to) {
+  for (size_t i = to; i-- > from;)
+    if (s[i] == ':' && s[i - 1] != ':' && (i + 1 == to || s[i + 1] != ':'))
+      return i;
+  return to;
+}
+
+// Buraco tok[from, to) (sem as chaves) -> tokens em b->toks, apontando pro
+// texto do próprio token, e o '}' em close como sentinela
+static int lex_hole(Parser *p, FormatBuild *b, Cursor *c, size_t from,
+                    size_t to, size_t close) {
+  const char *src = c->tok->start + from;
+  size_t n = to - from;
+  char stack[HOLE_STACK];
+  char *tmp = n < sizeof(stack) ? stack : malloc(n + 1);
+  if (!tmp)
+    return 0;
+  memcpy(tmp, src, n);
+  tmp[n] = '\0';
+
+  Token base = cursor_at(c, from, 0); // buraco não tem '\n'
+  Tokenizer lexer;
+  init(&lexer, tmp, p->alloc);
+  size_t first = b->ntoks;
+  int ok = 1;
+  for (Token t = next(&lexer); ok && t.kind != TOK_EOF; t = next(&lexer)) {
+    size_t at = (size_t)(t.start - tmp);
+    t.start = src + at;
+    t.offset = base.offset + (int64_t)at;
+    t.line = base.line;
+    t.col = base.col + (int)at;
+    if (t.kind == DIRECTIVE) {
+      parser_error_at(p, &t, "'#' não vale dentro de buraco de f-string");
+      ok = 0;
+    } else if (!push_tok(b, t)) {
+      ok = 0;
+    }
+  }
+  if (tmp != stack)
+    free(tmp);
+  if (!ok)
+    return 0;
+  if (b->ntoks == first) {
+    Token at = cursor_at(c, from - 1, n + 2);
+    parser_error_at(p, &at, "buraco vazio na f-string");
+    return 0;
+  }
+  Token end = cursor_at(c, close, 1);
+  end.kind = RBRACE;
+  return push_tok(b, end);
+}
+
+// Separa o token em trechos e buracos; os buracos ficam sem expr ainda
+static int split(Parser *p, FormatBuild *b, Cursor *c, size_t open) {
+  const char *s = c->tok->start;
+  size_t end = (size_t)c->tok->len - 1; // a aspa de fechamento
+  size_t seg = open;
+  int f = c->tok->kind == FORMAT;
+  for (size_t i = open; i < end; i++) {
+    if (s[i] == '\\') {
+      i++;
+      continue;
+    }
+    if (!f || (s[i] != '{' && s[i] != '}'))
+      continue;
+
+    FmtPart part = {0};
+    if (s[i + 1] == s[i] && i + 1 < end) { // {{ ou }}: fica um só
+      if (!literal(p, c, seg, i + 1, &part) || !push_part(b, part, -1))
+        return 0;
+      seg = i + 2;
+      i++;
+      continue;
+    }
+    if (s[i] == '}') {
+      Token at = cursor_at(c, i, 1);
+      parser_error_at(p, &at, "'}' sozinho na f-string (use }} pro texto)");
+      return 0;
+    }
+
+    size_t j = i + 1;
+    while (j < end && s[j] != '}' && s[j] != '\n')
+      j++;
+    if (j == end || s[j] == '\n') {
+      Token at = cursor_at(c, i, 1);
+      parser_error_at(p, &at, "'{' sem '}' na f-string");
+      return 0;
+    }
+    if (!literal(p, c, seg, i, &part))
+      return 0;
+    size_t colon = spec_colon(s, i + 1, j);
+    if (colon < j && !parse_spec(p, c, colon + 1, j, &part))
+      return 0;
+    if (!lex_hole(p, b, c, i + 1, colon, j) ||
+        !push_part(b, part, c->tok->offset + (int64_t)j))
+      return 0;
+    seg = j + 1;
+    i = j;
+  }
+  if (seg == end && b->count)
+    return 1;
+  FmtPart tail = {0};
+  return literal(p, c, seg, end, &tail) && push_part(b, tail, -1);
+}
+
+static int closed(const Token *tok, size_t open) {
+  size_t len = (size_t)tok->len, slashes = 0;
+  while (len >= open + 2 + slashes && tok->start[len - 2 - slashes] == '\\')
+    slashes++;
+  return len > open && tok->start[len - 1] == '"' && slashes % 2 == 0;
+}
+
+// Depois de pp_inject os buracos chegam pelo parser_advance normal: cada um
+// é uma expressão seguida do próprio '}' sentinela
+static int parse_holes(Parser *p, FormatBuild *b) {
+  int ok = 1;
+  for (size_t i = 0; i < b->count; i++) {
+    int64_t close = b->closes[i];
+    if (close < 0)
+      continue;
+    parser_advance(p);
+    AstNode *expr = parse_expression(p);
+    int at_close = p->current.kind == RBRACE && p->current.offset == close;
+    if (expr && at_close) {
+      b->items[i].expr = expr;
+      continue;
+    }
+    if (expr)
+      parser_error_at(p, &p->current, "espera '}' no fim do buraco");
+    ast_free(p->alloc, expr);
+    ok = 0;
+    while (!p->halted && p->current.kind != TOK_EOF &&
+           !(p->current.kind == RBRACE && p->current.offset == close))
+      parser_advance(p); // o resto do buraco não vaza pro statement
+  }
+  return ok;
+}
+
+static void build_free(Parser *p, FormatBuild *b) {
+  for (size_t i = 0; i < b->count; i++)
+    ast_free(p->alloc, b->items[i].expr);
+  free(b->items);
+  free(b->closes);
+}
+
+AstNode *parse_format(Parser *p) {
+  Token tok = p->current;
+  size_t open = tok.kind == FORMAT ? 2 : 1;
+  if (!closed(&tok, open)) {
+    parser_error_at(p, &tok, "string sem '\"' no fim");
+    return NULL;
+  }
+
+  FormatBuild b = {0};
+  Cursor c = {&tok, 0, tok.line, tok.col};
+  int ok = split(p, &b, &c, open);
+  if (ok && b.ntoks) {
+    ok = pp_inject(p, b.toks, b.ntoks); // os tokens agora são dele
+    b.toks = NULL;
+    ok = ok && parse_holes(p, &b);
+  }
+  free(b.toks);
+  parser_advance(p); // o último '}' ou o próprio token
+
+  AstNode *node = ok ? ast_new_format(p->alloc, tok, b.items, b.count) : NULL;
+  if (!node) {
+    build_free(p, &b);
+    return NULL;
+  }
+  free(b.items); // o nó copiou; as exprs agora são dele
+  free(b.closes);
+  return node;
+}
@@ -13,101 +13,208 @@ AstNode *parse_block(Parser *p) {
   AstNode **stmts = NULL;
   size_t count = 0, cap = 4; // cresce como vector
 
-  stmts = malloc(cap * sizeof(AstNode *));
+  stmts = modal_alloc(p->alloc, cap * sizeof(AstNode *));
   if (!stmts)
     return NULL;
 
   while (p->current.kind != RBRACE && p->current.kind != TOK_EOF) {
     AstNode *stmt = parse_statement(p);
     if (p->had_error || !stmt) {
+      ast_free(p->alloc, stmt); // stmt parcial, descarta
       parser_synchronize(p);
       continue;
     }
 
     if (count >= cap) {
-      cap *= 2;
-      AstNode **new_stmts = realloc(stmts, cap * sizeof(AstNode *));
+      AstNode **new_stmts =
+          modal_realloc(p->alloc, stmts, cap * sizeof(AstNode *),
+                        cap * 2 * sizeof(AstNode *));
       if (!new_stmts) { /* handle error */
-        free(stmts);
+        modal_free(p->alloc, stmts, cap * sizeof(AstNode *));
         return NULL;
       }
       stmts = new_stmts;
+      cap *= 2;
     }
     stmts[count++] = stmt;
   }
 
   parser_consume(p, RBRACE, "espera '}' no fim do bloco");
-  return ast_new_block(open_tok, stmts, count);
+  AstNode *block = ast_new_block(p->alloc, open_tok, stmts, count);
+  modal_free(p->alloc, stmts,
+             cap * sizeof(AstNode *)); // ast_new_block copia os ponteiros
+  return block;
+}
+
+// ; opcional no fim — por quê? Sem ele o próximo stmt já delimita
+static void skip_semicolon(Parser *p) {
+  if (p->current.kind == OPERATOR && *p->current.start == ';')
+    parser_advance(p);
+}
+
+static int is_assign_op(const Token *tok) {
+  return tok->kind == OPERATOR && tok->len == 1 && *tok->start == '=';
 }
 
+// assert expr [, "msg" | f"msg {x}"] — a mensagem só é montada se falhar
 AstNode *parse_assert(Parser *p) {
   AstNode *expr = parse_expression(p); // recursão pra expr completa
   if (!expr)
     return NULL;
+  AstNode *message = NULL;
+  if (p->current.kind == OPERATOR && *p->current.start == ',') {
+    parser_advance(p);
+    if (p->current.kind != FORMAT && p->current.kind != STRING) {
+      parser_error_at(p, &p->current,
+                      "espera mensagem (\"...\" ou f\"...\") depois da ','");
+      ast_free(p->alloc, expr);
+      return NULL;
+    }
+    message = parse_format(p);
+    if (!message) {
+      ast_free(p->alloc, expr);
+      return NULL;
+    }
+  }
+  skip_semicolon(p);
+  AstNode *node = ast_new_assert(p->alloc, expr, message);
+  if (!node) {
+    ast_free(p->alloc, expr);
+    ast_free(p->alloc, message);
+  }
+  return node;
+}
+
+// Já consumiu o nome e está no '='
+static AstNode *parse_var_rest(Parser *p, Token name, int autofree) {
+  parser_advance(p); // '='
+  AstNode *init = parse_expression(p);
+  if (!init || p->had_error)
+    return init; // parse_program/parse_block descartam
+  skip_semicolon(p);
+  AstNode *decl = ast_new_var(p->alloc, name, init, autofree);
+  if (!decl)
+    ast_free(p->alloc, init);
+  return decl;
+}
 
-  // Opcional: ; mas sync cuida
-  // if (p->current.kind == OPERATOR && *p->current.start == ';') {
+static AstNode *parse_autofree(Parser *p) {
+  if (p->current.kind != IDENTIFIER) {
+    parser_error_at(p, &p->current, "espera nome depois de 'autofree'");
+    return NULL;
+  }
+  Token name = p->current;
   parser_advance(p);
-  // }
+  if (!is_assign_op(&p->current)) {
+    parser_error_at(p, &p->current, "espera '=' em 'autofree %.*s'",
+                    name.len, name.start);
+    return NULL;
+  }
+  return parse_var_rest(p, name, 1);
+}
 
-  return ast_new_assert(expr);
+// Defer roda no fim do escopo, fora do fluxo normal — não pode suspender,
+// e autofree solto morreria na mesma hora
+static int defer_allowed(const AstNode *stmt) {
+  switch (stmt->kind) {
+  case AST_ASYNC_BLOCK:
+  case AST_AWAIT_STMT:
+  case AST_TEST_STMT:
+    return 0;
+  case AST_VAR_DECL:
+    return !stmt->data.var.autofree;
+  case AST_BLOCK:
+    for (size_t i = 0; i < stmt->data.block_or_group.count; i++) {
+      const AstNode *child = stmt->data.block_or_group.stmts[i];
+      if (!child)
+        continue;
+      if (child->kind == AST_VAR_DECL)
+        continue; // dentro de bloco próprio, autofree é local do defer
+      if (!defer_allowed(child))
+        return 0;
+    }
+    return 1;
+  default:
+    return 1;
+  }
 }
 
-AstNode *parse_statement(Parser *p) {
+static AstNode *parse_defer(Parser *p, Token tok) {
+  AstNode *stmt = parse_statement(p);
+  if (!stmt || p->had_error)
+    return stmt;
+  if (!defer_allowed(stmt)) {
+    parser_error_at(p, &tok, "defer não aceita async, await, test nem "
+                             "autofree solto");
+    return stmt;
+  }
+  AstNode *node = ast_new_defer(p->alloc, tok, stmt);
+  if (!node)
+    ast_free(p->alloc, stmt);
+  return node;
+}
+
+static AstNode *statement(Parser *p) {
   switch (p->current.kind) {
   case ASSERT:
     parser_advance(p);
     return parse_assert(p);
 
-    // case TEST:
-    //   parser_advance(p);
-    //
-    //   if (p->current.kind != LBRACE) {
-    //     parser_error_at(p, &p->current, "`test` statement missing block");
-    //     return NULL;
-    //   }
-    //
-    //   if (p->current.kind == IDENTIFIER) {
-    //     parser_error_at(p, &p->current,
-    //                     "test name must be a string literal (use quotes: test
-    //                     "
-    //                     "\"name\" { ... })");
-    //     return NULL;
-    //   }
-    //
-    //   if (p->current.kind != STRING) {
-    //     parser_error_at(p, &p->current, "expected string literal after
-    //     `test`"); return NULL;
-    //   }
-    //
-    //   Token test = p->current;
-    //   printf("test len %c", p->current.len);
-    //
-    //   if (test.len < 3) {
-    //     parser_error_at(p, &test, "test need to have a name definition");
-    //     return NULL;
-    //   }
-    //
-    //   parser_advance(p);
-    //
-    //   if (p->current.kind != LBRACE) {
-    //     parser_error_at(p, &p->current, "expected '{' after test name");
-    //     return NULL;
-    //   }
-    //
-    //   AstNode *block = parse_block(p);
-    //   if (!block) {
-    //     // parser_error_at(p, &p->current, "expected '{' after test name");
-    //     return NULL;
-    //   }
-    //
-    //   return ast_new_test(test, block);
+  case TEST:
+    parser_advance(p);
+    return parse_test_decl(p);
+
+  case ASYNC: {
+    Token tok = p->current;
+    parser_advance(p);
+    if (p->current.kind != LBRACE) {
+      parser_error_at(p, &p->current, "espera '{' depois de 'async'");
+      return NULL;
+    }
+    AstNode *block = parse_block(p);
+    if (!block)
+      return NULL;
+    return ast_new_async(p->alloc, tok, block);
+  }
+
+  case AWAIT: {
+    Token tok = p->current;
+    parser_advance(p);
+    skip_semicolon(p);
+    return ast_new_await(p->alloc, tok);
+  }
+
+  case AUTOFREE:
+    parser_advance(p);
+    return parse_autofree(p);
+
+  case USE: // parse_program trata o use do topo antes de chegar aqui
+    parser_error_at(p, &p->current, "use só no topo do arquivo");
+    return NULL;
+
+  case STRUCT:
+  case UNION: {
+    int is_union = p->current.kind == UNION;
+    parser_advance(p);
+    return parse_record_decl(p, is_union);
+  }
+
+  case DEFER: {
+    Token tok = p->current;
+    parser_advance(p);
+    return parse_defer(p, tok);
+  }
 
   case LBRACE:
     return parse_block(p);
 
   default: {
     AstNode *expr = parse_expression(p);
+    if (expr && expr->kind == AST_IDENT && is_assign_op(&p->current)) {
+      Token name = expr->token;
+      ast_free(p->alloc, expr);
+      return parse_var_rest(p, name, 0);
+    }
     if (expr)
       return expr; // por agora, expr é stmt
     parser_error_at(p, &p->current, "statement inesperado");
@@ -115,3 +222,11 @@ AstNode *parse_statement(Parser *p) {
   }
   }
 }
+
+AstNode *parse_statement(Parser *p) { // { e defer aninham por aqui
+  if (!parser_enter(p))
+    return NULL;
+  AstNode *stmt = statement(p);
+  p->depth--;
+  return stmt;
+}
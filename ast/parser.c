@@ -1,4 +1,8 @@
 #include "parser.h"
+#include "cimport.h"
+#include "layout.h"
+#include "preproc.h"
+#include "types.h"
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,15 +10,31 @@
 
 void parser_init(Parser *p, Tokenizer *lexer, const char *filename) {
   p->lexer = lexer;
+  p->alloc = lexer->alloc;
   p->filename = filename;
   p->had_error = 0;
+  p->halted = 0;
+  p->natives = NULL;
+  p->imports = NULL;
+  p->find_module = NULL;
+  p->modules = NULL;
+  p->includes = NULL;
+  p->pp = NULL;
+  p->deps = NULL;
+  p->strings = NULL;
+  p->types = NULL;
+  p->depth = 0;
+  p->height = 0;
+  diag_init(&p->diag, p->alloc, filename, 0);
   p->current = next(lexer); // prime token
   p->previous = (Token){0};
 }
 
 void parser_advance(Parser *p) {
+  if (p->halted)
+    return; // current já é EOF
   p->previous = p->current;
-  p->current = next(p->lexer);
+  p->current = pp_next(p);
 }
 
 int parser_match(Parser *p, Kind kind) {
@@ -25,6 +45,46 @@ int parser_match(Parser *p, Kind kind) {
   return 0;
 }
 
+int parser_literal(Parser *p, const Token *tok, Literal *out) {
+  size_t bad;
+  const char *err = literal_parse(tok->start, (size_t)tok->len, out, &bad);
+  if (!err)
+    return 1;
+  Token at = *tok; // ^ no dígito errado, não no literal inteiro
+  at.start += bad;
+  at.col += (int)bad;
+  at.offset += (int64_t)bad;
+  at.len = bad ? tok->len - (int)bad : tok->len;
+  parser_error_at(p, &at, "%s", err);
+  return 0;
+}
+
+int parser_string(Parser *p, const Token *tok, const char **out, size_t *len) {
+  const char *err;
+  size_t bad;
+  *out = strpool_literal(p->strings, tok->start, (size_t)tok->len, len, &err,
+                         &bad);
+  if (*out)
+    return 1;
+  Token at = *tok;
+  at.start += bad;
+  at.col += (int)bad;
+  at.offset += (int64_t)bad;
+  at.len = bad ? 2 : tok->len; // o escape, ou a string toda
+  parser_error_at(p, &at, "%s", err ? err : "sem memória pra string");
+  return 0;
+}
+
+int parser_enter(Parser *p) {
+  if (p->depth < PARSER_MAX_DEPTH) {
+    p->depth++;
+    return 1;
+  }
+  parser_error_at(p, &p->current, "aninhamento passa de %d níveis",
+                  PARSER_MAX_DEPTH);
+  return 0;
+}
+
 void parser_consume(Parser *p, Kind kind, const char *msg) {
   if (p->current.kind == kind) {
     parser_advance(p);
@@ -37,26 +97,85 @@ void parser_consume(Parser *p, Kind kind, const char *msg) {
 AstNode *parse_program(Parser *p) {
   AstNode **stmts = NULL;
   size_t count = 0;
-  size_t cap = 8;
+  size_t cap = 0;
 
-  stmts = malloc(cap * sizeof(AstNode *));
-  if (!stmts)
-    return NULL;
+  // Fonte que começa com # — por quê aqui? O init já leu o primeiro token,
+  // antes de quem chama ligar includes e max_errors
+  if (p->current.kind == DIRECTIVE)
+    p->current = pp_resume(p, p->current);
 
   while (p->current.kind != TOK_EOF) {
+    if (p->current.kind == USE) { // um use vira vários nós de topo
+      if (!parse_use(p, &stmts, &count, &cap))
+        parser_synchronize(p);
+      continue;
+    }
+
     AstNode *stmt = parse_statement(p);
     if (p->had_error) {
+      ast_free(p->alloc, stmt); // stmt parcial, descarta
       parser_synchronize(p);
       continue;
     }
+    if (!ast_list_push(p->alloc, &stmts, &count, &cap, stmt)) {
+      ast_free(p->alloc, stmt);
+      break;
+    }
+  }
 
-    if (count >= cap) {
-      cap *= 2;
-      stmts = realloc(stmts, cap * sizeof(AstNode *));
+  AstNode *root = ast_new_block(p->alloc, p->current, stmts,
+                                count); // root = block de top-level stmts
+  modal_free(p->alloc, stmts,
+             cap * sizeof(AstNode *)); // ast_new_block copia os ponteiros
+  if (!p->had_error)
+    resolve_layouts(p, root); // sizeof vira constante antes de qualquer hash
+  if (!p->had_error)
+    resolve_externs(p, root); // idem pras constantes de C
+  if (!p->had_error)
+    ast_typecheck(p, root); // antes do pp_free, pelo mesmo motivo do layout
+  cimport_free(p);
+  pp_free(p); // depois do layout: erro dele em token de #include acha o arquivo
+  if (!p->had_error)
+    ast_escape_analyze(root);
+  return root;
+}
+
+void parser_note_file(Parser *p, const char *path, uint64_t hash) {
+  FileDeps *d = p->deps;
+  if (!d)
+    return;
+  for (size_t i = 0; i < d->count; i++)
+    if (strcmp(d->paths[i], path) == 0)
+      return;
+  if (d->count == d->cap) {
+    size_t cap = d->cap ? d->cap * 2 : 4;
+    char **paths = realloc(d->paths, cap * sizeof(char *));
+    if (paths)
+      d->paths = paths;
+    uint64_t *hashes =
+        paths ? realloc(d->hashes, cap * sizeof(uint64_t)) : NULL;
+    if (!hashes) {
+      d->incomplete = 1;
+      return;
     }
-    stmts[count++] = stmt;
+    d->hashes = hashes;
+    d->cap = cap;
   }
+  size_t len = strlen(path);
+  char *copy = malloc(len + 1);
+  if (!copy) {
+    d->incomplete = 1;
+    return;
+  }
+  memcpy(copy, path, len + 1);
+  d->paths[d->count] = copy;
+  d->hashes[d->count++] = hash;
+}
 
-  return ast_new_block(p->current, stmts,
-                       count); // root = block de top-level stmts
+void file_deps_free(FileDeps *d) {
+  for (size_t i = 0; i < d->count; i++)
+    free(d->paths[i]);
+  free(d->paths);
+  free(d->hashes);
+  *d = (FileDeps){0};
 }
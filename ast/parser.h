@@ -3,21 +3,65 @@
 
 #include "../tokenizer/tokenizer.h" // Token, TokenKind, Tokenizer
 #include "ast.h"                    // AstNode, AstNodeKind
+#include "diagnostics.h"            // Diagnostics
+#include "literal.h"                // Literal
+#include "strpool.h"                // StrPool
 
 #include <stdarg.h> // va_list (pra error variádico)
 #include <stddef.h> // size_t
 
+// Aninhamento máximo de expressões e statements — por quê um limite? O
+// parse e todo passe depois dele (fold, hash, checker, eval) são recursivos:
+// 20 mil '(' estouravam a pilha
+#define PARSER_MAX_DEPTH 256
+// Altura máxima da árvore de uma expressão — por quê outro limite? Cadeia
+// `1 + 1 + ...` é laço no parse, mas cada termo é um nível na árvore que os
+// passes descem; 100k termos estouravam a pilha
+#define PARSER_MAX_HEIGHT 10000
+
 typedef struct Parser Parser;
+typedef struct CImport CImport; // cimport.c
+typedef struct ModuleIface ModuleIface; // iface.h
+typedef struct IncludeCache IncludeCache; // preproc.h
+typedef struct TypeTable TypeTable;       // types.h
+typedef struct Preproc Preproc;           // preproc.c
+
+// Arquivos que o parse leu além do fonte (#include, use "x.h") com o hash do
+// conteúdo — por quê? A interface do módulo só vale se eles também não mudaram
+typedef struct {
+  char **paths;
+  uint64_t *hashes;
+  size_t count, cap;
+  int incomplete; // faltou memória pra algum: não dá pra confiar na lista
+} FileDeps;
 
 struct Parser {
   Tokenizer *lexer;
+  const ModalAllocator *alloc; // herdado do lexer; nós da AST vêm daqui
   Token current;
   Token previous;
   const char *filename;
   int had_error; // flag pra saber se rolou erro em algum ponto
+  int halted;    // bateu diag.max_errors: daqui pra frente só EOF
+  Diagnostics diag; // erros acumulados; quem chama renderiza e libera
+  const NativeLibs *natives; // --link; NULL = só símbolos do processo
+  CImport *imports; // constantes/typedefs dos use, vivem até o fim do parse
+  // use "x.modal": interface do módulo como escrito no use; NULL = fora de
+  // um programa carregado do disco (stdin, modal_parse), módulo vira erro
+  const ModuleIface *(*find_module)(void *modules, const char *path,
+                                    size_t len);
+  void *modules;
+  IncludeCache *includes; // #include "x"; NULL = diretiva vira erro
+  Preproc *pp;            // macros e #if abertos; nasce na primeira diretiva
+  FileDeps *deps;         // NULL = ninguém quer saber
+  StrPool *strings;       // strings com escape; NULL = escape vira erro
+  TypeTable *types; // tipo de cada expressão; NULL = checa e descarta
+  int depth;        // parse_expression/parse_statement abertos agora
+  int height;       // altura da última expressão que o parse montou
 };
 
-// Inicialização e entry point principal
+// Inicialização e entry point principal. diag.max_errors pode ser ajustado
+// depois do init; no fim, diag_render + diag_free
 void parser_init(Parser *p, Tokenizer *lexer, const char *filename);
 AstNode *
 parse_program(Parser *p); // retorna raiz da AST (um AST_BLOCK top-level)
@@ -27,15 +71,30 @@ void parser_advance(Parser *p);
 int parser_match(Parser *p, Kind kind);
 void parser_consume(Parser *p, Kind kind, const char *msg);
 void parser_error_at(Parser *p, Token *tok, const char *fmt, ...);
+// Aviso não marca had_error nem conta pro --max-errors
+void parser_warn_at(Parser *p, Token *tok, const char *fmt, ...);
 void parser_synchronize(Parser *p); // recovery básico após erro
+// Mais um nível de aninhamento; 0 (com erro) acima de PARSER_MAX_DEPTH.
+// Com 1, quem chamou desce p->depth na saída
+int parser_enter(Parser *p);
+// Valor do NUMBER tok; literal malformado vira erro no caractere culpado
+int parser_literal(Parser *p, const Token *tok, Literal *out);
+// Conteúdo do STRING tok, sem aspas e com os escapes decodificados (p->strings)
+int parser_string(Parser *p, const Token *tok, const char **out, size_t *len);
+// Registra em p->deps, uma vez por path
+void parser_note_file(Parser *p, const char *path, uint64_t hash);
+void file_deps_free(FileDeps *d);
 
 // Funções de parse expostas (pra modularidade — cada uma em seu .c)
 AstNode *parse_expression(Parser *p); // em parse_expr.c
 AstNode *parse_statement(Parser *p);  // em parse_stmt.c
 AstNode *parse_block(Parser *p);      // em parse_stmt.c
 AstNode *parse_assert(Parser *p);     // em parse_stmt.c
+AstNode *parse_test_decl(Parser *p);                 // em parse_decl.c
+// FORMAT ou STRING em current -> AST_FORMAT; avança além dele
+AstNode *parse_format(Parser *p); // em parse_format.c
+AstNode *parse_record_decl(Parser *p, int is_union); // em parse_decl.c
 // Futuro:
-AstNode *parse_test_decl(Parser *p);
 // AstNode  *parse_declaration(Parser *p);        // fn, struct, var...
 
 #endif // PARSER_H
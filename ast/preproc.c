@@ -0,0 +1,1138 @@
+#define _DEFAULT_SOURCE // realpath
+#include "preproc.h"
+#include "../lib/compiler/source.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PP_MAX_INCLUDES 64 // aninhamento: ciclo sem guard para aqui
+#define PP_MAX_FRAMES 512  // expansão de macro dentro de macro
+// Orçamento do parse inteiro — por quê? A profundidade não segura largura:
+// 40 linhas de #define Ai A(i-1) + A(i-1) já são 2^40 tokens
+#define PP_MAX_EXPANSIONS (1u << 20)
+#define PP_MAX_EXPANDED (1u << 20) // tokens que as macros produziram
+
+struct IncludeFile {
+  char *path; // como resolvido na primeira vez: diagnóstico e FileDeps
+  char *key;  // realpath
+  char *text;
+  size_t len;
+  uint64_t hash;
+  Token *tokens; // o arquivo inteiro, sem o EOF
+  size_t count;
+  const char *guard; // #ifndef G / #define G ... #endif; aponta pro texto
+  size_t guard_len;
+  int once; // #pragma once
+};
+
+typedef struct {
+  const char *name;
+  size_t len;
+  Token *body;
+  size_t count;
+  Token *params;
+  size_t nparams;
+  int function; // NOME(...) — '(' colado no nome
+  int active;   // em expansão: o nome dentro dele não reexpande
+} Macro;
+
+typedef struct {
+  const Token *toks;
+  size_t count, pos;
+  Token *owned;            // corpo já com os argumentos (macro função)
+  Macro *macro;            // reativa quando o frame acaba
+  const IncludeFile *file; // frame de #include
+  size_t conds;            // profundidade de #if quando o include entrou
+} Frame;
+
+typedef struct {
+  Token where;
+  int active; // o ramo atual vale
+  int taken;  // algum ramo já valeu: #elif/#else seguintes não
+  int parent; // o #if de fora está ativo
+  int in_else;
+} Cond;
+
+struct Preproc {
+  Macro *macros; // #undef deixa len 0 no lugar: o índice em slots não muda
+  size_t nmacros, macros_cap;
+  // Hash do nome -> índice + 1 em macros (0 = vazio); potência de 2 acima
+  // de 2 * nmacros — por quê? Cadeia de milhares de #define com uma busca
+  // por expansão ficava quadrática
+  size_t *slots;
+  size_t slots_cap;
+  Frame *frames;
+  size_t nframes, frames_cap;
+  Cond *conds;
+  size_t nconds, conds_cap;
+  const IncludeFile **seen; // incluídos neste parse: once e pp_locate
+  size_t nseen, seen_cap;
+  size_t includes; // frames de #include abertos
+  size_t expansions, expanded; // gastos do orçamento PP_MAX_*
+  Token pushback;
+  int has_pushback;
+};
+
+static int grow(void **items, size_t *cap, size_t need, size_t size) {
+  if (need <= *cap)
+    return 1;
+  size_t n = *cap ? *cap : 8;
+  while (n < need)
+    n *= 2;
+  void *p = realloc(*items, n * size);
+  if (!p)
+    return 0;
+  *items = p;
+  *cap = n;
+  return 1;
+}
+
+static int text_is(const Token *t, const char *s) {
+  size_t n = strlen(s);
+  return (size_t)t->len == n && memcmp(t->start, s, n) == 0;
+}
+
+// ----- palavras cruas da linha (guard e once, sem sub-tokenizar) -----
+
+static const char *skip_blank(const char *s, const char *end) {
+  while (s < end && (*s == ' ' || *s == '\t' || *s == '\\' || *s == '\n' ||
+                     *s == '\r'))
+    s++;
+  return s;
+}
+
+static const char *word(const char *s, const char *end, size_t *len) {
+  s = skip_blank(s, end);
+  const char *w = s;
+  while (s < end && (*s == '_' || (*s >= 'a' && *s <= 'z') ||
+                     (*s >= 'A' && *s <= 'Z') || (*s >= '0' && *s <= '9')))
+    s++;
+  *len = (size_t)(s - w);
+  return w;
+}
+
+// Nome da diretiva (depois do '#') e, opcional, a palavra seguinte
+static int directive_is(const Token *dir, const char *name, const char **arg,
+                        size_t *arg_len) {
+  const char *end = dir->start + dir->len;
+  size_t len;
+  const char *w = word(dir->start + 1, end, &len);
+  if (len != strlen(name) || memcmp(w, name, len) != 0)
+    return 0;
+  if (arg)
+    *arg = word(w + len, end, arg_len);
+  return 1;
+}
+
+// ----- cache -----
+
+void include_cache_init(IncludeCache *c) {
+  *c = (IncludeCache){0};
+  pthread_mutex_init(&c->lock, NULL);
+}
+
+static void file_free(IncludeFile *f) {
+  free(f->path);
+  free(f->key);
+  free(f->text);
+  free(f->tokens);
+  free(f);
+}
+
+void include_cache_free(IncludeCache *c) {
+  for (size_t i = 0; i < c->count; i++)
+    file_free(c->files[i]);
+  free(c->files);
+  pthread_mutex_destroy(&c->lock);
+  *c = (IncludeCache){0};
+}
+
+// O #ifndef do começo tem que fechar no último token: só aí o arquivo
+// inteiro some quando G já está definido
+static void detect_guard(IncludeFile *f) {
+  if (f->count < 3 || f->tokens[0].kind != DIRECTIVE ||
+      f->tokens[1].kind != DIRECTIVE)
+    return;
+  const char *g, *d;
+  size_t glen, dlen;
+  if (!directive_is(&f->tokens[0], "ifndef", &g, &glen) || !glen ||
+      !directive_is(&f->tokens[1], "define", &d, &dlen) || dlen != glen ||
+      memcmp(g, d, glen) != 0)
+    return;
+
+  int depth = 0;
+  for (size_t i = 0; i < f->count; i++) {
+    const Token *t = &f->tokens[i];
+    if (t->kind != DIRECTIVE)
+      continue;
+    if (directive_is(t, "if", NULL, NULL) ||
+        directive_is(t, "ifdef", NULL, NULL) ||
+        directive_is(t, "ifndef", NULL, NULL))
+      depth++;
+    else if (directive_is(t, "endif", NULL, NULL) && --depth == 0)
+      if (i + 1 != f->count)
+        return;
+  }
+  if (depth == 0) {
+    f->guard = g;
+    f->guard_len = glen;
+  }
+}
+
+static IncludeFile *load_file(const char *path, char *key) {
+  IncludeFile *f = calloc(1, sizeof(IncludeFile));
+  long len = 0;
+  char *text = f ? source_read(key, &len) : NULL;
+  size_t plen = strlen(path);
+  char *copy = text ? malloc(plen + 1) : NULL;
+  if (!copy) {
+    free(text);
+    free(f);
+    free(key);
+    return NULL;
+  }
+  memcpy(copy, path, plen + 1);
+  *f = (IncludeFile){.path = copy,
+                     .key = key,
+                     .text = text,
+                     .len = (size_t)len,
+                     .hash = ast_hash_bytes(text, (size_t)len)};
+
+  Tokenizer lexer;
+  init(&lexer, text, NULL);
+  size_t cap = 0;
+  for (Token t = next(&lexer); t.kind != TOK_EOF; t = next(&lexer)) {
+    if (!grow((void **)&f->tokens, &cap, f->count + 1, sizeof(Token))) {
+      file_free(f);
+      return NULL;
+    }
+    f->tokens[f->count++] = t;
+    if (t.kind == DIRECTIVE) {
+      const char *arg;
+      size_t arg_len;
+      if (directive_is(&t, "pragma", &arg, &arg_len) && arg_len == 4 &&
+          memcmp(arg, "once", 4) == 0)
+        f->once = 1;
+    }
+  }
+  detect_guard(f);
+  return f;
+}
+
+// Lê e tokeniza na primeira vez; as próximas (de qualquer thread) só acham.
+// NULL se não existe
+static const IncludeFile *cache_get(IncludeCache *c, const char *path) {
+  char *key = realpath(path, NULL);
+  if (!key)
+    return NULL;
+
+  pthread_mutex_lock(&c->lock);
+  IncludeFile *f = NULL;
+  for (size_t i = 0; i < c->count && !f; i++)
+    if (strcmp(c->files[i]->key, key) == 0)
+      f = c->files[i];
+  if (f) {
+    free(key);
+  } else if (grow((void **)&c->files, &c->cap, c->count + 1,
+                  sizeof(IncludeFile *))) {
+    f = load_file(path, key);
+    if (f)
+      c->files[c->count++] = f;
+  } else {
+    free(key);
+  }
+  pthread_mutex_unlock(&c->lock);
+  return f;
+}
+
+// ----- estado do parse -----
+
+static Preproc *pp_get(Parser *p) {
+  if (!p->pp) {
+    p->pp = calloc(1, sizeof(Preproc));
+    if (!p->pp)
+      parser_error_at(p, &p->current, "sem memória pro pré-processador");
+  }
+  return p->pp;
+}
+
+static size_t *slot_of(const Preproc *pp, size_t *slots, size_t cap,
+                       const char *name, size_t len) {
+  uint64_t h = 0xcbf29ce484222325ULL; // FNV-1a
+  for (size_t i = 0; i < len; i++)
+    h = (h ^ (unsigned char)name[i]) * 0x100000001b3ULL;
+  for (size_t i = (size_t)h & (cap - 1);; i = (i + 1) & (cap - 1)) {
+    const Macro *m = slots[i] ? &pp->macros[slots[i] - 1] : NULL;
+    if (!m || (m->len == len && memcmp(m->name, name, len) == 0))
+      return &slots[i];
+  }
+}
+
+static Macro *find_macro(Preproc *pp, const char *name, size_t len) {
+  if (!pp->slots_cap || !len)
+    return NULL;
+  size_t k = *slot_of(pp, pp->slots, pp->slots_cap, name, len);
+  return k ? &pp->macros[k - 1] : NULL;
+}
+
+// Slot pra macros[nmacros]; 0 sem memória
+static int reserve_slot(Preproc *pp) {
+  if ((pp->nmacros + 1) * 2 <= pp->slots_cap)
+    return 1;
+  size_t cap = pp->slots_cap ? pp->slots_cap * 2 : 16;
+  size_t *slots = calloc(cap, sizeof(size_t));
+  if (!slots)
+    return 0;
+  for (size_t i = 0; i < pp->nmacros; i++) {
+    const Macro *m = &pp->macros[i];
+    if (m->len)
+      *slot_of(pp, slots, cap, m->name, m->len) = i + 1;
+  }
+  free(pp->slots);
+  pp->slots = slots;
+  pp->slots_cap = cap;
+  return 1;
+}
+
+static void macro_free(Macro *m) {
+  free(m->body);
+  free(m->params);
+}
+
+static int skipping(const Preproc *pp) {
+  return pp->nconds && !pp->conds[pp->nconds - 1].active;
+}
+
+static void pop_frame(Parser *p) {
+  Preproc *pp = p->pp;
+  Frame *f = &pp->frames[--pp->nframes];
+  if (f->macro)
+    f->macro->active = 0;
+  free(f->owned);
+  if (f->file) {
+    pp->includes--;
+    if (pp->nconds > f->conds) {
+      parser_error_at(p, &pp->conds[f->conds].where, "#if sem #endif");
+      pp->nconds = f->conds;
+    }
+  }
+}
+
+static int push_frame(Parser *p, Frame f) {
+  Preproc *pp = p->pp;
+  if (pp->nframes >= PP_MAX_FRAMES ||
+      !grow((void **)&pp->frames, &pp->frames_cap, pp->nframes + 1,
+            sizeof(Frame))) {
+    free(f.owned);
+    return 0;
+  }
+  pp->frames[pp->nframes++] = f;
+  if (f.macro)
+    f.macro->active = 1;
+  if (f.file)
+    pp->includes++;
+  return 1;
+}
+
+// Mais uma expansão de n tokens em t. Estourou o orçamento: erro e o parse
+// para (pp_next só devolve EOF daqui pra frente)
+static int spend(Parser *p, const Token *t, size_t n) {
+  Preproc *pp = p->pp;
+  pp->expansions++;
+  pp->expanded += n;
+  if (pp->expansions <= PP_MAX_EXPANSIONS && pp->expanded <= PP_MAX_EXPANDED)
+    return 1;
+  if (!p->halted) {
+    parser_error_at(p, (Token *)t, "expansão de macro grande demais");
+    p->halted = 1;
+  }
+  return 0;
+}
+
+// Token cru: pushback, frames (macro/#include) e por fim o lexer
+static Token pull(Parser *p) {
+  Preproc *pp = p->pp;
+  if (pp->has_pushback) {
+    pp->has_pushback = 0;
+    return pp->pushback;
+  }
+  while (pp->nframes) {
+    Frame *f = &pp->frames[pp->nframes - 1];
+    if (f->pos < f->count)
+      return f->toks[f->pos++];
+    pop_frame(p);
+  }
+  return next(p->lexer);
+}
+
+// Quebra a linha da diretiva em tokens com o lexer normal (sobre uma cópia
+// terminada em '\0') e reaponta cada um pro texto original — por quê? A
+// AST guarda Token.start; o texto da linha vive tanto quanto o fonte
+static Token *split_directive(const Token *dir, size_t *count) {
+  size_t len = (size_t)dir->len - 1;
+  const char *text = dir->start + 1;
+  char *tmp = malloc(len + 1);
+  Token *toks = NULL;
+  size_t cap = 0;
+  *count = 0;
+  if (!tmp)
+    return NULL;
+  memcpy(tmp, text, len);
+  tmp[len] = '\0';
+
+  Tokenizer lexer;
+  init(&lexer, tmp, NULL);
+  for (Token t = next(&lexer); t.kind != TOK_EOF; t = next(&lexer)) {
+    if (t.kind == UNKNOWN && t.len == 1 && *t.start == '\\')
+      continue; // continuação de linha
+    if (!grow((void **)&toks, &cap, *count + 1, sizeof(Token)))
+      break;
+    if (t.line == 1)
+      t.col += dir->col;
+    t.line += dir->line - 1;
+    t.offset += dir->offset + 1;
+    t.start = text + (t.start - tmp);
+    toks[(*count)++] = t;
+  }
+  free(tmp);
+  return toks;
+}
+
+// ----- #if -----
+
+typedef struct {
+  Parser *p;
+  Token *toks;
+  size_t count, pos;
+  int bad;
+} Expr;
+
+static Token *peek_tok(Expr *e, size_t ahead) {
+  return e->pos + ahead < e->count ? &e->toks[e->pos + ahead] : NULL;
+}
+
+static int adjacent(const Token *a, const Token *b) {
+  return a && b && a->start + a->len == b->start;
+}
+
+// Operador na posição atual, juntando pares que o lexer do Modal separa
+// (&& || << >>). Devolve quantos tokens ele ocupa, 0 se não é op
+static int op_at(Expr *e, const char *op) {
+  Token *t = peek_tok(e, 0);
+  if (!t)
+    return 0;
+  size_t n = strlen(op);
+  if (n == 2 && op[0] == op[1]) {
+    Token *u = peek_tok(e, 1);
+    if (!u || !adjacent(t, u))
+      return 0;
+    char c = op[0];
+    int first = (t->len == 1 && *t->start == c);
+    int second = (u->len == 1 && *u->start == c);
+    if (first && second)
+      return 2;
+    return 0;
+  }
+  if ((size_t)t->len != n || memcmp(t->start, op, n) != 0)
+    return 0;
+  // '<' sozinho não pode ser metade de '<<'
+  Token *u = peek_tok(e, 1);
+  if (n == 1 && (op[0] == '<' || op[0] == '>' || op[0] == '&' ||
+                 op[0] == '|') &&
+      adjacent(t, u) && u->len == 1 && *u->start == op[0])
+    return 0;
+  return 1;
+}
+
+static long long expr_cond(Expr *e);
+
+static long long expr_unary(Expr *e) {
+  Token *t = peek_tok(e, 0);
+  if (!t) {
+    e->bad = 1;
+    return 0;
+  }
+  e->pos++;
+  if (t->kind == NUMBER) {
+    Literal lit;
+    size_t bad;
+    if (literal_parse(t->start, (size_t)t->len, &lit, &bad) || lit.is_float)
+      e->bad = 1;
+    return lit.i;
+  }
+  if (t->kind == IDENTIFIER || isalpha((unsigned char)*t->start))
+    return 0; // nome que sobrou depois da expansão vale 0, como em C
+  if (t->kind == LPAREN) {
+    long long v = expr_cond(e);
+    Token *close = peek_tok(e, 0);
+    if (!close || close->kind != RPAREN)
+      e->bad = 1;
+    else
+      e->pos++;
+    return v;
+  }
+  if (t->len == 1 && *t->start == '!')
+    return !expr_unary(e);
+  if (t->len == 1 && *t->start == '-')
+    return -expr_unary(e);
+  if (t->len == 1 && *t->start == '+')
+    return expr_unary(e);
+  if (t->len == 1 && *t->start == '~')
+    return ~expr_unary(e);
+  e->bad = 1;
+  return 0;
+}
+
+static const char *const levels[][4] = {
+    {"*", "/", "%", NULL}, {"+", "-", NULL},      {"<<", ">>", NULL},
+    {"<", "<=", ">", ">="}, {"==", "!=", NULL},   {"&", NULL},
+    {"^", NULL},           {"|", NULL},
+};
+#define LEVELS (int)(sizeof(levels) / sizeof(levels[0]))
+
+static long long apply(Expr *e, const char *op, long long a, long long b) {
+  switch (op[0]) {
+  case '*':
+    return a * b;
+  case '/':
+  case '%':
+    if (b == 0) {
+      e->bad = 1;
+      return 0;
+    }
+    return op[0] == '/' ? a / b : a % b;
+  case '+':
+    return a + b;
+  case '-':
+    return a - b;
+  case '<':
+    return op[1] == '<' ? (long long)((unsigned long long)a << (b & 63))
+           : op[1] == '=' ? a <= b
+                          : a < b;
+  case '>':
+    return op[1] == '>' ? a >> (b & 63) : op[1] == '=' ? a >= b : a > b;
+  case '=':
+    return a == b;
+  case '!':
+    return a != b;
+  case '&':
+    return a & b;
+  case '^':
+    return a ^ b;
+  default:
+    return a | b;
+  }
+}
+
+static long long expr_level(Expr *e, int level) {
+  if (level < 0)
+    return expr_unary(e);
+  long long v = expr_level(e, level - 1);
+  for (;;) {
+    const char *op = NULL;
+    int width = 0;
+    for (int i = 0; i < 4 && levels[level][i] && !op; i++)
+      if ((width = op_at(e, levels[level][i])))
+        op = levels[level][i];
+    if (!op)
+      return v;
+    e->pos += (size_t)width;
+    v = apply(e, op, v, expr_level(e, level - 1));
+  }
+}
+
+static int logic_op(Expr *e, char c, Kind word) {
+  Token *t = peek_tok(e, 0);
+  if (t && t->kind == word) {
+    e->pos++;
+    return 1;
+  }
+  char op[3] = {c, c, '\0'};
+  int width = op_at(e, op);
+  if (!width && c == '|' && t && t->kind == PIPE) {
+    Token *u = peek_tok(e, 1);
+    width = u && u->kind == PIPE && adjacent(t, u) ? 2 : 0;
+  }
+  e->pos += (size_t)width;
+  return width != 0;
+}
+
+static long long expr_and(Expr *e) {
+  long long v = expr_level(e, LEVELS - 1);
+  while (logic_op(e, '&', AND)) {
+    long long r = expr_level(e, LEVELS - 1);
+    v = v && r;
+  }
+  return v;
+}
+
+static long long expr_or(Expr *e) {
+  long long v = expr_and(e);
+  while (logic_op(e, '|', OR)) {
+    long long r = expr_and(e);
+    v = v || r;
+  }
+  return v;
+}
+
+static long long expr_cond(Expr *e) {
+  long long c = expr_or(e);
+  Token *t = peek_tok(e, 0);
+  if (!t || t->kind != QUESTION)
+    return c;
+  e->pos++;
+  long long a = expr_cond(e);
+  Token *colon = peek_tok(e, 0);
+  if (!colon || colon->len != 1 || *colon->start != ':') {
+    e->bad = 1;
+    return 0;
+  }
+  e->pos++;
+  long long b = expr_cond(e);
+  return c ? a : b;
+}
+
+// Expande as macros da condição (objeto, recursivo) e troca defined(X) por
+// 0/1; macro função em #if não é suportada
+static int expand_cond(Parser *p, const Token *in, size_t n, Token **out,
+                       size_t *count, size_t *cap, int depth) {
+  Preproc *pp = p->pp;
+  static const char one[] = "1", zero[] = "0";
+  for (size_t i = 0; i < n; i++) {
+    Token t = in[i];
+    if (t.kind == IDENTIFIER && text_is(&t, "defined")) {
+      size_t j = i + 1;
+      int paren = j < n && in[j].kind == LPAREN;
+      j += (size_t)paren;
+      if (j >= n || in[j].kind != IDENTIFIER ||
+          (paren && (j + 1 >= n || in[j + 1].kind != RPAREN))) {
+        parser_error_at(p, &t, "espera defined(NOME)");
+        return 0;
+      }
+      int set = find_macro(pp, in[j].start, (size_t)in[j].len) != NULL;
+      i = j + (size_t)paren;
+      t.kind = NUMBER;
+      t.start = set ? one : zero;
+      t.len = 1;
+    } else if (t.kind == IDENTIFIER) {
+      Macro *m = find_macro(pp, t.start, (size_t)t.len);
+      if (m && m->function) {
+        parser_error_at(p, &t, "macro função '%.*s' em #if não é suportada",
+                        t.len, t.start);
+        return 0;
+      }
+      if (m && !m->active && depth < PP_MAX_FRAMES) {
+        if (!spend(p, &t, m->count))
+          return 0;
+        m->active = 1;
+        int ok = expand_cond(p, m->body, m->count, out, count, cap, depth + 1);
+        m->active = 0;
+        if (!ok)
+          return 0;
+        continue;
+      }
+    }
+    if (!grow((void **)out, cap, *count + 1, sizeof(Token)))
+      return 0;
+    (*out)[(*count)++] = t;
+  }
+  return 1;
+}
+
+static int eval_cond(Parser *p, const Token *dir, const Token *toks,
+                     size_t n) {
+  Token *ex = NULL;
+  size_t count = 0, cap = 0;
+  if (!n) {
+    parser_error_at(p, (Token *)dir, "#if sem condição");
+    return 0;
+  }
+  if (!expand_cond(p, toks, n, &ex, &count, &cap, 0)) {
+    free(ex);
+    return 0;
+  }
+  Expr e = {.p = p, .toks = ex, .count = count};
+  long long v = expr_cond(&e);
+  if (e.bad || e.pos != e.count)
+    parser_error_at(p, (Token *)dir, "condição inválida no #if");
+  free(ex);
+  return !e.bad && v != 0;
+}
+
+// ----- diretivas -----
+
+static void cond_push(Parser *p, const Token *dir, int value) {
+  Preproc *pp = p->pp;
+  int parent = !skipping(pp);
+  if (!grow((void **)&pp->conds, &pp->conds_cap, pp->nconds + 1,
+            sizeof(Cond)))
+    return;
+  pp->conds[pp->nconds++] = (Cond){.where = *dir,
+                                   .active = parent && value,
+                                   .taken = value,
+                                   .parent = parent};
+}
+
+// Um include aberto só fecha os #if que abriu
+static Cond *cond_top(Parser *p, const Token *dir, const char *what) {
+  Preproc *pp = p->pp;
+  size_t floor = 0;
+  for (size_t i = pp->nframes; i-- > 0;)
+    if (pp->frames[i].file) {
+      floor = pp->frames[i].conds;
+      break;
+    }
+  if (pp->nconds <= floor) {
+    parser_error_at(p, (Token *)dir, "#%s sem #if", what);
+    return NULL;
+  }
+  return &pp->conds[pp->nconds - 1];
+}
+
+static void do_conditional(Parser *p, const Token *dir, const Token *t,
+                           size_t n) {
+  Preproc *pp = p->pp;
+  const Token *name = &t[0];
+  if (text_is(name, "if")) {
+    cond_push(p, dir, skipping(pp) ? 0 : eval_cond(p, dir, t + 1, n - 1));
+  } else if (text_is(name, "ifdef") || text_is(name, "ifndef")) {
+    int want = text_is(name, "ifdef");
+    int set = 0;
+    if (n < 2 || t[1].kind != IDENTIFIER)
+      parser_error_at(p, (Token *)dir, "espera nome depois de #%.*s",
+                      name->len, name->start);
+    else
+      set = find_macro(pp, t[1].start, (size_t)t[1].len) != NULL;
+    cond_push(p, dir, set == want);
+  } else if (text_is(name, "elif")) {
+    Cond *c = cond_top(p, dir, "elif");
+    if (!c)
+      return;
+    if (c->in_else) {
+      parser_error_at(p, (Token *)dir, "#elif depois de #else");
+      return;
+    }
+    int value = c->parent && !c->taken && eval_cond(p, dir, t + 1, n - 1);
+    c->active = value;
+    c->taken |= value;
+  } else if (text_is(name, "else")) {
+    Cond *c = cond_top(p, dir, "else");
+    if (!c)
+      return;
+    if (c->in_else)
+      parser_error_at(p, (Token *)dir, "#else repetido");
+    c->in_else = 1;
+    c->active = c->parent && !c->taken;
+    c->taken = 1;
+  } else if (cond_top(p, dir, "endif")) {
+    pp->nconds--;
+  }
+}
+
+static int is_conditional(const Token *name) {
+  return text_is(name, "if") || text_is(name, "ifdef") ||
+         text_is(name, "ifndef") || text_is(name, "elif") ||
+         text_is(name, "else") || text_is(name, "endif");
+}
+
+static int same_tokens(const Token *a, size_t na, const Token *b, size_t nb) {
+  if (na != nb)
+    return 0;
+  for (size_t i = 0; i < na; i++)
+    if (a[i].len != b[i].len || memcmp(a[i].start, b[i].start, a[i].len) != 0)
+      return 0;
+  return 1;
+}
+
+static Token *copy_tokens(const Token *t, size_t n) {
+  Token *out = malloc((n ? n : 1) * sizeof(Token));
+  if (out && n)
+    memcpy(out, t, n * sizeof(Token));
+  return out;
+}
+
+static void do_define(Parser *p, const Token *dir, const Token *t, size_t n) {
+  Preproc *pp = p->pp;
+  if (n < 2 || t[1].kind != IDENTIFIER) {
+    parser_error_at(p, (Token *)dir, "espera nome depois de #define");
+    return;
+  }
+  Macro m = {.name = t[1].start, .len = (size_t)t[1].len};
+  size_t body = 2;
+  if (n > 2 && t[2].kind == LPAREN && adjacent(&t[1], &t[2])) {
+    m.function = 1;
+    size_t i = 3, first = 3;
+    for (; i < n && t[i].kind != RPAREN; i++) {
+      int param = (i - first) % 2 == 0;
+      if (param ? t[i].kind != IDENTIFIER : !text_is(&t[i], ","))
+        break;
+    }
+    if (i >= n || t[i].kind != RPAREN || (i > first && (i - first) % 2 == 0)) {
+      parser_error_at(p, (Token *)&t[i < n ? i : n - 1],
+                      "parâmetros de macro: (a, b, ...)");
+      return;
+    }
+    m.nparams = (i - first + 1) / 2;
+    m.params = malloc((m.nparams ? m.nparams : 1) * sizeof(Token));
+    if (!m.params)
+      return;
+    for (size_t k = 0; k < m.nparams; k++)
+      m.params[k] = t[first + 2 * k];
+    body = i + 1;
+  }
+  for (size_t i = body; i < n; i++)
+    if (t[i].kind == DIRECTIVE) {
+      parser_error_at(p, (Token *)&t[i], "# e ## não são suportados em "
+                                         "#define");
+      free(m.params);
+      return;
+    }
+  m.count = n - body;
+  m.body = copy_tokens(t + body, m.count);
+  if (!m.body) {
+    free(m.params);
+    return;
+  }
+
+  Macro *old = find_macro(pp, m.name, m.len);
+  if (old) {
+    if (!same_tokens(old->body, old->count, m.body, m.count) ||
+        old->function != m.function || old->nparams != m.nparams)
+      parser_warn_at(p, (Token *)&t[1], "macro '%.*s' redefinida",
+                     (int)m.len, m.name);
+    macro_free(old);
+    *old = m;
+    return;
+  }
+  if (!reserve_slot(pp) ||
+      !grow((void **)&pp->macros, &pp->macros_cap, pp->nmacros + 1,
+            sizeof(Macro))) {
+    macro_free(&m);
+    return;
+  }
+  pp->macros[pp->nmacros++] = m;
+  *slot_of(pp, pp->slots, pp->slots_cap, m.name, m.len) = pp->nmacros;
+}
+
+static void do_undef(Parser *p, const Token *dir, const Token *t, size_t n) {
+  Preproc *pp = p->pp;
+  if (n < 2 || t[1].kind != IDENTIFIER) {
+    parser_error_at(p, (Token *)dir, "espera nome depois de #undef");
+    return;
+  }
+  Macro *m = find_macro(pp, t[1].start, (size_t)t[1].len);
+  if (!m)
+    return;
+  if (!m->active) { // dentro da própria expansão o frame ainda lê o corpo
+    macro_free(m);
+    m->body = NULL;
+    m->params = NULL;
+  }
+  m->len = 0; // não casa mais com nome nenhum
+}
+
+static int was_seen(const Preproc *pp, const IncludeFile *f) {
+  for (size_t i = 0; i < pp->nseen; i++)
+    if (pp->seen[i] == f)
+      return 1;
+  return 0;
+}
+
+// Arquivo dono do trecho atual: o #include mais interno, senão o fonte
+static const char *current_file(const Parser *p) {
+  const Preproc *pp = p->pp;
+  for (size_t i = pp->nframes; i-- > 0;)
+    if (pp->frames[i].file)
+      return pp->frames[i].file->path;
+  return p->filename;
+}
+
+// Relativo ao arquivo que inclui; se não existir lá, o caminho como está
+static const IncludeFile *find_include(Parser *p, const Token *name) {
+  const char *from = current_file(p);
+  const char *path = name->start + 1;
+  size_t len = (size_t)name->len - 2;
+  const char *slash = from ? strrchr(from, '/') : NULL;
+  size_t dir = slash && *path != '/' ? (size_t)(slash - from + 1) : 0;
+  char *full = malloc(dir + len + 1);
+  if (!full)
+    return NULL;
+
+  const IncludeFile *f = NULL;
+  for (int attempt = 0; attempt < 2 && !f; attempt++) {
+    size_t prefix = attempt == 0 ? dir : 0;
+    if (attempt == 1 && dir == 0)
+      break;
+    memcpy(full, from, prefix);
+    memcpy(full + prefix, path, len);
+    full[prefix + len] = '\0';
+    f = cache_get(p->includes, full);
+  }
+  free(full);
+  return f;
+}
+
+static void do_include(Parser *p, const Token *dir, const Token *t,
+                       size_t n) {
+  Preproc *pp = p->pp;
+  if (n < 2 || t[1].kind != STRING || t[1].len < 2) {
+    parser_error_at(p, (Token *)dir, "espera #include \"arquivo\"");
+    return;
+  }
+  if (!p->includes) {
+    parser_error_at(p, (Token *)&t[1], "#include sem cache de includes "
+                                       "(Parser.includes)");
+    return;
+  }
+  if (pp->includes >= PP_MAX_INCLUDES) {
+    parser_error_at(p, (Token *)&t[1], "#include aninhado demais (ciclo sem "
+                                       "include guard?)");
+    return;
+  }
+  const IncludeFile *f = find_include(p, &t[1]);
+  if (!f) {
+    parser_error_at(p, (Token *)&t[1], "não consegui ler %.*s", t[1].len,
+                    t[1].start);
+    return;
+  }
+
+  if (!was_seen(pp, f)) {
+    parser_note_file(p, f->path, f->hash);
+    if (grow((void **)&pp->seen, &pp->seen_cap, pp->nseen + 1,
+             sizeof(*pp->seen)))
+      pp->seen[pp->nseen++] = f;
+  } else if (f->once) {
+    return;
+  }
+  if (f->guard && find_macro(pp, f->guard, f->guard_len))
+    return; // guard já definido: o arquivo todo sumiria
+  if (f->count)
+    push_frame(p, (Frame){.toks = f->tokens,
+                          .count = f->count,
+                          .file = f,
+                          .conds = pp->nconds});
+}
+
+static void directive(Parser *p, const Token *dir) {
+  Preproc *pp = p->pp;
+  size_t n;
+  Token *t = split_directive(dir, &n);
+  if (!n) { // '#' sozinho é diretiva nula
+    free(t);
+    return;
+  }
+
+  if (is_conditional(&t[0]))
+    do_conditional(p, dir, t, n);
+  else if (skipping(pp))
+    ; // ramo falso: só os condicionais contam
+  else if (text_is(&t[0], "define"))
+    do_define(p, dir, t, n);
+  else if (text_is(&t[0], "undef"))
+    do_undef(p, dir, t, n);
+  else if (text_is(&t[0], "include"))
+    do_include(p, dir, t, n);
+  else if (text_is(&t[0], "error") || text_is(&t[0], "warning")) {
+    const char *end = dir->start + dir->len;
+    const char *msg = skip_blank(t[0].start + t[0].len, end);
+    if (text_is(&t[0], "error"))
+      parser_error_at(p, (Token *)dir, "#error %.*s", (int)(end - msg), msg);
+    else
+      parser_warn_at(p, (Token *)dir, "#warning %.*s", (int)(end - msg), msg);
+  } else if (!text_is(&t[0], "pragma")) { // once já visto na carga
+    parser_error_at(p, &t[0], "diretiva desconhecida #%.*s", t[0].len,
+                    t[0].start);
+  }
+  free(t);
+}
+
+// ----- expansão -----
+
+static int collect_args(Parser *p, const Token *name, Token **args,
+                        size_t *count, size_t **starts, size_t *nargs) {
+  size_t cap = 0, scap = 0;
+  int depth = 0;
+  *count = *nargs = 0;
+  *args = NULL;
+  *starts = NULL;
+  if (!grow((void **)starts, &scap, 1, sizeof(size_t)))
+    return 0;
+  (*starts)[(*nargs)++] = 0;
+  for (;;) {
+    Token a = pull(p);
+    if (a.kind == TOK_EOF || a.kind == DIRECTIVE) {
+      parser_error_at(p, (Token *)name, "chamada de '%.*s' sem ')'",
+                      name->len, name->start);
+      p->pp->pushback = a;
+      p->pp->has_pushback = 1;
+      return 0;
+    }
+    if (a.kind == LPAREN)
+      depth++;
+    if (a.kind == RPAREN && depth-- == 0)
+      return 1;
+    if (depth == 0 && text_is(&a, ",")) {
+      if (!grow((void **)starts, &scap, *nargs + 1, sizeof(size_t)))
+        return 0;
+      (*starts)[(*nargs)++] = *count;
+      continue;
+    }
+    if (!grow((void **)args, &cap, *count + 1, sizeof(Token)))
+      return 0;
+    (*args)[(*count)++] = a;
+  }
+}
+
+static int expand_function(Parser *p, Macro *m, const Token *name) {
+  Preproc *pp = p->pp;
+  Token open = pull(p);
+  if (open.kind != LPAREN) { // nome sozinho: não é chamada
+    pp->pushback = open;
+    pp->has_pushback = 1;
+    return 0;
+  }
+
+  Token *args, *out = NULL;
+  size_t count, *starts, nargs, cap = 0, n = 0;
+  int ok = collect_args(p, name, &args, &count, &starts, &nargs);
+  if (ok && m->nparams == 0 && nargs == 1 && count == 0)
+    nargs = 0; // F() sem parâmetro
+  if (ok && nargs != m->nparams) {
+    parser_error_at(p, (Token *)name, "macro '%.*s' espera %zu argumento(s), "
+                                      "recebeu %zu",
+                    name->len, name->start, m->nparams, nargs);
+    ok = 0;
+  }
+
+  for (size_t i = 0; ok && i < m->count; i++) {
+    const Token *b = &m->body[i];
+    size_t k = 0;
+    while (k < m->nparams &&
+           !(b->kind == IDENTIFIER && b->len == m->params[k].len &&
+             memcmp(b->start, m->params[k].start, b->len) == 0))
+      k++;
+    const Token *src = k < m->nparams ? args + starts[k] : b;
+    size_t len = k < m->nparams
+                     ? (k + 1 < nargs ? starts[k + 1] : count) - starts[k]
+                     : 1;
+    if (!grow((void **)&out, &cap, n + len, sizeof(Token))) {
+      ok = 0;
+      break;
+    }
+    memcpy(out + n, src, len * sizeof(Token));
+    n += len;
+  }
+  free(args);
+  free(starts);
+  if (!ok || !spend(p, name, n)) {
+    free(out);
+    return 1; // a chamada some; o erro já foi dado
+  }
+  if (!push_frame(p, (Frame){.toks = out, .count = n, .owned = out,
+                             .macro = m}))
+    parser_error_at(p, (Token *)name, "expansão de '%.*s' funda demais",
+                    name->len, name->start);
+  return 1;
+}
+
+// 1 se t virou tokens de macro (já empilhados)
+static int expand(Parser *p, const Token *t) {
+  Preproc *pp = p->pp;
+  Macro *m = find_macro(pp, t->start, (size_t)t->len);
+  if (!m || m->active)
+    return 0;
+  if (m->function)
+    return expand_function(p, m, t);
+  if (!spend(p, t, m->count))
+    return 1;
+  if (!push_frame(p, (Frame){.toks = m->body, .count = m->count, .macro = m}))
+    parser_error_at(p, (Token *)t, "expansão de '%.*s' funda demais", t->len,
+                    t->start);
+  return 1;
+}
+
+Token pp_next(Parser *p) {
+  if (!p->pp) {
+    Token t = next(p->lexer); // caminho comum: nenhuma diretiva até aqui
+    if (t.kind != DIRECTIVE || !pp_get(p))
+      return t;
+    directive(p, &t);
+  }
+
+  Preproc *pp = p->pp;
+  for (;;) {
+    if (p->halted) // sem isso o recovery do parser puxava a expansão toda
+      return token_make(TOK_EOF, p->current.start, 0, p->current.line,
+                        p->current.col);
+    Token t = pull(p);
+    if (t.kind == DIRECTIVE) {
+      directive(p, &t);
+      continue;
+    }
+    if (t.kind == TOK_EOF) {
+      if (pp->nconds) {
+        parser_error_at(p, &pp->conds[0].where, "#if sem #endif");
+        pp->nconds = 0;
+      }
+      return t;
+    }
+    if (skipping(pp))
+      continue;
+    if (t.kind == IDENTIFIER && pp->nmacros && expand(p, &t))
+      continue;
+    return t;
+  }
+}
+
+int pp_inject(Parser *p, Token *toks, size_t count) {
+  if (!pp_get(p)) {
+    free(toks);
+    return 0;
+  }
+  return push_frame(p, (Frame){.toks = toks, .count = count, .owned = toks});
+}
+
+Token pp_resume(Parser *p, Token dir) {
+  if (!pp_get(p))
+    return next(p->lexer);
+  directive(p, &dir);
+  return pp_next(p);
+}
+
+int pp_locate(const Parser *p, const Token *tok, const char **file,
+              const char **line_start, int *line_len) {
+  const Preproc *pp = p->pp;
+  for (size_t i = 0; pp && i < pp->nseen; i++) {
+    const IncludeFile *f = pp->seen[i];
+    if (!tok->start || tok->start < f->text || tok->start > f->text + f->len)
+      continue;
+    const char *s = tok->start, *e = tok->start;
+    while (s > f->text && s[-1] != '\n')
+      s--;
+    while (*e && *e != '\n')
+      e++;
+    *file = f->path;
+    *line_start = s;
+    *line_len = (int)(e - s);
+    return 1;
+  }
+  return 0;
+}
+
+void pp_free(Parser *p) {
+  Preproc *pp = p->pp;
+  if (!pp)
+    return;
+  while (pp->nframes)
+    pop_frame(p);
+  for (size_t i = 0; i < pp->nmacros; i++)
+    macro_free(&pp->macros[i]);
+  free(pp->macros);
+  free(pp->slots);
+  free(pp->frames);
+  free(pp->conds);
+  free(pp->seen);
+  free(pp);
+  p->pp = NULL;
+}
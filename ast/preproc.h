@@ -0,0 +1,43 @@
+// preproc.h — diretivas # (#include, #define, #if...) entre o lexer e o parser
+#ifndef PREPROC_H
+#define PREPROC_H
+
+#include "parser.h"
+#include <pthread.h>
+
+typedef struct IncludeFile IncludeFile; // preproc.c
+
+// Arquivos de #include já lidos e tokenizados, com include guard / #pragma
+// once detectados na carga — por quê? Um header que centenas de arquivos
+// incluem é lido e lexado uma vez só. Os tokens da AST apontam pro texto
+// daqui: o cache vive tanto quanto as ASTs (contexto, programa, watch).
+// Thread-safe: os módulos de uma onda parseiam juntos contra o mesmo cache
+typedef struct IncludeCache {
+  pthread_mutex_t lock;
+  IncludeFile **files;
+  size_t count, cap;
+} IncludeCache;
+
+void include_cache_init(IncludeCache *c);
+void include_cache_free(IncludeCache *c);
+
+// Próximo token pro parser: executa as diretivas, pula ramos falsos de
+// #if e expande macros. Sem nenhuma diretiva no fonte é só next(lexer)
+Token pp_next(Parser *p);
+// dir já saiu do lexer (primeiro token do fonte): executa e segue como pp_next
+Token pp_resume(Parser *p, Token dir);
+
+// toks (malloc; passa a ser daqui) saem antes do resto do fonte — por quê?
+// Os buracos de f-string (parse_format.c) são lexados à parte e parseados
+// pelo caminho normal, com macros e diagnóstico no lugar certo. 0 sem memória
+int pp_inject(Parser *p, Token *toks, size_t count);
+
+// Arquivo e linha de um token vindo de #include (ou de macro definida lá);
+// 0 se o token é do próprio fonte
+int pp_locate(const Parser *p, const Token *tok, const char **file,
+              const char **line_start, int *line_len);
+
+// Fim do parse: libera macros e pilhas
+void pp_free(Parser *p);
+
+#endif
@@ -0,0 +1,184 @@
+#include "strpool.h"
+#include "ast.h" // ast_hash_bytes
+#include <string.h>
+
+#define STRPOOL_BLOCK 4096
+
+struct StrBlock {
+  StrBlock *next;
+  size_t cap, used;
+  char data[];
+};
+
+void strpool_init(StrPool *pool, const ModalAllocator *alloc) {
+  *pool = (StrPool){.alloc = alloc ? alloc : modal_heap_allocator()};
+}
+
+void strpool_free(StrPool *pool) {
+  modal_free(pool->alloc, pool->slots, pool->cap * sizeof(StrEntry));
+  for (StrBlock *b = pool->blocks, *next; b; b = next) {
+    next = b->next;
+    modal_free(pool->alloc, b, sizeof(StrBlock) + b->cap);
+  }
+  strpool_init(pool, pool->alloc);
+}
+
+static char *pool_bytes(StrPool *pool, size_t len) {
+  StrBlock *b = pool->blocks;
+  if (!b || b->cap - b->used < len) {
+    size_t cap = len > STRPOOL_BLOCK ? len : STRPOOL_BLOCK;
+    b = modal_alloc(pool->alloc, sizeof(StrBlock) + cap);
+    if (!b)
+      return NULL;
+    b->next = pool->blocks;
+    b->cap = cap;
+    b->used = 0;
+    pool->blocks = b;
+  }
+  char *out = b->data + b->used;
+  b->used += len;
+  return out;
+}
+
+static int pool_grow(StrPool *pool) {
+  size_t cap = pool->cap ? pool->cap * 2 : 64;
+  StrEntry *slots = modal_alloc(pool->alloc, cap * sizeof(StrEntry));
+  if (!slots)
+    return 0;
+  memset(slots, 0, cap * sizeof(StrEntry));
+  for (size_t i = 0; i < pool->cap; i++) {
+    const StrEntry *e = &pool->slots[i];
+    if (!e->s)
+      continue;
+    size_t j = e->hash & (cap - 1);
+    while (slots[j].s)
+      j = (j + 1) & (cap - 1);
+    slots[j] = *e;
+  }
+  modal_free(pool->alloc, pool->slots, pool->cap * sizeof(StrEntry));
+  pool->slots = slots;
+  pool->cap = cap;
+  return 1;
+}
+
+// A cópia única de s[0, len); NULL sem memória
+static const char *intern(StrPool *pool, const char *s, size_t len) {
+  if (pool->count * 4 >= pool->cap * 3 && !pool_grow(pool))
+    return NULL;
+  uint64_t hash = ast_hash_bytes(s, len);
+  size_t i = hash & (pool->cap - 1);
+  for (; pool->slots[i].s; i = (i + 1) & (pool->cap - 1)) {
+    const StrEntry *e = &pool->slots[i];
+    if (e->hash == hash && e->len == len && memcmp(e->s, s, len) == 0)
+      return e->s;
+  }
+  char *copy = pool_bytes(pool, len ? len : 1);
+  if (!copy)
+    return NULL;
+  memcpy(copy, s, len);
+  pool->slots[i] = (StrEntry){copy, len, hash};
+  pool->count++;
+  return copy;
+}
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  c |= 0x20;
+  return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+// body[0, n) -> out (cabe: decodificado nunca é maior); -1 ok, senão o
+// offset do '\\' inválido dentro de body
+static long decode(const char *body, size_t n, char *out, size_t *out_len) {
+  size_t o = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (body[i] != '\\') {
+      out[o++] = body[i];
+      continue;
+    }
+    size_t at = i++;
+    switch (i < n ? body[i] : '\0') {
+    case 'n':
+      out[o++] = '\n';
+      break;
+    case 't':
+      out[o++] = '\t';
+      break;
+    case 'r':
+      out[o++] = '\r';
+      break;
+    case '0':
+      out[o++] = '\0';
+      break;
+    case '\\':
+    case '"':
+    case '\'':
+      out[o++] = body[i];
+      break;
+    case 'x': {
+      int hi = i + 1 < n ? hex_value(body[i + 1]) : -1;
+      int lo = i + 2 < n ? hex_value(body[i + 2]) : -1;
+      if (hi < 0 || lo < 0)
+        return (long)at;
+      out[o++] = (char)(hi * 16 + lo);
+      i += 2;
+      break;
+    }
+    default:
+      return (long)at;
+    }
+  }
+  *out_len = o;
+  return -1;
+}
+
+const char *strpool_literal(StrPool *pool, const char *s, size_t len,
+                            size_t *out_len, const char **err, size_t *bad) {
+  *err = NULL;
+  *bad = 0;
+  // Fechada de verdade: termina em '"' que não é escape (conta as '\\'
+  // coladas antes dela)
+  size_t slashes = 0;
+  while (len >= 2 + slashes && s[len - 2 - slashes] == '\\')
+    slashes++;
+  if (len < 2 || s[len - 1] != '"' || slashes % 2) {
+    *err = "string sem '\"' no fim";
+    return NULL;
+  }
+
+  const char *out = strpool_text(pool, s + 1, len - 2, out_len, err, bad);
+  if (!out && *err)
+    *bad += 1; // a aspa de abertura
+  return out;
+}
+
+const char *strpool_text(StrPool *pool, const char *body, size_t n,
+                         size_t *out_len, const char **err, size_t *bad) {
+  *err = NULL;
+  *bad = 0;
+  if (!memchr(body, '\\', n)) {
+    *out_len = n;
+    return body;
+  }
+  if (!pool) {
+    *err = "string com escape fora de um StrPool";
+    return NULL;
+  }
+
+  char stack[256];
+  char *tmp = n <= sizeof(stack) ? stack : modal_alloc(pool->alloc, n);
+  if (!tmp)
+    return NULL;
+  const char *out = NULL;
+  long at = decode(body, n, tmp, out_len);
+  if (at >= 0) {
+    *err = "escape inválido (use \\n \\t \\r \\0 \\\\ \\\" \\' ou \\xHH)";
+    *bad = (size_t)at;
+  } else {
+    out = intern(pool, tmp, *out_len);
+  }
+  if (tmp != stack)
+    modal_free(pool->alloc, tmp, n);
+  return out;
+}
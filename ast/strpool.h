@@ -0,0 +1,44 @@
+// strpool.h — conteúdo das strings literais, decodificado e sem repetição
+#ifndef STRPOOL_H
+#define STRPOOL_H
+
+#include "../builtin/allocators.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct StrBlock StrBlock; // strpool.c
+
+typedef struct {
+  const char *s;
+  size_t len;
+  uint64_t hash;
+} StrEntry;
+
+// Strings com escape, decodificadas uma vez só — por quê? Arquivo de test
+// repete a mesma mensagem centenas de vezes; cada texto distinto vive aqui
+// uma vez e todo literal igual aponta pra ele. Sem escape nem passa por
+// aqui: o conteúdo é o próprio fonte. Vive tanto quanto as ASTs (contexto,
+// módulo, watch); uma thread por pool
+typedef struct StrPool {
+  const ModalAllocator *alloc;
+  StrEntry *slots; // endereçamento aberto, cap potência de 2
+  size_t count, cap;
+  StrBlock *blocks;
+} StrPool;
+
+void strpool_init(StrPool *pool, const ModalAllocator *alloc);
+void strpool_free(StrPool *pool);
+
+// Conteúdo do token STRING s[0, len) — com as aspas — em *out/*out_len:
+// sem '\\' é uma fatia do próprio token (zero cópia); com escape (\n \t \r
+// \0 \\ \" \' \xHH) é a cópia única do pool. Erro: NULL com a mensagem em
+// *err e o offset culpado em *bad (*err NULL: faltou memória). pool NULL só
+// serve pra string sem escape
+const char *strpool_literal(StrPool *pool, const char *s, size_t len,
+                            size_t *out_len, const char **err, size_t *bad);
+// Idem pra um miolo sem aspas (trecho literal de f-string); *bad é relativo
+// a body
+const char *strpool_text(StrPool *pool, const char *body, size_t n,
+                         size_t *out_len, const char **err, size_t *bad);
+
+#endif
@@ -0,0 +1,429 @@
+#include "../lib/runtime/simd.h"
+#include "parser.h"
+#include "types.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Espelho do executor (lib/compiler/eval.c, pipeline.c, scope.c): cada erro
+// daqui é uma falha certa lá, e tipo que passa daqui é o Value que o eval
+// vai ver — por isso ele pode pular a tag
+
+#define NO_VAR SIZE_MAX
+
+typedef struct {
+  const char *name;
+  size_t len;
+  TypeId type;
+  size_t shadowed; // Var de mesmo nome embaixo na pilha; NO_VAR nenhum
+} Var;
+
+// Nome -> Var do topo — por quê não varrer a pilha? Um test com n autofree
+// olhando um nome de fora fazia o checker quadrático. Nome fica na tabela
+// depois do pop (top = NO_VAR), então a sondagem nunca quebra
+typedef struct {
+  const char *name; // NULL: vazio
+  size_t len;
+  size_t top;
+} VarSlot;
+
+typedef struct {
+  Parser *p;
+  TypeTable *t;
+  int keep;  // t é do chamador: anota os nós
+  Var *vars; // pilha: escopo aberto é só a altura guardada (pop_vars)
+  size_t nvars, cap;
+  VarSlot *index; // potência de 2
+  size_t nnames, index_cap;
+  AstNode **defers; // dos blocos abertos, checados no fim de cada um
+  size_t ndefers, defers_cap;
+  int oom; // daqui pra frente tudo TYPE_NONE, sem erro
+} Check;
+
+static VarSlot *var_slot(const Check *c, const char *name, size_t len) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < len; i++)
+    h = (h ^ (uint8_t)name[i]) * 0x100000001b3ULL;
+  size_t mask = c->index_cap - 1;
+  for (size_t j = (size_t)h & mask;; j = (j + 1) & mask) {
+    VarSlot *s = &c->index[j];
+    if (!s->name || (s->len == len && memcmp(s->name, name, len) == 0))
+      return s;
+  }
+}
+
+static Var *find_var(Check *c, const char *name, size_t len) {
+  if (!c->index_cap)
+    return NULL;
+  VarSlot *s = var_slot(c, name, len);
+  return s->name && s->top != NO_VAR ? &c->vars[s->top] : NULL;
+}
+
+static int index_grow(Check *c) {
+  size_t cap = c->index_cap ? c->index_cap * 2 : 64;
+  VarSlot *old = c->index;
+  size_t old_cap = c->index_cap;
+  c->index = calloc(cap, sizeof(VarSlot));
+  if (!c->index) {
+    c->index = old;
+    return 0;
+  }
+  c->index_cap = cap;
+  for (size_t i = 0; i < old_cap; i++)
+    if (old[i].name)
+      *var_slot(c, old[i].name, old[i].len) = old[i];
+  free(old);
+  return 1;
+}
+
+static void pop_vars(Check *c, size_t mark) {
+  while (c->nvars > mark) {
+    const Var *v = &c->vars[--c->nvars];
+    var_slot(c, v->name, v->len)->top = v->shadowed;
+  }
+}
+
+static void push_var(Check *c, const char *name, size_t len, TypeId type) {
+  if ((c->nnames + 1) * 2 > c->index_cap && !index_grow(c)) {
+    c->oom = 1;
+    return;
+  }
+  if (c->nvars == c->cap) {
+    size_t cap = c->cap ? c->cap * 2 : 16;
+    Var *vars = realloc(c->vars, cap * sizeof(Var));
+    if (!vars) {
+      c->oom = 1;
+      return;
+    }
+    c->vars = vars;
+    c->cap = cap;
+  }
+  VarSlot *s = var_slot(c, name, len);
+  if (!s->name) {
+    *s = (VarSlot){name, len, NO_VAR};
+    c->nnames++;
+  }
+  c->vars[c->nvars] = (Var){name, len, type, s->top};
+  s->top = c->nvars++;
+}
+
+static void push_defer(Check *c, AstNode *stmt) {
+  if (c->ndefers == c->defers_cap) {
+    size_t cap = c->defers_cap ? c->defers_cap * 2 : 8;
+    AstNode **defers = realloc(c->defers, cap * sizeof(AstNode *));
+    if (!defers) {
+      c->oom = 1;
+      return;
+    }
+    c->defers = defers;
+    c->defers_cap = cap;
+  }
+  c->defers[c->ndefers++] = stmt;
+}
+
+static int is_vec(Check *c, TypeId t) {
+  return types_info(c->t, t)->kind == TYPE_KIND_VEC;
+}
+
+static const char *name(Check *c, TypeId t) { return types_name(c->t, t); }
+
+// ----- expressões -----
+
+static TypeId check_expr(Check *c, AstNode *e);
+
+static int is_compare(const Token *op) {
+  return op->len == 2 || *op->start == '<' || *op->start == '>';
+}
+
+// Mesmas regras do eval_binop: i64 com f64 vira f64, comparação dá i64,
+// escalar com vetor replica nas lanes
+static TypeId binop_type(Check *c, AstNode *e, TypeId l, TypeId r) {
+  Token *op = &e->token;
+  if (l == TYPE_NONE || r == TYPE_NONE)
+    return TYPE_NONE;
+  if (l == TYPE_RANGE || r == TYPE_RANGE) {
+    parser_error_at(c->p, op, "range não entra em conta: só como fonte de "
+                              "pipeline (0..n | sum)");
+    return TYPE_NONE;
+  }
+  if (l == TYPE_I64 && r == TYPE_I64)
+    return TYPE_I64;
+  if (!is_vec(c, l) && !is_vec(c, r))
+    return is_compare(op) ? TYPE_I64 : TYPE_F64;
+  if (l == TYPE_F64 || r == TYPE_F64) {
+    parser_error_at(c->p, op, "%s %.*s %s: vetor é só de inteiros", name(c, l),
+                    op->len, op->start, name(c, r));
+    return TYPE_NONE;
+  }
+  if (is_vec(c, l) && is_vec(c, r) && l != r) {
+    parser_error_at(c->p, op, "%s %.*s %s: vetores de tipos diferentes",
+                    name(c, l), op->len, op->start, name(c, r));
+    return TYPE_NONE;
+  }
+  return is_vec(c, l) ? l : r;
+}
+
+// Args de from em diante, todos i64 como o eval_scalar_arg quer; 0 se
+// algum não é
+static int scalar_args(Check *c, AstNode *call, size_t from) {
+  int ok = 1;
+  for (size_t i = from; i < call->data.call.count; i++) {
+    AstNode *arg = call->data.call.args[i];
+    TypeId t = check_expr(c, arg);
+    if (t == TYPE_I64)
+      continue;
+    ok = 0;
+    if (t != TYPE_NONE)
+      parser_error_at(c->p, &arg->token,
+                      "argumento %zu de '%.*s' tem que ser i64, não %s", i + 1,
+                      (int)call->data.call.len, call->data.call.name,
+                      name(c, t));
+  }
+  return ok;
+}
+
+static int call_is(const AstNode *call, const char *s) {
+  return call->data.call.len == strlen(s) &&
+         memcmp(call->data.call.name, s, call->data.call.len) == 0;
+}
+
+static int is_reduction(const AstNode *call) {
+  return call_is(call, "sum") || call_is(call, "min") ||
+         call_is(call, "max") || call_is(call, "all") || call_is(call, "any");
+}
+
+static TypeId call_type(Check *c, AstNode *e) {
+  size_t count = e->data.call.count;
+  int len = (int)e->data.call.len;
+  const char *fn = e->data.call.name;
+  if (e->data.call.native)
+    return scalar_args(c, e, 0) ? TYPE_I64 : TYPE_NONE;
+
+  SimdType simd;
+  if (simd_type_from_name(fn, len, &simd)) {
+    int lanes = simd_lane_count(simd);
+    if (!scalar_args(c, e, 0))
+      return TYPE_NONE;
+    if (count != 1 && count != (size_t)lanes) {
+      parser_error_at(c->p, &e->token, "%.*s espera 1 ou %d argumentos, não %zu",
+                      len, fn, lanes, count);
+      return TYPE_NONE;
+    }
+    return types_vec(c->t, simd);
+  }
+
+  int known = is_reduction(e) || call_is(e, "lane") || call_is(e, "shuffle");
+  TypeId v = count ? check_expr(c, e->data.call.args[0]) : TYPE_NONE;
+  if (!known || !count) {
+    scalar_args(c, e, 1); // anota, mesmo sem chamada que sirva
+    parser_error_at(c->p, &e->token,
+                    known ? "'%.*s' sem argumento" : "função '%.*s' não existe",
+                    len, fn);
+    return TYPE_NONE;
+  }
+
+  if (is_reduction(e)) {
+    if (count != 1) {
+      scalar_args(c, e, 1);
+      parser_error_at(c->p, &e->token, "'%.*s' espera um argumento", len, fn);
+      return TYPE_NONE;
+    }
+    if (v == TYPE_RANGE) {
+      parser_error_at(c->p, &e->token, "%.*s de range é pipeline: 0..n | %.*s",
+                      len, fn, len, fn);
+      return TYPE_NONE;
+    }
+    if (v == TYPE_F64) {
+      parser_error_at(c->p, &e->token, "'%.*s' espera vetor ou i64, não f64",
+                      len, fn);
+      return TYPE_NONE;
+    }
+    return v == TYPE_NONE ? TYPE_NONE : TYPE_I64;
+  }
+
+  // lane/shuffle: primeiro o vetor, depois índices
+  int ok = scalar_args(c, e, 1);
+  if (v == TYPE_NONE || !ok)
+    return TYPE_NONE;
+  if (!is_vec(c, v)) {
+    parser_error_at(c->p, &e->token, "'%.*s' espera vetor, não %s", len, fn,
+                    name(c, v));
+    return TYPE_NONE;
+  }
+  int lanes = types_info(c->t, v)->lanes;
+  if (call_is(e, "lane")) {
+    if (count == 2)
+      return TYPE_I64;
+    parser_error_at(c->p, &e->token, "lane espera (vetor, índice)");
+    return TYPE_NONE;
+  }
+  if (count == (size_t)lanes + 1)
+    return v;
+  parser_error_at(c->p, &e->token, "shuffle de %s espera %d índices, não %zu",
+                  name(c, v), lanes, count - 1);
+  return TYPE_NONE;
+}
+
+// `it` só existe nos estágios; a fonte ainda vê o de fora
+static TypeId pipeline_type(Check *c, AstNode *e) {
+  AstNode *source = e->data.pipeline.source;
+  TypeId src = check_expr(c, source);
+  int ok = src != TYPE_NONE;
+  if (ok && src != TYPE_RANGE && !is_vec(c, src)) {
+    parser_error_at(c->p, &source->token,
+                    "pipeline precisa de range ou vetor, não %s", name(c, src));
+    ok = 0;
+  }
+  size_t mark = c->nvars;
+  push_var(c, "it", 2, TYPE_I64);
+  if (c->oom)
+    return TYPE_NONE;
+  for (size_t i = 0; i < e->data.pipeline.count; i++) {
+    AstNode *stage = e->data.pipeline.stages[i].expr;
+    TypeId t = check_expr(c, stage);
+    if (t == TYPE_I64)
+      continue;
+    ok = 0;
+    if (t != TYPE_NONE)
+      parser_error_at(c->p, &stage->token,
+                      "estágio de pipeline tem que dar i64, não %s", name(c, t));
+  }
+  pop_vars(c, mark);
+  return ok ? TYPE_I64 : TYPE_NONE;
+}
+
+static TypeId expr_type(Check *c, AstNode *e) {
+  switch (e->kind) {
+  case AST_NUMBER_LIT:
+    return e->data.number.is_float ? TYPE_F64 : TYPE_I64;
+  case AST_VEC_LIT:
+    return types_vec(c->t, e->data.vec.type);
+  case AST_IDENT: {
+    const Var *v = find_var(c, e->data.ident.name, e->data.ident.len);
+    if (v)
+      return v->type;
+    parser_error_at(c->p, &e->token, "'%.*s' não existe aqui",
+                    (int)e->data.ident.len, e->data.ident.name);
+    return TYPE_NONE;
+  }
+  case AST_UNARY_OP: {
+    TypeId t = check_expr(c, e->data.unary.expr);
+    if (t != TYPE_RANGE)
+      return t;
+    parser_error_at(c->p, &e->token, "range não tem sinal");
+    return TYPE_NONE;
+  }
+  case AST_BIN_OP: {
+    TypeId l = check_expr(c, e->data.binop.left);
+    TypeId r = check_expr(c, e->data.binop.right);
+    return binop_type(c, e, l, r);
+  }
+  case AST_RANGE: {
+    TypeId lo = check_expr(c, e->data.binop.left);
+    TypeId hi = check_expr(c, e->data.binop.right);
+    if (lo == TYPE_NONE || hi == TYPE_NONE)
+      return TYPE_NONE;
+    if (lo == TYPE_I64 && hi == TYPE_I64)
+      return TYPE_RANGE;
+    parser_error_at(c->p, &e->token, "limite de range tem que ser i64: %s..%s",
+                    name(c, lo), name(c, hi));
+    return TYPE_NONE;
+  }
+  case AST_CALL:
+    return call_type(c, e);
+  case AST_PIPELINE:
+    return pipeline_type(c, e);
+  case AST_FORMAT: // buraco aceita qualquer valor
+    for (size_t i = 0; i < e->data.format.count; i++)
+      check_expr(c, e->data.format.parts[i].expr);
+    return TYPE_NONE;
+  default:
+    return TYPE_NONE;
+  }
+}
+
+static TypeId check_expr(Check *c, AstNode *e) {
+  if (!e)
+    return TYPE_NONE;
+  TypeId t = c->oom ? TYPE_NONE : expr_type(c, e);
+  if (c->oom) // pilha incompleta: o tipo pode ser de outro binding
+    t = TYPE_NONE;
+  if (c->keep)
+    types_set(c->t, e, t);
+  return t;
+}
+
+// ----- statements -----
+
+static void check_block(Check *c, AstNode *block);
+
+static void check_stmt(Check *c, AstNode *s) {
+  if (!s || c->p->halted)
+    return;
+  switch (s->kind) {
+  case AST_VAR_DECL: {
+    TypeId t = check_expr(c, s->data.var.init);
+    // `x = e` com x visível reatribui (scope.c): o tipo fica o do binding
+    Var *v = s->data.var.autofree
+                 ? NULL
+                 : find_var(c, s->data.var.name, s->data.var.len);
+    if (!v) {
+      push_var(c, s->data.var.name, s->data.var.len, t);
+    } else if (t != v->type && t != TYPE_NONE && v->type != TYPE_NONE) {
+      parser_error_at(c->p, &s->token, "'%.*s' é %s; não dá pra guardar %s nele",
+                      (int)s->data.var.len, s->data.var.name,
+                      name(c, v->type), name(c, t));
+    }
+    return;
+  }
+  case AST_ASSERT_STMT: // todo valor tem verdade (value_truthy)
+    check_expr(c, s->data.unary.expr);
+    check_expr(c, s->data.unary.message);
+    return;
+  case AST_DEFER_STMT:
+    push_defer(c, s->data.unary.expr);
+    return;
+  case AST_BLOCK:
+    check_block(c, s);
+    return;
+  case AST_ASYNC_BLOCK: // a tarefa vê cópia dos bindings: mesmos tipos
+    check_stmt(c, s->data.unary.expr);
+    return;
+  case AST_AWAIT_STMT:
+    return;
+  default: // expressão solta
+    check_expr(c, s);
+    return;
+  }
+}
+
+// Defer roda no scope_exit, com tudo que o bloco declarou: checa no fim,
+// do último pro primeiro, como ele roda
+static void check_block(Check *c, AstNode *block) {
+  size_t vars = c->nvars, defers = c->ndefers;
+  for (size_t i = 0; i < block->data.block_or_group.count; i++)
+    check_stmt(c, block->data.block_or_group.stmts[i]);
+  while (c->ndefers > defers)
+    check_stmt(c, c->defers[--c->ndefers]);
+  pop_vars(c, vars);
+}
+
+void ast_typecheck(Parser *p, AstNode *program) {
+  if (!program || program->kind != AST_BLOCK)
+    return;
+  TypeTable scratch;
+  types_init(&scratch, p->alloc);
+  Check c = {.p = p,
+             .t = p->types ? p->types : &scratch,
+             .keep = p->types != NULL};
+  // Statement de topo fora de test nunca roda: só os tests
+  for (size_t i = 0; i < program->data.block_or_group.count; i++) {
+    AstNode *stmt = program->data.block_or_group.stmts[i];
+    if (stmt && stmt->kind == AST_TEST_STMT && stmt->data.test.block &&
+        stmt->data.test.block->kind == AST_BLOCK)
+      check_block(&c, stmt->data.test.block);
+  }
+  free(c.vars);
+  free(c.index);
+  free(c.defers);
+  types_free(&scratch);
+}
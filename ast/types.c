@@ -0,0 +1,132 @@
+#include "types.h"
+#include "../lib/runtime/simd.h"
+#include <string.h>
+
+static const TypeInfo scalars[TYPE_FIRST_COMPOSITE] = {
+    [TYPE_NONE] = {.kind = TYPE_KIND_NONE},
+    [TYPE_I64] = {.kind = TYPE_KIND_I64},
+    [TYPE_F64] = {.kind = TYPE_KIND_F64},
+    [TYPE_RANGE] = {.kind = TYPE_KIND_RANGE, .elem = TYPE_I64},
+};
+
+void types_init(TypeTable *t, const ModalAllocator *alloc) {
+  *t = (TypeTable){.alloc = alloc ? alloc : modal_heap_allocator()};
+}
+
+void types_free(TypeTable *t) {
+  modal_free(t->alloc, t->types, t->cap * sizeof(TypeInfo));
+  modal_free(t->alloc, t->slots, t->nslots * sizeof(uint32_t));
+  modal_free(t->alloc, t->nodes, t->nodes_cap * sizeof(TypeId));
+  types_init(t, t->alloc);
+}
+
+// A chave é o próprio TypeInfo: 8 bytes, sem ponteiro
+static uint64_t info_hash(const TypeInfo *info) {
+  uint64_t bits;
+  memcpy(&bits, info, sizeof(bits));
+  bits ^= bits >> 33;
+  bits *= 0xff51afd7ed558ccdULL;
+  return bits ^ (bits >> 33);
+}
+
+static int same_info(const TypeInfo *a, const TypeInfo *b) {
+  return a->kind == b->kind && a->simd == b->simd && a->lanes == b->lanes &&
+         a->elem == b->elem;
+}
+
+static int slots_grow(TypeTable *t) {
+  uint32_t n = t->nslots ? t->nslots * 2 : 16;
+  uint32_t *slots = modal_alloc(t->alloc, n * sizeof(uint32_t));
+  if (!slots)
+    return 0;
+  memset(slots, 0, n * sizeof(uint32_t));
+  for (uint32_t i = 0; i < t->count; i++) {
+    uint32_t j = (uint32_t)info_hash(&t->types[i]) & (n - 1);
+    while (slots[j])
+      j = (j + 1) & (n - 1);
+    slots[j] = i + TYPE_FIRST_COMPOSITE;
+  }
+  modal_free(t->alloc, t->slots, t->nslots * sizeof(uint32_t));
+  t->slots = slots;
+  t->nslots = n;
+  return 1;
+}
+
+TypeId types_intern(TypeTable *t, TypeInfo info) {
+  for (TypeId id = 0; id < TYPE_FIRST_COMPOSITE; id++)
+    if (same_info(&scalars[id], &info))
+      return id;
+  if ((t->count + 1) * 2 > t->nslots && !slots_grow(t))
+    return TYPE_NONE;
+
+  uint32_t j = (uint32_t)info_hash(&info) & (t->nslots - 1);
+  for (; t->slots[j]; j = (j + 1) & (t->nslots - 1))
+    if (same_info(&t->types[t->slots[j] - TYPE_FIRST_COMPOSITE], &info))
+      return t->slots[j];
+
+  if (t->count == t->cap) {
+    uint32_t cap = t->cap ? t->cap * 2 : 8;
+    TypeInfo *types = modal_realloc(t->alloc, t->types,
+                                    t->cap * sizeof(TypeInfo),
+                                    cap * sizeof(TypeInfo));
+    if (!types)
+      return TYPE_NONE;
+    t->types = types;
+    t->cap = cap;
+  }
+  t->types[t->count] = info;
+  TypeId id = t->count++ + TYPE_FIRST_COMPOSITE;
+  t->slots[j] = id;
+  return id;
+}
+
+TypeId types_vec(TypeTable *t, int simd) {
+  return types_intern(t, (TypeInfo){.kind = TYPE_KIND_VEC,
+                                    .simd = (uint8_t)simd,
+                                    .lanes = (uint16_t)simd_lane_count(simd),
+                                    .elem = TYPE_I64});
+}
+
+const TypeInfo *types_info(const TypeTable *t, TypeId id) {
+  if (id < TYPE_FIRST_COMPOSITE)
+    return &scalars[id];
+  if (id - TYPE_FIRST_COMPOSITE >= t->count)
+    return &scalars[TYPE_NONE];
+  return &t->types[id - TYPE_FIRST_COMPOSITE];
+}
+
+const char *types_name(const TypeTable *t, TypeId id) {
+  const TypeInfo *info = types_info(t, id);
+  switch ((TypeKind)info->kind) {
+  case TYPE_KIND_I64:
+    return "i64";
+  case TYPE_KIND_F64:
+    return "f64";
+  case TYPE_KIND_RANGE:
+    return "range";
+  case TYPE_KIND_VEC:
+    return simd_type_name((SimdType)info->simd);
+  case TYPE_KIND_NONE:
+    break;
+  }
+  return "?";
+}
+
+void types_set(TypeTable *t, AstNode *node, TypeId id) {
+  if (t->nnodes == t->nodes_cap) {
+    if (t->nodes_cap > UINT32_MAX / 2)
+      return; // slot é de 32 bits: o resto fica sem tipo
+    uint32_t cap = t->nodes_cap ? t->nodes_cap * 2 : 256;
+    TypeId *nodes = modal_realloc(t->alloc, t->nodes,
+                                  t->nodes_cap * sizeof(TypeId),
+                                  cap * sizeof(TypeId));
+    if (!nodes)
+      return;
+    t->nodes = nodes;
+    t->nodes_cap = cap;
+    if (!t->nnodes)
+      t->nodes[t->nnodes++] = TYPE_NONE; // slot 0: nó sem tipo
+  }
+  node->ty = t->nnodes;
+  t->nodes[t->nnodes++] = id;
+}
@@ -0,0 +1,75 @@
+// types.h — tipos estáticos das expressões: tabela plana e interned, id de
+// 32 bits. Dois tipos iguais na estrutura têm o mesmo id, então comparar
+// tipo é comparar inteiro. O tipo de cada nó fica num array ao lado da AST
+// (node->ty é o índice), não dentro do nó
+#ifndef TYPES_H
+#define TYPES_H
+
+#include "ast.h"
+#include <stdint.h>
+
+typedef uint32_t TypeId;
+typedef struct Parser Parser; // parser.h
+
+typedef enum {
+  TYPE_KIND_NONE, // erro já reportado, ou nó sem checagem
+  TYPE_KIND_I64,
+  TYPE_KIND_F64,
+  TYPE_KIND_RANGE, // a..b de i64, só como fonte de pipeline
+  TYPE_KIND_VEC,   // simd + lanes, elementos i64
+} TypeKind;
+
+// Os escalares têm id fixo, sem passar pela tabela; composto começa em
+// TYPE_FIRST_COMPOSITE
+enum {
+  TYPE_NONE = 0,
+  TYPE_I64,
+  TYPE_F64,
+  TYPE_RANGE,
+  TYPE_FIRST_COMPOSITE
+};
+
+// 8 bytes — por quê tão pouco? Tipo composto aponta pros filhos por id,
+// a tabela é um array só
+typedef struct {
+  uint8_t kind; // TypeKind
+  uint8_t simd; // TYPE_KIND_VEC: SimdType
+  uint16_t lanes;
+  TypeId elem; // range/vetor: tipo de cada elemento
+} TypeInfo;
+
+typedef struct TypeTable {
+  const ModalAllocator *alloc;
+  TypeInfo *types; // id - TYPE_FIRST_COMPOSITE
+  uint32_t count, cap;
+  uint32_t *slots; // ids, endereçamento aberto, potência de 2; 0 vazio
+  uint32_t nslots;
+  TypeId *nodes; // tipo por node->ty; nodes[0] = TYPE_NONE
+  uint32_t nnodes, nodes_cap;
+} TypeTable;
+
+void types_init(TypeTable *t, const ModalAllocator *alloc);
+void types_free(TypeTable *t);
+
+// Id de info, criando se é a primeira vez; TYPE_NONE sem memória
+TypeId types_intern(TypeTable *t, TypeInfo info);
+TypeId types_vec(TypeTable *t, int simd);
+const TypeInfo *types_info(const TypeTable *t, TypeId id);
+// Pra mensagem: "i64", "f64", "range", "i32x4"
+const char *types_name(const TypeTable *t, TypeId id);
+
+// Grava id como tipo de node (um slot novo no primeiro); sem memória o nó
+// só fica sem tipo, e o eval segue dinâmico nele
+void types_set(TypeTable *t, AstNode *node, TypeId id);
+static inline TypeId types_of(const TypeTable *t, const AstNode *node) {
+  return t && node->ty < t->nnodes ? t->nodes[node->ty] : TYPE_NONE;
+}
+
+// Checa os tests de program e anota cada expressão em p->types (sem
+// tabela, uma temporária: só os erros valem). Escopo igual ao do executor:
+// `x = e` com x visível reatribui e tem que manter o tipo, defer vê o fim
+// do bloco. Erro vai pro parser_error_at no token do nó. parse_program
+// chama depois de um parse sem erro
+void ast_typecheck(Parser *p, AstNode *program);
+
+#endif
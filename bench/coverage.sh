@@ -0,0 +1,60 @@
+#!/bin/sh
+# coverage.sh — quanto o --coverage custa: o mesmo workload com e sem
+# contadores, melhor de N rodadas de cada (ruído só soma, nunca tira)
+#
+#   make bench-coverage
+#   bench/coverage.sh [tests] [rodadas]     (padrão: 20000 e 7)
+#
+# O workload sai gerado num diretório temporário: cada test tem 40
+# atribuições e 3 asserts, 43 statements — com o padrão, ~1,7M incrementos
+# de contador por rodada. Os dois lados rodam com --no-cache — por quê? O
+# --coverage já desliga o cache; com ele, o lado sem cobertura nem rodaria
+# os tests. O tempo é o do --test-time, só a execução dos tests: o parse é
+# quase todo o tempo de parede do processo e esconderia o custo do executor
+set -eu
+
+MODAL=${MODAL:-./modal}
+TESTS=${1:-20000}
+RUNS=${2:-7}
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+awk -v n="$TESTS" 'BEGIN {
+  for (t = 0; t < n; t++) {
+    printf "test \"t%d\" {\n  v0 = %d\n", t, t
+    for (k = 1; k < 40; k++)
+      printf "  v%d = v%d + %d\n", k, k - 1, k
+    printf "  assert v0 == %d\n  assert v39 - v0 == 780\n", t
+    printf "  assert v20 > v10\n}\n"
+  }
+}' > "$dir/bench.modal"
+
+# Melhor tempo em ms de RUNS rodadas de: $MODAL --no-cache "$@" bench.modal.
+# Quem mede é o próprio modal — por quê? date +%N não é POSIX, e sh não tem
+# relógio abaixo do segundo
+best() {
+  i=0
+  while [ "$i" -lt "$RUNS" ]; do
+    "$MODAL" --no-cache --test-time "$@" "$dir/bench.modal" 2>&1 > /dev/null
+    i=$((i + 1))
+  done | awk '/^tempo dos tests:/ {
+    if (min == "" || $4 < min)
+      min = $4
+  }
+  END {
+    if (min == "")
+      exit 1
+    print min
+  }'
+}
+
+off=$(best)
+on=$(best --coverage --coverage-file "$dir/cov")
+echo "workload: $TESTS tests, 43 statements cada; melhor de $RUNS"
+echo "sem --coverage: $off ms"
+echo "com --coverage: $on ms"
+awk -v a="$off" -v b="$on" 'BEGIN {
+  if (a > 0)
+    printf "custo: %+.1f%%\n", (b - a) * 100 / a
+}'
@@ -0,0 +1,163 @@
+#include "allocators.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN 16
+#define ARENA_DEFAULT_CHUNK (64 * 1024)
+
+static void *heap_alloc(void *ud, size_t size) {
+  (void)ud;
+  return malloc(size ? size : 1); // malloc(0) pode voltar NULL
+}
+
+static void *heap_realloc(void *ud, void *ptr, size_t old_size,
+                          size_t new_size) {
+  (void)ud;
+  (void)old_size;
+  return realloc(ptr, new_size ? new_size : 1);
+}
+
+static void heap_free(void *ud, void *ptr, size_t size) {
+  (void)ud;
+  (void)size;
+  free(ptr);
+}
+
+// const e sem estado — por quê? Compartilhado entre threads sem lock
+static const ModalAllocator heap_allocator = {
+    .alloc = heap_alloc,
+    .realloc = heap_realloc,
+    .free = heap_free,
+    .reset = NULL,
+    .ud = NULL,
+};
+
+const ModalAllocator *modal_heap_allocator(void) { return &heap_allocator; }
+
+struct ArenaChunk {
+  ArenaChunk *prev;
+  size_t cap;
+  size_t used;
+  size_t last; // offset da última alocação (pra free/realloc no lugar)
+  _Alignas(ARENA_ALIGN) unsigned char data[];
+};
+
+static size_t align_up(size_t n) {
+  return (n + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static ArenaChunk *chunk_new(ModalArena *arena, size_t min_size) {
+  size_t cap = arena->chunk_size;
+  if (cap < min_size)
+    cap = align_up(min_size);
+  ArenaChunk *chunk =
+      modal_alloc(arena->backing, sizeof(ArenaChunk) + cap);
+  if (!chunk)
+    return NULL;
+  chunk->prev = arena->head;
+  chunk->cap = cap;
+  chunk->used = 0;
+  chunk->last = SIZE_MAX;
+  arena->head = chunk;
+  return chunk;
+}
+
+static void *arena_alloc(void *ud, size_t size) {
+  ModalArena *arena = ud;
+  size = align_up(size ? size : 1);
+
+  ArenaChunk *chunk = arena->head;
+  if (!chunk || chunk->cap - chunk->used < size) {
+    chunk = chunk_new(arena, size);
+    if (!chunk)
+      return NULL;
+  }
+
+  void *ptr = chunk->data + chunk->used;
+  chunk->last = chunk->used;
+  chunk->used += size;
+  return ptr;
+}
+
+static int is_last(const ArenaChunk *chunk, const void *ptr) {
+  return chunk && chunk->last != SIZE_MAX &&
+         (const unsigned char *)ptr == chunk->data + chunk->last;
+}
+
+static void *arena_realloc(void *ud, void *ptr, size_t old_size,
+                           size_t new_size) {
+  ModalArena *arena = ud;
+  if (!ptr)
+    return arena_alloc(ud, new_size);
+
+  // Última alocação cresce no lugar — caso comum dos vetores do parser
+  ArenaChunk *chunk = arena->head;
+  if (is_last(chunk, ptr)) {
+    size_t need = align_up(new_size ? new_size : 1);
+    if (chunk->last + need <= chunk->cap) {
+      chunk->used = chunk->last + need;
+      return ptr;
+    }
+  }
+
+  if (new_size <= old_size)
+    return ptr;
+  void *out = arena_alloc(ud, new_size);
+  if (out)
+    memcpy(out, ptr, old_size);
+  return out;
+}
+
+static void arena_free(void *ud, void *ptr, size_t size) {
+  (void)size;
+  ModalArena *arena = ud;
+  ArenaChunk *chunk = arena->head;
+  if (is_last(chunk, ptr)) {
+    chunk->used = chunk->last;
+    chunk->last = SIZE_MAX;
+  }
+}
+
+static void arena_reset(void *ud) { modal_arena_reset(ud); }
+
+void modal_arena_init(ModalArena *arena, const ModalAllocator *backing,
+                      size_t chunk_size) {
+  arena->backing = backing ? backing : modal_heap_allocator();
+  arena->head = NULL;
+  arena->chunk_size = chunk_size ? align_up(chunk_size) : ARENA_DEFAULT_CHUNK;
+}
+
+ModalAllocator modal_arena_allocator(ModalArena *arena) {
+  return (ModalAllocator){
+      .alloc = arena_alloc,
+      .realloc = arena_realloc,
+      .free = arena_free,
+      .reset = arena_reset,
+      .ud = arena,
+  };
+}
+
+// Mantém o chunk mais antigo — por quê? Um serviço que reseta por request
+// reaproveita a mesma memória sem voltar ao backing toda vez
+void modal_arena_reset(ModalArena *arena) {
+  ArenaChunk *chunk = arena->head;
+  while (chunk && chunk->prev) {
+    ArenaChunk *prev = chunk->prev;
+    modal_free(arena->backing, chunk, sizeof(ArenaChunk) + chunk->cap);
+    chunk = prev;
+  }
+  if (chunk) {
+    chunk->used = 0;
+    chunk->last = SIZE_MAX;
+  }
+  arena->head = chunk;
+}
+
+void modal_arena_destroy(ModalArena *arena) {
+  modal_arena_reset(arena);
+  if (arena->head)
+    modal_free(arena->backing, arena->head,
+               sizeof(ArenaChunk) + arena->head->cap);
+  arena->head = NULL;
+}
@@ -1,9 +1,52 @@
 #ifndef ALLOCATORS_H
 #define ALLOCATORS_H
 
-#define free(ptr) ((void)0)
-#define malloc(sz) xmalloc(sz)
-#define realloc(p, s) xrealloc(p, s)
-#define calloc(n, s) xcalloc(n, s)
+#include <stddef.h>
+
+// Vtable de alocação — tudo que o compilador aloca (Tokenizer, Parser, nós
+// da AST) passa por aqui. Por quê? Quem embute o compilador decide de onde
+// vem a memória, e dá pra ter vários contextos independentes ao mesmo tempo.
+// Os tamanhos vão junto no realloc/free pra arenas não precisarem de header
+typedef struct ModalAllocator {
+  void *(*alloc)(void *ud, size_t size);
+  void *(*realloc)(void *ud, void *ptr, size_t old_size, size_t new_size);
+  void (*free)(void *ud, void *ptr, size_t size);
+  void (*reset)(void *ud); // libera tudo de uma vez; NULL se não suporta
+  void *ud;
+} ModalAllocator;
+
+static inline void *modal_alloc(const ModalAllocator *a, size_t size) {
+  return a->alloc(a->ud, size);
+}
+
+static inline void *modal_realloc(const ModalAllocator *a, void *ptr,
+                                  size_t old_size, size_t new_size) {
+  return a->realloc(a->ud, ptr, old_size, new_size);
+}
+
+static inline void modal_free(const ModalAllocator *a, void *ptr,
+                              size_t size) {
+  if (ptr)
+    a->free(a->ud, ptr, size);
+}
+
+// malloc/realloc/free da libc; reset é NULL
+const ModalAllocator *modal_heap_allocator(void);
+
+// Arena: bump allocation em chunks vindos de `backing`. free só devolve se
+// for a última alocação; reset volta tudo pro primeiro chunk
+typedef struct ArenaChunk ArenaChunk;
+
+typedef struct {
+  const ModalAllocator *backing;
+  ArenaChunk *head; // chunk atual (lista ligada pros anteriores)
+  size_t chunk_size;
+} ModalArena;
+
+void modal_arena_init(ModalArena *arena, const ModalAllocator *backing,
+                      size_t chunk_size);
+ModalAllocator modal_arena_allocator(ModalArena *arena);
+void modal_arena_reset(ModalArena *arena);
+void modal_arena_destroy(ModalArena *arena);
 
 #endif
@@ -0,0 +1,79 @@
+#include "region.h"
+#include <stdlib.h>
+
+#define REGION_ALIGN 16
+
+struct RegionChunk {
+  RegionChunk *next;
+  size_t cap;
+  size_t used;
+  _Alignas(REGION_ALIGN) unsigned char data[];
+};
+
+void region_pool_init(RegionPool *pool) {
+  *pool = (RegionPool){.free_chunks = NULL, .heap_calls = 0, .allocations = 0};
+}
+
+void region_pool_destroy(RegionPool *pool) {
+  while (pool->free_chunks) {
+    RegionChunk *next = pool->free_chunks->next;
+    free(pool->free_chunks);
+    pool->heap_calls++;
+    pool->free_chunks = next;
+  }
+}
+
+void region_open(Region *r, RegionPool *pool) {
+  r->pool = pool;
+  r->chunks = NULL; // chunk só sai do pool na primeira alocação
+}
+
+static RegionChunk *take_chunk(RegionPool *pool, size_t need) {
+  // Chunks do pool têm REGION_CHUNK; pedido maior vai direto pro heap
+  if (need <= REGION_CHUNK && pool->free_chunks) {
+    RegionChunk *c = pool->free_chunks;
+    pool->free_chunks = c->next;
+    c->used = 0;
+    return c;
+  }
+  size_t cap = need > REGION_CHUNK ? need : REGION_CHUNK;
+  RegionChunk *c = malloc(sizeof(RegionChunk) + cap);
+  pool->heap_calls++;
+  if (!c)
+    return NULL;
+  c->cap = cap;
+  c->used = 0;
+  return c;
+}
+
+void *region_alloc(Region *r, size_t size) {
+  size = (size + (REGION_ALIGN - 1)) & ~(size_t)(REGION_ALIGN - 1);
+  RegionChunk *c = r->chunks;
+  if (!c || c->cap - c->used < size) {
+    c = take_chunk(r->pool, size);
+    if (!c)
+      return NULL;
+    c->next = r->chunks;
+    r->chunks = c;
+  }
+  void *p = c->data + c->used;
+  c->used += size;
+  r->pool->allocations++;
+  return p;
+}
+
+void region_release(Region *r) {
+  RegionChunk *c = r->chunks;
+  while (c) {
+    RegionChunk *next = c->next;
+    if (c->cap == REGION_CHUNK) {
+      c->next = r->pool->free_chunks;
+      r->pool->free_chunks = c;
+    } else {
+      free(c); // chunk gigante não volta pro pool
+      r->pool->heap_calls++;
+    }
+    c = next;
+  }
+  r->chunks = NULL;
+}
@@ -0,0 +1,32 @@
+#ifndef REGION_H
+#define REGION_H
+
+#include <stddef.h>
+
+// Região de um escopo: bump allocation liberada de uma vez no fim do bloco.
+// Os chunks voltam pro RegionPool em vez do heap — por quê? Depois do
+// aquecimento, abrir/fechar escopo não chama malloc/free nenhuma vez
+#define REGION_CHUNK 4096
+
+typedef struct RegionChunk RegionChunk;
+
+typedef struct {
+  RegionChunk *free_chunks;
+  size_t heap_calls;  // malloc/free de chunks (o que sobra de heap)
+  size_t allocations; // region_alloc atendidos
+} RegionPool;
+
+typedef struct {
+  RegionPool *pool;
+  RegionChunk *chunks; // atual na cabeça
+} Region;
+
+void region_pool_init(RegionPool *pool);
+void region_pool_destroy(RegionPool *pool);
+
+void region_open(Region *r, RegionPool *pool);
+void *region_alloc(Region *r, size_t size); // NULL se o heap negou
+// Devolve todos os chunks ao pool num passo só
+void region_release(Region *r);
+
+#endif
@@ -0,0 +1,39 @@
+// ffi.h — header de exemplo pro `use` (examples/ffi.modal). As funções vêm
+// da libc, então roda sem --link
+#ifndef MODAL_FFI_EXAMPLE_H
+#define MODAL_FFI_EXAMPLE_H
+
+#include <stdint.h>
+
+#define BUF_SIZE 256
+#define FLAGS (1 << 3 | 0x1)
+#define LIMITE (BUF_SIZE * 4 - 1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum Cor { VERMELHO, VERDE = 5, AZUL };
+
+typedef struct {
+  int32_t x, y;
+} Ponto;
+
+struct Cabecalho {
+  uint8_t tag;
+  uint64_t len;
+  const char *nome;
+  Ponto cantos[2];
+};
+
+int abs(int x);
+long labs(long x);
+long long llabs(long long x);
+int toupper(int c);
+int isdigit(int c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,643 @@
+// complexity.c — fuzzing de complexidade pro next() e o parse_program: não
+// procura crash, procura entrada cujo custo cresce mais que linear.
+//
+// Um caso tem três partes separadas por CASE_SEP: prefixo, corpo e sufixo.
+// O corpo repete r vezes e depois 8r; a razão dos custos dá o expoente (1:
+// linear, 2: quadrático). CASE_REP e CASE_PREV viram o número da repetição
+// e o anterior (prefixo 0, corpo 1..r, sufixo r+1) — por quê? Cadeia de
+// #define Ai A(i-1) + A(i-1) precisa de um nome novo por repetição. Custo é medido em tokens, alocações, bytes
+// alocados e trabalho (instruções com perf_event, senão ns de CPU), por
+// byte de entrada.
+//
+//   make fuzz
+//   ./modal-fuzz [--runs n] [--seed s] [--out dir] [casos ou diretórios...]
+//       busca: muta os casos (e um dicionário de tokens), minimiza o que
+//       passar do limite e grava em dir (padrão fuzz/corpus)
+//   ./modal-fuzz --check fuzz/corpus
+//       regressão: mede cada caso salvo; sai com 1 se algum não é linear.
+//       Cada caso também parseia uma vez com STRESS_BYTES — por quê? Pilha
+//       funda (cadeia `1 + 1 + ...`) só estoura bem acima da medida maior
+//
+// Com -DMODAL_LIBFUZZER vira alvo do libFuzzer (make modal-libfuzzer): cada
+// entrada é um caso, e superlinear aborta — o libFuzzer grava o crash
+#define _DEFAULT_SOURCE // syscall (perf_event), clock_gettime, dirent
+#include "../ast/ast.h"
+#include "../ast/parser.h"
+#include "../ast/strpool.h"
+#include "../tokenizer/tokenizer.h"
+#include <dirent.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define CASE_SEP '\x1e' // ASCII record separator: nunca é fonte válido
+#define CASE_REP '\x1d' // group separator, idem
+#define CASE_PREV '\x1c' // file separator, idem
+#define PART_MAX 256    // o corpo é a unidade que repete: pequeno de propósito
+#define MIN_BYTES 2048  // tamanho da medida menor; a maior é SCALE vezes
+#define SCALE 8
+#define STRESS_BYTES (1u << 20)
+// Expoente acima disso é superlinear. Contador é exato; tempo tem ruído
+#define LIMIT_COUNT 1.25
+#define LIMIT_WORK 1.5
+
+// ---- custo ----------------------------------------------------------------
+
+typedef struct {
+  const ModalAllocator *backing;
+  uint64_t allocs, bytes;
+} Counter;
+
+static void *count_alloc(void *ud, size_t size) {
+  Counter *c = ud;
+  c->allocs++;
+  c->bytes += size;
+  return modal_alloc(c->backing, size);
+}
+
+static void *count_realloc(void *ud, void *ptr, size_t old_size,
+                           size_t new_size) {
+  Counter *c = ud;
+  c->allocs++;
+  if (new_size > old_size)
+    c->bytes += new_size - old_size;
+  return modal_realloc(c->backing, ptr, old_size, new_size);
+}
+
+static void count_free(void *ud, void *ptr, size_t size) {
+  modal_free(((Counter *)ud)->backing, ptr, size);
+}
+
+enum { M_TOKENS, M_ALLOCS, M_BYTES, M_LEX_WORK, M_PARSE_WORK, M_COUNT };
+static const char *metric_names[M_COUNT] = {"tokens", "allocs", "bytes",
+                                            "lex-work", "parse-work"};
+
+typedef struct {
+  double v[M_COUNT];
+} Cost;
+
+// Instruções do processo em modo usuário; -1 sem perf (container, macOS):
+// aí vale o tempo de CPU da thread
+static int perf_fd = -1;
+static const char *work_unit = "ns";
+
+static void work_open(void) {
+#ifdef __linux__
+  struct perf_event_attr a;
+  memset(&a, 0, sizeof(a));
+  a.type = PERF_TYPE_HARDWARE;
+  a.size = sizeof(a);
+  a.config = PERF_COUNT_HW_INSTRUCTIONS;
+  a.disabled = 1;
+  a.exclude_kernel = 1;
+  a.exclude_hv = 1;
+  perf_fd = (int)syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);
+  if (perf_fd >= 0 && ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, 0) != 0) {
+    close(perf_fd);
+    perf_fd = -1;
+  }
+  if (perf_fd >= 0)
+    work_unit = "instr";
+#endif
+}
+
+static uint64_t work_now(void) {
+#ifdef __linux__
+  uint64_t n;
+  if (perf_fd >= 0 && read(perf_fd, &n, sizeof(n)) == (ssize_t)sizeof(n))
+    return n;
+#endif
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t lex_once(const char *src, const ModalAllocator *a,
+                         uint64_t *tokens) {
+  Tokenizer t;
+  uint64_t w0 = work_now();
+  init(&t, src, a);
+  uint64_t n = 0;
+  while (next(&t).kind != TOK_EOF)
+    n++;
+  uint64_t w = work_now() - w0;
+  tokenizer_free_lexemes(a, t.lexemes);
+  *tokens = n;
+  return w;
+}
+
+// Igual ao modal_parse, sem contexto: #include e use de módulo viram erro,
+// então nada do disco entra na medida
+static uint64_t parse_once(const char *src, const ModalAllocator *a) {
+  uint64_t w0 = work_now();
+  Tokenizer t;
+  init(&t, src, a);
+  StrPool strings;
+  strpool_init(&strings, a);
+  Parser p;
+  parser_init(&p, &t, "<fuzz>");
+  p.strings = &strings;
+  AstNode *root = parse_program(&p);
+  ast_free(a, root);
+  diag_free(&p.diag);
+  strpool_free(&strings);
+  tokenizer_free_lexemes(a, t.lexemes);
+  return work_now() - w0;
+}
+
+// Trabalho é o menor de 3 — por quê? Ruído só soma, nunca tira
+static void measure(const char *src, Cost *out) {
+  Counter c = {.backing = modal_heap_allocator()};
+  ModalAllocator a = {.alloc = count_alloc,
+                      .realloc = count_realloc,
+                      .free = count_free,
+                      .ud = &c};
+  uint64_t tokens = 0, lex = UINT64_MAX, parse = UINT64_MAX;
+  for (int i = 0; i < 3; i++) {
+    uint64_t w = lex_once(src, &a, &tokens);
+    if (w < lex)
+      lex = w;
+  }
+  c.allocs = c.bytes = 0;
+  for (int i = 0; i < 3; i++) {
+    uint64_t w = parse_once(src, &a);
+    if (w < parse)
+      parse = w;
+  }
+  out->v[M_TOKENS] = (double)tokens;
+  out->v[M_ALLOCS] = (double)c.allocs / 3;
+  out->v[M_BYTES] = (double)c.bytes / 3;
+  out->v[M_LEX_WORK] = (double)lex;
+  out->v[M_PARSE_WORK] = (double)parse;
+}
+
+// ---- casos ----------------------------------------------------------------
+
+enum { PREFIX, BODY, SUFFIX };
+
+typedef struct {
+  char part[3][PART_MAX];
+  size_t len[3];
+} Case;
+
+// Sem separador: tudo é corpo; um só: prefixo e corpo
+static void case_from_bytes(Case *c, const uint8_t *data, size_t size) {
+  memset(c, 0, sizeof(*c));
+  const uint8_t *seps[2] = {NULL, NULL};
+  int nsep = 0;
+  for (size_t i = 0; i < size && nsep < 2; i++)
+    if (data[i] == (uint8_t)CASE_SEP)
+      seps[nsep++] = data + i;
+  const uint8_t *start[3] = {data, data, data + size};
+  const uint8_t *end[3] = {data, data + size, data + size};
+  if (nsep >= 1) {
+    end[PREFIX] = seps[0];
+    start[BODY] = seps[0] + 1;
+  }
+  if (nsep == 2) {
+    end[BODY] = seps[1];
+    start[SUFFIX] = seps[1] + 1;
+  }
+  for (int p = 0; p < 3; p++) {
+    size_t n = (size_t)(end[p] - start[p]);
+    if (n > PART_MAX)
+      n = PART_MAX;
+    for (size_t i = 0; i < n; i++) // '\0' pararia o tokenizer no meio
+      c->part[p][c->len[p]++] = start[p][i] ? (char)start[p][i] : ' ';
+  }
+}
+
+// Parte p como a repetição número idx; devolve o fim do que escreveu
+static char *put_part(char *w, const Case *c, int p, size_t idx) {
+  for (size_t i = 0; i < c->len[p]; i++) {
+    char b = c->part[p][i];
+    if (b == CASE_REP || b == CASE_PREV)
+      w += sprintf(w, "%zu", b == CASE_REP ? idx : idx ? idx - 1 : 0);
+    else
+      *w++ = b;
+  }
+  return w;
+}
+
+// prefixo + corpo * reps + sufixo, terminado em '\0'
+static char *expand(const Case *c, size_t reps, size_t *len) {
+  size_t n = c->len[PREFIX] + c->len[BODY] * reps + c->len[SUFFIX];
+  size_t marks = 0; // cada um vira até 20 dígitos
+  for (int p = 0; p < 3; p++)
+    for (size_t i = 0; i < c->len[p]; i++)
+      marks += (c->part[p][i] == CASE_REP || c->part[p][i] == CASE_PREV) *
+               (p == BODY ? reps : 1);
+  char *s = malloc(n + marks * 20 + 1);
+  if (!s)
+    return NULL;
+  char *w = put_part(s, c, PREFIX, 0);
+  for (size_t i = 0; i < reps; i++)
+    w = put_part(w, c, BODY, i + 1);
+  w = put_part(w, c, SUFFIX, reps + 1);
+  *w = '\0';
+  *len = (size_t)(w - s);
+  return s;
+}
+
+typedef struct {
+  double exp[M_COUNT]; // expoente de cada métrica; 0 se não deu pra medir
+  Cost small, large;
+  size_t bytes[2];
+  int worst; // métrica com o maior expoente
+  int superlinear;
+} Verdict;
+
+static double limit_of(int m) {
+  return m == M_LEX_WORK || m == M_PARSE_WORK ? LIMIT_WORK : LIMIT_COUNT;
+}
+
+static int judge(const Case *c, Verdict *v) {
+  memset(v, 0, sizeof(*v));
+  if (!c->len[BODY])
+    return 0; // nada pra repetir
+  size_t reps = (MIN_BYTES + c->len[BODY] - 1) / c->len[BODY];
+  char *s = expand(c, reps, &v->bytes[0]);
+  if (!s)
+    return 0;
+  measure(s, &v->small);
+  free(s);
+  s = expand(c, reps * SCALE, &v->bytes[1]);
+  if (!s)
+    return 0;
+  measure(s, &v->large);
+  free(s);
+
+  double scale = log((double)v->bytes[1] / (double)v->bytes[0]);
+  for (int m = 0; m < M_COUNT; m++) {
+    // Contador que quase não anda (ex.: 0 tokens num comentário) não diz nada
+    if (v->small.v[m] < 16 || v->large.v[m] <= 0)
+      continue;
+    v->exp[m] = log(v->large.v[m] / v->small.v[m]) / scale;
+    if (v->exp[m] - limit_of(m) > v->exp[v->worst] - limit_of(v->worst))
+      v->worst = m;
+  }
+  v->superlinear = v->exp[v->worst] > limit_of(v->worst);
+  return 1;
+}
+
+static void print_verdict(FILE *out, const char *name, const Verdict *v) {
+  fprintf(out, "%s: %zu → %zu bytes", name, v->bytes[0], v->bytes[1]);
+  for (int m = 0; m < M_COUNT; m++)
+    if (v->exp[m] > 0)
+      fprintf(out, " %s n^%.2f", metric_names[m], v->exp[m]);
+  double per_byte = v->large.v[M_PARSE_WORK] / (double)v->bytes[1];
+  fprintf(out, "; parse %.1f %s/byte%s\n", per_byte, work_unit,
+          v->superlinear ? "  SUPERLINEAR" : "");
+}
+
+#ifdef MODAL_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  static int opened;
+  if (!opened++)
+    work_open();
+  Case c;
+  case_from_bytes(&c, data, size);
+  Verdict v;
+  if (judge(&c, &v) && v.superlinear) {
+    print_verdict(stderr, "libfuzzer", &v);
+    abort();
+  }
+  return 0;
+}
+
+#else
+
+// ---- busca ----------------------------------------------------------------
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t rng(void) { // xorshift64*: mesma semente, mesma busca
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+static size_t pick(size_t n) { return n ? (size_t)(rng() % n) : 0; }
+
+// Pedaços que levam o lexer e o parser pros estados caros: comentário e
+// string sem fim, buraco de f-string, diretiva, macro em cadeia, recovery
+// de erro
+static const char *const dict[] = {
+    "test \"t\" {", "assert ", "defer ", "async {", "await", "autofree ",
+    "struct S {",   "union U {", "use \"x.h\"", "alias ", "sizeof(", "(",
+    ")",            "{",         "}",           "\"",     "f\"",    "{x}",
+    "\\",           "-{",        "*/",          "--",     "\n",     "#define A ",
+    "#if 1\n",      "#endif\n",  "..",          "...",    "|",      "map it",
+    "filter ",      "| sum",     "=",           "==",     "+",      "*",
+    "0x",           "1.5e",      "1_000",       "i32x4(", ",",      ";",
+    "x",            "?.",        "??",          "->",     "::",     "@",
+    "'",            "\\x",       " ",           "\t",     "{{",     "}}",
+    "#define A\x1d A\x1c + A\x1c\n", // cadeia: CASE_REP / CASE_PREV
+};
+
+static void insert(Case *c, int p, const char *s, size_t n) {
+  if (c->len[p] + n > PART_MAX)
+    return;
+  size_t at = pick(c->len[p] + 1);
+  memmove(c->part[p] + at + n, c->part[p] + at, c->len[p] - at);
+  memcpy(c->part[p] + at, s, n);
+  c->len[p] += n;
+}
+
+static void erase(Case *c, int p, size_t at, size_t n) {
+  memmove(c->part[p] + at, c->part[p] + at + n, c->len[p] - at - n);
+  c->len[p] -= n;
+}
+
+static void mutate(Case *c, const Case *pool, size_t npool) {
+  int p = pick(10) < 7 ? BODY : pick(2) ? PREFIX : SUFFIX;
+  size_t len = c->len[p];
+  switch (pick(6)) {
+  case 0: {
+    const char *s = dict[pick(sizeof(dict) / sizeof(dict[0]))];
+    insert(c, p, s, strlen(s));
+    break;
+  }
+  case 1: {
+    char b = (char)(pick(4) ? 32 + pick(95) : 1 + pick(255));
+    if (b == CASE_SEP)
+      b = ' ';
+    insert(c, p, &b, 1);
+    break;
+  }
+  case 2:
+    if (len) {
+      size_t at = pick(len);
+      erase(c, p, at, 1 + pick(len - at));
+    }
+    break;
+  case 3:
+    if (len) {
+      size_t at = pick(len), n = 1 + pick(len - at);
+      char tmp[PART_MAX];
+      memcpy(tmp, c->part[p] + at, n);
+      insert(c, p, tmp, n);
+    }
+    break;
+  case 4:
+    if (len) {
+      char b = (char)(32 + pick(95));
+      c->part[p][pick(len)] = b == CASE_SEP ? ' ' : b;
+    }
+    break;
+  default: {
+    const Case *o = &pool[pick(npool)];
+    int q = (int)pick(3);
+    if (o->len[q]) {
+      size_t at = pick(o->len[q]);
+      insert(c, p, o->part[q] + at, 1 + pick(o->len[q] - at));
+    }
+    break;
+  }
+  }
+}
+
+// Tira pedaços de cada parte enquanto o caso continuar superlinear na
+// mesma métrica — por quê? O corpus fica com o mínimo que reproduz
+static void minimize(Case *c, int metric) {
+  int tries = 0;
+  for (int p = BODY;; p = p == BODY ? PREFIX : p == PREFIX ? SUFFIX : -1) {
+    if (p < 0)
+      break;
+    for (size_t chunk = c->len[p] / 2 ? c->len[p] / 2 : 1; chunk;
+         chunk /= 2) {
+      for (size_t at = 0; at + chunk <= c->len[p] && tries < 400;) {
+        Case t = *c;
+        erase(&t, p, at, chunk);
+        Verdict v;
+        tries++;
+        if (judge(&t, &v) && v.superlinear && v.worst == metric)
+          *c = t;
+        else
+          at += chunk;
+      }
+    }
+  }
+}
+
+static size_t case_to_bytes(const Case *c, char *out) {
+  size_t n = 0;
+  for (int p = 0; p < 3; p++) {
+    if (p)
+      out[n++] = CASE_SEP;
+    memcpy(out + n, c->part[p], c->len[p]);
+    n += c->len[p];
+  }
+  return n;
+}
+
+static uint64_t fnv(const char *s, size_t n) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < n; i++)
+    h = (h ^ (uint8_t)s[i]) * 0x100000001b3ULL;
+  return h;
+}
+
+static int save_case(const Case *c, const char *dir, const char *metric,
+                     char *path, size_t cap) {
+  char buf[3 * PART_MAX + 2];
+  size_t n = case_to_bytes(c, buf);
+  mkdir(dir, 0755);
+  snprintf(path, cap, "%s/%s-%016llx", dir, metric,
+           (unsigned long long)fnv(buf, n));
+  FILE *f = fopen(path, "wb");
+  if (!f)
+    return 0;
+  int ok = fwrite(buf, 1, n, f) == n;
+  return fclose(f) == 0 && ok;
+}
+
+static int load_case(const char *path, Case *c) {
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return 0;
+  uint8_t buf[3 * PART_MAX + 2];
+  size_t n = fread(buf, 1, sizeof(buf), f);
+  fclose(f);
+  case_from_bytes(c, buf, n);
+  return 1;
+}
+
+typedef struct {
+  char **paths;
+  size_t count, cap;
+} PathList;
+
+static void add_path(PathList *l, const char *path) {
+  struct stat st;
+  if (stat(path, &st) != 0)
+    return;
+  if (S_ISDIR(st.st_mode)) {
+    DIR *d = opendir(path);
+    if (!d)
+      return;
+    struct dirent *e;
+    while ((e = readdir(d)))
+      if (e->d_name[0] != '.') {
+        char full[4096];
+        snprintf(full, sizeof(full), "%s/%s", path, e->d_name);
+        add_path(l, full);
+      }
+    closedir(d);
+    return;
+  }
+  if (l->count == l->cap) {
+    size_t cap = l->cap ? l->cap * 2 : 16;
+    char **paths = realloc(l->paths, cap * sizeof(char *));
+    if (!paths)
+      return;
+    l->paths = paths;
+    l->cap = cap;
+  }
+  char *copy = strdup(path);
+  if (copy)
+    l->paths[l->count++] = copy;
+}
+
+static int by_name(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static int check(PathList *l) {
+  qsort(l->paths, l->count, sizeof(char *), by_name);
+  int bad = 0;
+  for (size_t i = 0; i < l->count; i++) {
+    Case c;
+    Verdict v;
+    if (!load_case(l->paths[i], &c) || !judge(&c, &v))
+      continue;
+    print_verdict(stdout, l->paths[i], &v);
+    bad += v.superlinear;
+
+    size_t len;
+    char *s = expand(&c, STRESS_BYTES / c.len[BODY], &len);
+    if (s)
+      parse_once(s, modal_heap_allocator());
+    free(s);
+  }
+  printf("%zu casos, %d superlineares\n", l->count, bad);
+  return bad ? 1 : 0;
+}
+
+#define POOL_MAX 256
+
+static int search(PathList *seeds, long runs, const char *out_dir) {
+  static Case pool[POOL_MAX];
+  static double score[POOL_MAX];
+  size_t npool = 0;
+  for (size_t i = 0; i < seeds->count && npool < POOL_MAX; i++)
+    if (load_case(seeds->paths[i], &pool[npool]))
+      npool++;
+  for (size_t i = 0; i < sizeof(dict) / sizeof(dict[0]) && npool < POOL_MAX;
+       i++) {
+    Case *c = &pool[npool++];
+    memset(c, 0, sizeof(*c));
+    memcpy(c->part[BODY], dict[i], strlen(dict[i]));
+    c->len[BODY] = strlen(dict[i]);
+  }
+
+  uint64_t seen[256];
+  size_t nseen = 0;
+  int found = 0;
+  for (long r = 0; r < runs; r++) {
+    size_t parent = pick(npool);
+    Case c = pool[parent];
+    for (size_t k = 1 + pick(3); k; k--)
+      mutate(&c, pool, npool);
+    Verdict v;
+    if (!judge(&c, &v))
+      continue;
+    double s = v.exp[v.worst] - limit_of(v.worst);
+
+    if (v.superlinear) {
+      minimize(&c, v.worst);
+      char buf[3 * PART_MAX + 2];
+      uint64_t h = fnv(buf, case_to_bytes(&c, buf));
+      int dup = 0;
+      for (size_t i = 0; i < nseen; i++)
+        dup |= seen[i] == h;
+      if (dup || !judge(&c, &v) || !v.superlinear)
+        continue;
+      if (nseen < sizeof(seen) / sizeof(seen[0]))
+        seen[nseen++] = h;
+      char path[4096];
+      if (save_case(&c, out_dir, metric_names[v.worst], path, sizeof(path))) {
+        print_verdict(stdout, path, &v);
+        found++;
+      }
+      continue;
+    }
+    // Sobe o morro: fica quem chega mais perto do limite
+    if (npool < POOL_MAX) {
+      score[npool] = s;
+      pool[npool++] = c;
+    } else if (s > score[parent]) {
+      size_t victim = pick(npool);
+      if (score[victim] < s) {
+        score[victim] = s;
+        pool[victim] = c;
+      }
+    }
+    if ((r + 1) % 1000 == 0)
+      fprintf(stderr, "%ld execuções, %d superlineares\n", r + 1, found);
+  }
+  printf("%ld execuções, %d superlineares%s%s\n", runs, found,
+         found ? " em " : "", found ? out_dir : "");
+  return found ? 1 : 0;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Uso: %s [--runs n] [--seed s] [--out dir] [casos ou dirs...]\n"
+          "     %s --check <casos ou dirs...>\n",
+          prog, prog);
+}
+
+int main(int argc, char **argv) {
+  long runs = 2000;
+  const char *out_dir = "fuzz/corpus";
+  int check_mode = 0;
+  PathList paths = {0};
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--check") == 0) {
+      check_mode = 1;
+    } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+      runs = strtol(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      rng_state = strtoull(argv[++i], NULL, 10) | 1;
+    } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      out_dir = argv[++i];
+    } else if (argv[i][0] == '-') {
+      usage(argv[0]);
+      return 2;
+    } else {
+      add_path(&paths, argv[i]);
+    }
+  }
+  setvbuf(stdout, NULL, _IOLBF, 0); // achado sai mesmo se o resto travar
+  work_open();
+  fprintf(stderr, "trabalho medido em %s\n", work_unit);
+  int status = check_mode ? check(&paths) : search(&paths, runs, out_dir);
+  for (size_t i = 0; i < paths.count; i++)
+    free(paths.paths[i]);
+  free(paths.paths);
+  return status;
+}
+
+#endif
@@ -0,0 +1,202 @@
+#include "async_exec.h"
+#include "coverage.h"
+#include "profile.h"
+#include "scope.h"
+#include <stdlib.h>
+
+// Onde a tarefa parou num bloco — a "pilha" da corrotina são esses pares
+// mais o escopo de cada bloco. Escopo no heap, não no array — por quê? O
+// array cresce com realloc e os filhos apontam pro escopo do pai
+typedef struct {
+  AstNode *block;
+  size_t index;
+  Scope *scope;
+} AsyncFrame;
+
+#define INLINE_FRAMES 4
+
+typedef struct {
+  Coro coro; // primeiro campo: Coro* <-> AsyncTask*
+  AsyncFrame *frames;
+  size_t depth, cap;
+  _Atomic int *failed; // compartilhado pelo test inteiro
+  const TestEnv *env;  // idem
+  RegionPool pool;     // regiões dos escopos desta tarefa
+  AsyncFrame inline_frames[INLINE_FRAMES];
+} AsyncTask;
+
+int ast_uses_async(const AstNode *node) {
+  if (!node)
+    return 0;
+  switch (node->kind) {
+  case AST_ASYNC_BLOCK:
+  case AST_AWAIT_STMT:
+    return 1;
+  case AST_BLOCK:
+  case AST_PAREN_GROUP:
+    for (size_t i = 0; i < node->data.block_or_group.count; i++)
+      if (ast_uses_async(node->data.block_or_group.stmts[i]))
+        return 1;
+    return 0;
+  default:
+    return 0;
+  }
+}
+
+static int push_frame(AsyncTask *t, AstNode *block) {
+  if (t->depth == t->cap) {
+    size_t cap = t->cap * 2;
+    AsyncFrame *frames;
+    if (t->frames == t->inline_frames) {
+      frames = malloc(cap * sizeof(AsyncFrame));
+      if (frames)
+        for (size_t i = 0; i < t->depth; i++)
+          frames[i] = t->frames[i];
+    } else {
+      frames = realloc(t->frames, cap * sizeof(AsyncFrame));
+    }
+    if (!frames)
+      return 0;
+    t->frames = frames;
+    t->cap = cap;
+  }
+  Scope *scope = malloc(sizeof(Scope));
+  if (!scope)
+    return 0;
+  scope_open(scope, t->depth ? t->frames[t->depth - 1].scope : NULL, &t->pool);
+  scope->env = t->env;
+  cov_hit(t->env, block->cov); // raiz, bloco aninhado e corpo de async
+  t->frames[t->depth++] = (AsyncFrame){block, 0, scope};
+  return 1;
+}
+
+// Fecha o bloco do topo: defers dele rodam aqui, antes de voltar pro pai
+static int pop_frame(AsyncTask *t) {
+  Scope *scope = t->frames[--t->depth].scope;
+  int ok = scope_exit(scope);
+  free(scope);
+  return ok;
+}
+
+static void task_free(Coro *c) {
+  AsyncTask *t = (AsyncTask *)c;
+  while (t->depth > 0) // só sobra frame em tarefa que nem chegou a rodar
+    pop_frame(t);
+  region_pool_destroy(&t->pool);
+  if (t->frames != t->inline_frames)
+    free(t->frames);
+  free(t);
+}
+
+static CoroStatus task_resume(SchedWorker *w, Coro *c);
+
+static AsyncTask *task_new(AstNode *block, _Atomic int *failed,
+                           const TestEnv *env) {
+  AsyncTask *t = malloc(sizeof(AsyncTask));
+  if (!t)
+    return NULL;
+  coro_init(&t->coro, task_resume, task_free);
+  t->frames = t->inline_frames;
+  t->depth = 0;
+  t->cap = INLINE_FRAMES;
+  t->failed = failed;
+  t->env = env;
+  region_pool_init(&t->pool);
+  if (!push_frame(t, block)) {
+    task_free(&t->coro);
+    return NULL;
+  }
+  return t;
+}
+
+static void fail(AsyncTask *t) {
+  atomic_store(t->failed, 1);
+  // Para o corpo, mas os defers de cada bloco aberto ainda rodam; os filhos
+  // são esperados no fim
+  while (t->depth > 0)
+    pop_frame(t);
+}
+
+// Pilha do --profile nesta thread: test + blocos abertos da tarefa. Refeita
+// a cada statement — por quê? A tarefa retoma em qualquer worker, e os
+// blocos abrem e fecham no meio do loop
+static void prof_task(const AsyncTask *t) {
+  profile_reset(t->env->test);
+  for (size_t i = 0; i < t->depth; i++)
+    profile_push(t->frames[i].block);
+}
+
+// Executa statements até o fim ou até um await suspender. Por quê loop e não
+// recursão? O estado inteiro fica em frames, dá pra parar e voltar em
+// qualquer statement
+static CoroStatus task_resume(SchedWorker *w, Coro *c) {
+  AsyncTask *t = (AsyncTask *)c;
+
+  while (t->depth > 0) {
+    AsyncFrame *f = &t->frames[t->depth - 1];
+    if (!f->block || f->index >= f->block->data.block_or_group.count) {
+      if (!pop_frame(t))
+        fail(t);
+      continue;
+    }
+    AstNode *stmt = f->block->data.block_or_group.stmts[f->index++];
+    if (!stmt)
+      continue;
+    if (t->env && t->env->profile)
+      prof_task(t);
+
+    switch (stmt->kind) {
+    case AST_ASSERT_STMT:
+    case AST_VAR_DECL:
+    case AST_DEFER_STMT:
+    case AST_CALL:
+      if (!scope_exec(f->scope, stmt))
+        fail(t);
+      break;
+    case AST_BLOCK:
+      if (!push_frame(t, stmt))
+        fail(t);
+      break;
+    case AST_ASYNC_BLOCK: {
+      cov_hit(t->env, stmt->cov);
+      AsyncTask *child = task_new(stmt->data.unary.expr, t->failed, t->env);
+      if (!child || !scope_capture(child->frames[0].scope, f->scope)) {
+        if (child)
+          task_free(&child->coro); // filho que não subiu: fecha sem rodar
+        fail(t);
+        break;
+      }
+      sched_spawn(w, &child->coro, c);
+      break;
+    }
+    case AST_AWAIT_STMT:
+      cov_hit(t->env, stmt->cov); // uma vez: retomar não passa aqui de novo
+      if (!sched_join(c)) {
+        if (t->env && t->env->profile)
+          profile_reset(NULL);
+        return CORO_SUSPENDED; // último filho retoma daqui
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  if (t->env && t->env->profile)
+    profile_reset(NULL); // o worker volta pro scheduler
+  // Fim do corpo: espera os filhos antes de terminar
+  if (!sched_join(c))
+    return CORO_SUSPENDED;
+  return CORO_DONE;
+}
+
+int async_exec_block(Scheduler *s, AstNode *block, const TestEnv *env) {
+  _Atomic int failed;
+  atomic_init(&failed, 0);
+
+  AsyncTask *root = task_new(block, &failed, env);
+  if (!root)
+    return 0;
+  sched_run(s, &root->coro);
+  return !atomic_load(&failed);
+}
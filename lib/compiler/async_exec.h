@@ -0,0 +1,21 @@
+// async_exec.h
+#ifndef ASYNC_EXEC_H
+#define ASYNC_EXEC_H
+
+#include "../../ast/ast.h"
+#include "../runtime/sched.h"
+#include "scope.h"
+
+// Tem async/await em algum ponto do bloco? Sem isso o test roda direto na
+// thread do runner, sem passar pelo scheduler
+int ast_uses_async(const AstNode *node);
+
+// Roda o corpo de um test como corrotina raiz no pool: cada `async { }`
+// vira uma tarefa filha, `await` suspende até os filhos terminarem, e o
+// fim de um bloco async espera os próprios filhos (concorrência
+// estruturada). Retorna 1 se todos os asserts passaram; env (ou NULL) vai
+// pra toda tarefa: a mensagem do primeiro assert que falhou, de qualquer
+// uma, e os contadores do --coverage
+int async_exec_block(Scheduler *s, AstNode *block, const TestEnv *env);
+
+#endif
@@ -0,0 +1,378 @@
+#include "coverage.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define COVERAGE_MAGIC "MODALCV1"
+
+typedef struct {
+  char magic[8];
+  uint64_t nfiles, nslots, names_len; // nomes: um blob com '\0' entre eles
+} CovHeader;
+
+// Cresce *items em dobro até caber need (malloc direto: a cobertura não
+// pertence à AST)
+static int grow(void **items, size_t *cap, size_t need, size_t size) {
+  if (need <= *cap)
+    return 1;
+  size_t n = *cap ? *cap : 64;
+  while (n < need)
+    n *= 2;
+  void *p = realloc(*items, n * size);
+  if (!p)
+    return 0;
+  *items = p;
+  *cap = n;
+  return 1;
+}
+
+void coverage_init(Coverage *c) {
+  *c = (Coverage){0};
+  // O ralo já nasce: slot 0 de quem não tem slot
+  if (grow((void **)&c->slots, &c->cap, 1, sizeof(CovSlot)))
+    c->slots[c->count++] = (CovSlot){0};
+}
+
+void coverage_free(Coverage *c) {
+  for (size_t i = 0; i < c->nfiles; i++)
+    free(c->files[i]);
+  free(c->files);
+  free(c->slots);
+  free((void *)c->counts);
+  *c = (Coverage){0};
+}
+
+// ----- slots -----
+
+typedef struct {
+  Coverage *c;
+  uint32_t file;
+  const char *source;
+  size_t len;
+} Walk;
+
+static int add_slot(Walk *w, AstNode *node, CovKind kind) {
+  const char *at = node->token.start;
+  if (w->source && (!at || at < w->source || at >= w->source + w->len))
+    return 1; // veio de #include: a linha não é deste arquivo
+  Coverage *c = w->c;
+  if (c->count >= UINT32_MAX ||
+      !grow((void **)&c->slots, &c->cap, c->count + 1, sizeof(CovSlot)))
+    return 0;
+  if (kind != COV_FAIL)
+    node->cov = (uint32_t)c->count;
+  c->slots[c->count++] = (CovSlot){w->file, (uint32_t)node->token.line, kind};
+  return 1;
+}
+
+// Só o que o executor percorre (scope.c, async_exec.c): bloco e statement
+static int visit(Walk *w, AstNode *stmt) {
+  if (!stmt)
+    return 1;
+  switch (stmt->kind) {
+  case AST_BLOCK:
+    if (!add_slot(w, stmt, COV_BLOCK))
+      return 0;
+    for (size_t i = 0; i < stmt->data.block_or_group.count; i++)
+      if (!visit(w, stmt->data.block_or_group.stmts[i]))
+        return 0;
+    return 1;
+  case AST_ASSERT_STMT:
+    // fail colado no stmt: o executor acha o ramo em cov + 1
+    if (!add_slot(w, stmt, COV_STMT))
+      return 0;
+    return !stmt->cov || add_slot(w, stmt, COV_FAIL);
+  case AST_VAR_DECL:
+  case AST_CALL:
+  case AST_AWAIT_STMT:
+    return add_slot(w, stmt, COV_STMT);
+  case AST_DEFER_STMT:
+  case AST_ASYNC_BLOCK:
+    return add_slot(w, stmt, COV_STMT) && visit(w, stmt->data.unary.expr);
+  default:
+    return 1; // expressão solta: o executor nem olha
+  }
+}
+
+static char *copy_str(const char *s) {
+  size_t n = strlen(s) + 1;
+  char *out = malloc(n);
+  if (out)
+    memcpy(out, s, n);
+  return out;
+}
+
+int coverage_add(Coverage *c, AstNode *root, const char *file,
+                 const char *source, size_t len) {
+  if (!c->slots || c->counts) // sem o ralo, ou já armado
+    return 0;
+  if (!root || root->kind != AST_BLOCK)
+    return 1;
+  if (!grow((void **)&c->files, &c->files_cap, c->nfiles + 1, sizeof(char *)))
+    return 0;
+  char *name = copy_str(file);
+  if (!name)
+    return 0;
+  c->files[c->nfiles] = name;
+  Walk w = {c, (uint32_t)c->nfiles++, source, len};
+  for (size_t i = 0; i < root->data.block_or_group.count; i++) {
+    AstNode *stmt = root->data.block_or_group.stmts[i];
+    if (stmt && stmt->kind == AST_TEST_STMT &&
+        !visit(&w, stmt->data.test.block))
+      return 0;
+  }
+  return 1;
+}
+
+int coverage_arm(Coverage *c) {
+  if (!c->slots)
+    return 0;
+  c->counts = calloc(c->count, sizeof(*c->counts));
+  return c->counts != NULL;
+}
+
+// ----- arquivo -----
+
+int coverage_save(const Coverage *c, const char *path) {
+  if (!c->counts)
+    return 0;
+  CovHeader h = {.nfiles = c->nfiles, .nslots = c->count};
+  memcpy(h.magic, COVERAGE_MAGIC, sizeof(h.magic));
+  for (size_t i = 0; i < c->nfiles; i++)
+    h.names_len += strlen(c->files[i]) + 1;
+  // Cópia simples dos contadores — por quê? _Atomic uint64_t não tem
+  // garantia de ter o layout de uint64_t
+  uint64_t *counts = malloc(c->count * sizeof(uint64_t));
+  if (!counts)
+    return 0;
+  for (size_t i = 0; i < c->count; i++)
+    counts[i] = atomic_load_explicit(&c->counts[i], memory_order_relaxed);
+
+  size_t len = strlen(path);
+  char *tmp = malloc(len + 5);
+  FILE *f = NULL;
+  if (tmp) {
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", 5);
+    f = fopen(tmp, "wb");
+  }
+  int ok = f && fwrite(&h, sizeof(h), 1, f) == 1;
+  for (size_t i = 0; ok && i < c->nfiles; i++)
+    ok = fwrite(c->files[i], 1, strlen(c->files[i]) + 1, f) ==
+         strlen(c->files[i]) + 1;
+  ok = ok && fwrite(c->slots, sizeof(CovSlot), c->count, f) == c->count &&
+       fwrite(counts, sizeof(uint64_t), c->count, f) == c->count;
+  if (f) {
+    ok = (fclose(f) == 0) && ok;
+    if (ok)
+      ok = rename(tmp, path) == 0;
+    else
+      remove(tmp);
+  }
+  free(tmp);
+  free(counts);
+  return ok;
+}
+
+typedef struct {
+  char *names;
+  const char **files;
+  CovSlot *slots;
+  uint64_t *counts;
+  size_t nfiles, nslots;
+} CovData;
+
+static void data_free(CovData *d) {
+  free(d->names);
+  free((void *)d->files);
+  free(d->slots);
+  free(d->counts);
+}
+
+// Não confia no disco: tamanhos contra o arquivo, nomes fechados, slots
+// apontando pra arquivo que existe
+static int data_read(CovData *d, const char *path) {
+  *d = (CovData){0};
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return 0;
+  CovHeader h = {0};
+  long size = -1;
+  if (fseek(f, 0, SEEK_END) == 0)
+    size = ftell(f);
+  int ok = size >= (long)sizeof(h) && fseek(f, 0, SEEK_SET) == 0 &&
+           fread(&h, sizeof(h), 1, f) == 1 &&
+           memcmp(h.magic, COVERAGE_MAGIC, sizeof(h.magic)) == 0;
+  uint64_t body = ok ? (uint64_t)size - sizeof(h) : 0;
+  uint64_t per_slot = sizeof(CovSlot) + sizeof(uint64_t);
+  ok = ok && h.names_len <= body && h.nfiles <= h.names_len &&
+       h.nslots == (body - h.names_len) / per_slot &&
+       (body - h.names_len) % per_slot == 0;
+  if (ok) {
+    d->nfiles = (size_t)h.nfiles;
+    d->nslots = (size_t)h.nslots;
+    d->names = malloc((size_t)h.names_len + 1);
+    d->files = malloc((d->nfiles + 1) * sizeof(char *));
+    d->slots = malloc((d->nslots + 1) * sizeof(CovSlot));
+    d->counts = malloc((d->nslots + 1) * sizeof(uint64_t));
+    ok = d->names && d->files && d->slots && d->counts &&
+         fread(d->names, 1, (size_t)h.names_len, f) == h.names_len &&
+         fread(d->slots, sizeof(CovSlot), d->nslots, f) == d->nslots &&
+         fread(d->counts, sizeof(uint64_t), d->nslots, f) == d->nslots;
+  }
+  fclose(f);
+
+  // Nomes: exatamente nfiles, cada um terminado em '\0'
+  size_t at = 0;
+  for (size_t i = 0; ok && i < d->nfiles; i++) {
+    const char *end = at < h.names_len
+                          ? memchr(d->names + at, '\0', (size_t)h.names_len - at)
+                          : NULL;
+    ok = end != NULL;
+    if (ok) {
+      d->files[i] = d->names + at;
+      at = (size_t)(end - d->names) + 1;
+    }
+  }
+  ok = ok && at == h.names_len;
+  for (size_t i = 0; ok && i < d->nslots; i++)
+    ok = (i == 0 || d->slots[i].file < d->nfiles) &&
+         d->slots[i].kind <= COV_FAIL &&
+         (d->slots[i].kind != COV_FAIL ||
+          (i > 1 && d->slots[i - 1].kind == COV_STMT));
+  if (!ok)
+    data_free(d);
+  return ok;
+}
+
+// ----- relatório -----
+
+typedef struct {
+  uint64_t hits;  // maior contagem dos blocos/statements da linha
+  uint64_t fails; // soma dos ramos de falha dos asserts da linha
+  int code;       // a linha tem slot
+} LineCov;
+
+typedef struct {
+  size_t lines, lines_hit;
+  size_t branches, branches_hit;
+} CovTotals;
+
+static char *read_source(const char *path, size_t *len) {
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return NULL;
+  char *text = NULL;
+  long size = -1;
+  if (fseek(f, 0, SEEK_END) == 0)
+    size = ftell(f);
+  if (size >= 0 && fseek(f, 0, SEEK_SET) == 0)
+    text = malloc((size_t)size + 1);
+  if (text && fread(text, 1, (size_t)size, f) != (size_t)size) {
+    free(text);
+    text = NULL;
+  }
+  fclose(f);
+  if (text) {
+    text[size] = '\0';
+    *len = (size_t)size;
+  }
+  return text;
+}
+
+// Contagem alinhada à direita; linha de código que nunca rodou sai
+// "#####", como no gcov — por quê? Salta aos olhos no meio dos números
+static void print_line(FILE *out, const LineCov *l, int line,
+                       const char *text, size_t len) {
+  if (!l || !l->code)
+    fprintf(out, "%9s | ", "");
+  else if (!l->hits)
+    fprintf(out, "%9s | ", "#####");
+  else
+    fprintf(out, "%9llu | ", (unsigned long long)l->hits);
+  fprintf(out, "%4d  ", line);
+  fwrite(text, 1, len, out);
+  if (l && l->fails)
+    fprintf(out, "   [falhou %llu]", (unsigned long long)l->fails);
+  fputc('\n', out);
+}
+
+static void report_file(FILE *out, const CovData *d, uint32_t file,
+                        CovTotals *all) {
+  int max_line = 0;
+  for (size_t i = 1; i < d->nslots; i++)
+    if (d->slots[i].file == file && (int)d->slots[i].line > max_line)
+      max_line = (int)d->slots[i].line;
+  LineCov *lines = calloc((size_t)max_line + 1, sizeof(LineCov));
+  if (!lines)
+    return;
+
+  CovTotals t = {0};
+  for (size_t i = 1; i < d->nslots; i++) {
+    const CovSlot *s = &d->slots[i];
+    if (s->file != file)
+      continue;
+    LineCov *l = &lines[s->line];
+    uint64_t n = d->counts[i];
+    if (s->kind == COV_FAIL) {
+      // Os dois ramos do assert: passou (rodou mais vezes do que falhou) e
+      // falhou
+      uint64_t runs = d->counts[i - 1];
+      t.branches += 2;
+      t.branches_hit += (runs > n) + (n > 0);
+      l->fails += n;
+      continue;
+    }
+    l->code = 1;
+    if (n > l->hits)
+      l->hits = n;
+  }
+  for (int i = 1; i <= max_line; i++)
+    if (lines[i].code) {
+      t.lines++;
+      t.lines_hit += lines[i].hits > 0;
+    }
+
+  fprintf(out, "── %s\n", d->files[file]);
+  size_t len = 0;
+  char *text = read_source(d->files[file], &len);
+  if (!text) {
+    fprintf(out, "  (fonte não abre; só os totais)\n");
+  } else {
+    const char *s = text, *end = text + len;
+    for (int line = 1; s < end; line++) {
+      const char *e = memchr(s, '\n', (size_t)(end - s));
+      if (!e)
+        e = end;
+      print_line(out, line <= max_line ? &lines[line] : NULL, line, s,
+                 (size_t)(e - s));
+      s = e + 1;
+    }
+    free(text);
+  }
+  fprintf(out, "  linhas: %zu de %zu, ramos de assert: %zu de %zu\n\n",
+          t.lines_hit, t.lines, t.branches_hit, t.branches);
+  all->lines += t.lines;
+  all->lines_hit += t.lines_hit;
+  all->branches += t.branches;
+  all->branches_hit += t.branches_hit;
+  free(lines);
+}
+
+static int percent(size_t hit, size_t total) {
+  return total ? (int)(hit * 100 / total) : 100;
+}
+
+int coverage_report(const char *path, FILE *out) {
+  CovData d;
+  if (!data_read(&d, path))
+    return 0;
+  CovTotals all = {0};
+  for (size_t i = 0; i < d.nfiles; i++)
+    report_file(out, &d, (uint32_t)i, &all);
+  fprintf(out, "Cobertura: linhas %zu/%zu (%d%%), ramos %zu/%zu (%d%%)\n",
+          all.lines_hit, all.lines, percent(all.lines_hit, all.lines),
+          all.branches_hit, all.branches,
+          percent(all.branches_hit, all.branches));
+  data_free(&d);
+  return 1;
+}
@@ -0,0 +1,67 @@
+// coverage.h — --coverage: um contador por bloco e por statement, num array
+// só, que o executor incrementa no lugar; gravado num binário pro relatório.
+// Custo com e sem: make bench-coverage (bench/coverage.sh)
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include "../../ast/ast.h"
+#include "scope.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define COVERAGE_DEFAULT_PATH ".modal-coverage"
+
+// O que o slot conta. COV_FAIL é o outro lado do assert — por quê slot
+// próprio? Passar e falhar são os dois ramos; o fail vem logo depois do
+// COV_STMT do mesmo assert
+typedef enum { COV_BLOCK, COV_STMT, COV_FAIL } CovKind;
+
+typedef struct {
+  uint32_t file; // índice em files
+  uint32_t line;
+  uint32_t kind; // CovKind
+} CovSlot;
+
+// slots[0] é o ralo: nó sem slot (cov 0) conta ali e o relatório ignora —
+// por quê? O executor incrementa sem testar se o nó foi instrumentado
+typedef struct {
+  char **files; // como nos diagnósticos (relativo ao cwd)
+  size_t nfiles, files_cap;
+  CovSlot *slots;
+  size_t count, cap;
+  _Atomic uint64_t *counts; // um por slot; coverage_arm aloca
+} Coverage;
+
+void coverage_init(Coverage *c);
+void coverage_free(Coverage *c);
+
+// Dá slot pros tests de root (blocos, statements, os dois ramos de cada
+// assert), com a linha do token. source[0, len) é o texto de file: token
+// fora dele veio de #include e fica sem slot; source NULL não confere.
+// 0 sem memória
+int coverage_add(Coverage *c, AstNode *root, const char *file,
+                 const char *source, size_t len);
+// Depois do último coverage_add: os contadores, zerados. 0 sem memória
+int coverage_arm(Coverage *c);
+
+// Binário: cabeçalho, nomes dos arquivos, slots e contagens (escreve num
+// .tmp e renomeia). 0 se não gravou
+int coverage_save(const Coverage *c, const char *path);
+// Lê path e imprime cada arquivo linha a linha com as contagens, e o total
+// de linhas e de ramos exercitados. 0 se o arquivo não lê
+int coverage_report(const char *path, FILE *out);
+
+// Conta uma passada pelo slot — por quê load+store relaxed e não fetch_add?
+// Sem lock nem barreira no caminho quente; tarefas async em threads
+// diferentes podem perder uma contagem, mas executou ou não continua exato.
+// Sem --coverage é um teste de ponteiro
+static inline void cov_hit(const TestEnv *env, uint32_t slot) {
+  if (env && env->cov)
+    atomic_store_explicit(
+        &env->cov[slot],
+        atomic_load_explicit(&env->cov[slot], memory_order_relaxed) + 1,
+        memory_order_relaxed);
+}
+
+#endif
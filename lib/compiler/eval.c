@@ -0,0 +1,705 @@
+#include "eval.h"
+#include "../../ast/intern.h"
+#include "pipeline.h"
+#include <string.h>
+
+static void set_scalar(Value *out, long long v) {
+  out->kind = VAL_INT;
+  out->scalar = v;
+}
+
+static void set_f64(Value *out, double v) {
+  out->kind = VAL_F64;
+  out->f64 = v;
+}
+
+static int token_op(const Token *tok, SimdOp *op) {
+  char c = *tok->start;
+  if (tok->len == 2) {
+    switch (c) {
+    case '=':
+      *op = SIMD_EQ;
+      return 1;
+    case '!':
+      *op = SIMD_NE;
+      return 1;
+    case '<':
+      *op = SIMD_LE;
+      return 1;
+    case '>':
+      *op = SIMD_GE;
+      return 1;
+    }
+    return 0;
+  }
+  switch (c) {
+  case '+':
+    *op = SIMD_ADD;
+    return 1;
+  case '-':
+    *op = SIMD_SUB;
+    return 1;
+  case '*':
+    *op = SIMD_MUL;
+    return 1;
+  case '/':
+    *op = SIMD_DIV;
+    return 1;
+  case '<':
+    *op = SIMD_LT;
+    return 1;
+  case '>':
+    *op = SIMD_GT;
+    return 1;
+  }
+  return 0;
+}
+
+// Comparação escalar dá 1/0 (como em C); só a vetorial dá máscara -1/0
+static int scalar_binop(SimdOp op, long long l, long long r, long long *out) {
+  unsigned long long ul = (unsigned long long)l, ur = (unsigned long long)r;
+  switch (op) {
+  case SIMD_ADD:
+    *out = (long long)(ul + ur);
+    return 1;
+  case SIMD_SUB:
+    *out = (long long)(ul - ur);
+    return 1;
+  case SIMD_MUL:
+    *out = (long long)(ul * ur);
+    return 1;
+  case SIMD_DIV:
+    if (r == 0)
+      return 0;
+    *out = r == -1 ? (long long)(0 - ul) : l / r;
+    return 1;
+  case SIMD_EQ:
+    *out = l == r;
+    return 1;
+  case SIMD_NE:
+    *out = l != r;
+    return 1;
+  case SIMD_LT:
+    *out = l < r;
+    return 1;
+  case SIMD_LE:
+    *out = l <= r;
+    return 1;
+  case SIMD_GT:
+    *out = l > r;
+    return 1;
+  case SIMD_GE:
+    *out = l >= r;
+    return 1;
+  case SIMD_AND:
+    *out = (long long)(ul & ur);
+    return 1;
+  }
+  return 0;
+}
+
+// Inteiro com f64 vira f64, como em C; comparação dá 1/0 inteiro
+static int float_binop(SimdOp op, double l, double r, Value *out) {
+  switch (op) {
+  case SIMD_ADD:
+    set_f64(out, l + r);
+    return 1;
+  case SIMD_SUB:
+    set_f64(out, l - r);
+    return 1;
+  case SIMD_MUL:
+    set_f64(out, l * r);
+    return 1;
+  case SIMD_DIV:
+    set_f64(out, l / r); // IEEE: 1.0 / 0 é inf, não erro
+    return 1;
+  case SIMD_EQ:
+    set_scalar(out, l == r);
+    return 1;
+  case SIMD_NE:
+    set_scalar(out, l != r);
+    return 1;
+  case SIMD_LT:
+    set_scalar(out, l < r);
+    return 1;
+  case SIMD_LE:
+    set_scalar(out, l <= r);
+    return 1;
+  case SIMD_GT:
+    set_scalar(out, l > r);
+    return 1;
+  case SIMD_GE:
+    set_scalar(out, l >= r);
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static double as_f64(const Value *v) {
+  return v->kind == VAL_F64 ? v->f64 : (double)v->scalar;
+}
+
+// Tipo que o ast_typecheck deu pra e; TYPE_NONE fora de test ou sem tabela
+static TypeId static_type(const Scope *env, const AstNode *e) {
+  return env && env->env && env->env->types ? env->env->types[e->ty]
+                                            : TYPE_NONE;
+}
+
+// Os dois lados i64 pelo checker: a conta vai direto em long long
+static int i64_operands(const Scope *env, const AstNode *e) {
+  return static_type(env, e->data.binop.left) == TYPE_I64 &&
+         static_type(env, e->data.binop.right) == TYPE_I64;
+}
+
+// Nó que também desce pelo caminho i64 (sem memo pra consultar)
+static int i64_node(const Scope *env, const AstNode *e) {
+  return e->kind == AST_BIN_OP && static_type(env, e) == TYPE_I64 &&
+         !(e->hc && ast_shared(e)->memo) && i64_operands(env, e);
+}
+
+// Cadeia à esquerda (`1 + 1 + ...`) desce em laço, SPINE_CHUNK nós por
+// vez; só o que passa disso vira recursão — por quê? Um nível de pilha por
+// termo estourava a pilha numa cadeia de 50k termos
+#define SPINE_CHUNK 64
+
+static int i64_binop(AstNode *expr, const Scope *env, long long *out) {
+  AstNode *spine[SPINE_CHUNK];
+  SimdOp ops[SPINE_CHUNK];
+  size_t n = 0;
+  do {
+    if (!token_op(&expr->token, &ops[n]))
+      return 0;
+    spine[n++] = expr;
+    expr = expr->data.binop.left;
+  } while (n < SPINE_CHUNK && i64_node(env, expr));
+
+  long long acc, r;
+  if (!eval_i64(expr, env, &acc))
+    return 0;
+  while (n--)
+    if (!eval_i64(spine[n]->data.binop.right, env, &r) ||
+        !scalar_binop(ops[n], acc, r, &acc))
+      return 0;
+  *out = acc;
+  return 1;
+}
+
+// Nó que o checker provou i64 não passa por Value: sem montar a união, sem
+// despachar no kind a cada nível. Ident ainda confere o binding — por quê?
+// Defer que roda depois de uma falha pode achar o x de fora, de outro tipo;
+// aí o test já falhou e o nó só falha junto. Nó com memo (--hash-cons) vai
+// pelo eval_expr, que é quem sabe usar o memo
+int eval_i64(AstNode *expr, const Scope *env, long long *out) {
+  if (expr && static_type(env, expr) == TYPE_I64 &&
+      !(expr->hc && ast_shared(expr)->memo)) {
+    switch (expr->kind) {
+    case AST_NUMBER_LIT:
+      if (expr->data.number.is_float)
+        break;
+      *out = expr->data.number.value;
+      return 1;
+    case AST_IDENT: {
+      const Binding *b =
+          scope_lookup(env, expr->data.ident.name, expr->data.ident.len);
+      if (!b || b->value.kind != VAL_INT)
+        return 0;
+      *out = b->value.scalar;
+      return 1;
+    }
+    case AST_UNARY_OP: {
+      long long v;
+      if (!eval_i64(expr->data.unary.expr, env, &v))
+        return 0;
+      *out = (long long)(0 - (unsigned long long)v);
+      return 1;
+    }
+    case AST_BIN_OP:
+      if (i64_operands(env, expr))
+        return i64_binop(expr, env, out);
+      break;
+    default:
+      break;
+    }
+  }
+  Value v;
+  if (!eval_expr(expr, env, &v) || v.kind != VAL_INT)
+    return 0;
+  *out = v.scalar;
+  return 1;
+}
+
+static int apply_binop(SimdOp op, Value *l, Value *r, Value *out) {
+  if (l->kind == VAL_RANGE || r->kind == VAL_RANGE)
+    return 0; // range só vale como fonte de pipeline
+  if (l->kind == VAL_INT && r->kind == VAL_INT) {
+    long long v;
+    if (!scalar_binop(op, l->scalar, r->scalar, &v))
+      return 0;
+    set_scalar(out, v);
+    return 1;
+  }
+  if (l->kind != VAL_VEC && r->kind != VAL_VEC)
+    return float_binop(op, as_f64(l), as_f64(r), out);
+  if (l->kind == VAL_F64 || r->kind == VAL_F64)
+    return 0; // vetores são só de inteiros
+
+  // Escalar com vetor: replica o escalar em todas as lanes
+  if (l->kind == VAL_INT)
+    simd_splat(&l->vec, r->vec.type, l->scalar);
+  if (r->kind == VAL_INT)
+    simd_splat(&r->vec, l->vec.type, r->scalar);
+  if (l->vec.type != r->vec.type)
+    return 0;
+  out->kind = VAL_VEC;
+  return simd_binop(op, &l->vec, &r->vec, &out->vec);
+}
+
+// Mesma descida em laço do i64_binop; nó com memo para a descida e vai
+// pelo eval_expr
+static int eval_binop(AstNode *expr, const Scope *env, Value *out) {
+  AstNode *spine[SPINE_CHUNK];
+  SimdOp ops[SPINE_CHUNK];
+  size_t n = 0;
+  do {
+    if (!token_op(&expr->token, &ops[n]))
+      return 0;
+    spine[n++] = expr;
+    expr = expr->data.binop.left;
+  } while (n < SPINE_CHUNK && expr && expr->kind == AST_BIN_OP &&
+           !(expr->hc && ast_shared(expr)->memo));
+
+  Value acc, r;
+  if (!eval_expr(expr, env, &acc))
+    return 0;
+  while (n--) {
+    if (!eval_expr(spine[n]->data.binop.right, env, &r) ||
+        !apply_binop(ops[n], &acc, &r, out))
+      return 0;
+    acc = *out;
+  }
+  return 1;
+}
+
+static int name_is(const AstNode *call, const char *name) {
+  size_t len = strlen(name);
+  return call->data.call.len == len &&
+         memcmp(call->data.call.name, name, len) == 0;
+}
+
+static int eval_scalar_arg(AstNode *arg, const Scope *env, long long *out) {
+  return eval_i64(arg, env, out);
+}
+
+// i32x4(a, b, c, d) ou i32x4(x) pra replicar
+static int eval_vec_ctor(AstNode *call, SimdType type, const Scope *env,
+                         Value *out) {
+  size_t lanes = (size_t)simd_lane_count(type);
+  size_t count = call->data.call.count;
+  if (count != 1 && count != lanes)
+    return 0;
+
+  out->kind = VAL_VEC;
+  simd_splat(&out->vec, type, 0);
+  for (size_t i = 0; i < count; i++) {
+    long long x;
+    if (!eval_scalar_arg(call->data.call.args[i], env, &x))
+      return 0;
+    if (count == 1)
+      simd_splat(&out->vec, type, x);
+    else
+      simd_set(&out->vec, (int)i, x);
+  }
+  return 1;
+}
+
+// Função C: argumentos vão direto como int64, sem Value no meio
+static int eval_native(AstNode *call, const Scope *env, Value *out) {
+  const AstNode *fn = call->data.call.native;
+  int64_t args[FFI_MAX_ARGS];
+  for (size_t i = 0; i < call->data.call.count; i++) {
+    long long x;
+    if (!eval_scalar_arg(call->data.call.args[i], env, &x))
+      return 0;
+    args[i] = x;
+  }
+  set_scalar(out, ffi_call(fn->data.native.addr, fn->data.native.ret,
+                           fn->data.native.params, fn->data.native.count,
+                           args));
+  return 1;
+}
+
+static int eval_call(AstNode *call, const Scope *env, Value *out) {
+  if (call->data.call.native)
+    return eval_native(call, env, out);
+
+  size_t count = call->data.call.count;
+  AstNode **args = call->data.call.args;
+
+  SimdType type;
+  if (simd_type_from_name(call->data.call.name, (int)call->data.call.len,
+                          &type))
+    return eval_vec_ctor(call, type, env, out);
+
+  if (count == 0)
+    return 0;
+  Value v;
+  if (!eval_expr(args[0], env, &v) || v.kind == VAL_RANGE)
+    return 0; // range reduz com pipeline: 0..n | sum
+
+  static const struct {
+    const char *name;
+    SimdReduce op;
+  } reductions[] = {{"sum", SIMD_SUM},
+                    {"min", SIMD_MIN},
+                    {"max", SIMD_MAX},
+                    {"all", SIMD_ALL},
+                    {"any", SIMD_ANY}};
+  for (size_t i = 0; i < sizeof(reductions) / sizeof(reductions[0]); i++) {
+    if (!name_is(call, reductions[i].name))
+      continue;
+    if (count != 1)
+      return 0;
+    if (v.kind == VAL_INT) { // escalar é vetor de uma lane
+      int boolean = reductions[i].op == SIMD_ALL || reductions[i].op == SIMD_ANY;
+      set_scalar(out, boolean ? v.scalar != 0 : v.scalar);
+      return 1;
+    }
+    set_scalar(out, simd_reduce(reductions[i].op, &v.vec));
+    return 1;
+  }
+
+  if (v.kind != VAL_VEC)
+    return 0;
+  int lanes = simd_lane_count(v.vec.type);
+
+  if (name_is(call, "lane")) { // lane(v, i)
+    long long i;
+    if (count != 2 || !eval_scalar_arg(args[1], env, &i) || i < 0 ||
+        i >= lanes)
+      return 0;
+    set_scalar(out, simd_get(&v.vec, (int)i));
+    return 1;
+  }
+
+  if (name_is(call, "shuffle")) { // shuffle(v, i0, i1, ...) — uma por lane
+    if (count != (size_t)lanes + 1)
+      return 0;
+    int idx[8];
+    for (int i = 0; i < lanes; i++) {
+      long long x;
+      if (!eval_scalar_arg(args[i + 1], env, &x) || x < 0 || x >= lanes)
+        return 0;
+      idx[i] = (int)x;
+    }
+    out->kind = VAL_VEC;
+    simd_shuffle(&v.vec, idx, &out->vec);
+    return 1;
+  }
+  return 0;
+}
+
+static int eval_node(AstNode *expr, const Scope *env, Value *out) {
+  switch (expr->kind) {
+  case AST_NUMBER_LIT:
+    if (expr->data.number.is_float)
+      set_f64(out, expr->data.number.f64);
+    else
+      set_scalar(out, expr->data.number.value);
+    return 1;
+  case AST_VEC_LIT:
+    out->kind = VAL_VEC;
+    simd_splat(&out->vec, (SimdType)expr->data.vec.type, 0);
+    for (int i = 0; i < expr->data.vec.lanes; i++)
+      simd_set(&out->vec, i, expr->data.vec.values[i]);
+    return 1;
+  case AST_IDENT: {
+    const Binding *b =
+        scope_lookup(env, expr->data.ident.name, expr->data.ident.len);
+    if (!b)
+      return 0;
+    *out = b->value;
+    return 1;
+  }
+  case AST_UNARY_OP: { // só '-' por enquanto: 0 - x, vale pra vetor também
+    Value v;
+    if (!eval_expr(expr->data.unary.expr, env, &v))
+      return 0;
+    if (v.kind == VAL_RANGE)
+      return 0;
+    if (v.kind == VAL_INT) {
+      set_scalar(out, (long long)(0 - (unsigned long long)v.scalar));
+      return 1;
+    }
+    if (v.kind == VAL_F64) {
+      set_f64(out, -v.f64);
+      return 1;
+    }
+    SimdVec zero;
+    simd_splat(&zero, v.vec.type, 0);
+    out->kind = VAL_VEC;
+    return simd_binop(SIMD_SUB, &zero, &v.vec, &out->vec);
+  }
+  case AST_BIN_OP:
+    if (static_type(env, expr) == TYPE_I64 && i64_operands(env, expr)) {
+      long long v;
+      if (!i64_binop(expr, env, &v))
+        return 0;
+      set_scalar(out, v);
+      return 1;
+    }
+    return eval_binop(expr, env, out);
+  case AST_RANGE: {
+    long long lo, hi;
+    if (!eval_i64(expr->data.binop.left, env, &lo) ||
+        !eval_i64(expr->data.binop.right, env, &hi))
+      return 0;
+    out->kind = VAL_RANGE;
+    out->lo = lo;
+    out->hi = hi;
+    return 1;
+  }
+  case AST_PIPELINE:
+    return eval_pipeline(expr, env, out);
+  case AST_CALL:
+    return eval_call(expr, env, out);
+  default:
+    return 0;
+  }
+}
+
+static int same_value(const Value *a, const Value *b) {
+  if (a->kind != b->kind)
+    return 0;
+  switch (a->kind) {
+  case VAL_INT:
+    return a->scalar == b->scalar;
+  case VAL_F64: // bits: -0.0 e NaN não confundem
+    return memcmp(&a->f64, &b->f64, sizeof(double)) == 0;
+  case VAL_RANGE:
+    return a->lo == b->lo && a->hi == b->hi;
+  case VAL_VEC:
+    if (a->vec.type != b->vec.type)
+      return 0;
+    for (int i = 0; i < simd_lane_count(a->vec.type); i++)
+      if (simd_get(&a->vec, i) != simd_get(&b->vec, i))
+        return 0;
+    return 1;
+  }
+  return 0;
+}
+
+// Nó compartilhado (ast/intern.c): expressão pura, então o valor só
+// depende dos livres — mesmos valores da última vez, mesmo resultado
+// (falha inclusive). Memo ocupado por outra thread: avalia direto
+static int eval_memo(AstNode *expr, const AstShared *sh, const Scope *env,
+                     Value *out) {
+  AstMemo *m = sh->memo;
+  Value args[AST_SHARED_MAX_FREE];
+  for (int i = 0; i < sh->nfree; i++) {
+    const AstNode *id = sh->free[i];
+    const Binding *b = scope_lookup(env, id->data.ident.name, id->data.ident.len);
+    if (!b)
+      return eval_node(expr, env, out);
+    args[i] = b->value;
+  }
+
+  if (atomic_exchange_explicit(&m->busy, 1, memory_order_acquire))
+    return eval_node(expr, env, out);
+  int hit = m->filled;
+  for (int i = 0; hit && i < sh->nfree; i++)
+    hit = same_value(&m->args[i], &args[i]);
+  if (hit) {
+    int ok = m->ok;
+    if (ok)
+      *out = m->result;
+    m->hits++;
+    atomic_store_explicit(&m->busy, 0, memory_order_release);
+    return ok;
+  }
+  // Solta durante a avaliação — por quê? Pipeline longo seguraria as outras
+  // threads, que avaliam sem memo em vez de esperar
+  atomic_store_explicit(&m->busy, 0, memory_order_release);
+
+  int ok = eval_node(expr, env, out);
+  if (!atomic_exchange_explicit(&m->busy, 1, memory_order_acquire)) {
+    for (int i = 0; i < sh->nfree; i++)
+      m->args[i] = args[i];
+    m->ok = ok;
+    if (ok)
+      m->result = *out;
+    m->filled = 1;
+    atomic_store_explicit(&m->busy, 0, memory_order_release);
+  }
+  return ok;
+}
+
+int eval_expr(AstNode *expr, const Scope *env, Value *out) {
+  if (!expr)
+    return 0;
+  if (expr->hc && ast_shared(expr)->memo)
+    return eval_memo(expr, ast_shared(expr), env, out);
+  return eval_node(expr, env, out);
+}
+
+int value_truthy(const Value *v) {
+  if (v->kind == VAL_INT)
+    return v->scalar != 0;
+  if (v->kind == VAL_RANGE)
+    return v->lo < v->hi; // range vazio é falso
+  if (v->kind == VAL_F64)
+    return v->f64 != 0.0;
+  return (int)simd_reduce(SIMD_ALL, &v->vec);
+}
+
+int eval_assert(AstNode *expr, const Scope *env) {
+  Value value;
+  if (!eval_expr(expr, env, &value))
+    return 0;
+  return value_truthy(&value);
+}
+
+#define FOLD_MAX_RANGE (1u << 16)
+
+static int is_literal(const AstNode *node) {
+  return node &&
+         (node->kind == AST_NUMBER_LIT || node->kind == AST_VEC_LIT);
+}
+
+// Nó vira literal no lugar — por quê no lugar? Quem aponta pra ele (pai,
+// array do bloco) não precisa saber
+static void replace_with(const ModalAllocator *a, AstNode *node,
+                         const Value *v) {
+  if (node->kind == AST_BIN_OP) {
+    ast_free(a, node->data.binop.left);
+    ast_free(a, node->data.binop.right);
+  } else if (node->kind == AST_UNARY_OP) {
+    ast_free(a, node->data.unary.expr);
+  } else if (node->kind == AST_PIPELINE) {
+    ast_free(a, node->data.pipeline.source);
+    for (size_t i = 0; i < node->data.pipeline.count; i++)
+      ast_free(a, node->data.pipeline.stages[i].expr);
+    modal_free(a, node->data.pipeline.stages,
+               node->data.pipeline.count * sizeof(PipeStage));
+  } else {
+    for (size_t i = 0; i < node->data.call.count; i++)
+      ast_free(a, node->data.call.args[i]);
+    modal_free(a, node->data.call.args,
+               node->data.call.count * sizeof(AstNode *));
+  }
+
+  if (v->kind == VAL_INT || v->kind == VAL_F64) {
+    node->kind = AST_NUMBER_LIT;
+    node->data.number.is_float = v->kind == VAL_F64;
+    node->data.number.value = v->kind == VAL_INT ? v->scalar : 0;
+    node->data.number.f64 = v->kind == VAL_F64 ? v->f64 : 0.0;
+    return;
+  }
+  node->kind = AST_VEC_LIT;
+  node->data.vec.type = (int)v->vec.type;
+  node->data.vec.lanes = simd_lane_count(v->vec.type);
+  for (int i = 0; i < node->data.vec.lanes; i++)
+    node->data.vec.values[i] = simd_get(&v->vec, i);
+}
+
+static void fold_expr(const ModalAllocator *a, AstNode *node);
+
+// Cadeia à esquerda dobra de baixo pra cima em laço, como no eval_binop
+static void fold_spine(const ModalAllocator *a, AstNode *node) {
+  AstNode *spine[SPINE_CHUNK];
+  size_t n = 0;
+  do {
+    spine[n++] = node;
+    node = node->data.binop.left;
+  } while (n < SPINE_CHUNK && node && node->kind == AST_BIN_OP);
+
+  fold_expr(a, node);
+  while (n--) {
+    AstNode *e = spine[n];
+    Value v;
+    fold_expr(a, e->data.binop.right);
+    if (is_literal(e->data.binop.left) && is_literal(e->data.binop.right) &&
+        eval_expr(e, NULL, &v))
+      replace_with(a, e, &v);
+  }
+}
+
+static void fold_expr(const ModalAllocator *a, AstNode *node) {
+  if (!node)
+    return;
+  int constant = 1;
+  if (node->kind == AST_BIN_OP) {
+    fold_spine(a, node);
+    return;
+  } else if (node->kind == AST_UNARY_OP) {
+    fold_expr(a, node->data.unary.expr);
+    constant = is_literal(node->data.unary.expr);
+  } else if (node->kind == AST_CALL) {
+    for (size_t i = 0; i < node->data.call.count; i++) {
+      fold_expr(a, node->data.call.args[i]);
+      constant &= is_literal(node->data.call.args[i]);
+    }
+    constant &= !node->data.call.native; // C pode ter efeito: roda no test
+  } else if (node->kind == AST_RANGE) {
+    fold_expr(a, node->data.binop.left);
+    fold_expr(a, node->data.binop.right);
+    return; // range não tem literal; quem dobra é o pipeline em volta
+  } else if (node->kind == AST_PIPELINE) {
+    AstNode *src = node->data.pipeline.source;
+    fold_expr(a, src);
+    for (size_t i = 0; i < node->data.pipeline.count; i++)
+      fold_expr(a, node->data.pipeline.stages[i].expr);
+    // Estágio com variável de fora não avalia sem env e fica pro runtime;
+    // range enorme também — por quê? Compilar não pode levar minutos
+    if (src && src->kind == AST_RANGE) {
+      AstNode *lo = src->data.binop.left, *hi = src->data.binop.right;
+      constant = lo && hi && lo->kind == AST_NUMBER_LIT &&
+                 hi->kind == AST_NUMBER_LIT && !lo->data.number.is_float &&
+                 !hi->data.number.is_float &&
+                 hi->data.number.value >= lo->data.number.value &&
+                 (unsigned long long)hi->data.number.value -
+                         (unsigned long long)lo->data.number.value <=
+                     FOLD_MAX_RANGE;
+    } else
+      constant = is_literal(src);
+  } else {
+    return;
+  }
+
+  // Falha (ex: divisão por zero) fica pro runtime, que reprova o assert
+  Value v;
+  if (constant && eval_expr(node, NULL, &v))
+    replace_with(a, node, &v);
+}
+
+void eval_fold_constants(const ModalAllocator *a, AstNode *node) {
+  if (!node)
+    return;
+  switch (node->kind) {
+  case AST_BLOCK:
+    for (size_t i = 0; i < node->data.block_or_group.count; i++)
+      eval_fold_constants(a, node->data.block_or_group.stmts[i]);
+    return;
+  case AST_TEST_STMT:
+    eval_fold_constants(a, node->data.test.block);
+    return;
+  case AST_ASYNC_BLOCK:
+  case AST_DEFER_STMT:
+    eval_fold_constants(a, node->data.unary.expr);
+    return;
+  case AST_ASSERT_STMT:
+    fold_expr(a, node->data.unary.expr);
+    eval_fold_constants(a, node->data.unary.message);
+    return;
+  case AST_FORMAT:
+    for (size_t i = 0; i < node->data.format.count; i++)
+      fold_expr(a, node->data.format.parts[i].expr);
+    return;
+  case AST_VAR_DECL:
+    fold_expr(a, node->data.var.init);
+    return;
+  default:
+    fold_expr(a, node); // expressão solta
+    return;
+  }
+}
@@ -0,0 +1,30 @@
+// eval.h
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "../../ast/ast.h"
+#include "scope.h"
+#include "value.h"
+
+// Avalia expressão (inteiro, f64 ou vetor); retorna 0 se não dá pra avaliar
+// (ident desconhecido, divisão por zero, tipos de vetor diferentes...) —
+// por quê? Assert falha em vez de crashar.
+// Só lê env: pode rodar em várias threads ao mesmo tempo (async), cada
+// tarefa com seus escopos
+int eval_expr(AstNode *expr, const Scope *env, Value *out);
+
+// eval_expr que só aceita inteiro. Nó que o ast_typecheck anotou como i64
+// roda sem Value no meio (env->env->types)
+int eval_i64(AstNode *expr, const Scope *env, long long *out);
+
+// Inteiro/f64: diferente de zero, como em C. Vetor: todas as lanes
+int value_truthy(const Value *v);
+
+// 1 se a expressão do assert é verdadeira
+int eval_assert(AstNode *expr, const Scope *env);
+
+// Troca toda subexpressão sem identificador pelo valor (AST_NUMBER_LIT ou
+// AST_VEC_LIT), liberando os filhos com a. Roda uma vez depois do parse
+void eval_fold_constants(const ModalAllocator *a, AstNode *node);
+
+#endif
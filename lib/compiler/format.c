@@ -0,0 +1,232 @@
+#include "format.h"
+#include "eval.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FMT_INLINE_HOLES 8 // mais buracos que isso: valores na região
+
+// %.17g ocupa no máximo isso: sinal, 17 dígitos, ponto, e-308
+#define F64_SHORT_MAX 24
+
+typedef struct {
+  Value value;
+  int ok;
+} Hole;
+
+static size_t int_len(long long v) {
+  unsigned long long u = v < 0 ? 0ull - (unsigned long long)v
+                               : (unsigned long long)v;
+  size_t n = v < 0;
+  do {
+    n++;
+    u /= 10;
+  } while (u);
+  return n;
+}
+
+static size_t hex_len(long long v) {
+  unsigned long long u = v < 0 ? 0ull - (unsigned long long)v
+                               : (unsigned long long)v;
+  size_t n = v < 0;
+  do {
+    n++;
+    u >>= 4;
+  } while (u);
+  return n;
+}
+
+// Dígitos de trás pra frente no lugar certo — por quê medir antes? Sem
+// buffer temporário nem inversão
+static size_t write_int(char *out, long long v) {
+  size_t n = int_len(v);
+  unsigned long long u = v < 0 ? 0ull - (unsigned long long)v
+                               : (unsigned long long)v;
+  char *p = out + n;
+  do {
+    *--p = (char)('0' + u % 10);
+    u /= 10;
+  } while (u);
+  if (v < 0)
+    *--p = '-';
+  return n;
+}
+
+static size_t write_hex(char *out, long long v) {
+  static const char digits[] = "0123456789abcdef";
+  size_t n = hex_len(v);
+  unsigned long long u = v < 0 ? 0ull - (unsigned long long)v
+                               : (unsigned long long)v;
+  char *p = out + n;
+  do {
+    *--p = digits[u & 15];
+    u >>= 4;
+  } while (u);
+  if (v < 0)
+    *--p = '-';
+  return n;
+}
+
+// Teto do f64 com prec casas fixas: parte inteira de até 309 dígitos só
+// quando o número é enorme
+static size_t f64_bound(const FmtPart *part, double x) {
+  if (part->kind != FMT_F64)
+    return F64_SHORT_MAX;
+  size_t whole = x < 1e15 && x > -1e15 ? 16 : 310; // NaN: o teto grande
+  return 1 + whole + 1 + (size_t)part->prec;
+}
+
+// f64 sem formato: o menor entre %.15g e %.17g que volta pro mesmo double —
+// 0.1 sai "0.1", não "0.10000000000000001"
+static size_t write_f64(char *out, size_t room, const FmtPart *part,
+                        double x) {
+  int n;
+  if (part->kind == FMT_F64) {
+    n = snprintf(out, room, "%.*f", part->prec, x);
+  } else {
+    n = snprintf(out, room, "%.15g", x);
+    if (n > 0 && (size_t)n < room && strtod(out, NULL) != x)
+      n = snprintf(out, room, "%.17g", x);
+  }
+  return n > 0 ? (size_t)n : 0;
+}
+
+static int wants_f64(const FmtPart *part, ValueKind kind) {
+  return part->kind == FMT_F64 ||
+         (part->kind == FMT_AUTO && kind == VAL_F64);
+}
+
+static long long lane(const SimdVec *v, int i) {
+  return v->type == SIMD_I32X4 || v->type == SIMD_I32X8 ? v->lanes.i32[i]
+                                                        : v->lanes.i64[i];
+}
+
+// f64 num buraco d/x: trunca, saturando — (long long) de NaN ou de 1e300 é UB
+static long long f64_to_int(double f) {
+  if (f != f)
+    return 0;
+  if (f >= 9.2e18)
+    return LLONG_MAX;
+  if (f <= -9.2e18)
+    return LLONG_MIN;
+  return (long long)f;
+}
+
+// Um escalar já convertido pro jeito do buraco: d/x truncam f64, .N
+// promove inteiro
+static size_t scalar_bound(const FmtPart *part, long long i, double f,
+                           int is_f64) {
+  if (wants_f64(part, is_f64 ? VAL_F64 : VAL_INT))
+    return f64_bound(part, is_f64 ? f : (double)i);
+  long long v = is_f64 ? f64_to_int(f) : i;
+  return part->kind == FMT_HEX ? hex_len(v) : int_len(v);
+}
+
+static size_t write_scalar(char *out, size_t room, const FmtPart *part,
+                           long long i, double f, int is_f64) {
+  if (wants_f64(part, is_f64 ? VAL_F64 : VAL_INT))
+    return write_f64(out, room, part, is_f64 ? f : (double)i);
+  long long v = is_f64 ? f64_to_int(f) : i;
+  return part->kind == FMT_HEX ? write_hex(out, v) : write_int(out, v);
+}
+
+static size_t hole_bound(const FmtPart *part, const Hole *h) {
+  const Value *v = &h->value;
+  if (!h->ok)
+    return 1;
+  switch (v->kind) {
+  case VAL_INT:
+    return scalar_bound(part, v->scalar, 0, 0);
+  case VAL_F64:
+    return scalar_bound(part, 0, v->f64, 1);
+  case VAL_RANGE:
+    return scalar_bound(part, v->lo, 0, 0) + 2 +
+           scalar_bound(part, v->hi, 0, 0);
+  case VAL_VEC: {
+    size_t n = 2; // [ ]
+    int lanes = simd_lane_count(v->vec.type);
+    for (int i = 0; i < lanes; i++)
+      n += scalar_bound(part, lane(&v->vec, i), 0, 0) + 2;
+    return n;
+  }
+  }
+  return 1;
+}
+
+// room é o que sobra do buffer, que já foi medido com folga
+static size_t write_hole(char *out, size_t room, const FmtPart *part,
+                         const Hole *h) {
+  const Value *v = &h->value;
+  if (!h->ok) {
+    *out = '?';
+    return 1;
+  }
+  size_t n = 0;
+  switch (v->kind) {
+  case VAL_INT:
+    return write_scalar(out, room, part, v->scalar, 0, 0);
+  case VAL_F64:
+    return write_scalar(out, room, part, 0, v->f64, 1);
+  case VAL_RANGE:
+    n = write_scalar(out, room, part, v->lo, 0, 0);
+    memcpy(out + n, "..", 2);
+    n += 2;
+    return n + write_scalar(out + n, room - n, part, v->hi, 0, 0);
+  case VAL_VEC: {
+    out[n++] = '[';
+    int lanes = simd_lane_count(v->vec.type);
+    for (int i = 0; i < lanes; i++) {
+      if (i) {
+        memcpy(out + n, ", ", 2);
+        n += 2;
+      }
+      n += write_scalar(out + n, room - n, part, lane(&v->vec, i), 0, 0);
+    }
+    out[n++] = ']';
+    return n;
+  }
+  }
+  return n;
+}
+
+size_t format_render(const AstNode *fmt, Scope *env, char *buf, size_t cap) {
+  const FmtPart *parts = fmt->data.format.parts;
+  size_t count = fmt->data.format.count;
+
+  Hole inline_holes[FMT_INLINE_HOLES];
+  Hole *holes = count <= FMT_INLINE_HOLES
+                    ? inline_holes
+                    : region_alloc(&env->region, count * sizeof(Hole));
+  if (!holes)
+    return 0;
+
+  // 1) valores e tamanho: exato pra inteiro, teto pra f64
+  size_t bound = fmt->data.format.fixed_len;
+  for (size_t i = 0; i < count; i++) {
+    if (!parts[i].expr)
+      continue;
+    holes[i].ok = eval_expr(parts[i].expr, env, &holes[i].value);
+    bound += hole_bound(&parts[i], &holes[i]);
+  }
+
+  // 2) um buffer só: o de quem chamou, ou a região se não couber
+  char *out = bound < cap ? buf : region_alloc(&env->region, bound + 1);
+  if (!out)
+    return 0;
+  size_t n = 0;
+  for (size_t i = 0; i < count; i++) {
+    memcpy(out + n, parts[i].text, parts[i].len);
+    n += parts[i].len;
+    if (parts[i].expr)
+      n += write_hole(out + n, bound + 1 - n, &parts[i], &holes[i]);
+  }
+  out[n] = '\0';
+
+  if (out != buf && cap) {
+    size_t keep = n < cap ? n : cap - 1;
+    memcpy(buf, out, keep);
+    buf[keep] = '\0';
+  }
+  return n;
+}
@@ -0,0 +1,14 @@
+// format.h — f-string montada na hora: mede tudo, escreve uma vez só
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include "../../ast/ast.h"
+#include "scope.h"
+
+// Texto de fmt (AST_FORMAT) com os buracos avaliados em env. Se o tamanho
+// medido cabe em buf[0, cap), escreve direto ali; senão monta na região do
+// escopo e copia o que couber. Retorna o tamanho do texto inteiro (maior que
+// cap - 1: truncou). Buraco que não avalia vira "?"
+size_t format_render(const AstNode *fmt, Scope *env, char *buf, size_t cap);
+
+#endif
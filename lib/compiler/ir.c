@@ -0,0 +1,532 @@
+#include "ir.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Cresce *items em dobro até caber need (malloc direto: a IR não pertence
+// à AST)
+static int grow(void **items, uint32_t *cap, uint64_t need, size_t size) {
+  if (need <= *cap)
+    return 1;
+  if (need >= IR_NONE)
+    return 0; // ids são uint32 e IR_NONE é reservado
+  uint64_t n = *cap ? *cap : 16;
+  while (n < need)
+    n *= 2;
+  if (n >= IR_NONE)
+    n = IR_NONE - 1;
+  void *p = realloc(*items, (size_t)n * size);
+  if (!p)
+    return 0;
+  *items = p;
+  *cap = (uint32_t)n;
+  return 1;
+}
+
+void ir_init(IrFunc *f, const AstNode *test) {
+  *f = (IrFunc){0};
+  f->test = test;
+}
+
+void ir_free(IrFunc *f) {
+  for (uint32_t b = 0; b < f->nblocks; b++) {
+    free(f->blocks[b].code);
+    free(f->blocks[b].preds);
+  }
+  free(f->blocks);
+  free(f->insts);
+  free(f->args);
+  free(f->names);
+  *f = (IrFunc){0};
+}
+
+uint32_t ir_block(IrFunc *f) {
+  if (!grow((void **)&f->blocks, &f->blocks_cap, (uint64_t)f->nblocks + 1,
+            sizeof(IrBlock)))
+    return IR_NONE;
+  f->blocks[f->nblocks] = (IrBlock){0};
+  return f->nblocks++;
+}
+
+uint32_t ir_emit(IrFunc *f, uint32_t block, IrOp op, IrType type, uint32_t a,
+                 uint32_t b, const AstNode *node) {
+  IrBlock *bb = &f->blocks[block];
+  if (!grow((void **)&f->insts, &f->insts_cap, (uint64_t)f->ninsts + 1,
+            sizeof(IrInst)) ||
+      !grow((void **)&bb->code, &bb->cap, (uint64_t)bb->count + 1,
+            sizeof(uint32_t)))
+    return IR_NONE;
+  uint32_t id = f->ninsts++;
+  f->insts[id] = (IrInst){.op = (uint8_t)op,
+                          .type = (uint8_t)type,
+                          .block = block,
+                          .a = a,
+                          .b = b,
+                          .node = node};
+  f->insts[id].imm.br.then = f->insts[id].imm.br.other = IR_NONE;
+  bb->code[bb->count++] = id;
+  return id;
+}
+
+int ir_reserve_args(IrFunc *f, uint32_t inst, uint32_t n) {
+  uint64_t need = (uint64_t)f->nargs + n;
+  uint32_t cap = f->args_cap; // names cresce junto, com o mesmo cap
+  if (!grow((void **)&f->names, &cap, need, sizeof(IrName)))
+    return 0;
+  if (!grow((void **)&f->args, &f->args_cap, need, sizeof(uint32_t)))
+    return 0; // names maior que args só sobra espaço
+  if (cap != f->args_cap)
+    return 0; // não acontece: os dois dobram a partir do mesmo cap
+  for (uint32_t i = 0; i < n; i++) {
+    f->args[f->nargs + i] = IR_NONE;
+    f->names[f->nargs + i] = (IrName){0};
+  }
+  f->insts[inst].first = f->nargs;
+  f->insts[inst].count = n;
+  f->nargs += n;
+  return 1;
+}
+
+int ir_add_pred(IrFunc *f, uint32_t to, uint32_t from) {
+  IrBlock *bb = &f->blocks[to];
+  if (!grow((void **)&bb->preds, &bb->preds_cap, (uint64_t)bb->npreds + 1,
+            sizeof(uint32_t)))
+    return 0;
+  bb->preds[bb->npreds++] = from;
+  return 1;
+}
+
+int ir_is_terminator(IrOp op) {
+  return op == IR_BR || op == IR_CBR || op == IR_PASS || op == IR_FAIL;
+}
+
+int ir_succs(const IrFunc *f, uint32_t b, uint32_t out[2]) {
+  const IrBlock *bb = &f->blocks[b];
+  if (!bb->count)
+    return 0;
+  const IrInst *t = &f->insts[bb->code[bb->count - 1]];
+  if (t->op == IR_BR) {
+    out[0] = t->imm.br.then;
+    return 1;
+  }
+  if (t->op == IR_CBR) {
+    out[0] = t->imm.br.then;
+    out[1] = t->imm.br.other;
+    return 2;
+  }
+  return 0;
+}
+
+uint32_t ir_live_count(const IrFunc *f) {
+  uint32_t n = 0;
+  for (uint32_t b = 0; b < f->nblocks; b++)
+    if (!f->blocks[b].dead)
+      n += f->blocks[b].count;
+  return n;
+}
+
+static const char *const op_names[IR_OP_COUNT] = {
+    [IR_CONST] = "const", [IR_PHI] = "phi",       [IR_ADD] = "add",
+    [IR_SUB] = "sub",     [IR_MUL] = "mul",       [IR_DIV] = "div",
+    [IR_NEG] = "neg",     [IR_EQ] = "eq",         [IR_NE] = "ne",
+    [IR_LT] = "lt",       [IR_LE] = "le",         [IR_GT] = "gt",
+    [IR_GE] = "ge",       [IR_AND] = "and",       [IR_OR] = "or",
+    [IR_MIN] = "min",     [IR_MAX] = "max",       [IR_ITOF] = "itof",
+    [IR_TRUTHY] = "truthy", [IR_EXPR] = "expr",   [IR_CALL] = "call",
+    [IR_BR] = "br",       [IR_CBR] = "cbr",       [IR_PASS] = "pass",
+    [IR_FAIL] = "fail"};
+
+const char *ir_op_name(IrOp op) {
+  return op < IR_OP_COUNT ? op_names[op] : "?";
+}
+
+int ir_may_trap(const IrFunc *f, const IrInst *in) {
+  if (in->op == IR_EXPR)
+    return !in->node || in->node->kind != AST_VEC_LIT; // literal não falha
+  if (in->op != IR_DIV || in->type != IR_I64)
+    return 0;
+  const IrInst *d = &f->insts[in->b];
+  return d->op != IR_CONST || d->imm.i == 0;
+}
+
+// ----- dump -----
+
+static const char *type_name(IrType t) {
+  static const char *const names[] = {"void", "i64", "f64", "val"};
+  return t <= IR_VAL ? names[t] : "?";
+}
+
+static void dump_inst(const IrFunc *f, uint32_t id, FILE *out) {
+  const IrInst *in = &f->insts[id];
+  int n = 2;
+  fputs("  ", out);
+  if (in->type != IR_VOID)
+    n += fprintf(out, "v%u = %s ", id, type_name(in->type));
+  n += fprintf(out, "%s", ir_op_name(in->op));
+  switch (in->op) {
+  case IR_CONST:
+    n += in->type == IR_F64 ? fprintf(out, " %.17g", in->imm.f)
+                            : fprintf(out, " %lld", in->imm.i);
+    break;
+  case IR_PHI: {
+    const IrBlock *bb = &f->blocks[in->block];
+    for (uint32_t i = 0; i < in->count; i++)
+      n += fprintf(out, "%s[v%u, bb%u]", i ? ", " : " ", f->args[in->first + i],
+                   i < bb->npreds ? bb->preds[i] : IR_NONE);
+    break;
+  }
+  case IR_EXPR:
+  case IR_CALL:
+    if (in->op == IR_CALL)
+      n += fprintf(out, " %.*s", (int)in->node->data.call.len,
+                   in->node->data.call.name);
+    n += fprintf(out, "(");
+    for (uint32_t i = 0; i < in->count; i++) {
+      const IrName *nm = &f->names[in->first + i];
+      n += fprintf(out, "%s", i ? ", " : "");
+      if (nm->name)
+        n += fprintf(out, "%.*s=", (int)nm->len, nm->name);
+      n += fprintf(out, "v%u", f->args[in->first + i]);
+    }
+    n += fprintf(out, ")");
+    break;
+  case IR_BR:
+    n += fprintf(out, " bb%u", in->imm.br.then);
+    break;
+  case IR_CBR:
+    n += fprintf(out, " v%u, bb%u, bb%u", in->a, in->imm.br.then,
+                 in->imm.br.other);
+    break;
+  default:
+    if (in->a != IR_NONE)
+      n += fprintf(out, " v%u", in->a);
+    if (in->b != IR_NONE)
+      n += fprintf(out, ", v%u", in->b);
+    break;
+  }
+  if (in->node)
+    fprintf(out, "%*s; %d:%d", n < 40 ? 40 - n : 1, "", in->node->token.line,
+            in->node->token.col);
+  fputc('\n', out);
+}
+
+void ir_dump(const IrFunc *f, FILE *out) {
+  for (uint32_t b = 0; b < f->nblocks; b++) {
+    const IrBlock *bb = &f->blocks[b];
+    if (bb->dead)
+      continue;
+    fprintf(out, "bb%u:", b);
+    for (uint32_t i = 0; i < bb->npreds; i++)
+      fprintf(out, "%s bb%u", i ? "," : "  ; preds", bb->preds[i]);
+    fputc('\n', out);
+    for (uint32_t i = 0; i < bb->count; i++)
+      dump_inst(f, bb->code[i], out);
+  }
+}
+
+// ----- dominadores -----
+
+uint32_t ir_dominators(const IrFunc *f, uint32_t *idom, uint32_t *rpo) {
+  uint32_t n = f->nblocks;
+  uint32_t *order = malloc((size_t)n * sizeof(uint32_t)); // pós-ordem
+  uint32_t *stack = malloc((size_t)n * sizeof(uint32_t));
+  uint8_t *state = calloc(n, 1); // 0 novo, 1 na pilha, 2 pronto
+  uint32_t *pos = malloc((size_t)n * sizeof(uint32_t)); // índice em rpo
+  uint32_t count = 0;
+  for (uint32_t b = 0; b < n; b++)
+    idom[b] = IR_NONE;
+  if (!order || !stack || !state || !pos || !n || f->blocks[0].dead)
+    goto out;
+
+  // DFS iterativa: o bloco sai da pilha quando os sucessores já saíram
+  uint32_t top = 0;
+  stack[top++] = 0;
+  state[0] = 1;
+  while (top) {
+    uint32_t b = stack[top - 1], s[2];
+    int ns = ir_succs(f, b, s), pushed = 0;
+    for (int i = 0; i < ns && !pushed; i++)
+      if (s[i] < n && !state[s[i]]) {
+        state[s[i]] = 1;
+        stack[top++] = s[i];
+        pushed = 1;
+      }
+    if (!pushed) {
+      state[b] = 2;
+      order[count++] = b;
+      top--;
+    }
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    rpo[i] = order[count - 1 - i];
+    pos[rpo[i]] = i;
+  }
+
+  idom[0] = 0;
+  for (int changed = 1; changed;) {
+    changed = 0;
+    for (uint32_t i = 1; i < count; i++) {
+      uint32_t b = rpo[i], best = IR_NONE;
+      const IrBlock *bb = &f->blocks[b];
+      for (uint32_t p = 0; p < bb->npreds; p++) {
+        uint32_t q = bb->preds[p];
+        if (idom[q] == IR_NONE)
+          continue;
+        if (best == IR_NONE) {
+          best = q;
+          continue;
+        }
+        uint32_t x = q, y = best; // sobe até o ancestral comum
+        while (x != y) {
+          while (pos[x] > pos[y])
+            x = idom[x];
+          while (pos[y] > pos[x])
+            y = idom[y];
+        }
+        best = x;
+      }
+      if (best != IR_NONE && idom[b] != best) {
+        idom[b] = best;
+        changed = 1;
+      }
+    }
+  }
+out:
+  free(order);
+  free(stack);
+  free(state);
+  free(pos);
+  return count;
+}
+
+int ir_dominates(const uint32_t *idom, uint32_t a, uint32_t b) {
+  if (idom[b] == IR_NONE)
+    return 0;
+  for (;;) {
+    if (a == b)
+      return 1;
+    if (b == 0)
+      return 0;
+    b = idom[b];
+  }
+}
+
+// ----- verificador -----
+
+typedef struct {
+  const IrFunc *f;
+  uint32_t *idom;
+  uint32_t *index; // posição de cada inst no bloco
+  char *why;
+  size_t cap;
+} Verify;
+
+static int bad(Verify *v, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  if (v->cap)
+    vsnprintf(v->why, v->cap, fmt, ap);
+  va_end(ap);
+  return 0;
+}
+
+// Operando existe, está vivo e a definição domina o uso (no fim de at_block
+// pra arg de phi, antes de at senão)
+static int check_use(Verify *v, uint32_t id, uint32_t use, uint32_t at_block,
+                     int phi) {
+  const IrFunc *f = v->f;
+  if (id >= f->ninsts || f->insts[id].dead)
+    return bad(v, "v%u usa v%u, que não existe", use, id);
+  const IrInst *def = &f->insts[id];
+  if (def->type == IR_VOID)
+    return bad(v, "v%u usa v%u, que não tem valor", use, id);
+  if (!ir_dominates(v->idom, def->block, at_block))
+    return bad(v, "v%u usa v%u, que não domina o uso", use, id);
+  if (!phi && def->block == at_block && v->index[id] >= v->index[use])
+    return bad(v, "v%u usa v%u antes da definição", use, id);
+  return 1;
+}
+
+static IrType type_of(const IrFunc *f, uint32_t id) {
+  return id < f->ninsts ? (IrType)f->insts[id].type : IR_VOID;
+}
+
+static int check_types(Verify *v, uint32_t id) {
+  const IrFunc *f = v->f;
+  const IrInst *in = &f->insts[id];
+  IrType t = in->type, a = type_of(f, in->a), b = type_of(f, in->b);
+  switch (in->op) {
+  case IR_CONST:
+    return t == IR_I64 || t == IR_F64 || bad(v, "v%u: const sem tipo", id);
+  case IR_ADD:
+  case IR_SUB:
+  case IR_MUL:
+  case IR_DIV:
+    return ((t == IR_I64 || t == IR_F64) && a == t && b == t) ||
+           bad(v, "v%u: %s com tipos trocados", id, ir_op_name(in->op));
+  case IR_NEG:
+    return ((t == IR_I64 || t == IR_F64) && a == t) ||
+           bad(v, "v%u: neg com tipo trocado", id);
+  case IR_EQ:
+  case IR_NE:
+  case IR_LT:
+  case IR_LE:
+  case IR_GT:
+  case IR_GE:
+    return (t == IR_I64 && a == b && (a == IR_I64 || a == IR_F64)) ||
+           bad(v, "v%u: comparação com tipos trocados", id);
+  case IR_AND:
+  case IR_OR:
+  case IR_MIN:
+  case IR_MAX:
+    return (t == IR_I64 && a == IR_I64 && b == IR_I64) ||
+           bad(v, "v%u: %s só de i64", id, ir_op_name(in->op));
+  case IR_ITOF:
+    return (t == IR_F64 && a == IR_I64) || bad(v, "v%u: itof de i64", id);
+  case IR_TRUTHY:
+    return (t == IR_I64 && a == IR_VAL) || bad(v, "v%u: truthy de val", id);
+  case IR_CBR:
+    return a == IR_I64 || bad(v, "v%u: cbr precisa de i64", id);
+  case IR_PHI:
+    for (uint32_t i = 0; i < in->count; i++)
+      if (type_of(f, f->args[in->first + i]) != t)
+        return bad(v, "v%u: phi com tipos diferentes", id);
+    return t != IR_VOID || bad(v, "v%u: phi sem tipo", id);
+  case IR_CALL:
+    for (uint32_t i = 0; i < in->count; i++)
+      if (type_of(f, f->args[in->first + i]) != IR_I64)
+        return bad(v, "v%u: call só com i64", id);
+    return t == IR_I64 || bad(v, "v%u: call dá i64", id);
+  case IR_EXPR:
+    return t == IR_VAL || bad(v, "v%u: expr dá val", id);
+  default:
+    return t == IR_VOID || bad(v, "v%u: terminador com valor", id);
+  }
+}
+
+static int count_of(const uint32_t *items, uint32_t n, uint32_t x) {
+  int c = 0;
+  for (uint32_t i = 0; i < n; i++)
+    c += items[i] == x;
+  return c;
+}
+
+// Forma do bloco e das arestas, antes de precisar de dominador
+static int check_block(Verify *v, uint32_t b) {
+  const IrFunc *f = v->f;
+  const IrBlock *bb = &f->blocks[b];
+  if (!bb->count)
+    return bad(v, "bb%u vazio", b);
+  int phis = 1;
+  for (uint32_t i = 0; i < bb->count; i++) {
+    uint32_t id = bb->code[i];
+    if (id >= f->ninsts || f->insts[id].dead || f->insts[id].block != b)
+      return bad(v, "bb%u lista v%u, que não é dele", b, id);
+    const IrInst *in = &f->insts[id];
+    v->index[id] = i;
+    if (in->op == IR_PHI) {
+      if (!phis)
+        return bad(v, "v%u: phi depois de instrução comum", id);
+      if (in->count != bb->npreds)
+        return bad(v, "v%u: phi com %u args e %u preds", id, in->count,
+                   bb->npreds);
+    } else {
+      phis = 0;
+    }
+    if (ir_is_terminator((IrOp)in->op) != (i + 1 == bb->count))
+      return bad(v, "bb%u: terminador fora do fim", b);
+  }
+  uint32_t s[2];
+  int ns = ir_succs(f, b, s);
+  for (int i = 0; i < ns; i++) {
+    if (s[i] >= f->nblocks || f->blocks[s[i]].dead || s[i] == 0)
+      return bad(v, "bb%u salta pra bloco inválido", b);
+    const IrBlock *to = &f->blocks[s[i]];
+    if (count_of(to->preds, to->npreds, b) != count_of(s, (uint32_t)ns, s[i]))
+      return bad(v, "bb%u -> bb%u sem pred que case", b, s[i]);
+  }
+  for (uint32_t p = 0; p < bb->npreds; p++) {
+    uint32_t q = bb->preds[p], qs[2];
+    if (q >= f->nblocks || f->blocks[q].dead)
+      return bad(v, "bb%u tem pred morto bb%u", b, q);
+    int nq = ir_succs(f, q, qs);
+    if (!count_of(qs, (uint32_t)nq, b))
+      return bad(v, "bb%u tem pred bb%u que não salta pra ele", b, q);
+  }
+  return 1;
+}
+
+int ir_verify(const IrFunc *f, char *why, size_t cap) {
+  uint32_t n = f->nblocks;
+  Verify v = {f, malloc((size_t)n * sizeof(uint32_t)),
+              malloc((size_t)f->ninsts * sizeof(uint32_t) + 1), why, cap};
+  uint32_t *rpo = malloc((size_t)n * sizeof(uint32_t) + 1);
+  int ok = v.idom && v.index && rpo;
+  if (!ok)
+    bad(&v, "sem memória");
+  if (ok && (!n || f->blocks[0].dead || f->blocks[0].npreds))
+    ok = bad(&v, "bb0 tem que existir e não ter preds");
+  for (uint32_t b = 0; ok && b < n; b++)
+    if (!f->blocks[b].dead)
+      ok = check_block(&v, b);
+  if (ok) {
+    ir_dominators(f, v.idom, rpo);
+    for (uint32_t b = 0; ok && b < n; b++)
+      if (!f->blocks[b].dead && v.idom[b] == IR_NONE)
+        ok = bad(&v, "bb%u vivo mas inalcançável", b);
+  }
+  for (uint32_t b = 0; ok && b < n; b++) {
+    const IrBlock *bb = &f->blocks[b];
+    for (uint32_t i = 0; ok && !bb->dead && i < bb->count; i++) {
+      uint32_t id = bb->code[i];
+      const IrInst *in = &f->insts[id];
+      ok = check_types(&v, id);
+      if (in->op == IR_PHI) {
+        for (uint32_t k = 0; ok && k < in->count; k++)
+          ok = check_use(&v, f->args[in->first + k], id, bb->preds[k], 1);
+        continue;
+      }
+      if (ok && in->a != IR_NONE)
+        ok = check_use(&v, in->a, id, b, 0);
+      if (ok && in->b != IR_NONE)
+        ok = check_use(&v, in->b, id, b, 0);
+      for (uint32_t k = 0; ok && (in->op == IR_EXPR || in->op == IR_CALL) &&
+                           k < in->count;
+           k++)
+        ok = check_use(&v, f->args[in->first + k], id, b, 0);
+    }
+  }
+  free(v.idom);
+  free(v.index);
+  free(rpo);
+  return ok;
+}
+
+// ----- --dump-ir -----
+
+void ir_report(const AstNode *program, FILE *out) {
+  if (!program || program->kind != AST_BLOCK)
+    return;
+  for (size_t i = 0; i < program->data.block_or_group.count; i++) {
+    const AstNode *test = program->data.block_or_group.stmts[i];
+    if (!test || test->kind != AST_TEST_STMT)
+      continue;
+    fprintf(out, "test \"%.*s\"", (int)test->data.test.len,
+            test->data.test.name);
+    IrFunc f;
+    const char *why;
+    if (!ir_lower_test(&f, test, &why)) {
+      fprintf(out, ": sem IR (%s)\n\n", why);
+      continue;
+    }
+    uint32_t before = ir_live_count(&f);
+    char msg[200];
+    if (!ir_optimize(&f, 1, msg, sizeof(msg)))
+      fprintf(out, ": IR inválida em %s\n", msg);
+    else
+      fprintf(out, ": %u -> %u instruções\n", before, ir_live_count(&f));
+    ir_dump(&f, out);
+    fputc('\n', out);
+    ir_free(&f);
+  }
+}
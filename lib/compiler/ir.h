@@ -0,0 +1,142 @@
+// ir.h — IR em SSA de um test: blocos básicos, phi e valores em arrays
+// planos. ir_lower.c sai da AST, ir_opt.c otimiza, aqui dump e verificador
+#ifndef IR_H
+#define IR_H
+
+#include "../../ast/ast.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#define IR_NONE UINT32_MAX // operando/alvo ausente
+
+// Tipo do valor. IR_VAL é o Value dinâmico do eval (vetor, range, ou
+// escalar que só se sabe rodando): as ops dele são opacas
+typedef enum { IR_VOID, IR_I64, IR_F64, IR_VAL } IrType;
+
+typedef enum {
+  IR_CONST, // imm.i ou imm.f
+  IR_PHI,   // args: um por predecessor, na ordem de preds
+  IR_ADD,
+  IR_SUB,
+  IR_MUL,
+  IR_DIV, // i64: divisor 0 falha o test (como no eval); f64 segue IEEE
+  IR_NEG,
+  IR_EQ, // comparações dão i64 0/1, de i64 ou de f64
+  IR_NE,
+  IR_LT,
+  IR_LE,
+  IR_GT,
+  IR_GE,
+  IR_AND, // i64 bit a bit; pros any/all de pipeline
+  IR_OR,
+  IR_MIN,
+  IR_MAX,
+  IR_ITOF,   // i64 -> f64
+  IR_TRUTHY, // IR_VAL -> i64, como value_truthy
+  IR_EXPR,   // node avaliado pelo eval com os args ligados a names; pode falhar
+  IR_CALL,   // função C de node (AST_CALL), args i64; tem efeito
+  // terminadores: sempre o último do bloco, e só eles
+  IR_BR,   // imm.br.then
+  IR_CBR,  // a != 0 ? then : other; node é o assert, se veio de um
+  IR_PASS, // fim do test: passou
+  IR_FAIL, // fim do test: falhou
+  IR_OP_COUNT
+} IrOp;
+
+typedef struct {
+  const char *name;
+  size_t len;
+} IrName;
+
+typedef struct {
+  uint8_t op;   // IrOp
+  uint8_t type; // IrType do resultado
+  uint8_t dead; // removida por uma passada; id não é reusado
+  uint8_t impure; // IR_EXPR com chamada C dentro
+  uint32_t block;
+  uint32_t a, b;         // operandos (IR_NONE se não tem)
+  uint32_t first, count; // PHI/EXPR/CALL: fatia de args (e names)
+  union {
+    long long i;
+    double f;
+    struct {
+      uint32_t then, other;
+    } br;
+  } imm;
+  const AstNode *node; // de onde veio: linha no dump; EXPR/CALL usam
+} IrInst;
+
+typedef struct {
+  uint32_t *code; // ids em ordem, phis primeiro, terminador no fim
+  uint32_t count, cap;
+  uint32_t *preds; // ordem casa com os args dos phis
+  uint32_t npreds, preds_cap;
+  int dead;
+} IrBlock;
+
+// Um test inteiro. Tudo malloc, não pertence à AST — mas node aponta pra
+// ela: a AST vive mais que a função
+typedef struct {
+  const AstNode *test;
+  IrInst *insts;
+  uint32_t ninsts, insts_cap;
+  IrBlock *blocks; // blocks[0]: entrada
+  uint32_t nblocks, blocks_cap;
+  uint32_t *args;
+  IrName *names; // paralelo a args; só EXPR usa
+  uint32_t nargs, args_cap;
+} IrFunc;
+
+void ir_init(IrFunc *f, const AstNode *test);
+void ir_free(IrFunc *f);
+
+// Construção: bloco novo vazio e instrução no fim de block. IR_NONE sem
+// memória
+uint32_t ir_block(IrFunc *f);
+uint32_t ir_emit(IrFunc *f, uint32_t block, IrOp op, IrType type, uint32_t a,
+                 uint32_t b, const AstNode *node);
+// Fatia nova de n args (e names zerados) pra inst; 0 sem memória
+int ir_reserve_args(IrFunc *f, uint32_t inst, uint32_t n);
+// Liga from -> to em preds de to (terminador de from já escrito)
+int ir_add_pred(IrFunc *f, uint32_t to, uint32_t from);
+
+// Alvos do terminador de b; retorna quantos (0, 1 ou 2)
+int ir_succs(const IrFunc *f, uint32_t b, uint32_t out[2]);
+// Instruções vivas
+uint32_t ir_live_count(const IrFunc *f);
+
+// Nome da op pro dump ("add", "cbr"...)
+const char *ir_op_name(IrOp op);
+int ir_is_terminator(IrOp op);
+// 1 se a op pode falhar o test (divisão inteira, EXPR)
+int ir_may_trap(const IrFunc *f, const IrInst *in);
+
+// Texto legível: blocos com preds, uma instrução por linha com a linha:col
+// do fonte
+void ir_dump(const IrFunc *f, FILE *out);
+
+// Checa as invariantes: terminador único no fim, phis no começo com um arg
+// por pred, preds batendo com os terminadores, tipos das ops, e todo uso
+// dominado pela definição. 1 se ok; senão a primeira falha em why (buf)
+int ir_verify(const IrFunc *f, char *why, size_t cap);
+
+// Dominadores (Cooper-Harvey-Kennedy); idom[entrada] = entrada, bloco
+// inalcançável fica com IR_NONE. rpo recebe a ordem reversa pós-ordem,
+// retorna quantos blocos alcançáveis. Os dois com nblocks posições
+uint32_t ir_dominators(const IrFunc *f, uint32_t *idom, uint32_t *rpo);
+int ir_dominates(const uint32_t *idom, uint32_t a, uint32_t b);
+
+// AST -> IR (ir_lower.c). 0 se o test usa o que a IR ainda não tem (defer,
+// async, await); why diz o quê
+int ir_lower_test(IrFunc *f, const AstNode *test, const char **why);
+
+// Passadas em sequência até não mudar nada (ir_opt.c): propagação de
+// constante, junção de blocos, CSE, LICM e DCE. verify roda ir_verify
+// depois de cada uma;
+// 0 se alguma deixou a IR inválida (why diz qual e por quê)
+int ir_optimize(IrFunc *f, int verify, char *why, size_t cap);
+
+// --dump-ir: cada test de program baixado, otimizado, verificado e impresso
+void ir_report(const AstNode *program, FILE *out);
+
+#endif
@@ -0,0 +1,663 @@
+// ir_lower.c — AST de um test -> IrFunc. Variável é só um nome pro último
+// valor SSA: o fonte não tem if nem laço, então phi só aparece nos laços
+// de pipeline de range, que viram blocos de verdade
+#include "ir.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  const char *name;
+  size_t len;
+  uint32_t id; // IR_NONE na inferência (`it` de estágio ainda sem valor)
+  IrType type;
+} Var;
+
+typedef struct {
+  IrFunc *f;
+  uint32_t cur;  // bloco onde a próxima instrução entra
+  uint32_t fail; // bloco do IR_FAIL, criado no primeiro uso
+  Var *vars;     // pilha: escopo aberto é só a altura guardada
+  size_t nvars, cap;
+  Var *free_vars; // idents de um EXPR, sem repetir
+  size_t nfree, free_cap;
+  int oom;
+} Lower;
+
+static Var *find_var(Lower *L, const char *name, size_t len) {
+  for (size_t i = L->nvars; i-- > 0;)
+    if (L->vars[i].len == len && memcmp(L->vars[i].name, name, len) == 0)
+      return &L->vars[i];
+  return NULL;
+}
+
+static int push_var(Lower *L, const char *name, size_t len, uint32_t id,
+                    IrType type) {
+  if (L->nvars == L->cap) {
+    size_t cap = L->cap ? L->cap * 2 : 16;
+    Var *p = realloc(L->vars, cap * sizeof(Var));
+    if (!p) {
+      L->oom = 1;
+      return 0;
+    }
+    L->vars = p;
+    L->cap = cap;
+  }
+  L->vars[L->nvars++] = (Var){name, len, id, type};
+  return 1;
+}
+
+// ----- emissão -----
+
+static uint32_t emit(Lower *L, IrOp op, IrType type, uint32_t a, uint32_t b,
+                     const AstNode *node) {
+  if (L->oom)
+    return IR_NONE;
+  uint32_t id = ir_emit(L->f, L->cur, op, type, a, b, node);
+  if (id == IR_NONE)
+    L->oom = 1;
+  return id;
+}
+
+static uint32_t new_block(Lower *L) {
+  uint32_t b = L->oom ? IR_NONE : ir_block(L->f);
+  if (b == IR_NONE)
+    L->oom = 1;
+  return b;
+}
+
+static uint32_t const_i(Lower *L, long long v, const AstNode *node) {
+  uint32_t id = emit(L, IR_CONST, IR_I64, IR_NONE, IR_NONE, node);
+  if (id != IR_NONE)
+    L->f->insts[id].imm.i = v;
+  return id;
+}
+
+static uint32_t const_f(Lower *L, double v, const AstNode *node) {
+  uint32_t id = emit(L, IR_CONST, IR_F64, IR_NONE, IR_NONE, node);
+  if (id != IR_NONE)
+    L->f->insts[id].imm.f = v;
+  return id;
+}
+
+static void branch(Lower *L, uint32_t to) {
+  uint32_t id = emit(L, IR_BR, IR_VOID, IR_NONE, IR_NONE, NULL);
+  if (id == IR_NONE)
+    return;
+  L->f->insts[id].imm.br.then = to;
+  if (!ir_add_pred(L->f, to, L->cur))
+    L->oom = 1;
+}
+
+static void cbranch(Lower *L, uint32_t cond, uint32_t then, uint32_t other,
+                    const AstNode *node) {
+  uint32_t id = emit(L, IR_CBR, IR_VOID, cond, IR_NONE, node);
+  if (id == IR_NONE)
+    return;
+  L->f->insts[id].imm.br.then = then;
+  L->f->insts[id].imm.br.other = other;
+  if (!ir_add_pred(L->f, then, L->cur) || !ir_add_pred(L->f, other, L->cur))
+    L->oom = 1;
+}
+
+static uint32_t fail_block(Lower *L) {
+  if (L->fail != IR_NONE)
+    return L->fail;
+  uint32_t b = new_block(L), cur = L->cur;
+  if (b == IR_NONE)
+    return IR_NONE;
+  L->cur = b;
+  emit(L, IR_FAIL, IR_VOID, IR_NONE, IR_NONE, NULL);
+  L->cur = cur;
+  return L->fail = b;
+}
+
+// ----- tipos -----
+
+static int bin_op(const Token *tok, IrOp *op) {
+  char c = *tok->start;
+  if (tok->len == 2) { // como token_op do eval: só olha o primeiro
+    switch (c) {
+    case '=':
+      *op = IR_EQ;
+      return 1;
+    case '!':
+      *op = IR_NE;
+      return 1;
+    case '<':
+      *op = IR_LE;
+      return 1;
+    case '>':
+      *op = IR_GE;
+      return 1;
+    }
+    return 0;
+  }
+  switch (c) {
+  case '+':
+    *op = IR_ADD;
+    return 1;
+  case '-':
+    *op = IR_SUB;
+    return 1;
+  case '*':
+    *op = IR_MUL;
+    return 1;
+  case '/':
+    *op = IR_DIV;
+    return 1;
+  case '<':
+    *op = IR_LT;
+    return 1;
+  case '>':
+    *op = IR_GT;
+    return 1;
+  }
+  return 0;
+}
+
+static int is_compare(IrOp op) { return op >= IR_EQ && op <= IR_GE; }
+
+static IrType infer(Lower *L, const AstNode *e);
+
+// Range com limites i64 e estágios i64 sobre `it` i64: vira laço. O resto
+// (vetor, estágio com f64 ou Value) fica pro eval num EXPR
+static int loopable(Lower *L, const AstNode *pipe) {
+  const AstNode *src = pipe->data.pipeline.source;
+  if (!src || src->kind != AST_RANGE ||
+      infer(L, src->data.binop.left) != IR_I64 ||
+      infer(L, src->data.binop.right) != IR_I64)
+    return 0;
+  size_t mark = L->nvars;
+  if (!push_var(L, "it", 2, IR_NONE, IR_I64))
+    return 0;
+  int ok = 1;
+  for (size_t i = 0; ok && i < pipe->data.pipeline.count; i++)
+    ok = infer(L, pipe->data.pipeline.stages[i].expr) == IR_I64;
+  L->nvars = mark;
+  return ok;
+}
+
+// Tipo do valor de e, sem emitir nada. IR_VOID: o eval falha com certeza
+// (nome que não existe, op desconhecida, f64 onde só vale inteiro)
+static IrType infer(Lower *L, const AstNode *e) {
+  if (!e)
+    return IR_VOID;
+  switch (e->kind) {
+  case AST_NUMBER_LIT:
+    return e->data.number.is_float ? IR_F64 : IR_I64;
+  case AST_VEC_LIT:
+    return IR_VAL;
+  case AST_IDENT: {
+    const Var *v = find_var(L, e->data.ident.name, e->data.ident.len);
+    return v ? v->type : IR_VOID;
+  }
+  case AST_UNARY_OP:
+    return infer(L, e->data.unary.expr);
+  case AST_BIN_OP: {
+    IrOp op;
+    IrType l = infer(L, e->data.binop.left);
+    IrType r = l == IR_VOID ? IR_VOID : infer(L, e->data.binop.right);
+    if (!bin_op(&e->token, &op) || r == IR_VOID)
+      return IR_VOID;
+    if (l == IR_VAL || r == IR_VAL)
+      return IR_VAL;
+    return l == IR_I64 && r == IR_I64 ? IR_I64
+           : is_compare(op)           ? IR_I64
+                                      : IR_F64;
+  }
+  case AST_RANGE: {
+    IrType lo = infer(L, e->data.binop.left);
+    IrType hi = lo == IR_VOID ? IR_VOID : infer(L, e->data.binop.right);
+    if (lo == IR_F64 || hi == IR_F64 || hi == IR_VOID)
+      return IR_VOID;
+    return IR_VAL;
+  }
+  case AST_CALL: {
+    int val = 0;
+    for (size_t i = 0; i < e->data.call.count; i++) {
+      IrType t = infer(L, e->data.call.args[i]);
+      if (t == IR_VOID || (t == IR_F64 && e->data.call.native))
+        return IR_VOID;
+      val |= t == IR_VAL;
+    }
+    return e->data.call.native && !val ? IR_I64 : IR_VAL;
+  }
+  case AST_PIPELINE:
+    if (loopable(L, e))
+      return IR_I64;
+    return infer(L, e->data.pipeline.source) == IR_VOID ? IR_VOID : IR_VAL;
+  default:
+    return IR_VOID;
+  }
+}
+
+// ----- expressões -----
+
+static int has_native(const AstNode *e) {
+  if (!e)
+    return 0;
+  switch (e->kind) {
+  case AST_UNARY_OP:
+    return has_native(e->data.unary.expr);
+  case AST_BIN_OP:
+  case AST_RANGE:
+    return has_native(e->data.binop.left) || has_native(e->data.binop.right);
+  case AST_CALL:
+    if (e->data.call.native)
+      return 1;
+    for (size_t i = 0; i < e->data.call.count; i++)
+      if (has_native(e->data.call.args[i]))
+        return 1;
+    return 0;
+  case AST_PIPELINE:
+    if (has_native(e->data.pipeline.source))
+      return 1;
+    for (size_t i = 0; i < e->data.pipeline.count; i++)
+      if (has_native(e->data.pipeline.stages[i].expr))
+        return 1;
+    return 0;
+  default:
+    return 0;
+  }
+}
+
+// Junta em free_vars os nomes que e lê e que existem aqui; nome que não
+// existe (o `it` do próprio pipeline, ou um erro) o eval resolve sozinho
+static void collect(Lower *L, const AstNode *e) {
+  if (!e || L->oom)
+    return;
+  switch (e->kind) {
+  case AST_IDENT: {
+    const Var *v = find_var(L, e->data.ident.name, e->data.ident.len);
+    if (!v)
+      return;
+    for (size_t i = 0; i < L->nfree; i++)
+      if (L->free_vars[i].len == v->len &&
+          memcmp(L->free_vars[i].name, v->name, v->len) == 0)
+        return;
+    if (L->nfree == L->free_cap) {
+      size_t cap = L->free_cap ? L->free_cap * 2 : 8;
+      Var *p = realloc(L->free_vars, cap * sizeof(Var));
+      if (!p) {
+        L->oom = 1;
+        return;
+      }
+      L->free_vars = p;
+      L->free_cap = cap;
+    }
+    L->free_vars[L->nfree++] = *v;
+    return;
+  }
+  case AST_UNARY_OP:
+    collect(L, e->data.unary.expr);
+    return;
+  case AST_BIN_OP:
+  case AST_RANGE:
+    collect(L, e->data.binop.left);
+    collect(L, e->data.binop.right);
+    return;
+  case AST_CALL:
+    for (size_t i = 0; i < e->data.call.count; i++)
+      collect(L, e->data.call.args[i]);
+    return;
+  case AST_PIPELINE:
+    collect(L, e->data.pipeline.source);
+    for (size_t i = 0; i < e->data.pipeline.count; i++)
+      collect(L, e->data.pipeline.stages[i].expr);
+    return;
+  default:
+    return;
+  }
+}
+
+// e inteiro pro eval, com os nomes que ele lê como args
+static uint32_t emit_expr(Lower *L, const AstNode *e) {
+  L->nfree = 0;
+  collect(L, e);
+  uint32_t id = emit(L, IR_EXPR, IR_VAL, IR_NONE, IR_NONE, e);
+  if (id == IR_NONE)
+    return IR_NONE;
+  if (!ir_reserve_args(L->f, id, (uint32_t)L->nfree)) {
+    L->oom = 1;
+    return IR_NONE;
+  }
+  IrFunc *f = L->f;
+  f->insts[id].impure = (uint8_t)has_native(e);
+  for (size_t i = 0; i < L->nfree; i++) {
+    f->args[f->insts[id].first + i] = L->free_vars[i].id;
+    f->names[f->insts[id].first + i] =
+        (IrName){L->free_vars[i].name, L->free_vars[i].len};
+  }
+  return id;
+}
+
+static IrType type_of(Lower *L, uint32_t id) {
+  return id == IR_NONE ? IR_VOID : (IrType)L->f->insts[id].type;
+}
+
+static uint32_t lower_expr(Lower *L, const AstNode *e);
+
+static uint32_t to_f64(Lower *L, uint32_t id, const AstNode *node) {
+  return type_of(L, id) == IR_F64 ? id
+                                  : emit(L, IR_ITOF, IR_F64, id, IR_NONE, node);
+}
+
+static uint32_t lower_call(Lower *L, const AstNode *e) {
+  uint32_t n = (uint32_t)e->data.call.count, args[FFI_MAX_ARGS];
+  if (n > FFI_MAX_ARGS)
+    n = FFI_MAX_ARGS; // cimport.c já recusa protótipo maior
+  for (uint32_t i = 0; i < n; i++)
+    args[i] = lower_expr(L, e->data.call.args[i]);
+  uint32_t id = emit(L, IR_CALL, IR_I64, IR_NONE, IR_NONE, e);
+  if (id == IR_NONE)
+    return IR_NONE;
+  if (!ir_reserve_args(L->f, id, n)) {
+    L->oom = 1;
+    return IR_NONE;
+  }
+  for (uint32_t i = 0; i < n; i++)
+    L->f->args[L->f->insts[id].first + i] = args[i];
+  return id;
+}
+
+// Acumuladores do terminal: valor inicial e o passo com x
+typedef struct {
+  uint32_t phi[2];   // no cabeçalho
+  uint32_t latch[2]; // no latch
+  uint32_t init[2];
+  int n; // 1, ou 2 pra min/max (melhor + contagem)
+} Accs;
+
+static void acc_step(Lower *L, PipeTerminal t, const Accs *in, uint32_t x,
+                     uint32_t out[2], const AstNode *node) {
+  uint32_t one, zero, nz;
+  switch (t) {
+  case PIPE_SUM:
+    out[0] = emit(L, IR_ADD, IR_I64, in->phi[0], x, node);
+    return;
+  case PIPE_COUNT:
+    one = const_i(L, 1, node);
+    out[0] = emit(L, IR_ADD, IR_I64, in->phi[0], one, node);
+    return;
+  case PIPE_MIN:
+  case PIPE_MAX:
+    out[0] = emit(L, t == PIPE_MIN ? IR_MIN : IR_MAX, IR_I64, in->phi[0], x,
+                  node);
+    one = const_i(L, 1, node);
+    out[1] = emit(L, IR_ADD, IR_I64, in->phi[1], one, node);
+    return;
+  case PIPE_ANY:
+  case PIPE_ALL:
+    zero = const_i(L, 0, node);
+    nz = emit(L, IR_NE, IR_I64, x, zero, node);
+    out[0] = emit(L, t == PIPE_ANY ? IR_OR : IR_AND, IR_I64, in->phi[0], nz,
+                  node);
+    return;
+  }
+}
+
+static uint32_t new_phi(Lower *L, uint32_t n, const AstNode *node) {
+  uint32_t id = emit(L, IR_PHI, IR_I64, IR_NONE, IR_NONE, node);
+  if (id != IR_NONE && !ir_reserve_args(L->f, id, n))
+    L->oom = 1;
+  return L->oom ? IR_NONE : id;
+}
+
+static void set_arg(Lower *L, uint32_t phi, uint32_t k, uint32_t v) {
+  if (!L->oom)
+    L->f->args[L->f->insts[phi].first + k] = v;
+}
+
+// Uma aresta que chega no latch e os acumuladores com que chega
+typedef struct {
+  uint32_t from;
+  uint32_t acc[2];
+} Edge;
+
+// lo..hi | estágios | terminal como laço:
+//   pre:    br head
+//   head:   i, accs = phi; cbr i < hi, body, exit
+//   body:   estágios; filter falso salta pro latch com os accs de antes
+//   latch:  accs = phi das arestas; i + 1; br head
+//   exit:   resultado (min/max de nada vai pro bloco de falha)
+static uint32_t lower_loop(Lower *L, const AstNode *pipe) {
+  const AstNode *src = pipe->data.pipeline.source;
+  PipeTerminal t = pipe->data.pipeline.terminal;
+  uint32_t lo = lower_expr(L, src->data.binop.left);
+  uint32_t hi = lower_expr(L, src->data.binop.right);
+  Accs accs = {.n = t == PIPE_MIN || t == PIPE_MAX ? 2 : 1};
+  long long start = t == PIPE_MIN ? LLONG_MAX
+                    : t == PIPE_MAX ? LLONG_MIN
+                    : t == PIPE_ALL ? 1
+                                    : 0;
+  accs.init[0] = const_i(L, start, pipe);
+  accs.init[1] = accs.n == 2 ? const_i(L, 0, pipe) : IR_NONE;
+
+  uint32_t head = new_block(L), body = new_block(L), latch = new_block(L),
+           exit = new_block(L);
+  branch(L, head);
+  L->cur = head;
+  uint32_t i = new_phi(L, 2, src);
+  for (int k = 0; k < accs.n; k++)
+    accs.phi[k] = new_phi(L, 2, pipe);
+  uint32_t more = emit(L, IR_LT, IR_I64, i, hi, src);
+  cbranch(L, more, body, exit, NULL);
+
+  L->cur = body;
+  size_t mark = L->nvars;
+  push_var(L, "it", 2, i, IR_I64);
+  size_t it = L->nvars - 1;
+  size_t nstages = pipe->data.pipeline.count;
+  Edge *edges = malloc((nstages + 1) * sizeof(Edge));
+  size_t nedges = 0;
+  if (!edges)
+    L->oom = 1;
+  for (size_t s = 0; s < nstages && !L->oom; s++) {
+    const PipeStage *st = &pipe->data.pipeline.stages[s];
+    uint32_t v = lower_expr(L, st->expr);
+    if (st->kind == PIPE_MAP) {
+      L->vars[it].id = v;
+      continue;
+    }
+    uint32_t keep = new_block(L);
+    edges[nedges++] = (Edge){L->cur, {accs.phi[0], accs.phi[1]}};
+    cbranch(L, v, keep, latch, st->expr);
+    L->cur = keep;
+  }
+  uint32_t x = L->oom ? IR_NONE : L->vars[it].id;
+  L->nvars = mark;
+  if (!L->oom) {
+    Edge *e = &edges[nedges++];
+    e->from = L->cur;
+    acc_step(L, t, &accs, x, e->acc, pipe);
+    branch(L, latch);
+  }
+
+  // Preds do latch saíram na ordem das arestas: cbr dos filters, depois o br
+  L->cur = latch;
+  for (int k = 0; k < accs.n && !L->oom; k++) {
+    accs.latch[k] = new_phi(L, (uint32_t)nedges, pipe);
+    for (size_t j = 0; j < nedges; j++)
+      set_arg(L, accs.latch[k], (uint32_t)j, edges[j].acc[k]);
+  }
+  free(edges);
+  uint32_t one = const_i(L, 1, src);
+  uint32_t next = emit(L, IR_ADD, IR_I64, i, one, src);
+  branch(L, head);
+  // Preds do cabeçalho: pre, latch
+  set_arg(L, i, 0, lo);
+  set_arg(L, i, 1, next);
+  for (int k = 0; k < accs.n; k++) {
+    set_arg(L, accs.phi[k], 0, accs.init[k]);
+    set_arg(L, accs.phi[k], 1, accs.latch[k]);
+  }
+
+  L->cur = exit;
+  if (t == PIPE_COUNT || t == PIPE_SUM || t == PIPE_ANY || t == PIPE_ALL)
+    return accs.phi[0];
+  uint32_t zero = const_i(L, 0, pipe);
+  uint32_t some = emit(L, IR_NE, IR_I64, accs.phi[1], zero, pipe);
+  uint32_t ok = new_block(L);
+  cbranch(L, some, ok, fail_block(L), pipe);
+  L->cur = ok;
+  return accs.phi[0];
+}
+
+// Valor de e; quem chama já viu que infer(e) não é IR_VOID
+static uint32_t lower_expr(Lower *L, const AstNode *e) {
+  if (L->oom)
+    return IR_NONE;
+  IrType t = infer(L, e);
+  if (t == IR_VAL)
+    return emit_expr(L, e);
+  switch (e->kind) {
+  case AST_NUMBER_LIT:
+    return e->data.number.is_float ? const_f(L, e->data.number.f64, e)
+                                   : const_i(L, e->data.number.value, e);
+  case AST_IDENT:
+    return find_var(L, e->data.ident.name, e->data.ident.len)->id;
+  case AST_UNARY_OP: {
+    uint32_t x = lower_expr(L, e->data.unary.expr);
+    return emit(L, IR_NEG, t, x, IR_NONE, e);
+  }
+  case AST_BIN_OP: {
+    IrOp op;
+    bin_op(&e->token, &op);
+    uint32_t l = lower_expr(L, e->data.binop.left);
+    uint32_t r = lower_expr(L, e->data.binop.right);
+    if (type_of(L, l) != type_of(L, r)) { // i64 com f64 vira f64, como em C
+      l = to_f64(L, l, e);
+      r = to_f64(L, r, e);
+    }
+    return emit(L, op, t, l, r, e); // comparação dá i64 mesmo de f64
+  }
+  case AST_CALL:
+    return lower_call(L, e);
+  case AST_PIPELINE:
+    return lower_loop(L, e);
+  default:
+    return IR_NONE; // infer não deixa chegar aqui
+  }
+}
+
+// ----- statements -----
+
+// Salta pro bloco de falha e encerra: o resto do test não roda
+static int trap(Lower *L) {
+  uint32_t fail = fail_block(L);
+  if (fail != IR_NONE)
+    branch(L, fail);
+  return 0;
+}
+
+static uint32_t truth(Lower *L, uint32_t v, const AstNode *node) {
+  switch (type_of(L, v)) {
+  case IR_F64: {
+    uint32_t zero = const_f(L, 0.0, node);
+    return emit(L, IR_NE, IR_I64, v, zero, node);
+  }
+  case IR_VAL:
+    return emit(L, IR_TRUTHY, IR_I64, v, IR_NONE, node);
+  default:
+    return v; // cbr já testa != 0
+  }
+}
+
+static int lower_stmt(Lower *L, const AstNode *s);
+
+static int lower_block(Lower *L, const AstNode *block) {
+  size_t mark = L->nvars;
+  int go = 1;
+  for (size_t i = 0; go && i < block->data.block_or_group.count; i++)
+    go = lower_stmt(L, block->data.block_or_group.stmts[i]);
+  L->nvars = mark;
+  return go;
+}
+
+// 1: segue pro próximo statement; 0: o test acabou aqui (falha certa ou
+// sem memória)
+static int lower_stmt(Lower *L, const AstNode *s) {
+  if (!s || L->oom)
+    return !L->oom;
+  switch (s->kind) {
+  case AST_ASSERT_STMT: {
+    if (infer(L, s->data.unary.expr) == IR_VOID)
+      return trap(L);
+    uint32_t v = lower_expr(L, s->data.unary.expr);
+    uint32_t cond = truth(L, v, s);
+    uint32_t next = new_block(L);
+    cbranch(L, cond, next, fail_block(L), s);
+    L->cur = next;
+    return !L->oom;
+  }
+  case AST_VAR_DECL: {
+    IrType t = infer(L, s->data.var.init);
+    if (t == IR_VOID)
+      return trap(L);
+    uint32_t v = lower_expr(L, s->data.var.init);
+    Var *old = s->data.var.autofree
+                   ? NULL
+                   : find_var(L, s->data.var.name, s->data.var.len);
+    if (old) { // reatribui: o nome passa a valer o valor novo
+      old->id = v;
+      old->type = t;
+      return !L->oom;
+    }
+    return push_var(L, s->data.var.name, s->data.var.len, v, t);
+  }
+  case AST_BLOCK:
+    return lower_block(L, s);
+  case AST_CALL:
+    if (infer(L, s) == IR_VOID)
+      return trap(L);
+    lower_expr(L, s);
+    return !L->oom;
+  default:
+    return 1; // expressão solta não roda
+  }
+}
+
+// defer/async/await: o executor tem ordem de saída e tarefas que a IR
+// ainda não modela
+static const char *unsupported(const AstNode *s) {
+  if (!s)
+    return NULL;
+  switch (s->kind) {
+  case AST_DEFER_STMT:
+    return "defer";
+  case AST_ASYNC_BLOCK:
+  case AST_AWAIT_STMT:
+    return "async/await";
+  case AST_BLOCK:
+    for (size_t i = 0; i < s->data.block_or_group.count; i++) {
+      const char *why = unsupported(s->data.block_or_group.stmts[i]);
+      if (why)
+        return why;
+    }
+    return NULL;
+  default:
+    return NULL;
+  }
+}
+
+int ir_lower_test(IrFunc *f, const AstNode *test, const char **why) {
+  ir_init(f, test);
+  const AstNode *body = test->data.test.block;
+  *why = body ? unsupported(body) : "test sem corpo";
+  if (*why)
+    return 0;
+
+  Lower L = {.f = f, .fail = IR_NONE};
+  L.cur = new_block(&L);
+  if (lower_block(&L, body))
+    emit(&L, IR_PASS, IR_VOID, IR_NONE, IR_NONE, NULL);
+  free(L.vars);
+  free(L.free_vars);
+  if (L.oom) {
+    ir_free(f);
+    *why = "sem memória";
+    return 0;
+  }
+  return 1;
+}
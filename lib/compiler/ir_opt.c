@@ -0,0 +1,729 @@
+// ir_opt.c — passadas sobre IrFunc. Cada uma retorna 1 se mudou algo, 0
+// se não, -1 sem memória; o gerenciador repete a sequência até parar de
+// mudar. Instrução removida só ganha dead (ids não são reusados) e sai do
+// array do bloco; uso de valor substituído passa por repl
+#include "ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ----- utilitários -----
+
+static uint32_t *identity(const IrFunc *f) {
+  uint32_t *repl = malloc((size_t)f->ninsts * sizeof(uint32_t) + 1);
+  for (uint32_t i = 0; repl && i < f->ninsts; i++)
+    repl[i] = i;
+  return repl;
+}
+
+static uint32_t resolve(uint32_t *repl, uint32_t id) {
+  if (id == IR_NONE)
+    return id;
+  uint32_t r = id;
+  while (repl[r] != r)
+    r = repl[r];
+  while (repl[id] != r) { // encurta o caminho pra próxima vez
+    uint32_t next = repl[id];
+    repl[id] = r;
+    id = next;
+  }
+  return r;
+}
+
+static int has_args(const IrInst *in) {
+  return in->op == IR_PHI || in->op == IR_EXPR || in->op == IR_CALL;
+}
+
+static void rewrite(IrFunc *f, uint32_t *repl, IrInst *in) {
+  in->a = resolve(repl, in->a);
+  in->b = resolve(repl, in->b);
+  for (uint32_t i = 0; has_args(in) && i < in->count; i++)
+    f->args[in->first + i] = resolve(repl, f->args[in->first + i]);
+}
+
+static void rewrite_all(IrFunc *f, uint32_t *repl) {
+  for (uint32_t b = 0; b < f->nblocks; b++)
+    for (uint32_t i = 0; !f->blocks[b].dead && i < f->blocks[b].count; i++)
+      rewrite(f, repl, &f->insts[f->blocks[b].code[i]]);
+}
+
+// Tira do array do bloco o que morreu ou foi pra outro bloco
+static void compact(IrFunc *f, uint32_t b) {
+  IrBlock *bb = &f->blocks[b];
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < bb->count; i++) {
+    const IrInst *in = &f->insts[bb->code[i]];
+    if (!in->dead && in->block == b)
+      bb->code[n++] = bb->code[i];
+  }
+  bb->count = n;
+}
+
+static void kill(IrFunc *f, uint32_t id, uint32_t *repl, uint32_t to) {
+  f->insts[id].dead = 1;
+  if (repl)
+    repl[id] = to;
+}
+
+// Tira a k-ésima aresta de entrada de b, e o arg k de cada phi
+static void remove_pred(IrFunc *f, uint32_t b, uint32_t k) {
+  IrBlock *bb = &f->blocks[b];
+  for (uint32_t i = 0; i < bb->count; i++) {
+    IrInst *in = &f->insts[bb->code[i]];
+    if (in->op != IR_PHI)
+      break;
+    uint32_t *args = &f->args[in->first];
+    memmove(&args[k], &args[k + 1], (in->count - k - 1) * sizeof(uint32_t));
+    in->count--;
+  }
+  memmove(&bb->preds[k], &bb->preds[k + 1],
+          (bb->npreds - k - 1) * sizeof(uint32_t));
+  bb->npreds--;
+}
+
+static void remove_edge(IrFunc *f, uint32_t from, uint32_t to) {
+  IrBlock *bb = &f->blocks[to];
+  for (uint32_t k = 0; k < bb->npreds; k++)
+    if (bb->preds[k] == from) {
+      remove_pred(f, to, k);
+      return;
+    }
+}
+
+static int is_const(const IrFunc *f, uint32_t id, long long *v) {
+  if (id == IR_NONE || f->insts[id].op != IR_CONST ||
+      f->insts[id].type != IR_I64)
+    return 0;
+  *v = f->insts[id].imm.i;
+  return 1;
+}
+
+// ----- propagação de constante -----
+
+// Mesma aritmética do eval: inteiro dá a volta, divisão por 0 não dobra
+// (falha no runtime), por -1 é negação
+static int fold_i64(IrOp op, long long l, long long r, long long *out) {
+  unsigned long long ul = (unsigned long long)l, ur = (unsigned long long)r;
+  switch (op) {
+  case IR_ADD:
+    *out = (long long)(ul + ur);
+    return 1;
+  case IR_SUB:
+    *out = (long long)(ul - ur);
+    return 1;
+  case IR_MUL:
+    *out = (long long)(ul * ur);
+    return 1;
+  case IR_DIV:
+    if (r == 0)
+      return 0;
+    *out = r == -1 ? (long long)(0 - ul) : l / r;
+    return 1;
+  case IR_EQ:
+    *out = l == r;
+    return 1;
+  case IR_NE:
+    *out = l != r;
+    return 1;
+  case IR_LT:
+    *out = l < r;
+    return 1;
+  case IR_LE:
+    *out = l <= r;
+    return 1;
+  case IR_GT:
+    *out = l > r;
+    return 1;
+  case IR_GE:
+    *out = l >= r;
+    return 1;
+  case IR_AND:
+    *out = (long long)(ul & ur);
+    return 1;
+  case IR_OR:
+    *out = (long long)(ul | ur);
+    return 1;
+  case IR_MIN:
+    *out = l < r ? l : r;
+    return 1;
+  case IR_MAX:
+    *out = l > r ? l : r;
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static int fold_f64(IrOp op, double l, double r, IrInst *out) {
+  switch (op) {
+  case IR_ADD:
+    out->imm.f = l + r;
+    return 1;
+  case IR_SUB:
+    out->imm.f = l - r;
+    return 1;
+  case IR_MUL:
+    out->imm.f = l * r;
+    return 1;
+  case IR_DIV:
+    out->imm.f = l / r;
+    return 1;
+  case IR_EQ:
+    out->imm.i = l == r;
+    return 1;
+  case IR_NE:
+    out->imm.i = l != r;
+    return 1;
+  case IR_LT:
+    out->imm.i = l < r;
+    return 1;
+  case IR_LE:
+    out->imm.i = l <= r;
+    return 1;
+  case IR_GT:
+    out->imm.i = l > r;
+    return 1;
+  case IR_GE:
+    out->imm.i = l >= r;
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static void make_const(IrInst *in) {
+  in->op = IR_CONST;
+  in->a = in->b = IR_NONE;
+  in->count = 0;
+}
+
+// Dobra in no lugar se os operandos são constantes. 1 se dobrou
+static int fold(IrFunc *f, IrInst *in) {
+  const IrInst *a = in->a != IR_NONE ? &f->insts[in->a] : NULL;
+  const IrInst *b = in->b != IR_NONE ? &f->insts[in->b] : NULL;
+  if (!a || a->op != IR_CONST)
+    return 0;
+  if (in->op == IR_NEG) {
+    if (in->type == IR_F64)
+      in->imm.f = -a->imm.f;
+    else
+      in->imm.i = (long long)(0 - (unsigned long long)a->imm.i);
+    make_const(in);
+    return 1;
+  }
+  if (in->op == IR_ITOF) {
+    in->imm.f = (double)a->imm.i;
+    make_const(in);
+    return 1;
+  }
+  if (!b || b->op != IR_CONST || in->op < IR_ADD || in->op > IR_MAX)
+    return 0;
+  if (a->type == IR_F64) {
+    double l = a->imm.f, r = b->imm.f;
+    if (!fold_f64((IrOp)in->op, l, r, in))
+      return 0;
+  } else {
+    long long v;
+    if (!fold_i64((IrOp)in->op, a->imm.i, b->imm.i, &v))
+      return 0;
+    in->imm.i = v;
+  }
+  make_const(in);
+  return 1;
+}
+
+// x + 0, x - 0, x * 1, x / 1 (só i64: em f64 -0.0 + 0 não é -0.0). Valor
+// que substitui in, ou IR_NONE
+static uint32_t identity_of(const IrFunc *f, const IrInst *in) {
+  long long v;
+  if (in->type != IR_I64)
+    return IR_NONE;
+  switch (in->op) {
+  case IR_ADD:
+    if (is_const(f, in->b, &v) && v == 0)
+      return in->a;
+    return is_const(f, in->a, &v) && v == 0 ? in->b : IR_NONE;
+  case IR_MUL:
+    if (is_const(f, in->b, &v) && v == 1)
+      return in->a;
+    return is_const(f, in->a, &v) && v == 1 ? in->b : IR_NONE;
+  case IR_SUB:
+  case IR_DIV:
+    return is_const(f, in->b, &v) && v == (in->op == IR_DIV) ? in->a
+                                                             : IR_NONE;
+  default:
+    return IR_NONE;
+  }
+}
+
+// phi cujos args são todos o mesmo valor (fora ele mesmo) é esse valor
+static uint32_t trivial_phi(const IrFunc *f, uint32_t id) {
+  const IrInst *in = &f->insts[id];
+  uint32_t same = IR_NONE;
+  for (uint32_t i = 0; i < in->count; i++) {
+    uint32_t x = f->args[in->first + i];
+    if (x == id || x == same)
+      continue;
+    if (same != IR_NONE)
+      return IR_NONE;
+    same = x;
+  }
+  return same;
+}
+
+// Bloco que ninguém alcança some, e com ele as arestas que saíam dele
+static int drop_unreachable(IrFunc *f) {
+  uint32_t *idom = malloc((size_t)f->nblocks * sizeof(uint32_t) + 1);
+  uint32_t *rpo = malloc((size_t)f->nblocks * sizeof(uint32_t) + 1);
+  if (!idom || !rpo) {
+    free(idom);
+    free(rpo);
+    return -1;
+  }
+  ir_dominators(f, idom, rpo);
+  int changed = 0;
+  for (uint32_t b = 0; b < f->nblocks; b++) {
+    if (f->blocks[b].dead || idom[b] != IR_NONE)
+      continue;
+    uint32_t s[2];
+    int ns = ir_succs(f, b, s);
+    for (int i = 0; i < ns; i++)
+      if (!f->blocks[s[i]].dead)
+        remove_edge(f, b, s[i]);
+    for (uint32_t i = 0; i < f->blocks[b].count; i++)
+      f->insts[f->blocks[b].code[i]].dead = 1;
+    f->blocks[b].dead = 1;
+    f->blocks[b].count = 0;
+    changed = 1;
+  }
+  free(idom);
+  free(rpo);
+  return changed;
+}
+
+static int constprop(IrFunc *f) {
+  uint32_t *repl = identity(f);
+  if (!repl)
+    return -1;
+  int changed = 0;
+  for (uint32_t b = 0; b < f->nblocks; b++) {
+    IrBlock *bb = &f->blocks[b];
+    for (uint32_t i = 0; !bb->dead && i < bb->count; i++) {
+      uint32_t id = bb->code[i];
+      IrInst *in = &f->insts[id];
+      rewrite(f, repl, in);
+      uint32_t to;
+      if (in->op == IR_PHI && (to = trivial_phi(f, id)) != IR_NONE) {
+        kill(f, id, repl, to);
+        changed = 1;
+      } else if ((to = identity_of(f, in)) != IR_NONE) {
+        kill(f, id, repl, to);
+        changed = 1;
+      } else if (in->op != IR_CONST && fold(f, in)) {
+        changed = 1;
+      } else if (in->op == IR_CBR && f->insts[in->a].op == IR_CONST) {
+        // Desvio decidido: vira br e a outra aresta some
+        int taken = f->insts[in->a].imm.i != 0;
+        uint32_t keep = taken ? in->imm.br.then : in->imm.br.other;
+        uint32_t drop = taken ? in->imm.br.other : in->imm.br.then;
+        in->op = IR_BR;
+        in->a = IR_NONE;
+        in->imm.br.then = keep;
+        in->imm.br.other = IR_NONE;
+        remove_edge(f, b, drop);
+        changed = 1;
+      }
+    }
+  }
+  // Phi com arg de back edge pode ter visto o valor antes de ser trocado
+  rewrite_all(f, repl);
+  for (uint32_t b = 0; b < f->nblocks; b++)
+    compact(f, b);
+  free(repl);
+  int dropped = drop_unreachable(f);
+  if (dropped < 0)
+    return -1;
+  return changed || dropped;
+}
+
+// ----- blocos -----
+
+// b termina em br pra s, e s só tem b de pred: s vira o fim de b. Sobra de
+// assert que a propagação decidiu e de bloco que ficou só com o salto
+static int merge_blocks(IrFunc *f) {
+  int changed = 0;
+  for (uint32_t b = 0; b < f->nblocks; b++) {
+    IrBlock *bb = &f->blocks[b];
+    while (!bb->dead && bb->count) {
+      IrInst *term = &f->insts[bb->code[bb->count - 1]];
+      uint32_t s = term->imm.br.then;
+      if (term->op != IR_BR || s == b || f->blocks[s].npreds != 1)
+        break;
+      IrBlock *sb = &f->blocks[s];
+      if (sb->count && f->insts[sb->code[0]].op == IR_PHI)
+        break; // phi de um arg: a propagação tira antes
+      uint32_t need = bb->count - 1 + sb->count;
+      if (need > bb->cap) {
+        uint32_t *p = realloc(bb->code, (size_t)need * sizeof(uint32_t));
+        if (!p)
+          return -1;
+        bb->code = p;
+        bb->cap = need;
+      }
+      term->dead = 1;
+      bb->count--;
+      for (uint32_t i = 0; i < sb->count; i++) {
+        f->insts[sb->code[i]].block = b;
+        bb->code[bb->count++] = sb->code[i];
+      }
+      sb->count = 0;
+      sb->npreds = 0;
+      sb->dead = 1;
+      uint32_t succ[2];
+      int ns = ir_succs(f, b, succ);
+      for (int i = 0; i < ns; i++) { // quem vinha de s agora vem de b
+        IrBlock *t = &f->blocks[succ[i]];
+        for (uint32_t k = 0; k < t->npreds; k++)
+          if (t->preds[k] == s)
+            t->preds[k] = b;
+      }
+      changed = 1;
+    }
+  }
+  return changed;
+}
+
+// ----- CSE -----
+
+// Op sem efeito e sem estado: mesma op com mesmos operandos dá o mesmo
+// valor. Divisão entra — a de cima, que domina, já teria falhado antes
+static int cse_candidate(const IrInst *in) {
+  return in->op == IR_CONST || (in->op >= IR_ADD && in->op <= IR_TRUTHY);
+}
+
+static int commutative(IrOp op) {
+  return op == IR_ADD || op == IR_MUL || op == IR_EQ || op == IR_NE ||
+         op == IR_AND || op == IR_OR || op == IR_MIN || op == IR_MAX;
+}
+
+static uint64_t inst_key(const IrInst *in) {
+  uint64_t h = 1469598103934665603ull;
+  uint64_t parts[4] = {(uint64_t)in->op << 8 | in->type, in->a, in->b,
+                       in->op == IR_CONST ? (uint64_t)in->imm.i : 0};
+  for (int i = 0; i < 4; i++) {
+    h ^= parts[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+static int same_inst(const IrInst *x, const IrInst *y) {
+  if (x->op != y->op || x->type != y->type || x->a != y->a || x->b != y->b)
+    return 0;
+  if (x->op != IR_CONST)
+    return 1;
+  return memcmp(&x->imm, &y->imm, sizeof(x->imm)) == 0; // bits: -0.0, NaN
+}
+
+typedef struct {
+  uint32_t *heads; // balde -> índice em entries
+  uint32_t mask;
+  uint32_t *ids, *next; // entries: inst e o próximo do balde
+  uint32_t count;
+} Table;
+
+// Varre a árvore de dominadores em pré-ordem com a tabela valendo só no
+// ramo atual — por quê escopo? Valor de um irmão não domina o outro
+static int cse(IrFunc *f) {
+  uint32_t n = f->nblocks, size = 16;
+  while (size < f->ninsts * 2)
+    size *= 2;
+  uint32_t *idom = malloc((size_t)n * sizeof(uint32_t) + 1);
+  uint32_t *rpo = malloc((size_t)n * sizeof(uint32_t) + 1);
+  uint32_t *child = malloc((size_t)n * sizeof(uint32_t) + 1);
+  uint32_t *sibling = malloc((size_t)n * sizeof(uint32_t) + 1);
+  uint32_t *stack = malloc((size_t)n * 2 * sizeof(uint32_t) + 2);
+  uint32_t *marks = malloc((size_t)n * sizeof(uint32_t) + 1);
+  uint32_t *repl = identity(f);
+  Table t = {calloc(size, sizeof(uint32_t)), size - 1,
+             malloc((size_t)f->ninsts * sizeof(uint32_t) + 1),
+             malloc((size_t)f->ninsts * sizeof(uint32_t) + 1), 0};
+  int changed = -1;
+  if (!idom || !rpo || !child || !sibling || !stack || !marks || !repl ||
+      !t.heads || !t.ids || !t.next)
+    goto out;
+  changed = 0;
+  uint32_t reach = ir_dominators(f, idom, rpo);
+  for (uint32_t b = 0; b < n; b++)
+    child[b] = sibling[b] = IR_NONE;
+  for (uint32_t i = reach; i-- > 1;) { // filhos na ordem rpo
+    uint32_t b = rpo[i];
+    sibling[b] = child[idom[b]];
+    child[idom[b]] = b;
+  }
+
+  // Pilha de pares (bloco, altura da tabela na entrada); bloco com o bit
+  // alto é a saída dele
+  uint32_t top = 0;
+  if (reach)
+    stack[top++] = 0;
+  while (top) {
+    uint32_t b = stack[--top];
+    if (b & 0x80000000u) { // saída: desfaz o que o bloco pôs na tabela
+      b &= 0x7fffffffu;
+      while (t.count > marks[b]) {
+        uint32_t e = --t.count;
+        uint32_t h = (uint32_t)inst_key(&f->insts[t.ids[e]]) & t.mask;
+        t.heads[h] = t.next[e];
+      }
+      continue;
+    }
+    marks[b] = t.count;
+    IrBlock *bb = &f->blocks[b];
+    for (uint32_t i = 0; i < bb->count; i++) {
+      uint32_t id = bb->code[i];
+      IrInst *in = &f->insts[id];
+      rewrite(f, repl, in);
+      if (!cse_candidate(in))
+        continue;
+      if (commutative((IrOp)in->op) && in->a > in->b) {
+        uint32_t x = in->a;
+        in->a = in->b;
+        in->b = x;
+      }
+      uint32_t h = (uint32_t)inst_key(in) & t.mask, e;
+      for (e = t.heads[h]; e; e = t.next[e - 1])
+        if (same_inst(&f->insts[t.ids[e - 1]], in))
+          break;
+      if (e) {
+        kill(f, id, repl, t.ids[e - 1]);
+        changed = 1;
+        continue;
+      }
+      t.ids[t.count] = id; // entries começam em 1 nos baldes: 0 é vazio
+      t.next[t.count] = t.heads[h];
+      t.heads[h] = ++t.count;
+    }
+    stack[top++] = b | 0x80000000u;
+    for (uint32_t c = child[b]; c != IR_NONE; c = sibling[c])
+      stack[top++] = c;
+  }
+  rewrite_all(f, repl);
+  for (uint32_t b = 0; b < n; b++)
+    compact(f, b);
+out:
+  free(idom);
+  free(rpo);
+  free(child);
+  free(sibling);
+  free(stack);
+  free(marks);
+  free(repl);
+  free(t.heads);
+  free(t.ids);
+  free(t.next);
+  return changed;
+}
+
+// ----- LICM -----
+
+static int hoistable(const IrFunc *f, const IrInst *in) {
+  if (in->op == IR_EXPR)
+    return !in->impure && !ir_may_trap(f, in);
+  return cse_candidate(in) && !ir_may_trap(f, in);
+}
+
+static int insert_before_end(IrFunc *f, uint32_t b, uint32_t id) {
+  IrBlock *bb = &f->blocks[b];
+  if (bb->count == bb->cap) {
+    uint32_t cap = bb->cap ? bb->cap * 2 : 8;
+    uint32_t *p = realloc(bb->code, (size_t)cap * sizeof(uint32_t));
+    if (!p)
+      return 0;
+    bb->code = p;
+    bb->cap = cap;
+  }
+  bb->code[bb->count] = bb->code[bb->count - 1];
+  bb->code[bb->count - 1] = id;
+  bb->count++;
+  f->insts[id].block = b;
+  return 1;
+}
+
+// Um laço natural por cabeçalho (junta os back edges dele). Só sobe pro
+// pré-cabeçalho que já existe — o único pred de fora, terminando em br;
+// o laço de pipeline do ir_lower.c sempre tem um
+static int hoist_loop(IrFunc *f, uint32_t h, const uint32_t *idom,
+                      const uint32_t *rpo, uint32_t reach, uint8_t *in_loop,
+                      uint32_t *work) {
+  const IrBlock *hb = &f->blocks[h];
+  uint32_t top = 0, pre = IR_NONE, outside = 0;
+  memset(in_loop, 0, f->nblocks);
+  in_loop[h] = 1;
+  for (uint32_t k = 0; k < hb->npreds; k++)
+    if (ir_dominates(idom, h, hb->preds[k]) && !in_loop[hb->preds[k]]) {
+      in_loop[hb->preds[k]] = 1;
+      work[top++] = hb->preds[k];
+    }
+  if (!top)
+    return 0; // sem back edge: não é cabeçalho
+  while (top) {
+    const IrBlock *bb = &f->blocks[work[--top]];
+    for (uint32_t k = 0; k < bb->npreds; k++)
+      if (!in_loop[bb->preds[k]] && idom[bb->preds[k]] != IR_NONE) {
+        in_loop[bb->preds[k]] = 1;
+        work[top++] = bb->preds[k];
+      }
+  }
+  for (uint32_t k = 0; k < hb->npreds; k++)
+    if (!in_loop[hb->preds[k]]) {
+      pre = hb->preds[k];
+      outside++;
+    }
+  uint32_t s[2];
+  if (outside != 1 || ir_succs(f, pre, s) != 1)
+    return 0;
+
+  int changed = 0;
+  for (uint32_t r = 0; r < reach; r++) { // rpo: definição antes do uso
+    uint32_t b = rpo[r];
+    if (!in_loop[b])
+      continue;
+    IrBlock *bb = &f->blocks[b];
+    int moved = 0;
+    for (uint32_t i = 0; i < bb->count; i++) {
+      uint32_t id = bb->code[i];
+      IrInst *in = &f->insts[id];
+      if (!hoistable(f, in))
+        continue;
+      int invariant = (in->a == IR_NONE || !in_loop[f->insts[in->a].block]) &&
+                      (in->b == IR_NONE || !in_loop[f->insts[in->b].block]);
+      for (uint32_t k = 0; invariant && has_args(in) && k < in->count; k++)
+        invariant = !in_loop[f->insts[f->args[in->first + k]].block];
+      if (!invariant)
+        continue;
+      if (!insert_before_end(f, pre, id))
+        return -1;
+      moved = changed = 1;
+    }
+    if (moved)
+      compact(f, b);
+  }
+  return changed;
+}
+
+static int licm(IrFunc *f) {
+  uint32_t n = f->nblocks;
+  uint32_t *idom = malloc((size_t)n * sizeof(uint32_t) + 1);
+  uint32_t *rpo = malloc((size_t)n * sizeof(uint32_t) + 1);
+  uint32_t *work = malloc((size_t)n * sizeof(uint32_t) + 1);
+  uint8_t *in_loop = malloc((size_t)n + 1);
+  int changed = -1;
+  if (idom && rpo && work && in_loop) {
+    changed = 0;
+    uint32_t reach = ir_dominators(f, idom, rpo);
+    // rpo de trás pra frente: laço de dentro antes do de fora, e o que sobe
+    // do de dentro ainda pode subir do de fora
+    for (uint32_t r = reach; r-- > 0 && changed >= 0;) {
+      int c = hoist_loop(f, rpo[r], idom, rpo, reach, in_loop, work);
+      changed = c < 0 ? -1 : changed | c;
+    }
+  }
+  free(idom);
+  free(rpo);
+  free(work);
+  free(in_loop);
+  return changed;
+}
+
+// ----- DCE -----
+
+// Vivo: terminador, o que tem efeito ou pode falhar o test, e o que eles
+// usam. O resto (inclusive phi que só alimenta a si mesmo) sai
+static int dce(IrFunc *f) {
+  uint8_t *live = calloc(f->ninsts + 1, 1);
+  uint32_t *work = malloc((size_t)f->ninsts * sizeof(uint32_t) + 1);
+  if (!live || !work) {
+    free(live);
+    free(work);
+    return -1;
+  }
+  uint32_t top = 0;
+  for (uint32_t b = 0; b < f->nblocks; b++)
+    for (uint32_t i = 0; !f->blocks[b].dead && i < f->blocks[b].count; i++) {
+      uint32_t id = f->blocks[b].code[i];
+      const IrInst *in = &f->insts[id];
+      if (ir_is_terminator((IrOp)in->op) || in->op == IR_CALL || in->impure ||
+          ir_may_trap(f, in)) {
+        live[id] = 1;
+        work[top++] = id;
+      }
+    }
+  while (top) {
+    const IrInst *in = &f->insts[work[--top]];
+    uint32_t ops[2] = {in->a, in->b};
+    for (int k = 0; k < 2; k++)
+      if (ops[k] != IR_NONE && !live[ops[k]]) {
+        live[ops[k]] = 1;
+        work[top++] = ops[k];
+      }
+    for (uint32_t k = 0; has_args(in) && k < in->count; k++) {
+      uint32_t x = f->args[in->first + k];
+      if (x != IR_NONE && !live[x]) {
+        live[x] = 1;
+        work[top++] = x;
+      }
+    }
+  }
+  int changed = 0;
+  for (uint32_t b = 0; b < f->nblocks; b++) {
+    IrBlock *bb = &f->blocks[b];
+    uint32_t before = bb->count;
+    for (uint32_t i = 0; !bb->dead && i < bb->count; i++)
+      if (!live[bb->code[i]])
+        f->insts[bb->code[i]].dead = 1;
+    compact(f, b);
+    changed |= bb->count != before;
+  }
+  free(live);
+  free(work);
+  return changed;
+}
+
+// ----- gerenciador -----
+
+typedef struct {
+  const char *name;
+  int (*run)(IrFunc *f);
+} Pass;
+
+static const Pass passes[] = {
+    {"constprop", constprop}, {"cfg", merge_blocks}, {"cse", cse},
+    {"licm", licm},           {"dce", dce}};
+
+#define IR_MAX_ROUNDS 8 // cada volta só tira coisa: para bem antes disso
+
+int ir_optimize(IrFunc *f, int verify, char *why, size_t cap) {
+  char msg[160];
+  if (verify && !ir_verify(f, msg, sizeof(msg))) {
+    snprintf(why, cap, "lower: %s", msg);
+    return 0;
+  }
+  for (int round = 0; round < IR_MAX_ROUNDS; round++) {
+    int changed = 0;
+    for (size_t p = 0; p < sizeof(passes) / sizeof(passes[0]); p++) {
+      int r = passes[p].run(f);
+      if (r < 0) {
+        snprintf(why, cap, "%s: sem memória", passes[p].name);
+        return 0;
+      }
+      changed |= r;
+      if (verify && !ir_verify(f, msg, sizeof(msg))) {
+        snprintf(why, cap, "%s: %s", passes[p].name, msg);
+        return 0;
+      }
+    }
+    if (!changed)
+      break;
+  }
+  return 1;
+}
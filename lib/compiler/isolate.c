@@ -0,0 +1,445 @@
+#define _POSIX_C_SOURCE 200809L // fork/pipe/poll/sigaction
+#include "isolate.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define IDLE UINT32_MAX
+
+// Resposta do filho por test; o texto da mensagem vem logo atrás, numa
+// write só (cabe em PIPE_BUF: não chega picado)
+typedef struct {
+  uint32_t index;
+  int32_t passed;
+  int32_t line;
+  uint32_t len;   // mensagem inteira; 0: sem mensagem
+  uint32_t shown; // bytes que vieram (até ASSERT_NOTE_MAX - 1)
+  uint64_t ns;    // tempo de parede do test, medido no filho
+} Report;
+
+// Slots a distribuir: sem plano uma fila só pra todos; com --shards uma por
+// shard, do mais caro pro mais barato. Filho com a fila vazia rouba do fim
+// (o mais barato) da fila com mais trabalho previsto — estimativa errada
+// não deixa um shard sozinho no fim
+typedef struct {
+  uint32_t *items;
+  size_t head, tail;
+  uint64_t load; // custo previsto do que falta
+} Queue;
+
+typedef struct {
+  pid_t pid;     // 0: sem processo
+  int cmd, res;  // escrita: índice do próximo test; leitura: Report
+  uint32_t busy; // test em andamento ou IDLE
+  int queue;     // fila própria
+} Worker;
+
+typedef struct {
+  AstNode *test;
+  int cache; // test_cache_check: 1 veio do cache, 0 guarda, -1 sem cache
+  uint64_t hash;
+  int done;
+  int passed;
+  uint64_t cost; // previsto pelo plano
+  uint64_t ns;   // medido; 0: não rodou até o fim
+  char why[32]; // filho que caiu no meio do test; vazio senão
+  char *text;   // mensagem do assert, malloc
+  uint32_t len, shown;
+  int line;
+} Slot;
+
+typedef struct {
+  TestRunner *r;
+  Slot *slots; // todos os tests do programa, na ordem do fonte
+  size_t nslots, printed;
+  uint32_t *todo; // slots que rodam num filho, agrupados por fila
+  size_t ntodo, finished;
+  Queue *queues;
+  int nqueues;
+  Worker *workers;
+  int nworkers;
+  struct sigaction old_pipe; // o filho volta pro SIGPIPE de antes
+} Pool;
+
+static int read_full(int fd, void *buf, size_t len) {
+  char *p = buf;
+  while (len) {
+    ssize_t n = read(fd, p, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return 0;
+    p += n;
+    len -= (size_t)n;
+  }
+  return 1;
+}
+
+static int write_full(int fd, const void *buf, size_t len) {
+  const char *p = buf;
+  while (len) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return 0;
+    p += n;
+    len -= (size_t)n;
+  }
+  return 1;
+}
+
+// ----- filho -----
+
+// Roda o que chegar em cmd até o pai fechar; nunca retorna
+static void child_main(Pool *p, int cmd, int res) {
+  uint32_t i;
+  while (read_full(cmd, &i, sizeof(i)) && i < p->nslots) {
+    char buf[sizeof(Report) + ASSERT_NOTE_MAX];
+    AssertNote note = {.buf = buf + sizeof(Report), .cap = ASSERT_NOTE_MAX};
+    Report rep = {.index = i};
+    uint64_t start = timings_now();
+    rep.passed = run_test_body(p->r, p->slots[i].test, &note);
+    rep.ns = timings_now() - start;
+    if (!rep.passed && atomic_load(&note.taken)) {
+      rep.line = note.line;
+      rep.len = note.len > UINT32_MAX ? UINT32_MAX : (uint32_t)note.len;
+      rep.shown = note.len < note.cap ? rep.len : (uint32_t)note.cap - 1;
+    }
+    memcpy(buf, &rep, sizeof(rep));
+    if (!write_full(res, buf, sizeof(rep) + rep.shown))
+      break;
+  }
+  sched_destroy(p->r->sched);
+  _exit(0); // sem atexit nem flush: o stdio é cópia do pai
+}
+
+// ----- pai -----
+
+// Fork do estado atual: AST, cache e pools já prontos no filho
+static int spawn(Pool *p, Worker *w) {
+  int cmd[2], res[2];
+  if (pipe(cmd) < 0)
+    return 0;
+  if (pipe(res) < 0) {
+    close(cmd[0]);
+    close(cmd[1]);
+    return 0;
+  }
+  fflush(NULL); // o que está no buffer sairia de novo pelo filho
+  pid_t pid = fork();
+  if (pid < 0) {
+    close(cmd[0]);
+    close(cmd[1]);
+    close(res[0]);
+    close(res[1]);
+    return 0;
+  }
+  if (pid == 0) {
+    sigaction(SIGPIPE, &p->old_pipe, NULL);
+    close(cmd[1]);
+    close(res[0]);
+    // Ponta de pipe de irmão aberta aqui seguraria o EOF dele
+    for (int j = 0; j < p->nworkers; j++)
+      if (p->workers[j].pid > 0) {
+        if (p->workers[j].cmd >= 0)
+          close(p->workers[j].cmd);
+        close(p->workers[j].res);
+      }
+    child_main(p, cmd[0], res[1]);
+  }
+  close(cmd[0]);
+  close(res[1]);
+  *w = (Worker){pid, cmd[1], res[0], IDLE, w->queue};
+  return 1;
+}
+
+static int queue_empty(const Queue *q) { return q->head == q->tail; }
+
+static int pending(const Pool *p) {
+  for (int k = 0; k < p->nqueues; k++)
+    if (!queue_empty(&p->queues[k]))
+      return 1;
+  return 0;
+}
+
+// Da própria fila pela frente; vazia, rouba do fim da mais carregada
+static Queue *take(Pool *p, const Worker *w, uint32_t *i, int *back) {
+  Queue *q = &p->queues[w->queue];
+  *back = queue_empty(q);
+  if (*back) {
+    q = NULL;
+    for (int k = 0; k < p->nqueues; k++) {
+      Queue *c = &p->queues[k];
+      if (!queue_empty(c) && (!q || c->load > q->load))
+        q = c;
+    }
+    if (!q)
+      return NULL;
+  }
+  *i = *back ? q->items[--q->tail] : q->items[q->head++];
+  q->load -= p->slots[*i].cost;
+  return q;
+}
+
+// Próximo test pro filho; sem mais nada, fecha cmd e ele sai sozinho
+static void assign(Pool *p, Worker *w) {
+  w->busy = IDLE;
+  uint32_t i;
+  int back;
+  Queue *q = take(p, w, &i, &back);
+  if (!q) {
+    if (w->cmd >= 0)
+      close(w->cmd);
+    w->cmd = -1;
+    return;
+  }
+  if (write_full(w->cmd, &i, sizeof(i))) {
+    w->busy = i;
+    return;
+  }
+  // Morreu parado: devolve pra fila, o EOF em res troca ele e o test espera
+  if (back)
+    q->tail++;
+  else
+    q->head--;
+  q->load += p->slots[i].cost;
+}
+
+// Imprime o que já dá na ordem do fonte: um test lento no começo segura a
+// saída, não o trabalho dos outros filhos
+static void flush_ready(Pool *p) {
+  TestRunner *r = p->r;
+  for (; p->printed < p->nslots && p->slots[p->printed].done; p->printed++) {
+    Slot *s = &p->slots[p->printed];
+    const char *note = s->cache == 1 ? "cached" : s->why[0] ? s->why : NULL;
+    report_test(r, s->test, s->passed, note);
+    if (s->cache == 0)
+      test_cache_store(r->cache, s->hash, s->passed);
+    if (s->ns || s->cache == 1)
+      record_timing(r, s->test, s->cache, s->hash, s->ns);
+    if (s->text) {
+      AssertNote n = {.buf = s->text,
+                      .cap = (size_t)s->shown + 1,
+                      .len = s->len,
+                      .line = s->line};
+      report_note(r, &n);
+    }
+  }
+}
+
+static void finish(Pool *p, Slot *s) {
+  s->done = 1;
+  p->finished++;
+  flush_ready(p);
+}
+
+static void reap(Worker *w, int *status) {
+  if (w->cmd >= 0)
+    close(w->cmd);
+  close(w->res);
+  while (waitpid(w->pid, status, 0) < 0 && errno == EINTR)
+    ;
+  // A fila fica: o filho que entrar no lugar continua de onde este parou
+  *w = (Worker){.cmd = -1, .res = -1, .busy = IDLE, .queue = w->queue};
+}
+
+// res ficou legível: resultado, ou EOF de filho que morreu
+static void on_ready(Pool *p, Worker *w) {
+  Report rep;
+  if (read_full(w->res, &rep, sizeof(rep)) && rep.index == w->busy &&
+      rep.shown < ASSERT_NOTE_MAX) {
+    Slot *s = &p->slots[rep.index];
+    s->passed = rep.passed;
+    s->ns = rep.ns ? rep.ns : 1;
+    s->line = rep.line;
+    s->len = rep.len;
+    if (rep.shown) {
+      s->text = malloc(rep.shown);
+      if (!s->text || !read_full(w->res, s->text, rep.shown)) {
+        free(s->text);
+        s->text = NULL;
+      } else {
+        s->shown = rep.shown;
+      }
+    }
+    finish(p, s);
+    assign(p, w);
+    return;
+  }
+
+  uint32_t busy = w->busy;
+  int status = 0;
+  reap(w, &status);
+  if (busy != IDLE) { // o test derrubou o processo: falha, e segue
+    Slot *s = &p->slots[busy];
+    s->passed = 0;
+    if (WIFSIGNALED(status))
+      snprintf(s->why, sizeof(s->why), "caiu: sinal %d", WTERMSIG(status));
+    else
+      snprintf(s->why, sizeof(s->why), "saiu com %d", WEXITSTATUS(status));
+    finish(p, s);
+  }
+  if (pending(p) && spawn(p, w))
+    assign(p, w);
+}
+
+static void run_pool(Pool *p) {
+  struct pollfd *fds = malloc((size_t)p->nworkers * sizeof(struct pollfd));
+  int *who = malloc((size_t)p->nworkers * sizeof(int));
+  while (fds && who && p->finished < p->ntodo) {
+    int n = 0;
+    for (int j = 0; j < p->nworkers; j++)
+      if (p->workers[j].pid > 0) {
+        fds[n] = (struct pollfd){.fd = p->workers[j].res, .events = POLLIN};
+        who[n++] = j;
+      }
+    if (!n)
+      break; // fork parou de funcionar: o resto roda aqui
+    if (poll(fds, (nfds_t)n, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    for (int k = 0; k < n; k++)
+      if (fds[k].revents)
+        on_ready(p, &p->workers[who[k]]);
+  }
+  free(fds);
+  free(who);
+
+  // Sobra (sem fork, sem memória): no processo do pai, sem isolamento
+  for (int k = 0; k < p->nqueues; k++) {
+    Queue *q = &p->queues[k];
+    while (!queue_empty(q)) {
+      Slot *s = &p->slots[q->items[q->head++]];
+      char text[ASSERT_NOTE_MAX];
+      AssertNote note = {.buf = text, .cap = sizeof(text)};
+      uint64_t start = timings_now();
+      s->passed = run_test_body(p->r, s->test, &note);
+      s->ns = timings_now() - start + 1;
+      finish(p, s);
+    }
+  }
+  for (int j = 0; j < p->nworkers; j++)
+    if (p->workers[j].pid > 0) {
+      int status;
+      reap(&p->workers[j], &status);
+    }
+}
+
+typedef struct {
+  int bin;
+  uint64_t cost;
+  uint32_t slot;
+} Pick;
+
+// Fila a fila; dentro dela o mais caro primeiro (LPT de novo), empate na
+// ordem do fonte
+static int by_queue(const void *a, const void *b) {
+  const Pick *x = a, *y = b;
+  if (x->bin != y->bin)
+    return x->bin - y->bin;
+  if (x->cost != y->cost)
+    return x->cost < y->cost ? 1 : -1;
+  return (x->slot > y->slot) - (x->slot < y->slot);
+}
+
+// Com --shards (plano e sem --shard) uma fila por shard; senão uma só, na
+// ordem do fonte. As filas são fatias de p->todo
+static int make_queues(Pool *p) {
+  const ShardPlan *plan = p->r->shard ? NULL : p->r->plan;
+  p->nqueues = plan && plan->nbins > 1 ? plan->nbins : 1;
+  p->queues = calloc((size_t)p->nqueues, sizeof(Queue));
+  Pick *picks = malloc((p->ntodo ? p->ntodo : 1) * sizeof(Pick));
+  if (!p->queues || !picks) {
+    free(picks);
+    return 0;
+  }
+  for (size_t k = 0; k < p->ntodo; k++) {
+    Slot *s = &p->slots[p->todo[k]];
+    const ShardTest *t = plan ? shard_find(plan, s->test) : NULL;
+    s->cost = t ? t->cost : 0;
+    picks[k] = (Pick){t && t->bin < p->nqueues ? t->bin : 0, s->cost,
+                      p->todo[k]};
+  }
+  if (plan)
+    qsort(picks, p->ntodo, sizeof(Pick), by_queue);
+  for (size_t k = 0; k < p->ntodo; k++)
+    p->todo[k] = picks[k].slot;
+  for (size_t k = 0, q = 0; q < (size_t)p->nqueues; q++) {
+    Queue *queue = &p->queues[q];
+    queue->items = p->todo + k;
+    for (; k < p->ntodo && picks[k].bin == (int)q; k++)
+      queue->load += picks[k].cost;
+    queue->tail = (size_t)(p->todo + k - queue->items);
+  }
+  free(picks);
+  return 1;
+}
+
+int isolate_run_tests(TestRunner *r, AstNode *program) {
+  if (!program || program->kind != AST_BLOCK)
+    return 1;
+  size_t count = program->data.block_or_group.count;
+  Pool p = {.r = r};
+  p.slots = calloc(count ? count : 1, sizeof(Slot));
+  p.todo = malloc((count ? count : 1) * sizeof(uint32_t));
+  if (!p.slots || !p.todo) {
+    free(p.slots);
+    free(p.todo);
+    return 0;
+  }
+  for (size_t i = 0; i < count; i++) {
+    AstNode *stmt = program->data.block_or_group.stmts[i];
+    if (!stmt || stmt->kind != AST_TEST_STMT || !test_in_shard(r, stmt))
+      continue;
+    Slot *s = &p.slots[p.nslots];
+    s->test = stmt;
+    s->cache = test_cache_check(r, stmt, &s->hash, &s->passed);
+    s->done = s->cache == 1;
+    if (!s->done)
+      p.todo[p.ntodo++] = (uint32_t)p.nslots;
+    p.nslots++;
+  }
+  if (!make_queues(&p)) {
+    free(p.slots);
+    free(p.todo);
+    free(p.queues);
+    return 0;
+  }
+
+  // Pipe de filho morto não pode derrubar o pai no write
+  struct sigaction ign = {.sa_handler = SIG_IGN};
+  sigemptyset(&ign.sa_mask);
+  sigaction(SIGPIPE, &ign, &p.old_pipe);
+  p.nworkers = r->isolate < (int)p.ntodo ? r->isolate : (int)p.ntodo;
+  p.workers = calloc(p.nworkers ? (size_t)p.nworkers : 1, sizeof(Worker));
+  int live = 0;
+  for (int j = 0; p.workers && j < p.nworkers; j++) {
+    p.workers[j] =
+        (Worker){.cmd = -1, .res = -1, .busy = IDLE, .queue = j % p.nqueues};
+    live += spawn(&p, &p.workers[j]);
+  }
+  int ok = !p.ntodo || live > 0;
+  if (ok) {
+    for (int j = 0; j < p.nworkers; j++)
+      if (p.workers[j].pid > 0)
+        assign(&p, &p.workers[j]);
+    flush_ready(&p); // os do cache antes do primeiro que roda
+    run_pool(&p);
+  }
+  sigaction(SIGPIPE, &p.old_pipe, NULL);
+
+  for (size_t i = 0; i < p.nslots; i++)
+    free(p.slots[i].text);
+  free(p.slots);
+  free(p.todo);
+  free(p.queues);
+  free(p.workers);
+  return ok;
+}
@@ -0,0 +1,19 @@
+// isolate.h — --isolate: cada test roda num processo filho, forkado do pai
+// já com o programa parseado. Test que derruba o processo sai como falha
+// e o filho é trocado por um novo; o resto da suíte nem percebe
+#ifndef ISOLATE_H
+#define ISOLATE_H
+
+#include "test_runner.h"
+
+// Sobe até r->isolate filhos (fork do estado atual: nada de reler nem
+// reparsear), distribui os tests de program que o cache não respondeu e
+// reporta tudo na ordem do fonte, como run_program_tests. Os filhos só
+// mandam o resultado por pipe; cache e totais ficam no pai. 0 se não deu
+// pra forkar nenhum filho — quem chama roda os tests aqui mesmo.
+// Com r->plan (--shards) cada filho tem a fila do seu shard e rouba dos
+// outros quando ela acaba; o tempo de cada test vem do filho pro
+// r->timings
+int isolate_run_tests(TestRunner *r, AstNode *program);
+
+#endif
@@ -0,0 +1,309 @@
+#include "pipeline.h"
+#include "eval.h"
+#include <string.h>
+
+typedef struct {
+  PipeTerminal terminal;
+  unsigned long long sum; // unsigned: soma dá a volta, igual à vetorial
+  long long count;
+  long long best; // min/max
+  int any, all;
+} Acc;
+
+static void acc_push(Acc *a, long long x) {
+  if (a->count == 0 || (a->terminal == PIPE_MIN && x < a->best) ||
+      (a->terminal == PIPE_MAX && x > a->best))
+    a->best = x;
+  a->sum += (unsigned long long)x;
+  a->count++;
+  a->any |= x != 0;
+  a->all &= x != 0;
+}
+
+static int acc_result(const Acc *a, Value *out) {
+  out->kind = VAL_INT;
+  switch (a->terminal) {
+  case PIPE_SUM:
+    out->scalar = (long long)a->sum;
+    return 1;
+  case PIPE_COUNT:
+    out->scalar = a->count;
+    return 1;
+  case PIPE_MIN:
+  case PIPE_MAX:
+    out->scalar = a->best;
+    return a->count > 0; // min/max de nada não existe
+  case PIPE_ANY:
+    out->scalar = a->any;
+    return 1;
+  case PIPE_ALL:
+    out->scalar = a->all;
+    return 1;
+  }
+  return 0;
+}
+
+// `it` vive num escopo de uma variável só, na pilha — por quê? Lookup acha
+// ele primeiro (pipeline aninhado sombreia o de fora) e não aloca nada
+typedef struct {
+  Scope scope;
+  Binding it;
+} ItScope;
+
+static void it_open(ItScope *s, const Scope *env) {
+  scope_open(&s->scope, (Scope *)env, NULL);
+  s->it = (Binding){.name = "it", .len = 2, .storage = BIND_STACK};
+  s->scope.vars = &s->it;
+}
+
+// 1: chegou no terminal com *x; 0: filtrado; -1: erro
+static int run_element(AstNode *pipe, ItScope *s, long long *x) {
+  s->it.value.kind = VAL_INT;
+  s->it.value.scalar = *x;
+  for (size_t i = 0; i < pipe->data.pipeline.count; i++) {
+    PipeStage *st = &pipe->data.pipeline.stages[i];
+    long long v;
+    if (!eval_i64(st->expr, &s->scope, &v))
+      return -1;
+    if (st->kind == PIPE_MAP)
+      s->it.value.scalar = v;
+    else if (!v)
+      return 0;
+  }
+  *x = s->it.value.scalar;
+  return 1;
+}
+
+static int push_element(AstNode *pipe, ItScope *s, long long x, Acc *acc) {
+  int r = run_element(pipe, s, &x);
+  if (r > 0)
+    acc_push(acc, x);
+  return r >= 0;
+}
+
+// Laço fundido de range: os estágios viram um programa de registradores,
+// cada registrador um bloco de PIPE_BLOCK elementos. Cada instrução roda
+// simd_array_op no bloco inteiro — o custo de interpretar sai uma vez por
+// bloco, não por elemento. Depois de um filter os vivos são compactados
+// (vetor de seleção), então estágio seguinte só vê elemento que o escalar
+// também veria: mesma semântica, inclusive divisão por zero
+#define PIPE_BLOCK 128
+#define PIPE_REGS 32
+#define PIPE_CODE 64
+
+typedef struct {
+  SimdOp op;
+  int dst, a, b;
+  int div; // divisor constante em Kernel.divs, ou -1
+} KInstr;
+
+typedef struct {
+  KInstr code[PIPE_CODE];
+  int ncode;
+  int nregs;
+  int stage_end[32]; // fim do código de cada estágio
+  int stage_reg[32]; // registrador com o resultado
+  long long consts[PIPE_REGS];
+  int is_const[PIPE_REGS];
+  SimdDivisor divs[PIPE_CODE];
+  int ndivs;
+} Kernel;
+
+static int binop_of(const Token *tok, SimdOp *op) {
+  char c = *tok->start;
+  if (tok->len == 2) {
+    if (tok->start[1] != '=')
+      return 0;
+    *op = c == '=' ? SIMD_EQ : c == '!' ? SIMD_NE : c == '<' ? SIMD_LE
+                                                              : SIMD_GE;
+    return c == '=' || c == '!' || c == '<' || c == '>';
+  }
+  switch (c) {
+  case '+':
+    *op = SIMD_ADD;
+    return 1;
+  case '-':
+    *op = SIMD_SUB;
+    return 1;
+  case '*':
+    *op = SIMD_MUL;
+    return 1;
+  case '/':
+    *op = SIMD_DIV;
+    return 1;
+  case '<':
+    *op = SIMD_LT;
+    return 1;
+  case '>':
+    *op = SIMD_GT;
+    return 1;
+  }
+  return 0;
+}
+
+static int const_reg(Kernel *k, long long value) {
+  for (int r = 1; r < k->nregs; r++)
+    if (k->is_const[r] && k->consts[r] == value)
+      return r;
+  if (k->nregs == PIPE_REGS)
+    return -1;
+  k->is_const[k->nregs] = 1;
+  k->consts[k->nregs] = value;
+  return k->nregs++;
+}
+
+// Registrador com o valor de e, ou -1 se não compila (chamada, vetor...)
+static int compile_expr(Kernel *k, const AstNode *e, const Scope *env) {
+  if (!e)
+    return -1;
+  switch (e->kind) {
+  case AST_NUMBER_LIT:
+    if (e->data.number.is_float)
+      return -1; // kernel é de inteiros: fica no caminho interpretado
+    return const_reg(k, e->data.number.value);
+  case AST_IDENT: {
+    if (e->data.ident.len == 2 && memcmp(e->data.ident.name, "it", 2) == 0)
+      return 0; // r0 é sempre `it`
+    // Variável de fora não muda durante o pipeline: vira constante
+    const Binding *b = scope_lookup(env, e->data.ident.name, e->data.ident.len);
+    if (!b || b->value.kind != VAL_INT)
+      return -1;
+    return const_reg(k, b->value.scalar);
+  }
+  case AST_UNARY_OP: {
+    int zero = const_reg(k, 0);
+    int x = compile_expr(k, e->data.unary.expr, env);
+    if (zero < 0 || x < 0 || k->nregs == PIPE_REGS || k->ncode == PIPE_CODE)
+      return -1;
+    k->code[k->ncode++] = (KInstr){SIMD_SUB, k->nregs, zero, x, -1};
+    return k->nregs++;
+  }
+  case AST_BIN_OP: {
+    SimdOp op;
+    if (!binop_of(&e->token, &op))
+      return -1;
+    int a = compile_expr(k, e->data.binop.left, env);
+    int b = compile_expr(k, e->data.binop.right, env);
+    if (a < 0 || b < 0 || k->nregs == PIPE_REGS || k->ncode == PIPE_CODE)
+      return -1;
+    KInstr in = {op, k->nregs, a, b, -1};
+    // x / 3 por multiplicação, como o compilador C faria; divisor zero
+    // fica no caminho geral, que falha igual ao escalar
+    if (op == SIMD_DIV && k->is_const[b] &&
+        simd_divisor_init(&k->divs[k->ndivs], k->consts[b]))
+      in.div = k->ndivs++;
+    k->code[k->ncode++] = in;
+    return k->nregs++;
+  }
+  default:
+    return -1;
+  }
+}
+
+static int compile_kernel(Kernel *k, AstNode *pipe, const Scope *env) {
+  memset(k, 0, sizeof(*k));
+  k->nregs = 1;
+  if (pipe->data.pipeline.count > 32)
+    return 0;
+  for (size_t i = 0; i < pipe->data.pipeline.count; i++) {
+    int r = compile_expr(k, pipe->data.pipeline.stages[i].expr, env);
+    if (r < 0)
+      return 0;
+    k->stage_reg[i] = r;
+    k->stage_end[i] = k->ncode;
+  }
+  return 1;
+}
+
+static void acc_block(Acc *acc, const int64_t *x, size_t n) {
+  switch (acc->terminal) {
+  case PIPE_SUM:
+    for (size_t i = 0; i < n; i++)
+      acc->sum += (unsigned long long)x[i];
+    acc->count += (long long)n;
+    return;
+  case PIPE_COUNT:
+    acc->count += (long long)n;
+    return;
+  default:
+    for (size_t i = 0; i < n; i++)
+      acc_push(acc, x[i]);
+  }
+}
+
+static int run_range_fused(AstNode *pipe, const Kernel *k, long long lo,
+                           long long hi, Acc *acc) {
+  _Alignas(32) int64_t regs[PIPE_REGS][PIPE_BLOCK];
+  for (int r = 1; r < k->nregs; r++)
+    if (k->is_const[r])
+      for (size_t i = 0; i < PIPE_BLOCK; i++)
+        regs[r][i] = k->consts[r];
+
+  size_t stages = pipe->data.pipeline.count;
+  unsigned long long total = (unsigned long long)hi - (unsigned long long)lo;
+  for (unsigned long long done = 0; done < total; done += PIPE_BLOCK) {
+    size_t n = total - done < PIPE_BLOCK ? (size_t)(total - done) : PIPE_BLOCK;
+    unsigned long long base = (unsigned long long)lo + done;
+    for (size_t i = 0; i < n; i++)
+      regs[0][i] = (int64_t)(base + i);
+
+    int pc = 0;
+    for (size_t s = 0; s < stages && n; s++) {
+      for (; pc < k->stage_end[s]; pc++) {
+        const KInstr *in = &k->code[pc];
+        if (in->div >= 0)
+          simd_array_div_by(regs[in->a], &k->divs[in->div], regs[in->dst], n);
+        else if (!simd_array_op(in->op, regs[in->a], regs[in->b], regs[in->dst],
+                           n))
+          return 0;
+      }
+      const int64_t *res = regs[k->stage_reg[s]];
+      if (pipe->data.pipeline.stages[s].kind == PIPE_MAP) {
+        if (res != regs[0])
+          memcpy(regs[0], res, n * sizeof(int64_t));
+        continue;
+      }
+      size_t kept = 0; // compacta sem desvio: escreve sempre, avança se vivo
+      for (size_t i = 0; i < n; i++) {
+        regs[0][kept] = regs[0][i];
+        kept += res[i] != 0;
+      }
+      n = kept;
+      pc = k->stage_end[s];
+    }
+    if (n)
+      acc_block(acc, regs[0], n);
+  }
+  return 1;
+}
+
+int eval_pipeline(AstNode *pipe, const Scope *env, Value *out) {
+  Value src;
+  if (!eval_expr(pipe->data.pipeline.source, env, &src))
+    return 0;
+
+  Acc acc = {.terminal = pipe->data.pipeline.terminal, .all = 1};
+
+  Kernel k;
+  if (src.kind == VAL_RANGE && src.lo < src.hi &&
+      compile_kernel(&k, pipe, env)) {
+    if (!run_range_fused(pipe, &k, src.lo, src.hi, &acc))
+      return 0;
+    return acc_result(&acc, out);
+  }
+
+  ItScope s;
+  it_open(&s, env);
+  if (src.kind == VAL_RANGE) {
+    for (long long x = src.lo; x < src.hi; x++)
+      if (!push_element(pipe, &s, x, &acc))
+        return 0;
+  } else if (src.kind == VAL_VEC) {
+    for (int i = 0; i < simd_lane_count(src.vec.type); i++)
+      if (!push_element(pipe, &s, simd_get(&src.vec, i), &acc))
+        return 0;
+  } else {
+    return 0;
+  }
+  return acc_result(&acc, out);
+}
@@ -0,0 +1,15 @@
+// pipeline.h
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "../../ast/ast.h"
+#include "scope.h"
+#include "value.h"
+
+// Roda `fonte | estágios | terminal` num laço só: cada elemento passa por
+// todos os estágios antes do próximo, sem coleção intermediária e sem
+// alocar. Fonte range com estágios só de aritmética e comparação compila
+// pra kernels SIMD sobre blocos; o resto anda elemento a elemento
+int eval_pipeline(AstNode *pipe, const Scope *env, Value *out);
+
+#endif
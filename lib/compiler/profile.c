@@ -0,0 +1,426 @@
+#define _DEFAULT_SOURCE // sigaction, setitimer, nanosleep
+#include "profile.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define PROF_MAX_DEPTH 32    // mais fundo que isso: "[...]" no topo
+#define PROF_RING 4096       // potência de 2; amostras entre duas drenagens
+#define PROF_DRAIN_NS 10000000L // 10 ms
+
+// Pilha viva de uma thread. Só a própria thread escreve; o handler roda na
+// mesma thread, então basta a ordem de escrita (release no depth)
+typedef struct {
+  const AstNode *frames[PROF_MAX_DEPTH];
+  _Atomic uint32_t depth; // pode passar de PROF_MAX_DEPTH: o resto não cabe
+} ThreadStack;
+
+// Uma amostra no anel. seq por slot — por quê? Handlers de várias threads
+// reservam, escrevem e publicam sem lock; o drenador só lê o que publicou
+typedef struct {
+  _Atomic uint64_t seq;
+  uint32_t depth;
+  const AstNode *frames[PROF_MAX_DEPTH];
+} ProfSample;
+
+typedef struct {
+  uint64_t hash, count;
+  size_t first; // em Profiler.frames
+  uint32_t depth;
+} StackCount;
+
+typedef struct {
+  const AstNode *test;
+  const char *file;
+} TestFile;
+
+struct Profiler {
+  int hz;
+  ProfSample *ring;
+  _Atomic uint64_t head;    // próximo slot a reservar (handlers)
+  uint64_t tail;            // próximo a drenar (só o drenador)
+  _Atomic uint64_t dropped; // anel cheio ou sem memória: amostra perdida
+  _Atomic int running;
+  pthread_t drainer;
+  int started;
+  struct sigaction old_action;
+  struct itimerval old_timer;
+  StackCount *stacks; // pilhas distintas, contadas
+  size_t nstacks, stacks_cap;
+  uint32_t *table; // índice + 1 em stacks; 0: vazio
+  size_t table_cap;
+  const AstNode **frames;
+  size_t nframes, frames_cap;
+  uint64_t samples;
+  TestFile *tests;
+  size_t ntests, tests_cap;
+};
+
+// TLS sem alocação: o handler lê direto daqui. Em executável (libmodal.a)
+// o acesso é um offset fixo, seguro dentro de handler de sinal
+static _Thread_local ThreadStack tls_stack;
+
+// O único estado global do compilador — por quê? Handler de sinal não
+// recebe argumento; é por aqui que ele acha o anel
+static _Atomic(Profiler *) active;
+
+static int grow(void **items, size_t *cap, size_t need, size_t size) {
+  if (need <= *cap)
+    return 1;
+  size_t n = *cap ? *cap : 64;
+  while (n < need)
+    n *= 2;
+  void *p = realloc(*items, n * size);
+  if (!p)
+    return 0;
+  *items = p;
+  *cap = n;
+  return 1;
+}
+
+// ----- pilha da thread -----
+
+void profile_reset(const AstNode *test) {
+  atomic_store_explicit(&tls_stack.depth, 0, memory_order_release);
+  if (test)
+    profile_push(test);
+}
+
+void profile_push(const AstNode *node) {
+  ThreadStack *s = &tls_stack;
+  uint32_t d = atomic_load_explicit(&s->depth, memory_order_relaxed);
+  if (d < PROF_MAX_DEPTH)
+    s->frames[d] = node;
+  atomic_store_explicit(&s->depth, d + 1, memory_order_release);
+}
+
+void profile_pop(void) {
+  ThreadStack *s = &tls_stack;
+  uint32_t d = atomic_load_explicit(&s->depth, memory_order_relaxed);
+  if (d)
+    atomic_store_explicit(&s->depth, d - 1, memory_order_release);
+}
+
+// ----- handler -----
+
+// Async-signal-safe: só atômicos lock-free e cópia de ponteiros
+static void record(Profiler *p, const ThreadStack *s) {
+  uint64_t pos = atomic_load_explicit(&p->head, memory_order_relaxed);
+  ProfSample *slot;
+  for (;;) {
+    slot = &p->ring[pos & (PROF_RING - 1)];
+    uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if (seq == pos) {
+      if (atomic_compare_exchange_weak_explicit(&p->head, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+        break;
+    } else if (seq < pos) { // o drenador ainda não leu a volta anterior
+      atomic_fetch_add_explicit(&p->dropped, 1, memory_order_relaxed);
+      return;
+    } else {
+      pos = atomic_load_explicit(&p->head, memory_order_relaxed);
+    }
+  }
+  uint32_t depth = atomic_load_explicit(&s->depth, memory_order_acquire);
+  uint32_t n = depth < PROF_MAX_DEPTH ? depth : PROF_MAX_DEPTH;
+  for (uint32_t i = 0; i < n; i++)
+    slot->frames[i] = s->frames[i];
+  slot->depth = depth;
+  atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+}
+
+static void on_sigprof(int sig) {
+  (void)sig;
+  int saved = errno;
+  Profiler *p = atomic_load_explicit(&active, memory_order_acquire);
+  if (p)
+    record(p, &tls_stack);
+  errno = saved;
+}
+
+// ----- drenagem -----
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t stack_hash(const AstNode *const *frames, uint32_t n,
+                           uint32_t depth) {
+  uint64_t h = FNV_OFFSET ^ depth;
+  for (uint32_t i = 0; i < n; i++) {
+    h ^= (uint64_t)(uintptr_t)frames[i];
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+static uint32_t kept(uint32_t depth) {
+  return depth < PROF_MAX_DEPTH ? depth : PROF_MAX_DEPTH;
+}
+
+static int same_stack(const Profiler *p, const StackCount *s,
+                      const AstNode *const *frames, uint32_t depth) {
+  return s->depth == depth &&
+         memcmp(p->frames + s->first, frames,
+                kept(depth) * sizeof(*frames)) == 0;
+}
+
+static int rehash(Profiler *p) {
+  size_t cap = p->table_cap ? p->table_cap * 2 : 256;
+  uint32_t *table = calloc(cap, sizeof(uint32_t));
+  if (!table)
+    return 0;
+  for (size_t i = 0; i < p->nstacks; i++) {
+    size_t at = p->stacks[i].hash & (cap - 1);
+    while (table[at])
+      at = (at + 1) & (cap - 1);
+    table[at] = (uint32_t)i + 1;
+  }
+  free(p->table);
+  p->table = table;
+  p->table_cap = cap;
+  return 1;
+}
+
+// Pilhas iguais viram uma linha com contagem: o arquivo final e a memória
+// crescem com pilhas distintas, não com tempo de execução
+static int count_stack(Profiler *p, const AstNode *const *frames,
+                       uint32_t depth) {
+  uint32_t n = kept(depth);
+  uint64_t h = stack_hash(frames, n, depth);
+  if ((p->nstacks + 1) * 2 > p->table_cap && !rehash(p))
+    return 0;
+  size_t at = h & (p->table_cap - 1);
+  for (; p->table[at]; at = (at + 1) & (p->table_cap - 1)) {
+    StackCount *s = &p->stacks[p->table[at] - 1];
+    if (s->hash == h && same_stack(p, s, frames, depth)) {
+      s->count++;
+      return 1;
+    }
+  }
+  if (p->nstacks >= UINT32_MAX - 1 ||
+      !grow((void **)&p->stacks, &p->stacks_cap, p->nstacks + 1,
+            sizeof(StackCount)) ||
+      !grow((void **)&p->frames, &p->frames_cap, p->nframes + n,
+            sizeof(*p->frames)))
+    return 0;
+  memcpy(p->frames + p->nframes, frames, n * sizeof(*frames));
+  p->stacks[p->nstacks] = (StackCount){h, 1, p->nframes, depth};
+  p->nframes += n;
+  p->table[at] = (uint32_t)++p->nstacks;
+  return 1;
+}
+
+static void drain(Profiler *p) {
+  for (;;) {
+    ProfSample *slot = &p->ring[p->tail & (PROF_RING - 1)];
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != p->tail + 1)
+      return;
+    if (count_stack(p, slot->frames, slot->depth))
+      p->samples++;
+    else
+      atomic_fetch_add_explicit(&p->dropped, 1, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, p->tail + PROF_RING,
+                          memory_order_release);
+    p->tail++;
+  }
+}
+
+static void *drainer_main(void *arg) {
+  Profiler *p = arg;
+  sigset_t set; // o drenador não é amostrado: nunca roda código Modal
+  sigemptyset(&set);
+  sigaddset(&set, SIGPROF);
+  pthread_sigmask(SIG_BLOCK, &set, NULL);
+  struct timespec wait = {0, PROF_DRAIN_NS};
+  while (atomic_load(&p->running)) {
+    drain(p);
+    nanosleep(&wait, NULL);
+  }
+  return NULL;
+}
+
+// ----- ciclo de vida -----
+
+Profiler *profiler_create(int hz) {
+  Profiler *p = calloc(1, sizeof(Profiler));
+  if (!p)
+    return NULL;
+  p->hz = hz > 0 ? hz : PROFILE_DEFAULT_HZ;
+  p->ring = malloc(PROF_RING * sizeof(ProfSample));
+  if (!p->ring || !rehash(p)) {
+    profiler_destroy(p);
+    return NULL;
+  }
+  for (uint64_t i = 0; i < PROF_RING; i++)
+    atomic_init(&p->ring[i].seq, i);
+  return p;
+}
+
+void profiler_destroy(Profiler *p) {
+  if (!p)
+    return;
+  if (p->started)
+    profiler_stop(p);
+  free(p->ring);
+  free(p->stacks);
+  free(p->table);
+  free((void *)p->frames);
+  free(p->tests);
+  free(p);
+}
+
+int profiler_add(Profiler *p, const AstNode *root, const char *file) {
+  if (!root || root->kind != AST_BLOCK)
+    return 1;
+  for (size_t i = 0; i < root->data.block_or_group.count; i++) {
+    const AstNode *stmt = root->data.block_or_group.stmts[i];
+    if (!stmt || stmt->kind != AST_TEST_STMT)
+      continue;
+    if (!grow((void **)&p->tests, &p->tests_cap, p->ntests + 1,
+              sizeof(TestFile)))
+      return 0;
+    p->tests[p->ntests++] = (TestFile){stmt, file};
+  }
+  return 1;
+}
+
+int profiler_start(Profiler *p) {
+  Profiler *none = NULL;
+  if (p->started ||
+      !atomic_compare_exchange_strong(&active, &none, p))
+    return 0;
+  atomic_store(&p->running, 1);
+  if (pthread_create(&p->drainer, NULL, drainer_main, p) != 0) {
+    atomic_store(&active, NULL);
+    return 0;
+  }
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_sigprof;
+  sa.sa_flags = SA_RESTART; // read/write dos tests não voltam com EINTR
+  sigemptyset(&sa.sa_mask);
+  long usec = 1000000L / p->hz;
+  struct itimerval timer = {{0, usec ? usec : 1}, {0, usec ? usec : 1}};
+  if (sigaction(SIGPROF, &sa, &p->old_action) != 0 ||
+      setitimer(ITIMER_PROF, &timer, &p->old_timer) != 0) {
+    atomic_store(&p->running, 0);
+    pthread_join(p->drainer, NULL);
+    atomic_store(&active, NULL);
+    return 0;
+  }
+  p->started = 1;
+  return 1;
+}
+
+void profiler_stop(Profiler *p) {
+  if (!p->started)
+    return;
+  setitimer(ITIMER_PROF, &p->old_timer, NULL);
+  sigaction(SIGPROF, &p->old_action, NULL);
+  atomic_store(&active, NULL);
+  atomic_store(&p->running, 0);
+  pthread_join(p->drainer, NULL);
+  drain(p); // o que chegou depois da última passada
+  p->started = 0;
+}
+
+void profiler_totals(const Profiler *p, uint64_t *samples, uint64_t *dropped) {
+  *samples = p->samples;
+  *dropped = atomic_load(&p->dropped);
+}
+
+// ----- saída -----
+
+static int by_test(const void *a, const void *b) {
+  uintptr_t x = (uintptr_t)((const TestFile *)a)->test;
+  uintptr_t y = (uintptr_t)((const TestFile *)b)->test;
+  return (x > y) - (x < y);
+}
+
+static const char *file_of(const TestFile *tests, size_t n,
+                           const AstNode *test) {
+  TestFile key = {test, NULL};
+  const TestFile *hit = n ? bsearch(&key, tests, n, sizeof(TestFile), by_test)
+                          : NULL;
+  return hit ? hit->file : "?";
+}
+
+// ';' separa frames e '\n' separa pilhas no formato: no nome viram ',' e ' '
+static void put_name(FILE *out, const char *name, size_t len) {
+  for (size_t i = 0; i < len; i++)
+    fputc(name[i] == ';' ? ',' : name[i] == '\n' ? ' ' : name[i], out);
+}
+
+static void put_frame(FILE *out, const AstNode *n, const char *file) {
+  const Token *t = &n->token;
+  switch (n->kind) {
+  case AST_TEST_STMT:
+    fputs("test \"", out);
+    put_name(out, n->data.test.name, n->data.test.len);
+    fprintf(out, "\" (%s:%d)", file, t->line);
+    return;
+  case AST_BLOCK:
+    fputs("{}", out);
+    break;
+  case AST_ASSERT_STMT:
+    fputs("assert", out);
+    break;
+  case AST_VAR_DECL:
+    put_name(out, n->data.var.name, n->data.var.len);
+    fputs(" =", out);
+    break;
+  case AST_CALL:
+    put_name(out, n->data.call.name, n->data.call.len);
+    fputs("()", out);
+    break;
+  case AST_DEFER_STMT:
+    fputs("defer", out);
+    break;
+  case AST_ASYNC_BLOCK:
+    fputs("async", out);
+    break;
+  case AST_AWAIT_STMT:
+    fputs("await", out);
+    break;
+  default:
+    fputs("?", out);
+    break;
+  }
+  fprintf(out, " (%s:%d:%d)", file, t->line, t->col);
+}
+
+int profiler_write(const Profiler *p, FILE *out) {
+  TestFile *tests = NULL;
+  if (p->ntests) {
+    tests = malloc(p->ntests * sizeof(TestFile));
+    if (!tests)
+      return 0;
+    memcpy(tests, p->tests, p->ntests * sizeof(TestFile));
+    qsort(tests, p->ntests, sizeof(TestFile), by_test);
+  }
+  for (size_t i = 0; i < p->nstacks; i++) {
+    const StackCount *s = &p->stacks[i];
+    const AstNode *const *frames = p->frames + s->first;
+    if (!s->depth) {
+      fputs("[runner]", out); // fora de test: scheduler, saída, workers ociosos
+    } else {
+      const char *file = file_of(tests, p->ntests, frames[0]);
+      for (uint32_t f = 0; f < kept(s->depth); f++) {
+        if (f)
+          fputc(';', out);
+        put_frame(out, frames[f], file);
+      }
+      if (s->depth > PROF_MAX_DEPTH)
+        fputs(";[...]", out);
+    }
+    fprintf(out, " %llu\n", (unsigned long long)s->count);
+  }
+  free(tests);
+  return !ferror(out);
+}
@@ -0,0 +1,52 @@
+// profile.h — --profile: amostra por SIGPROF a pilha de test/bloco/statement
+// em execução e grava no formato "collapsed" dos flamegraphs
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "../../ast/ast.h"
+#include "scope.h"
+#include <stdio.h>
+
+#define PROFILE_DEFAULT_PATH "modal-profile.folded"
+#define PROFILE_DEFAULT_HZ 997 // primo: não anda no passo de nenhum loop
+
+typedef struct Profiler Profiler; // profile.c
+
+// Anel de amostras e tabelas pré-alocados aqui: o handler de sinal só
+// escreve no anel; um thread drenador junta as pilhas iguais enquanto os
+// tests rodam. hz <= 0 usa PROFILE_DEFAULT_HZ. NULL sem memória
+Profiler *profiler_create(int hz);
+void profiler_destroy(Profiler *p);
+
+// Tests de root vêm de file — pro rótulo de cada frame. 0 sem memória
+int profiler_add(Profiler *p, const AstNode *root, const char *file);
+
+// Liga o timer (ITIMER_PROF: tempo de CPU do processo, todas as threads) e
+// o drenador. Um profiler ligado por processo. 0 se não ligou
+int profiler_start(Profiler *p);
+// Desliga, devolve o handler anterior e drena o que sobrou
+void profiler_stop(Profiler *p);
+
+// Uma linha por pilha distinta, "test;bloco;statement contagem", pro
+// flamegraph.pl e afins. As ASTs ainda têm que estar vivas. 0 se não gravou
+int profiler_write(const Profiler *p, FILE *out);
+// Amostras juntadas e perdidas (anel cheio)
+void profiler_totals(const Profiler *p, uint64_t *samples, uint64_t *dropped);
+
+// Pilha da thread atual, que o handler lê — por quê por thread? SIGPROF
+// interrompe a thread que estava gastando CPU, e é a pilha dela que vale
+void profile_reset(const AstNode *test); // NULL: thread fora de test
+void profile_push(const AstNode *node);
+void profile_pop(void);
+
+static inline void prof_enter(const TestEnv *env, const AstNode *node) {
+  if (env && env->profile)
+    profile_push(node);
+}
+
+static inline void prof_leave(const TestEnv *env) {
+  if (env && env->profile)
+    profile_pop();
+}
+
+#endif
@@ -0,0 +1,554 @@
+#define _DEFAULT_SOURCE // realpath
+#include "program.h"
+#include "eval.h"
+#include "source.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+  char *name;  // como está no use, sem aspas
+  Token where; // o STRING do use, pra erro de import
+  Module *mod;
+} ModuleDep;
+
+struct Module {
+  char *path;       // relativo ao cwd, como nos diagnósticos
+  char *key;        // realpath: identidade no grafo e nome da interface
+  char *iface_path; // NULL sem iface_dir
+  char *source;     // os tokens da AST apontam pra cá
+  long len;
+  uint64_t source_hash;
+  ModuleDep *deps;
+  size_t ndeps;
+  ModuleIface iface; // do disco ou refeita no parse
+  int from_disk;     // iface do disco, do mesmo fonte: deps vieram dela
+  int fresh;         // from_disk e os imports exportam o mesmo de antes
+  int mark;          // busca em profundidade: 0 novo, 1 na pilha, 2 pronto
+  int wave;          // 1 + a maior onda dos imports
+  int failed;        // erro aqui ou num import: não parseia nem roda
+  AstNode *root;     // NULL se não foi parseado
+  Diagnostics diag;
+  StrPool strings; // do módulo: parses da mesma onda não dividem pool
+  AstIntern shared; // --hash-cons: nós divididos da root, idem por módulo
+  TypeTable types;  // tipo de cada expressão da root (ast/types.h)
+};
+
+static int is_module_name(const char *name, size_t len) {
+  return len > 6 && memcmp(name + len - 6, ".modal", 6) == 0;
+}
+
+// Erro do grafo (import ilegível ou circular) no use de quem importa; a
+// linha sai do próprio fonte, que está inteiro em memória
+static void graph_error(Module *m, Token where, const char *fmt, ...) {
+  const char *line = m->source + where.offset;
+  const char *end = line;
+  while (line > m->source && line[-1] != '\n')
+    line--;
+  while (*end && *end != '\n')
+    end++;
+
+  va_list args;
+  va_start(args, fmt);
+  diag_report(&m->diag, DIAG_ERROR, &where, line, (int)(end - line), fmt,
+              args);
+  va_end(args);
+  m->failed = 1;
+}
+
+// ----- descoberta -----
+
+static int add_dep(Module *m, const char *name, size_t len, Token where) {
+  ModuleDep *deps = realloc(m->deps, (m->ndeps + 1) * sizeof(ModuleDep));
+  if (!deps)
+    return 0;
+  m->deps = deps;
+  char *copy = malloc(len + 1);
+  if (!copy)
+    return 0;
+  memcpy(copy, name, len);
+  copy[len] = '\0';
+  m->deps[m->ndeps++] = (ModuleDep){.name = copy, .where = where};
+  return 1;
+}
+
+// Interface do disco com o mesmo fonte: os imports estão nela
+static int deps_from_iface(Module *m) {
+  for (size_t i = 0; i < m->iface.ndeps; i++) {
+    const IfaceDep *d = &m->iface.deps[i];
+    const char *name = m->iface.strings + d->name.off;
+    if (d->offset < 0 || d->offset + d->name.len + 2 > m->len)
+      return 0;
+    Token where = {.kind = STRING,
+                   .start = m->source + d->offset,
+                   .len = (int)d->name.len + 2,
+                   .line = d->line,
+                   .col = d->col,
+                   .offset = d->offset};
+    if (!add_dep(m, name, d->name.len, where))
+      return 0;
+  }
+  return 1;
+}
+
+// Só o léxico — por quê? Achar os use não precisa de parse, e o parse de
+// verdade espera os imports terminarem
+static int deps_from_scan(const Program *g, Module *m) {
+  Tokenizer lexer;
+  init(&lexer, m->source, g->opts.alloc);
+  int ok = 1;
+  for (Token t = next(&lexer); ok && t.kind != TOK_EOF; t = next(&lexer)) {
+    if (t.kind != USE)
+      continue;
+    t = next(&lexer);
+    if (t.kind == STRING && is_module_name(t.start + 1, (size_t)t.len - 2))
+      ok = add_dep(m, t.start + 1, (size_t)t.len - 2, t);
+    if (t.kind == TOK_EOF)
+      break;
+  }
+  tokenizer_free_lexemes(g->opts.alloc, lexer.lexemes);
+  return ok;
+}
+
+static Module *find_key(const Program *g, const char *key) {
+  for (size_t i = 0; i < g->count; i++)
+    if (strcmp(g->modules[i]->key, key) == 0)
+      return g->modules[i];
+  return NULL;
+}
+
+static char *iface_path(const char *dir, const char *key) {
+  size_t len = strlen(dir) + 1 + 16 + 3 + 1;
+  char *path = malloc(len);
+  if (path)
+    snprintf(path, len, "%s/%016llx.mi", dir,
+             (unsigned long long)ast_hash_bytes(key, strlen(key)));
+  return path;
+}
+
+// path e key passam a ser do módulo, mesmo se falhar
+static Module *new_module(Program *g, char *path, char *key) {
+  Module *m = calloc(1, sizeof(Module));
+  if (m && g->count == g->cap) {
+    size_t cap = g->cap ? g->cap * 2 : 16;
+    Module **mods = realloc(g->modules, cap * sizeof(Module *));
+    if (mods) {
+      g->modules = mods;
+      g->cap = cap;
+    }
+  }
+  if (!m || g->count == g->cap) {
+    free(m);
+    free(path);
+    free(key);
+    return NULL;
+  }
+  m->path = path;
+  m->key = key;
+  iface_init(&m->iface);
+  strpool_init(&m->strings, g->opts.alloc);
+  ast_intern_init(&m->shared, g->opts.alloc);
+  types_init(&m->types, g->opts.alloc);
+  diag_init(&m->diag, g->opts.alloc, path, g->opts.max_errors);
+  g->modules[g->count++] = m;
+  return m;
+}
+
+static char *join_dir(const char *from, const char *name) {
+  const char *slash = strrchr(from, '/');
+  size_t dir = slash && name[0] != '/' ? (size_t)(slash - from + 1) : 0;
+  size_t len = strlen(name);
+  char *path = malloc(dir + len + 1);
+  if (path) {
+    memcpy(path, from, dir);
+    memcpy(path + dir, name, len + 1);
+  }
+  return path;
+}
+
+// Os #include e use "x.h" que o módulo leu da última vez continuam iguais?
+static int files_unchanged(const ModuleIface *iface) {
+  for (size_t i = 0; i < iface->nfiles; i++) {
+    long len = 0;
+    char *text = source_read(iface->strings + iface->files[i].path.off, &len);
+    int same = text && ast_hash_bytes(text, (size_t)len) == iface->files[i].hash;
+    free(text);
+    if (!same)
+      return 0;
+  }
+  return 1;
+}
+
+// Profundidade primeiro; path passa a ser do grafo. NULL se o módulo não
+// existe (erro no use de from) ou se fechou um ciclo
+static Module *visit(Program *g, char *path, Module *from, Token where) {
+  char *key = path ? realpath(path, NULL) : NULL;
+  char *source = NULL;
+  long len = 0;
+  Module *m = key ? find_key(g, key) : NULL;
+  if (!m && key)
+    source = source_read(key, &len);
+
+  if (m) {
+    free(path);
+    free(key);
+    if (m->mark == 1) {
+      graph_error(from, where, "import circular: %s já está na cadeia de "
+                               "imports",
+                  m->path);
+      return NULL;
+    }
+    return m;
+  }
+  if (!source) {
+    if (from && path)
+      graph_error(from, where, "não consegui ler o módulo %s", path);
+    else if (from)
+      from->failed = 1;
+    free(path);
+    free(key);
+    return NULL;
+  }
+
+  m = new_module(g, path, key);
+  if (!m) {
+    free(source);
+    if (from)
+      from->failed = 1;
+    return NULL;
+  }
+  m->source = source;
+  m->len = len;
+  m->source_hash = ast_hash_bytes(source, (size_t)len);
+  m->mark = 1;
+
+  if (g->opts.iface_dir) {
+    m->iface_path = iface_path(g->opts.iface_dir, m->key);
+    m->from_disk = m->iface_path && iface_read(&m->iface, m->iface_path) &&
+                   m->iface.source_hash == m->source_hash &&
+                   files_unchanged(&m->iface);
+  }
+  int ok = m->from_disk ? deps_from_iface(m) : deps_from_scan(g, m);
+  if (!ok)
+    m->failed = 1; // sem memória
+
+  for (size_t i = 0; ok && i < m->ndeps; i++) {
+    ModuleDep *d = &m->deps[i];
+    d->mod = visit(g, join_dir(m->path, d->name), m, d->where);
+    if (!d->mod || d->mod->failed)
+      m->failed = 1;
+    else if (d->mod->wave + 1 > m->wave)
+      m->wave = d->mod->wave + 1;
+  }
+  m->mark = 2;
+  return m;
+}
+
+// ----- parse -----
+
+static const ModuleIface *find_dep(void *modules, const char *name,
+                                   size_t len) {
+  Module *m = modules;
+  for (size_t i = 0; i < m->ndeps; i++)
+    if (m->deps[i].mod && strlen(m->deps[i].name) == len &&
+        memcmp(m->deps[i].name, name, len) == 0)
+      return &m->deps[i].mod->iface;
+  return NULL;
+}
+
+static int tests_cached(const Program *g, const Module *m) {
+  const TestCache *cache = g->opts.cache;
+  if (!cache || cache->refresh)
+    return 0;
+  for (size_t i = 0; i < m->iface.ntests; i++) {
+    int passed;
+    if (m->iface.tests[i].native ||
+        !test_cache_lookup(cache, m->iface.tests[i].hash, &passed))
+      return 0;
+  }
+  return 1;
+}
+
+static int needs_parse(const Program *g, Module *m) {
+  m->fresh = m->from_disk;
+  for (size_t i = 0; m->fresh && i < m->ndeps; i++)
+    m->fresh = m->deps[i].mod->iface.export_hash ==
+               m->iface.deps[i].export_hash;
+  return !m->fresh || (g->opts.parse_root && m == g->root) ||
+         g->opts.parse_all || !tests_cached(g, m);
+}
+
+// Roda numa thread da onda: só lê as interfaces dos imports (ondas
+// anteriores) e escreve no próprio módulo
+static void parse_module(Program *g, Module *m) {
+  const ModalAllocator *a = g->opts.alloc;
+  Tokenizer lexer;
+  init(&lexer, m->source, a);
+  Parser parser;
+  parser_init(&parser, &lexer, m->path);
+  parser.diag.max_errors = g->opts.max_errors;
+  parser.natives = g->opts.natives;
+  parser.find_module = find_dep;
+  parser.modules = m;
+  parser.includes = &g->includes;
+  parser.strings = &m->strings;
+  parser.types = &m->types;
+  FileDeps files = {0};
+  parser.deps = &files;
+  AstNode *root = parse_program(&parser);
+  tokenizer_free_lexemes(a, lexer.lexemes);
+
+  diag_free(&m->diag);
+  m->diag = parser.diag;
+  if (parser.had_error || !root) {
+    ast_free(a, root);
+    // Interface de módulo com erro nunca é gravada; os arquivos entram só
+    // pro --watch, que observa o #include onde o erro pode estar
+    if (!files.incomplete)
+      iface_add_files(&m->iface, &files);
+    file_deps_free(&files);
+    m->failed = 1;
+    return;
+  }
+  eval_fold_constants(a, root); // o hash dos tests na interface é o do runner
+  if (g->opts.hash_cons) {
+    m->shared.types = &m->types;
+    ast_intern_program(&m->shared, root); // depois do fold: dobrado não divide
+  }
+  m->root = root;
+
+  ModuleIface iface;
+  iface_init(&iface);
+  int ok = iface_build(&iface, root, m->source_hash);
+  for (size_t i = 0; ok && i < m->ndeps; i++) {
+    const ModuleDep *d = &m->deps[i];
+    ok = iface_add_dep(&iface, d->name, strlen(d->name), d->where,
+                       d->mod->iface.export_hash);
+  }
+  ok = ok && !files.incomplete && iface_add_files(&iface, &files);
+  file_deps_free(&files);
+  if (!ok) { // sem memória: sem interface nova, dependente leria a velha
+    iface_free(&iface);
+    m->failed = 1;
+    return;
+  }
+  iface_free(&m->iface);
+  m->iface = iface;
+  if (m->iface_path && !m->fresh)
+    iface_write(&m->iface, m->iface_path); // falhar só custa um reparse
+}
+
+typedef struct {
+  Program *g;
+  Module **list;
+  size_t count;
+  atomic_size_t next;
+} Wave;
+
+static void *wave_worker(void *arg) {
+  Wave *w = arg;
+  size_t i;
+  while ((i = atomic_fetch_add(&w->next, 1)) < w->count)
+    parse_module(w->g, w->list[i]);
+  return NULL;
+}
+
+static void run_wave(Program *g, Module **list, size_t count) {
+  Wave w = {.g = g, .list = list, .count = count};
+  atomic_init(&w.next, 0);
+
+  long threads = g->opts.threads;
+  if (threads <= 0)
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads > (long)count)
+    threads = (long)count;
+  pthread_t *tids = threads > 1 ? malloc((size_t)(threads - 1) *
+                                         sizeof(pthread_t))
+                                : NULL;
+  long started = 0;
+  for (; tids && started < threads - 1; started++)
+    if (pthread_create(&tids[started], NULL, wave_worker, &w) != 0)
+      break; // segue com menos threads
+  wave_worker(&w); // quem chama também trabalha
+  for (long i = 0; i < started; i++)
+    pthread_join(tids[i], NULL);
+  free(tids);
+}
+
+int program_load(Program *prog, const char *path, const ProgramOptions *opts) {
+  *prog = (Program){.opts = *opts};
+  include_cache_init(&prog->includes);
+  Program *g = prog;
+  if (opts->iface_dir)
+    mkdir(opts->iface_dir, 0777); // já existir é o caso comum
+
+  size_t len = strlen(path);
+  char *copy = malloc(len + 1);
+  if (copy)
+    memcpy(copy, path, len + 1);
+  g->root = visit(g, copy, NULL, (Token){0});
+  if (!g->root) {
+    g->error_count = 1;
+    return 0;
+  }
+
+  int max_wave = 0;
+  for (size_t i = 0; i < g->count; i++)
+    if (g->modules[i]->wave > max_wave)
+      max_wave = g->modules[i]->wave;
+
+  Module **list = malloc(g->count * sizeof(Module *));
+  for (int wave = 0; list && wave <= max_wave; wave++) {
+    size_t n = 0;
+    for (size_t i = 0; i < g->count; i++) {
+      Module *m = g->modules[i];
+      if (m->wave != wave || m->failed)
+        continue;
+      for (size_t j = 0; j < m->ndeps && !m->failed; j++)
+        m->failed = m->deps[j].mod->failed; // import quebrou nesta rodada
+      if (!m->failed && needs_parse(g, m))
+        list[n++] = m;
+    }
+    run_wave(g, list, n);
+  }
+  if (!list)
+    g->root->failed = 1;
+  free(list);
+
+  // Ordem de onda (estável): dependência sempre antes de quem importa
+  for (size_t i = 1; i < g->count; i++) {
+    Module *m = g->modules[i];
+    size_t j = i;
+    for (; j > 0 && g->modules[j - 1]->wave > m->wave; j--)
+      g->modules[j] = g->modules[j - 1];
+    g->modules[j] = m;
+  }
+
+  int failed = 0;
+  for (size_t i = 0; i < g->count; i++) {
+    g->error_count += (int)g->modules[i]->diag.error_count;
+    failed |= g->modules[i]->failed;
+  }
+  if (failed && !g->error_count)
+    g->error_count = 1; // sem memória no meio do caminho
+  return !failed;
+}
+
+AstNode *program_root(const Program *prog) {
+  return prog->root ? prog->root->root : NULL;
+}
+
+void program_render(const Program *prog, FILE *out, int json) {
+  if (json) {
+    const Diagnostics **ds = malloc((prog->count + 1) * sizeof(*ds));
+    if (!ds)
+      return;
+    for (size_t i = 0; i < prog->count; i++)
+      ds[i] = &prog->modules[i]->diag;
+    diag_render_json_many(ds, prog->count, out);
+    free(ds);
+    return;
+  }
+  for (size_t i = 0; i < prog->count; i++) {
+    const Diagnostics *d = &prog->modules[i]->diag;
+    if (d->count || d->dropped)
+      diag_render(d, out);
+  }
+}
+
+void program_run_tests(Program *prog, TestRunner *r) {
+  FILE *out = r->out ? r->out : stdout;
+  begin_tests(r);
+  for (size_t i = 0; i < prog->count; i++) {
+    Module *m = prog->modules[i];
+    if (m->failed || !m->iface.ntests)
+      continue;
+    if (prog->count > 1)
+      fprintf(out, "── %s\n", m->path);
+    if (m->root) {
+      r->types = m->types.nodes;
+      run_program_tests(r, m->root);
+      continue;
+    }
+    for (size_t t = 0; t < m->iface.ntests; t++) {
+      const IfaceTest *test = &m->iface.tests[t];
+      int passed = 0;
+      test_cache_use(r->cache, test->hash, &passed); // needs_parse viu
+      if (r->timings)
+        timings_store(r->timings, test->hash, 0);
+      report_test_result(r, m->iface.strings + test->name.off, test->name.len,
+                         passed, "cached");
+    }
+  }
+}
+
+int program_cover(Program *prog, Coverage *cov) {
+  for (size_t i = 0; i < prog->count; i++) {
+    Module *m = prog->modules[i];
+    if (m->root &&
+        !coverage_add(cov, m->root, m->path, m->source, (size_t)m->len))
+      return 0;
+  }
+  return 1;
+}
+
+int program_profile(Program *prog, Profiler *prof) {
+  for (size_t i = 0; i < prog->count; i++) {
+    Module *m = prog->modules[i];
+    if (m->root && !profiler_add(prof, m->root, m->path))
+      return 0;
+  }
+  return 1;
+}
+
+int program_shard(Program *prog, ShardPlan *plan, const TestTimings *timings,
+                  const TestCache *cache) {
+  for (size_t i = 0; i < prog->count; i++) {
+    Module *m = prog->modules[i];
+    if (m->root && !shard_add(plan, m->root, timings, cache))
+      return 0;
+  }
+  return 1;
+}
+
+void program_files(const Program *prog,
+                   void (*fn)(void *ctx, const char *path), void *ctx) {
+  for (size_t i = 0; i < prog->count; i++) {
+    const Module *m = prog->modules[i];
+    fn(ctx, m->path);
+    for (size_t f = 0; f < m->iface.nfiles; f++)
+      fn(ctx, m->iface.strings + m->iface.files[f].path.off);
+  }
+}
+
+void program_intern_stats(const Program *prog, AstInternStats *stats) {
+  for (size_t i = 0; i < prog->count; i++)
+    ast_intern_stats(&prog->modules[i]->shared, stats);
+}
+
+void program_free(Program *prog) {
+  for (size_t i = 0; i < prog->count; i++) {
+    Module *m = prog->modules[i];
+    ast_free(prog->opts.alloc, m->root);
+    ast_intern_free(&m->shared); // depois da árvore, que aponta pra cá
+    types_free(&m->types);
+    strpool_free(&m->strings);
+    diag_free(&m->diag);
+    iface_free(&m->iface);
+    for (size_t j = 0; j < m->ndeps; j++)
+      free(m->deps[j].name);
+    free(m->deps);
+    free(m->source);
+    free(m->path);
+    free(m->key);
+    free(m->iface_path);
+    free(m);
+  }
+  free(prog->modules);
+  include_cache_free(&prog->includes); // depois das ASTs, que apontam pra cá
+  *prog = (Program){0};
+}
@@ -0,0 +1,80 @@
+// program.h — programa de vários arquivos ligados por use "x.modal"
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include "../../ast/iface.h"
+#include "../../ast/intern.h"
+#include "../../ast/preproc.h"
+#include "../runtime/ffi.h"
+#include "coverage.h"
+#include "profile.h"
+#include "test_runner.h"
+#include <stdio.h>
+
+#define PROGRAM_IFACE_DIR ".modal-iface"
+
+typedef struct Module Module;
+
+typedef struct {
+  const ModalAllocator *alloc; // thread-safe se threads != 1
+  const NativeLibs *natives;   // pros use "foo.h" de qualquer módulo
+  size_t max_errors;           // por módulo; 0 = sem limite
+  int threads;                 // parse da mesma onda em paralelo (0 = CPUs)
+  const char *iface_dir;       // NULL: não lê nem grava interface
+  const TestCache *cache;      // módulo intacto com os tests todos aqui
+                               // nem é parseado
+  int parse_root;              // parseia o root mesmo intacto (--layout-report)
+  int hash_cons;               // expressões repetidas viram um nó (intern.h)
+  int parse_all; // parseia até módulo intacto: --shard planeja pelo AST
+} ProgramOptions;
+
+typedef struct {
+  ProgramOptions opts;
+  Module **modules; // dependências antes de quem importa; root no fim
+  size_t count, cap;
+  Module *root;
+  int error_count;
+  IncludeCache includes; // um #include lido uma vez pra todos os módulos
+} Program;
+
+// Lê path, segue os use "x.modal" (relativos ao arquivo que importa) e
+// parseia em ondas: cada onda só depende das anteriores, então seus módulos
+// parseiam juntos. Módulo cujo fonte e imports não mudaram desde a última
+// interface em iface_dir não é relexado pra achar os imports, e nem
+// parseado se os tests dele já estão no cache. 0 com erro: error_count e
+// program_render dizem quais; path ilegível deixa count em 0
+int program_load(Program *prog, const char *path, const ProgramOptions *opts);
+
+// AST do root; NULL se veio inteiro da interface
+AstNode *program_root(const Program *prog);
+
+// Diagnósticos de todos os módulos, cada um com o próprio arquivo
+void program_render(const Program *prog, FILE *out, int json);
+
+// Um cabeçalho e os tests de todos os módulos, dependências primeiro; test
+// de módulo não parseado sai do cache pelo hash da interface
+void program_run_tests(Program *prog, TestRunner *r);
+
+// Slots de cobertura pros tests de todos os módulos parseados (carregue sem
+// cache nem interface pra parsear todos). 0 sem memória
+int program_cover(Program *prog, Coverage *cov);
+// Idem pro --profile: de que arquivo vem cada test
+int program_profile(Program *prog, Profiler *prof);
+
+// Tests de todos os módulos parseados no plano do --shard (shard_add;
+// cache NULL planeja como se nada estivesse no cache)
+int program_shard(Program *prog, ShardPlan *plan, const TestTimings *timings,
+                  const TestCache *cache);
+
+// Fonte de cada módulo e os arquivos que o parse dele leu (#include, use
+// "x.h"), um por chamada — pro --watch saber o que observar. Módulo com erro
+// de parse também: o erro pode estar no #include
+void program_files(const Program *prog,
+                   void (*fn)(void *ctx, const char *path), void *ctx);
+
+// --hash-cons: soma as tabelas dos módulos parseados em stats
+void program_intern_stats(const Program *prog, AstInternStats *stats);
+
+void program_free(Program *prog);
+
+#endif
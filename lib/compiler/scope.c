@@ -0,0 +1,186 @@
+#include "scope.h"
+#include "coverage.h"
+#include "eval.h"
+#include "format.h"
+#include "profile.h"
+#include <stdlib.h>
+#include <string.h>
+
+void scope_open(Scope *s, Scope *parent, RegionPool *pool) {
+  s->parent = parent;
+  s->vars = NULL;
+  s->defers = NULL;
+  s->env = parent ? parent->env : NULL;
+  region_open(&s->region, pool);
+}
+
+static Binding *find(Scope *s, const char *name, size_t len) {
+  for (; s; s = s->parent)
+    for (Binding *b = s->vars; b; b = b->next)
+      if (b->len == len && memcmp(b->name, name, len) == 0)
+        return b;
+  return NULL;
+}
+
+const Binding *scope_lookup(const Scope *s, const char *name, size_t len) {
+  return find((Scope *)s, name, len);
+}
+
+static Binding *new_binding(Scope *s, const AstNode *decl) {
+  Binding *b;
+  BindStorage storage;
+  if (!decl->data.var.autofree) {
+    b = malloc(sizeof(Binding));
+    storage = BIND_HEAP;
+  } else if (decl->data.var.slot >= 0) {
+    b = &s->slots[decl->data.var.slot];
+    storage = BIND_STACK;
+  } else {
+    b = region_alloc(&s->region, sizeof(Binding));
+    storage = BIND_REGION;
+  }
+  if (!b)
+    return NULL;
+  b->name = decl->data.var.name;
+  b->len = decl->data.var.len;
+  b->storage = storage;
+  b->next = s->vars;
+  s->vars = b;
+  return b;
+}
+
+static int bind(Scope *s, const AstNode *decl, const Value *value) {
+  // `x = e` reatribui se x já existe; autofree sempre declara no escopo atual
+  Binding *b = decl->data.var.autofree
+                   ? NULL
+                   : find(s, decl->data.var.name, decl->data.var.len);
+  if (!b)
+    b = new_binding(s, decl);
+  if (!b)
+    return 0;
+  b->value = *value;
+  return 1;
+}
+
+static int push_defer(Scope *s, AstNode *stmt) {
+  DeferEntry *d = region_alloc(&s->region, sizeof(DeferEntry));
+  if (!d)
+    return 0;
+  d->stmt = stmt;
+  d->next = s->defers;
+  s->defers = d;
+  return 1;
+}
+
+static int exec_block(Scope *parent, AstNode *block) {
+  Scope s;
+  scope_open(&s, parent, parent->region.pool);
+  int ok = 1;
+  for (size_t i = 0; ok && i < block->data.block_or_group.count; i++)
+    ok = scope_exec(&s, block->data.block_or_group.stmts[i]);
+  return scope_exit(&s) && ok;
+}
+
+// Só aqui a mensagem vira texto: assert que passa não paga nada por ela
+static void note_failure(Scope *s, const AstNode *stmt) {
+  AssertNote *note = s->env->note;
+  if (atomic_exchange(&note->taken, 1))
+    return;
+  note->len = format_render(stmt->data.unary.message, s, note->buf, note->cap);
+  note->line = stmt->token.line;
+}
+
+static int exec_stmt(Scope *s, AstNode *stmt) {
+  switch (stmt->kind) {
+  case AST_ASSERT_STMT:
+    if (eval_assert(stmt->data.unary.expr, s))
+      return 1;
+    cov_hit(s->env, stmt->cov ? stmt->cov + 1 : 0); // o ramo da falha
+    if (stmt->data.unary.message && s->env && s->env->note)
+      note_failure(s, stmt);
+    return 0;
+  case AST_VAR_DECL: {
+    Value value;
+    if (!eval_expr(stmt->data.var.init, s, &value))
+      return 0;
+    return bind(s, stmt, &value);
+  }
+  case AST_DEFER_STMT:
+    return push_defer(s, stmt->data.unary.expr);
+  case AST_BLOCK:
+    return exec_block(s, stmt);
+  case AST_CALL: { // chamada solta roda pelo efeito (função C void etc.)
+    Value ignored;
+    return eval_expr(stmt, s, &ignored);
+  }
+  default:
+    return 1; // expressão solta não tem efeito
+  }
+}
+
+int scope_exec(Scope *s, AstNode *stmt) {
+  if (!stmt)
+    return 1;
+  cov_hit(s->env, stmt->cov);
+  prof_enter(s->env, stmt);
+  int ok = exec_stmt(s, stmt);
+  prof_leave(s->env);
+  return ok;
+}
+
+int scope_exit(Scope *s) {
+  int ok = 1;
+  // Registro sai da lista antes de rodar — por quê? O defer pode registrar
+  // outro defer no mesmo escopo, que também tem que rodar
+  while (s->defers) {
+    DeferEntry *d = s->defers;
+    s->defers = d->next;
+    if (!scope_exec(s, d->stmt))
+      ok = 0; // continua: os outros defers rodam mesmo assim
+  }
+  for (Binding *b = s->vars, *next; b; b = next) {
+    next = b->next;
+    if (b->storage == BIND_HEAP)
+      free(b);
+  }
+  s->vars = NULL;
+  region_release(&s->region);
+  return ok;
+}
+
+int scope_run(RegionPool *pool, AstNode *block, const TestEnv *env) {
+  Scope root;
+  scope_open(&root, NULL, pool);
+  root.env = env;
+  cov_hit(env, block->cov);
+  if (env && env->profile) { // o corpo entra na pilha como no async
+    profile_reset(env->test);
+    profile_push(block);
+  }
+  int ok = 1;
+  for (size_t i = 0; ok && i < block->data.block_or_group.count; i++)
+    ok = scope_exec(&root, block->data.block_or_group.stmts[i]);
+  ok = scope_exit(&root) && ok;
+  if (env && env->profile)
+    profile_reset(NULL);
+  return ok;
+}
+
+int scope_capture(Scope *dst, const Scope *src) {
+  Binding **tail = &dst->vars;
+  while (*tail)
+    tail = &(*tail)->next;
+  // Ordem preservada (de dentro pra fora) — shadowing continua igual
+  for (; src; src = src->parent)
+    for (const Binding *b = src->vars; b; b = b->next) {
+      Binding *copy = region_alloc(&dst->region, sizeof(Binding));
+      if (!copy)
+        return 0;
+      *copy = *b;
+      copy->storage = BIND_REGION;
+      copy->next = NULL;
+      *tail = copy;
+      tail = &copy->next;
+    }
+  return 1;
+}
@@ -0,0 +1,78 @@
+// scope.h
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include "../../ast/ast.h"
+#include "../../ast/types.h"
+#include "../../builtin/region.h"
+#include "value.h"
+#include <stdatomic.h>
+
+// Onde mora o valor de um binding — por quê guardar? scope_exit só devolve
+// pro heap o que veio dele
+typedef enum { BIND_HEAP, BIND_REGION, BIND_STACK } BindStorage;
+
+typedef struct Binding {
+  struct Binding *next; // mais novo na frente: shadowing é achar o primeiro
+  const char *name;
+  size_t len;
+  Value value;
+  BindStorage storage;
+} Binding;
+
+typedef struct DeferEntry {
+  struct DeferEntry *next; // LIFO: último defer roda primeiro
+  AstNode *stmt;
+} DeferEntry;
+
+// Mensagem do primeiro assert com `, f"..."` que falhou no test. buf é de
+// quem roda o test, tamanho fixo; taken — por quê? Tarefas async falham ao
+// mesmo tempo em threads diferentes, só a primeira escreve
+typedef struct {
+  char *buf;
+  size_t cap;
+  size_t len; // texto inteiro; >= cap: truncou
+  int line;
+  _Atomic int taken;
+} AssertNote;
+
+// O que todos os escopos de um test dividem, do test_runner.c até o último
+// bloco (e as tarefas async) — por quê junto? Um ponteiro só herdado
+typedef struct {
+  AssertNote *note;      // NULL: mensagem nem é montada
+  _Atomic uint64_t *cov; // contadores do --coverage (coverage.h); NULL: sem
+  const AstNode *test;   // o AST_TEST_STMT: base da pilha do --profile
+  int profile;           // --profile: blocos e statements na pilha (profile.h)
+  const TypeId *types;   // tipo por node->ty (ast/types.h); NULL: eval só dinâmico
+} TestEnv;
+
+// Escopo léxico de um bloco em execução. `x = e` sem binding visível vai pro
+// heap; `autofree` usa slot de pilha (se escape.c deixou) ou a região, que
+// some inteira em scope_exit junto com os registros de defer
+typedef struct Scope {
+  struct Scope *parent;
+  Binding *vars;
+  DeferEntry *defers;
+  Region region;
+  const TestEnv *env; // herdado do pai; NULL fora de test
+  Binding slots[AST_STACK_SLOTS];
+} Scope;
+
+void scope_open(Scope *s, Scope *parent, RegionPool *pool);
+const Binding *scope_lookup(const Scope *s, const char *name, size_t len);
+
+// Roda um statement que não suspende (assert, var, defer, bloco); retorna 0
+// se um assert falhou ou faltou memória
+int scope_exec(Scope *s, AstNode *stmt);
+// Roda os defers em ordem reversa, libera heap e região; retorna 0 se algum
+// defer falhou. Todo caminho de saída do bloco passa aqui
+int scope_exit(Scope *s);
+
+// Corpo de test síncrono inteiro num escopo raiz; env pode ser NULL
+int scope_run(RegionPool *pool, AstNode *block, const TestEnv *env);
+
+// Copia os bindings visíveis de src pra região de dst — por quê cópia? A
+// tarefa async filha roda em outra thread; capturar por valor evita corrida
+int scope_capture(Scope *dst, const Scope *src);
+
+#endif
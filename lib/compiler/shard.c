@@ -0,0 +1,175 @@
+#include "shard.h"
+#include <stdlib.h>
+#include <string.h>
+
+void shard_init(ShardPlan *p) { *p = (ShardPlan){0}; }
+
+void shard_free(ShardPlan *p) {
+  free(p->tests);
+  free(p->load);
+  shard_init(p);
+}
+
+// Tamanho do AST como proxy de tempo: o que o executor percorre
+static uint64_t node_count(const AstNode *n) {
+  if (!n)
+    return 0;
+  uint64_t c = 1;
+  switch (n->kind) {
+  case AST_BIN_OP:
+  case AST_RANGE:
+    return c + node_count(n->data.binop.left) +
+           node_count(n->data.binop.right);
+  case AST_UNARY_OP:
+  case AST_ASYNC_BLOCK:
+  case AST_DEFER_STMT:
+  case AST_ASSERT_STMT:
+    return c + node_count(n->data.unary.expr) +
+           (n->kind == AST_ASSERT_STMT ? node_count(n->data.unary.message) : 0);
+  case AST_BLOCK:
+  case AST_PAREN_GROUP:
+    for (size_t i = 0; i < n->data.block_or_group.count; i++)
+      c += node_count(n->data.block_or_group.stmts[i]);
+    return c;
+  case AST_TEST_STMT:
+    return c + node_count(n->data.test.block);
+  case AST_VAR_DECL:
+    return c + node_count(n->data.var.init);
+  case AST_CALL:
+    for (size_t i = 0; i < n->data.call.count; i++)
+      c += node_count(n->data.call.args[i]);
+    return c;
+  case AST_PIPELINE:
+    c += node_count(n->data.pipeline.source);
+    for (size_t i = 0; i < n->data.pipeline.count; i++)
+      c += node_count(n->data.pipeline.stages[i].expr);
+    return c;
+  case AST_FORMAT:
+    for (size_t i = 0; i < n->data.format.count; i++)
+      c += node_count(n->data.format.parts[i].expr);
+    return c;
+  default:
+    return c;
+  }
+}
+
+int shard_add(ShardPlan *p, AstNode *program, const TestTimings *timings,
+              const TestCache *cache) {
+  if (!program || program->kind != AST_BLOCK)
+    return 1;
+  for (size_t i = 0; i < program->data.block_or_group.count; i++) {
+    AstNode *test = program->data.block_or_group.stmts[i];
+    if (!test || test->kind != AST_TEST_STMT)
+      continue;
+    if (p->count == p->cap) {
+      size_t cap = p->cap ? p->cap * 2 : 64;
+      ShardTest *tests = realloc(p->tests, cap * sizeof(ShardTest));
+      if (!tests)
+        return 0;
+      p->tests = tests;
+      p->cap = cap;
+    }
+    ShardTest *t = &p->tests[p->count];
+    *t = (ShardTest){.test = test,
+                     .size = node_count(test),
+                     .order = (uint32_t)p->count};
+    uint64_t hash = timings || cache ? ast_hash(test) : 0;
+    int passed;
+    if (cache && !cache->refresh && !test->data.test.native &&
+        test_cache_lookup(cache, hash, &passed))
+      t->known = 2;
+    else if (timings && timings_lookup(timings, hash, &t->cost))
+      t->known = 1;
+    p->known += t->known == 1;
+    p->count++;
+  }
+  return 1;
+}
+
+// Mais caro primeiro; empate pela ordem no fonte — por quê? Todo shard
+// precisa chegar no mesmo plano
+static int by_cost(const void *a, const void *b) {
+  const ShardTest *x = a, *y = b;
+  if (x->cost != y->cost)
+    return x->cost < y->cost ? 1 : -1;
+  return (x->order > y->order) - (x->order < y->order);
+}
+
+static int by_test(const void *a, const void *b) {
+  uintptr_t x = (uintptr_t)((const ShardTest *)a)->test;
+  uintptr_t y = (uintptr_t)((const ShardTest *)b)->test;
+  return (x > y) - (x < y);
+}
+
+int shard_plan(ShardPlan *p, int nbins) {
+  if (nbins < 1)
+    nbins = 1;
+  free(p->load);
+  p->load = calloc((size_t)nbins, sizeof(uint64_t));
+  if (!p->load)
+    return 0;
+  p->nbins = nbins;
+
+  // ns por nó dos que têm tempo, pra pôr o resto na mesma escala
+  uint64_t ns = 0, nodes = 0;
+  for (size_t i = 0; i < p->count; i++)
+    if (p->tests[i].known == 1) {
+      ns += p->tests[i].cost;
+      nodes += p->tests[i].size;
+    }
+  double per_node = nodes ? (double)ns / (double)nodes : 1.0;
+  for (size_t i = 0; i < p->count; i++) {
+    ShardTest *t = &p->tests[i];
+    if (t->known == 2)
+      t->cost = 0;
+    else if (!t->known)
+      t->cost = (uint64_t)((double)t->size * per_node) + 1;
+  }
+
+  qsort(p->tests, p->count, sizeof(ShardTest), by_cost);
+  for (size_t i = 0; i < p->count; i++) {
+    int best = 0;
+    for (int b = 1; b < nbins; b++)
+      if (p->load[b] < p->load[best])
+        best = b;
+    p->tests[i].bin = best;
+    p->load[best] += p->tests[i].cost;
+  }
+  qsort(p->tests, p->count, sizeof(ShardTest), by_test);
+  return 1;
+}
+
+const ShardTest *shard_find(const ShardPlan *p, const AstNode *test) {
+  ShardTest key = {.test = test};
+  return p->count ? bsearch(&key, p->tests, p->count, sizeof(ShardTest),
+                            by_test)
+                  : NULL;
+}
+
+void shard_report(const ShardPlan *p, int shard, FILE *out) {
+  if (!p->load)
+    return;
+  uint64_t total = 0, worst = 0;
+  for (int b = 0; b < p->nbins; b++) {
+    total += p->load[b];
+    if (p->load[b] > worst)
+      worst = p->load[b];
+  }
+  size_t mine = 0;
+  for (size_t i = 0; i < p->count; i++)
+    mine += shard < 0 || p->tests[i].bin == shard;
+  // Sem nenhum tempo gravado a carga é em nós, não em ns
+  const char *unit = p->known ? "ms" : "mil nós";
+  double scale = p->known ? 1e6 : 1e3;
+  if (shard < 0)
+    fprintf(out,
+            "shards: %d processos, %zu tests; previsto %.1f %s no maior, "
+            "%.1f %s no total (%zu com tempo gravado)\n",
+            p->nbins, p->count, (double)worst / scale, unit,
+            (double)total / scale, unit, p->known);
+  else
+    fprintf(out,
+            "shard %d/%d: %zu de %zu tests; previsto %.1f %s (maior %.1f)\n",
+            shard + 1, p->nbins, mine, p->count,
+            (double)p->load[shard] / scale, unit, (double)worst / scale);
+}
@@ -0,0 +1,51 @@
+// shard.h — --shard i/N e --shards N: tests divididos entre processos pelo
+// tempo que levaram da última vez (timings.h), não por ordem no arquivo
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "../../ast/ast.h"
+#include "test_cache.h"
+#include "timings.h"
+#include <stdio.h>
+
+typedef struct {
+  const AstNode *test;
+  uint64_t size;  // nós do AST: estimativa pra quem não tem tempo
+  uint64_t cost;  // ns previsto (shard_plan preenche)
+  uint32_t order; // posição entre os tests do plano: desempate estável
+  int known;      // 1: tempo gravado; 2: sai do cache, custo ~0
+  int bin;
+} ShardTest;
+
+typedef struct {
+  ShardTest *tests; // depois do shard_plan: ordenado por ponteiro
+  size_t count, cap;
+  size_t known; // com tempo gravado
+  int nbins;
+  uint64_t *load; // previsto por shard
+} ShardPlan;
+
+void shard_init(ShardPlan *p);
+void shard_free(ShardPlan *p);
+
+// Junta os AST_TEST_STMT de program (chame pra cada módulo). Tempo vem de
+// timings pelo ast_hash; test que o cache responde não custa nada. 0 sem
+// memória
+int shard_add(ShardPlan *p, AstNode *program, const TestTimings *timings,
+              const TestCache *cache);
+
+// LPT: do mais caro pro mais barato, cada um no shard mais leve até ali.
+// Sem tempo gravado o custo é o tamanho do AST, na escala ns/nó dos que
+// têm (nenhum com tempo: todos em nós, a proporção vale igual). Mesmo
+// plano em todo processo que ver os mesmos tests e o mesmo arquivo de
+// tempos. 0 sem memória
+int shard_plan(ShardPlan *p, int nbins);
+
+// Entrada de test no plano; NULL se não está (test de fora do shard_add)
+const ShardTest *shard_find(const ShardPlan *p, const AstNode *test);
+
+// Uma linha: tests e carga prevista do shard (0..nbins-1), ou do maior
+// com shard < 0
+void shard_report(const ShardPlan *p, int shard, FILE *out);
+
+#endif
@@ -0,0 +1,30 @@
+#include "source.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+char *source_read(const char *path, long *out_size) {
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return NULL;
+
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (size < 0) {
+    fclose(f);
+    return NULL;
+  }
+
+  char *buffer = malloc(size + 1);
+  if (!buffer) {
+    fclose(f);
+    return NULL;
+  }
+  size_t got = fread(buffer, 1, size, f);
+  buffer[got] = '\0'; // arquivo pode ter encolhido entre ftell e fread
+  fclose(f);
+
+  if (out_size)
+    *out_size = (long)got;
+  return buffer;
+}
@@ -0,0 +1,9 @@
+// source.h
+#ifndef SOURCE_H
+#define SOURCE_H
+
+// Lê o arquivo inteiro num buffer terminado em '\0' (o Tokenizer espera
+// isso); retorna NULL se não abrir. Quem chama libera com free()
+char *source_read(const char *path, long *out_size);
+
+#endif
@@ -0,0 +1,177 @@
+#include "test_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_MAGIC "MODALTC2"
+
+typedef struct {
+  char magic[8];
+  char version[16]; // MODAL_VERSION com '\0' no fim
+  uint32_t semantics; // TEST_CACHE_SEMANTICS
+  uint32_t reserved;
+  uint64_t count;
+} CacheHeader;
+
+static void make_header(CacheHeader *h, uint64_t count) {
+  memset(h, 0, sizeof(*h));
+  memcpy(h->magic, CACHE_MAGIC, sizeof(h->magic));
+  strncpy(h->version, MODAL_VERSION, sizeof(h->version) - 1);
+  h->semantics = TEST_CACHE_SEMANTICS;
+  h->count = count;
+}
+
+static int cmp_entry(const void *a, const void *b) {
+  uint64_t x = ((const TestCacheEntry *)a)->hash;
+  uint64_t y = ((const TestCacheEntry *)b)->hash;
+  return (x > y) - (x < y);
+}
+
+static int reserve(TestCache *cache, size_t need) {
+  if (need <= cache->cap)
+    return 1;
+  size_t cap = cache->cap ? cache->cap : 64;
+  while (cap < need)
+    cap *= 2;
+  TestCacheEntry *entries = realloc(cache->entries, cap * sizeof(*entries));
+  if (!entries)
+    return 0;
+  cache->entries = entries;
+  cache->cap = cap;
+  return 1;
+}
+
+int test_cache_load(TestCache *cache, const char *path) {
+  *cache = (TestCache){.path = path};
+
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return 1; // primeira rodada: sem cache ainda
+
+  CacheHeader want, got;
+  make_header(&want, 0);
+  if (fread(&got, sizeof(got), 1, f) != 1 ||
+      memcmp(got.magic, want.magic, sizeof(want.magic)) != 0 ||
+      memcmp(got.version, want.version, sizeof(want.version)) != 0 ||
+      got.semantics != want.semantics) {
+    fclose(f);
+    cache->dirty = 1; // reescreve com o header da versão atual
+    return 1;
+  }
+
+  if (!reserve(cache, got.count)) {
+    fclose(f); // count corrompido ou sem memória: recomeça vazio
+    cache->dirty = 1;
+    return 1;
+  }
+  cache->count = fread(cache->entries, sizeof(TestCacheEntry), got.count, f);
+  fclose(f);
+  for (size_t i = 0; i < cache->count; i++)
+    cache->entries[i].seen = 0;
+
+  // Arquivo já sai ordenado do save, mas não confia no disco
+  qsort(cache->entries, cache->count, sizeof(TestCacheEntry), cmp_entry);
+  return 1;
+}
+
+static TestCacheEntry *find(const TestCache *cache, uint64_t hash) {
+  TestCacheEntry key = {.hash = hash};
+  return bsearch(&key, cache->entries, cache->count, sizeof(TestCacheEntry),
+                 cmp_entry);
+}
+
+int test_cache_lookup(const TestCache *cache, uint64_t hash, int *passed) {
+  TestCacheEntry *e = find(cache, hash);
+  if (!e)
+    return 0;
+  *passed = (int)e->passed;
+  return 1;
+}
+
+int test_cache_use(TestCache *cache, uint64_t hash, int *passed) {
+  TestCacheEntry *e = find(cache, hash);
+  if (!e)
+    return 0;
+  e->seen = 1;
+  e->scope = cache->scope;
+  *passed = (int)e->passed;
+  return 1;
+}
+
+void test_cache_store(TestCache *cache, uint64_t hash, int passed) {
+  TestCacheEntry *e = find(cache, hash);
+  if (e) {
+    e->seen = 1;
+    e->scope = cache->scope;
+    if ((int)e->passed != passed) {
+      e->passed = (uint32_t)passed;
+      cache->dirty = 1;
+    }
+    return;
+  }
+
+  if (!reserve(cache, cache->count + 1))
+    return; // sem memória: só perde o cache, o test já rodou
+
+  // Inserção ordenada — por quê? Poucos tests novos por rodada; o grosso
+  // chega ordenado do disco
+  size_t i = cache->count;
+  while (i > 0 && cache->entries[i - 1].hash > hash) {
+    cache->entries[i] = cache->entries[i - 1];
+    i--;
+  }
+  cache->entries[i] = (TestCacheEntry){
+      .hash = hash, .scope = cache->scope, .passed = passed, .seen = 1};
+  cache->count++;
+  cache->dirty = 1;
+}
+
+void test_cache_prune(TestCache *cache) {
+  size_t kept = 0;
+  for (size_t i = 0; i < cache->count; i++)
+    if (cache->entries[i].seen || cache->entries[i].scope != cache->scope)
+      cache->entries[kept++] = cache->entries[i];
+  if (kept != cache->count)
+    cache->dirty = 1;
+  cache->count = kept;
+}
+
+int test_cache_save(TestCache *cache) {
+  if (!cache->dirty)
+    return 1;
+
+  size_t len = strlen(cache->path);
+  char *tmp = malloc(len + 5);
+  if (!tmp)
+    return 0;
+  memcpy(tmp, cache->path, len);
+  memcpy(tmp + len, ".tmp", 5);
+
+  FILE *f = fopen(tmp, "wb");
+  if (!f) {
+    free(tmp);
+    return 0;
+  }
+
+  CacheHeader h;
+  make_header(&h, cache->count);
+  int ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+           fwrite(cache->entries, sizeof(TestCacheEntry), cache->count, f) ==
+               cache->count;
+  ok = (fclose(f) == 0) && ok;
+
+  if (ok)
+    ok = rename(tmp, cache->path) == 0;
+  else
+    remove(tmp);
+  free(tmp);
+
+  if (ok)
+    cache->dirty = 0;
+  return ok;
+}
+
+void test_cache_free(TestCache *cache) {
+  free(cache->entries);
+  *cache = (TestCache){0};
+}
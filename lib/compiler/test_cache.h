@@ -0,0 +1,54 @@
+// test_cache.h
+#ifndef TEST_CACHE_H
+#define TEST_CACHE_H
+
+#include "../../ast/ast.h"
+#include <stdint.h>
+
+#define TEST_CACHE_DEFAULT_PATH ".modal-cache"
+
+// Resultado de um test guardado pelo hash estrutural (ast_hash) do
+// AST_TEST_STMT — espaço, comentário e posição não mudam a chave
+typedef struct {
+  uint64_t hash;
+  uint64_t scope; // TestCache.scope da última rodada que usou o test
+  uint32_t passed;
+  uint32_t seen; // a rodada usou a entrada; só vale na memória
+} TestCacheEntry;
+
+// O que o mesmo AST dá ao rodar: sobe junto com toda mudança no eval que
+// pode mudar o resultado de um test (folding e SIMD, range, hash-cons,
+// checker de tipos...) — por quê além do MODAL_VERSION? Ele só anda em
+// release; um build no meio do caminho reaproveitaria resultado velho
+#define TEST_CACHE_SEMANTICS 5
+
+// Cache persistente de resultados. O arquivo carrega o MODAL_VERSION e o
+// TEST_CACHE_SEMANTICS no header; qualquer um diferente descarta tudo —
+// por quê? Compilador novo pode avaliar o mesmo AST de outro jeito
+typedef struct {
+  const char *path;
+  TestCacheEntry *entries; // ordenado por hash
+  size_t count, cap;
+  int dirty;
+  int refresh; // --rerun: ignora os hits mas regrava os resultados
+  // Arquivo de entrada da rodada (ast_hash_bytes do caminho) — por quê? O
+  // .modal-cache é do diretório, e rodar b.modal não pode podar o a.modal
+  uint64_t scope;
+} TestCache;
+
+// Carrega path; arquivo ausente, corrompido ou de outra versão = cache vazio
+int test_cache_load(TestCache *cache, const char *path);
+int test_cache_lookup(const TestCache *cache, uint64_t hash, int *passed);
+// Lookup de quem roda o test: marca a entrada como usada nesta rodada
+int test_cache_use(TestCache *cache, uint64_t hash, int *passed);
+void test_cache_store(TestCache *cache, uint64_t hash, int passed);
+// Tira as entradas do scope desta rodada que ela não usou nem guardou —
+// test apagado ou editado não fica no arquivo pra sempre. Só depois de uma
+// rodada que viu todos os tests: --shard i/N ou parse com erro apagariam
+// o resto
+void test_cache_prune(TestCache *cache);
+// Grava se algo mudou (tmp + rename, nunca deixa arquivo pela metade)
+int test_cache_save(TestCache *cache);
+void test_cache_free(TestCache *cache);
+
+#endif
@@ -1,79 +1,163 @@
 #include "test_runner.h"
+#include "async_exec.h"
+#include "isolate.h"
 #include <stdio.h>
 #include <string.h>
 
-static TestResults results = {0, 0, 0};
-
-void print_test_name(const char *name, size_t len) {
-  printf("%.*s", (int)len, name);
+void test_runner_init(TestRunner *r, TestCache *cache, FILE *out) {
+  *r = (TestRunner){.results = {0, 0, 0}, .cache = cache, .out = out};
+  region_pool_init(&r->pool);
 }
 
-int eval_assert(AstNode *expr) {
-  if (!expr)
-    return 0;
+void test_runner_finish(TestRunner *r) {
+  sched_destroy(r->sched);
+  r->sched = NULL;
+  region_pool_destroy(&r->pool);
+}
 
-  if (expr->kind == AST_BIN_OP) {
-    return 1;
-  }
+static FILE *runner_out(TestRunner *r) { return r->out ? r->out : stdout; }
 
-  return 1;
+void print_test_name(FILE *out, const char *name, size_t len) {
+  fprintf(out, "%.*s", (int)len, name);
 }
 
-void exec_test(AstNode *test_node) {
-  if (!test_node || test_node->kind != AST_TEST_STMT) {
-    return;
+void report_test_result(TestRunner *r, const char *name, size_t len,
+                        int passed, const char *note) {
+  FILE *out = runner_out(r);
+  fprintf(out, "Running test: \"");
+  print_test_name(out, name, len);
+  fprintf(out, "\" ... ");
+
+  if (passed) {
+    fprintf(out, "✓ PASSED");
+    r->results.passed++;
+  } else {
+    fprintf(out, "✗ FAILED");
+    r->results.failed++;
   }
+  r->results.total++;
 
-  const char *name = test_node->data.test.name;
-  size_t name_len = test_node->data.test.len;
-  AstNode *block = test_node->data.test.block;
+  if (note)
+    fprintf(out, " (%s)", note);
+  fprintf(out, "\n");
+}
 
-  results.total++;
+void report_test(TestRunner *r, AstNode *test_node, int passed,
+                 const char *note) {
+  report_test_result(r, test_node->data.test.name, test_node->data.test.len,
+                     passed, note);
+}
 
-  printf("Running test: \"");
-  print_test_name(name, name_len);
-  printf("\" ... ");
+// Texto pronto: fwrite direto, sem passar por printf de novo
+void report_note(TestRunner *r, const AssertNote *note) {
+  FILE *out = runner_out(r);
+  size_t shown = note->len < note->cap ? note->len : note->cap - 1;
+  fprintf(out, "    linha %d: ", note->line);
+  fwrite(note->buf, 1, shown, out);
+  fputs(shown < note->len ? "...\n" : "\n", out);
+}
 
+int run_test_body(TestRunner *r, AstNode *test_node, AssertNote *note) {
+  AstNode *block = test_node->data.test.block;
   int test_passed = 1;
+  TestEnv env = {.note = note,
+                 .cov = r->coverage,
+                 .test = test_node,
+                 .profile = r->profile,
+                 .types = r->types};
 
   if (block && block->kind == AST_BLOCK) {
-    for (size_t i = 0; i < block->data.block_or_group.count; i++) {
-      AstNode *stmt = block->data.block_or_group.stmts[i];
-
-      // Handle assert statements
-      if (stmt && stmt->kind == AST_ASSERT_STMT) {
-        if (!eval_assert(stmt->data.unary.expr)) {
-          test_passed = 0;
-          break;
-        }
-      }
+    if (ast_uses_async(block)) {
+      if (!r->sched)
+        r->sched = sched_create(r->threads);
+      test_passed = r->sched ? async_exec_block(r->sched, block, &env) : 0;
+    } else {
+      // Caminho direto, sem scheduler: escopos na pilha desta thread
+      test_passed = scope_run(&r->pool, block, &env);
     }
   }
-  if (test_passed) {
-    printf("✓ PASSED\n");
-    results.passed++;
-  } else {
-    printf("✗ FAILED\n");
-    results.failed++;
+
+  return test_passed;
+}
+
+int exec_test(TestRunner *r, AstNode *test_node) {
+  if (!test_node || test_node->kind != AST_TEST_STMT) {
+    return 0;
   }
+
+  char text[ASSERT_NOTE_MAX];
+  AssertNote note = {.buf = text, .cap = sizeof(text)};
+  int test_passed = run_test_body(r, test_node, &note);
+
+  report_test(r, test_node, test_passed, NULL);
+  if (!test_passed && atomic_load(&note.taken))
+    report_note(r, &note);
+  return test_passed;
 }
 
-void run_tests(AstNode *program) {
-  if (!program)
+int test_cache_check(TestRunner *r, AstNode *test_node, uint64_t *hash,
+                     int *passed) {
+  TestCache *cache = r->cache;
+  if (!cache || test_node->data.test.native) // C muda sem o hash saber
+    return -1;
+  *hash = ast_hash(test_node);
+  return !cache->refresh && test_cache_use(cache, *hash, passed);
+}
+
+int test_in_shard(const TestRunner *r, const AstNode *test_node) {
+  if (!r->shard || !r->plan)
+    return 1;
+  const ShardTest *t = shard_find(r->plan, test_node);
+  return !t || t->bin == r->shard - 1; // fora do plano: roda em todos
+}
+
+void record_timing(TestRunner *r, AstNode *test_node, int state, uint64_t hash,
+                   uint64_t ns) {
+  if (r->timings)
+    timings_store(r->timings, state >= 0 ? hash : ast_hash(test_node), ns);
+}
+
+static void run_test_cached(TestRunner *r, AstNode *test_node) {
+  uint64_t hash;
+  int passed;
+  int state = test_cache_check(r, test_node, &hash, &passed);
+  if (state == 1) {
+    report_test(r, test_node, passed, "cached");
+    record_timing(r, test_node, state, hash, 0);
     return;
+  }
+  uint64_t start = timings_now();
+  passed = exec_test(r, test_node);
+  record_timing(r, test_node, state, hash, timings_now() - start);
+  if (state == 0)
+    test_cache_store(r->cache, hash, passed);
+}
 
-  printf("\n═══════════════════════════════════════\n");
-  printf("         Running Modal Tests\n");
-  printf("═══════════════════════════════════════\n\n");
+void begin_tests(TestRunner *r) {
+  FILE *out = runner_out(r);
+  fprintf(out, "\n═══════════════════════════════════════\n");
+  fprintf(out, "         Running Modal Tests\n");
+  fprintf(out, "═══════════════════════════════════════\n\n");
 
-  results = (TestResults){0, 0, 0};
+  r->results = (TestResults){0, 0, 0};
+}
 
+void run_tests(TestRunner *r, AstNode *program) {
+  if (!program)
+    return;
+  begin_tests(r);
+  run_program_tests(r, program);
+}
+
+void run_program_tests(TestRunner *r, AstNode *program) {
+  if (r->isolate > 0 && isolate_run_tests(r, program))
+    return;
   // Iterate through top-level statements
-  if (program->kind == AST_BLOCK) {
+  if (program && program->kind == AST_BLOCK) {
     for (size_t i = 0; i < program->data.block_or_group.count; i++) {
       AstNode *stmt = program->data.block_or_group.stmts[i];
-      if (stmt && stmt->kind == AST_TEST_STMT) {
-        exec_test(stmt);
+      if (stmt && stmt->kind == AST_TEST_STMT && test_in_shard(r, stmt)) {
+        run_test_cached(r, stmt);
       }
     }
   }
@@ -3,6 +3,17 @@
 #define TEST_RUNNER_H
 
 #include "../../ast/ast.h"
+#include "../../builtin/region.h"
+#include "../runtime/sched.h"
+#include "scope.h"
+#include "shard.h"
+#include "test_cache.h"
+#include "timings.h"
+#include <stdatomic.h>
+#include <stdio.h>
+
+// Mensagem de assert maior que isso sai cortada com "..."
+#define ASSERT_NOTE_MAX 512
 
 typedef struct {
   int total;
@@ -10,6 +21,66 @@ typedef struct {
   int failed;
 } TestResults;
 
-void run_tests(AstNode *program);
+// Estado de uma rodada — por quê? Nada global: dois runners em threads
+// diferentes não se enxergam
+typedef struct {
+  TestResults results;
+  TestCache *cache; // NULL roda tudo
+  FILE *out;        // NULL = stdout
+  int threads;      // workers do pool async (0 = nº de CPUs)
+  Scheduler *sched; // criado no primeiro test com async
+  RegionPool pool;  // chunks das regiões de escopo, reusados entre tests
+  // Contadores do --coverage (coverage.h), armados antes; NULL sem
+  _Atomic uint64_t *coverage;
+  int profile; // --profile: mantém a pilha que o profile.c amostra
+  int isolate; // --isolate: > 0 roda os tests em tantos processos filhos
+  TestTimings *timings; // tempo de cada test que rodou; NULL não mede
+  // --shards N: com isolate, cada filho começa pela fila do seu shard.
+  // --shard i/N: shard = i, só roda (e reporta) os tests dele; 0 todos
+  const ShardPlan *plan;
+  int shard;
+  const TypeId *types; // tipos da árvore que roda (TypeTable.nodes); NULL sem
+} TestRunner;
+
+void test_runner_init(TestRunner *r, TestCache *cache, FILE *out);
+// Derruba o pool async, se subiu, e devolve os chunks de região
+void test_runner_finish(TestRunner *r);
+
+// Com cache, test com hash já visto só reporta o resultado guardado como
+// "cached"
+void run_tests(TestRunner *r, AstNode *program);
+
+// run_tests em duas partes, pra uma rodada com vários módulos: cabeçalho e
+// totais zerados uma vez, depois os tests de cada programa acumulando
+void begin_tests(TestRunner *r);
+void run_program_tests(TestRunner *r, AstNode *program);
+
+// Roda um AST_TEST_STMT e imprime o resultado; retorna 1 se passou
+int exec_test(TestRunner *r, AstNode *test_node);
+// Só o corpo, sem imprimir: 1 se passou; note recebe a mensagem do
+// primeiro assert com f"..." que falhou (o filho do isolate.c roda isso)
+int run_test_body(TestRunner *r, AstNode *test_node, AssertNote *note);
+
+// 1: *passed veio do cache; 0: roda e guarda com test_cache_store(r->cache,
+// *hash, ...); -1: roda sem cache (não tem, ou o test chama C)
+int test_cache_check(TestRunner *r, AstNode *test_node, uint64_t *hash,
+                     int *passed);
+
+// 0 se --shard deixou test pra outro processo
+int test_in_shard(const TestRunner *r, const AstNode *test_node);
+// Grava em r->timings quanto test_node levou (0: veio do cache, só marca
+// como usado); hash do test_cache_check se state >= 0, senão calcula
+void record_timing(TestRunner *r, AstNode *test_node, int state, uint64_t hash,
+                   uint64_t ns);
+
+// Imprime a linha de resultado de um test sem rodar (ex: resultado reusado
+// pelo watch); note vai entre parênteses no fim, NULL omite
+void report_test(TestRunner *r, AstNode *test_node, int passed,
+                 const char *note);
+// Idem só com o nome (ex: test de módulo que nem foi parseado)
+void report_test_result(TestRunner *r, const char *name, size_t len,
+                        int passed, const char *note);
+// "linha N: mensagem" do assert que falhou, embaixo do resultado
+void report_note(TestRunner *r, const AssertNote *note);
 
 #endif
@@ -0,0 +1,303 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime, getpid, fcntl, dirent
+#include "timings.h"
+#include "../../tokenizer/tokenizer.h" // MODAL_VERSION
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TIMINGS_MAGIC "MODALTT2"
+
+typedef struct {
+  char magic[8];
+  char version[16]; // MODAL_VERSION com '\0' no fim
+  uint64_t count;
+} TimingsHeader;
+
+static void make_header(TimingsHeader *h, uint64_t count) {
+  memset(h, 0, sizeof(*h));
+  memcpy(h->magic, TIMINGS_MAGIC, sizeof(h->magic));
+  strncpy(h->version, MODAL_VERSION, sizeof(h->version) - 1);
+  h->count = count;
+}
+
+static int cmp_entry(const void *a, const void *b) {
+  uint64_t x = ((const TimingEntry *)a)->hash;
+  uint64_t y = ((const TimingEntry *)b)->hash;
+  return (x > y) - (x < y);
+}
+
+uint64_t timings_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Entradas do disco, ordenadas; *count 0 se não tem nada que sirva
+static TimingEntry *read_file(const char *path, size_t *count) {
+  *count = 0;
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return NULL;
+  TimingsHeader want, got;
+  make_header(&want, 0);
+  TimingEntry *entries = NULL;
+  if (fread(&got, sizeof(got), 1, f) == 1 &&
+      memcmp(got.magic, want.magic, sizeof(want.magic)) == 0 &&
+      memcmp(got.version, want.version, sizeof(want.version)) == 0 &&
+      got.count && got.count <= SIZE_MAX / sizeof(TimingEntry))
+    entries = malloc((size_t)got.count * sizeof(TimingEntry));
+  if (entries)
+    *count = fread(entries, sizeof(TimingEntry), (size_t)got.count, f);
+  fclose(f);
+  if (entries) // o save grava ordenado, mas não confia no disco
+    qsort(entries, *count, sizeof(TimingEntry), cmp_entry);
+  return entries;
+}
+
+// path + sufixo: "<path>.3", "<path>.lock"...; n entra no fmt
+static char *path_plus(const char *path, const char *fmt, long n) {
+  size_t len = strlen(path) + 32;
+  char *s = malloc(len);
+  if (s) {
+    int w = snprintf(s, len, "%s", path);
+    snprintf(s + w, len - (size_t)w, fmt, n);
+  }
+  return s;
+}
+
+// b ganha de a no mesmo hash; libera os dois
+static TimingEntry *merge(TimingEntry *a, size_t na, TimingEntry *b,
+                          size_t nb, size_t *count) {
+  TimingEntry *all = nb ? malloc((na + nb) * sizeof(TimingEntry)) : NULL;
+  if (!all) { // nada no b, ou sem memória: fica o a
+    free(b);
+    *count = na;
+    return a;
+  }
+  size_t n = 0, i = 0, j = 0;
+  while (i < na || j < nb) {
+    if (j == nb || (i < na && a[i].hash < b[j].hash))
+      all[n++] = a[i++];
+    else {
+      if (i < na && a[i].hash == b[j].hash)
+        i++;
+      all[n++] = b[j++];
+    }
+  }
+  free(a);
+  free(b);
+  *count = n;
+  return all;
+}
+
+// Junta os <path>.i dos --shard em entries (o shard ganha: mediu depois);
+// names recebe quais foram, pro save apagar. Diretório ilegível = nenhum
+static TimingEntry *read_shards(const char *path, TimingEntry *entries,
+                                size_t *count, char ***names,
+                                size_t *nnames) {
+  const char *slash = strrchr(path, '/');
+  const char *base = slash ? slash + 1 : path;
+  size_t dir_len = slash ? (size_t)(slash - path) + 1 : 0;
+  size_t base_len = strlen(base);
+  char *dir = malloc(dir_len + 2);
+  if (!dir)
+    return entries;
+  memcpy(dir, dir_len ? path : ".", dir_len ? dir_len : 1);
+  dir[dir_len ? dir_len : 1] = '\0';
+  DIR *d = opendir(dir);
+  free(dir);
+  if (!d)
+    return entries;
+
+  struct dirent *e;
+  while ((e = readdir(d))) {
+    const char *tail = e->d_name + base_len;
+    if (strncmp(e->d_name, base, base_len) != 0 || tail[0] != '.' ||
+        !tail[1] || strspn(tail + 1, "0123456789") != strlen(tail + 1))
+      continue;
+    char *name = malloc(dir_len + strlen(e->d_name) + 1);
+    if (!name)
+      break;
+    memcpy(name, path, dir_len);
+    strcpy(name + dir_len, e->d_name);
+    size_t n;
+    TimingEntry *shard = read_file(name, &n);
+    entries = merge(entries, *count, shard, n, count);
+    char **grown = names ? realloc(*names, (*nnames + 1) * sizeof(char *))
+                         : NULL;
+    if (grown) {
+      *names = grown;
+      grown[(*nnames)++] = name;
+    } else {
+      free(name);
+    }
+  }
+  closedir(d);
+  return entries;
+}
+
+int timings_load(TestTimings *t, const char *path, int shard) {
+  *t = (TestTimings){.path = path, .shard = shard};
+  t->entries = read_file(path, &t->count);
+  if (!shard)
+    t->entries = read_shards(path, t->entries, &t->count, NULL, NULL);
+  t->cap = t->count;
+  return 1;
+}
+
+int timings_lookup(const TestTimings *t, uint64_t hash, uint64_t *ns) {
+  TimingEntry key = {.hash = hash};
+  const TimingEntry *e =
+      t->count ? bsearch(&key, t->entries, t->count, sizeof(TimingEntry),
+                         cmp_entry)
+               : NULL;
+  if (!e)
+    return 0;
+  *ns = e->ns;
+  return 1;
+}
+
+void timings_store(TestTimings *t, uint64_t hash, uint64_t ns) {
+  if (t->nmeasured == t->measured_cap) {
+    size_t cap = t->measured_cap ? t->measured_cap * 2 : 64;
+    TimingEntry *m = realloc(t->measured, cap * sizeof(TimingEntry));
+    if (!m)
+      return; // sem memória: só fica sem o tempo, o test já rodou
+    t->measured = m;
+    t->measured_cap = cap;
+  }
+  t->measured[t->nmeasured++] = (TimingEntry){hash, ns, 0};
+}
+
+void timings_prune(TestTimings *t) { t->prune = 1; }
+
+// Ordena por hash e deixa uma medida por test — empate é test repetido
+// com o mesmo AST: qualquer medida serve, mas medida ganha de só usado
+static size_t sort_measured(TimingEntry *m, size_t n) {
+  qsort(m, n, sizeof(TimingEntry), cmp_entry);
+  size_t out = 0;
+  for (size_t i = 0; i < n; i++)
+    if (!out || m[out - 1].hash != m[i].hash)
+      m[out++] = m[i];
+    else if (m[i].ns > m[out - 1].ns)
+      m[out - 1] = m[i];
+  return out;
+}
+
+// Aplica o que a rodada mediu (ns > 0) ou usou (ns 0) em cima do disco;
+// com prune, some do scope o que ela não usou
+static TimingEntry *apply_measured(const TestTimings *t, const TimingEntry *disk,
+                                   size_t ndisk, size_t nm, size_t *count) {
+  TimingEntry *all = malloc((ndisk + nm + 1) * sizeof(TimingEntry));
+  if (!all)
+    return NULL;
+  const TimingEntry *m = t->measured;
+  size_t n = 0, i = 0, j = 0;
+  while (i < ndisk || j < nm) {
+    if (j == nm || (i < ndisk && disk[i].hash < m[j].hash)) {
+      if (!t->prune || disk[i].scope != t->scope)
+        all[n++] = disk[i];
+      i++;
+      continue;
+    }
+    TimingEntry e = {m[j].hash, m[j].ns, t->scope};
+    if (i < ndisk && disk[i].hash == m[j].hash) {
+      if (!e.ns)
+        e.ns = disk[i].ns;
+      i++;
+    }
+    if (e.ns)
+      all[n++] = e;
+    j++;
+  }
+  *count = n;
+  return all;
+}
+
+// <path>.lock com fcntl — por quê não o próprio path? O rename troca o
+// arquivo, e a trava ficaria presa no que saiu. -1: grava sem trava
+static int lock_path(const char *path) {
+  char *name = path_plus(path, ".lock", 0);
+  int fd = name ? open(name, O_RDWR | O_CREAT, 0644) : -1;
+  free(name);
+  if (fd < 0)
+    return -1;
+  struct flock fl = {.l_type = F_WRLCK, .l_whence = SEEK_SET};
+  while (fcntl(fd, F_SETLKW, &fl) != 0)
+    if (errno != EINTR) {
+      close(fd);
+      return -1;
+    }
+  return fd;
+}
+
+int timings_save(TestTimings *t) {
+  if (!t->nmeasured)
+    return 1;
+  char *out = t->shard ? path_plus(t->path, ".%ld", t->shard)
+                       : path_plus(t->path, "", 0);
+  // tmp com o pid — por quê? Shards terminam juntos no mesmo diretório
+  char *tmp = path_plus(t->path, ".%ld.tmp", (long)getpid());
+  if (!out || !tmp) {
+    free(out);
+    free(tmp);
+    return 0;
+  }
+
+  int lock = lock_path(t->path);
+  size_t ndisk, nm = sort_measured(t->measured, t->nmeasured), n = 0;
+  char **absorbed = NULL;
+  size_t nabsorbed = 0;
+  TimingEntry *disk = read_file(out, &ndisk);
+  if (!t->shard)
+    disk = read_shards(t->path, disk, &ndisk, &absorbed, &nabsorbed);
+  TimingEntry *all = apply_measured(t, disk, ndisk, nm, &n);
+  free(disk);
+
+  FILE *f = all ? fopen(tmp, "wb") : NULL;
+  int ok = f != NULL;
+  if (f) {
+    TimingsHeader h;
+    make_header(&h, n);
+    ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+         fwrite(all, sizeof(TimingEntry), n, f) == n;
+    ok = (fclose(f) == 0) && ok;
+    if (ok)
+      ok = rename(tmp, out) == 0;
+    else
+      remove(tmp);
+  }
+  // Só depois do rename: o que os shards mediram já está no path
+  for (size_t i = 0; i < nabsorbed; i++) {
+    if (ok)
+      remove(absorbed[i]);
+    free(absorbed[i]);
+  }
+  free(absorbed);
+  if (lock >= 0)
+    close(lock);
+  free(out);
+  free(tmp);
+
+  if (ok && !t->shard) { // o que está em disco agora é a visão atual
+    free(t->entries);
+    t->entries = all;
+    t->count = t->cap = n;
+  } else {
+    free(all);
+  }
+  if (ok)
+    t->nmeasured = 0;
+  return ok;
+}
+
+void timings_free(TestTimings *t) {
+  free(t->entries);
+  free(t->measured);
+  *t = (TestTimings){0};
+}
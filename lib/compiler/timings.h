@@ -0,0 +1,54 @@
+// timings.h — quanto cada test levou da última vez, pro --shard
+#ifndef TIMINGS_H
+#define TIMINGS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TIMINGS_DEFAULT_PATH ".modal-timings"
+
+// Tempo de parede de um test pelo mesmo hash do cache (ast_hash)
+typedef struct {
+  uint64_t hash;
+  uint64_t ns;
+  uint64_t scope; // TestCache.scope da rodada que mediu ou usou por último
+} TimingEntry;
+
+// Arquivo pequeno ao lado do cache, mesmo header (versão diferente =
+// vazio: é só estimativa). measured — por quê separado? Outra rodada pode
+// gravar no meio desta; o save relê o disco com <path>.lock travado e só
+// sobrepõe o que esta rodada mediu.
+//
+// --shard i/N planeja só com <path> — os N processos chegam no mesmo
+// plano — e grava em <path>.i. Rodada sem --shard junta os <path>.i que
+// achar no <path> e apaga eles
+typedef struct {
+  const char *path;
+  int shard;     // --shard i/N: i; 0 grava no path
+  uint64_t scope; // como TestCache.scope: a poda só mexe nos desta entrada
+  int prune;     // timings_prune: o save tira o que a rodada não usou
+  TimingEntry *entries; // ordenado por hash
+  size_t count, cap;
+  TimingEntry *measured; // desta rodada, na ordem em que rodaram; ns 0: usado
+  size_t nmeasured, measured_cap;
+} TestTimings;
+
+// Arquivo ausente ou estranho = nenhum tempo conhecido. shard 0 também lê
+// os <path>.i que os --shard deixaram
+int timings_load(TestTimings *t, const char *path, int shard);
+// 0 se o test nunca rodou com tempo gravado
+int timings_lookup(const TestTimings *t, uint64_t hash, uint64_t *ns);
+// ns 0: test usado sem medir (veio do cache); só segura o tempo na poda
+void timings_store(TestTimings *t, uint64_t hash, uint64_t ns);
+// A rodada viu todos os tests: o save tira do scope o que não foi usado —
+// test apagado ou editado não fica no arquivo pra sempre
+void timings_prune(TestTimings *t);
+// Trava <path>.lock, relê o disco, aplica o que foi medido e grava (tmp +
+// rename): em <path>.i com --shard, senão em path
+int timings_save(TestTimings *t);
+void timings_free(TestTimings *t);
+
+// Relógio monotônico em ns, pra medir em volta do test
+uint64_t timings_now(void);
+
+#endif
@@ -0,0 +1,18 @@
+// value.h
+#ifndef VALUE_H
+#define VALUE_H
+
+#include "../runtime/simd.h"
+
+typedef enum { VAL_INT, VAL_VEC, VAL_RANGE, VAL_F64 } ValueKind;
+
+// Resultado de uma expressão: inteiro, f64, vetor de largura fixa ou range
+typedef struct {
+  ValueKind kind;
+  long long scalar; // VAL_INT
+  double f64;       // VAL_F64
+  long long lo, hi; // VAL_RANGE: [lo, hi)
+  SimdVec vec;      // VAL_VEC
+} Value;
+
+#endif
@@ -0,0 +1,387 @@
+#define _POSIX_C_SOURCE 200809L
+#include "watch.h"
+#include "program.h"
+#include "test_runner.h"
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// O que o watch lembra de cada test entre uma rodada e outra
+typedef struct {
+  uint64_t hash;
+  int passed;
+} TestRecord;
+
+typedef struct {
+  char *path;       // caminho como o usuário passou (ou dir/nome)
+  char *dir;        // diretório observado — por quê? Editores salvam via
+                    // rename, e o inode do arquivo muda
+  const char *base; // nome dentro de dir (aponta pra path)
+  int wd;
+  int dirty;
+  Program prog; // AST, fontes e #include da última versão que parseou
+  int loaded;
+  TestRecord *records; // ordenado por hash pra bsearch
+  size_t record_count;
+} WatchedFile;
+
+// Arquivo que um observado leu (use "x.modal", #include, use "x.h"): o
+// evento nele recarrega o observado — por quê? A AST dele depende do
+// conteúdo, mesmo que o observado em si não tenha mudado
+typedef struct {
+  char *base;
+  int wd;
+  size_t file; // índice em Watcher.files, que só cresce
+} WatchedDep;
+
+typedef struct {
+  char *dir;
+  int wd;
+} WatchedDir;
+
+typedef struct {
+  int fd;
+  WatchedFile *files;
+  size_t file_count, file_cap;
+  WatchedDir *dirs; // diretórios passados direto: pegam *.modal novos
+  size_t dir_count, dir_cap;
+  WatchedDep *deps; // acumulam: dependência que sumiu só custa um reload
+  size_t dep_count, dep_cap;
+} Watcher;
+
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static int has_modal_ext(const char *name) {
+  size_t len = strlen(name);
+  return len > 6 && strcmp(name + len - 6, ".modal") == 0;
+}
+
+static char *join_path(const char *dir, const char *name) {
+  size_t dl = strlen(dir), nl = strlen(name);
+  char *out = malloc(dl + nl + 2);
+  if (!out)
+    return NULL;
+  memcpy(out, dir, dl);
+  out[dl] = '/';
+  memcpy(out + dl + 1, name, nl + 1);
+  return out;
+}
+
+static int cmp_record(const void *a, const void *b) {
+  uint64_t x = ((const TestRecord *)a)->hash;
+  uint64_t y = ((const TestRecord *)b)->hash;
+  return (x > y) - (x < y);
+}
+
+static const TestRecord *find_record(const WatchedFile *wf, uint64_t hash) {
+  if (!wf->records) // primeira carga: bsearch não aceita NULL
+    return NULL;
+  TestRecord key = {hash, 0};
+  return bsearch(&key, wf->records, wf->record_count, sizeof(TestRecord),
+                 cmp_record);
+}
+
+static WatchedFile *find_file(Watcher *w, int wd, const char *name) {
+  for (size_t i = 0; i < w->file_count; i++) {
+    WatchedFile *wf = &w->files[i];
+    if (wf->wd == wd && strcmp(wf->base, name) == 0)
+      return wf;
+  }
+  return NULL;
+}
+
+static int add_dir_watch(Watcher *w, const char *dir) {
+  int wd = inotify_add_watch(w->fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (wd < 0)
+    fprintf(stderr, "watch: inotify em %s: %s\n", dir, strerror(errno));
+  return wd;
+}
+
+// Diretório de path (novo) e, em base, o nome dentro dele
+static char *parent_dir(const char *path, const char **base) {
+  const char *slash = strrchr(path, '/');
+  *base = slash ? slash + 1 : path;
+  return slash ? strndup(path, slash == path ? 1 : (size_t)(slash - path))
+               : strdup(".");
+}
+
+// Toma posse de path
+static WatchedFile *add_file(Watcher *w, char *path) {
+  if (w->file_count == w->file_cap) {
+    size_t cap = w->file_cap ? w->file_cap * 2 : 8;
+    WatchedFile *files = realloc(w->files, cap * sizeof(WatchedFile));
+    if (!files) {
+      free(path);
+      return NULL;
+    }
+    w->files = files;
+    w->file_cap = cap;
+  }
+
+  const char *base;
+  char *dir = parent_dir(path, &base);
+  int wd = dir ? add_dir_watch(w, dir) : -1;
+  if (wd < 0) {
+    free(dir);
+    free(path);
+    return NULL;
+  }
+
+  WatchedFile *wf = &w->files[w->file_count++];
+  *wf = (WatchedFile){
+      .path = path, .dir = dir, .base = base, .wd = wd, .dirty = 1};
+  return wf;
+}
+
+static int add_dir(Watcher *w, const char *dir) {
+  DIR *d = opendir(dir);
+  if (!d)
+    return 0;
+
+  struct dirent *ent;
+  while ((ent = readdir(d))) {
+    if (has_modal_ext(ent->d_name))
+      add_file(w, join_path(dir, ent->d_name));
+  }
+  closedir(d);
+
+  int wd = add_dir_watch(w, dir);
+  if (wd < 0)
+    return 0;
+  if (w->dir_count == w->dir_cap) {
+    size_t cap = w->dir_cap ? w->dir_cap * 2 : 4;
+    WatchedDir *dirs = realloc(w->dirs, cap * sizeof(WatchedDir));
+    if (!dirs)
+      return 0;
+    w->dirs = dirs;
+    w->dir_cap = cap;
+  }
+  w->dirs[w->dir_count++] = (WatchedDir){strdup(dir), wd};
+  return 1;
+}
+
+typedef struct {
+  Watcher *w;
+  size_t file;
+} DepWalk;
+
+static void add_dep(void *ctx, const char *path) {
+  DepWalk *walk = ctx;
+  Watcher *w = walk->w;
+  const WatchedFile *wf = &w->files[walk->file];
+  const char *base;
+  char *dir = parent_dir(path, &base);
+  if (!dir)
+    return;
+  // inotify devolve o mesmo wd pro mesmo diretório, por qualquer caminho
+  int wd = add_dir_watch(w, dir);
+  int known = wd < 0 || (wd == wf->wd && strcmp(base, wf->base) == 0);
+  for (size_t i = 0; !known && i < w->dep_count; i++) {
+    const WatchedDep *d = &w->deps[i];
+    known = d->file == walk->file && d->wd == wd && strcmp(d->base, base) == 0;
+  }
+  char *name = known ? NULL : strdup(base);
+  free(dir);
+  if (!name)
+    return;
+
+  if (w->dep_count == w->dep_cap) {
+    size_t cap = w->dep_cap ? w->dep_cap * 2 : 8;
+    WatchedDep *deps = realloc(w->deps, cap * sizeof(WatchedDep));
+    if (!deps) {
+      free(name);
+      return;
+    }
+    w->deps = deps;
+    w->dep_cap = cap;
+  }
+  w->deps[w->dep_count++] = (WatchedDep){name, wd, walk->file};
+}
+
+// Observa os módulos e #include que o programa de w->files[file] leu
+static void watch_deps(Watcher *w, size_t file, const Program *prog) {
+  DepWalk walk = {w, file};
+  program_files(prog, add_dep, &walk);
+}
+
+// Recarrega o programa do arquivo, com os módulos que ele importa, e roda
+// os tests novos/alterados dele. Em erro de leitura ou parse mantém a versão
+// anterior — por quê? O próximo save conserta e o estado antigo continua
+// valendo como base de comparação
+static void reload_file(Watcher *w, TestRunner *runner, size_t index) {
+  WatchedFile *wf = &w->files[index];
+  double t0 = now_ms();
+
+  // Sem interface nem cache: o watch já guarda o que reusar em records
+  ProgramOptions opts = {.alloc = modal_heap_allocator(), .parse_root = 1};
+  Program prog;
+  int ok = program_load(&prog, wf->path, &opts);
+  program_render(&prog, stderr, 0);
+
+  AstNode *root = ok ? program_root(&prog) : NULL;
+  if (!prog.count) {
+    fprintf(stderr, "watch: não consegui ler %s\n", wf->path);
+  } else if (!root) {
+    fprintf(stderr, "%s: erros no parse, mantendo a versão anterior\n",
+            wf->path);
+  }
+  if (!root) {
+    // Os arquivos que ele leu valem mesmo assim: o conserto pode vir deles
+    if (prog.count)
+      watch_deps(w, index, &prog);
+    program_free(&prog);
+    return;
+  }
+
+  printf("── %s ──\n", wf->path);
+
+  size_t count = root->data.block_or_group.count;
+  TestRecord *records = malloc((count ? count : 1) * sizeof(TestRecord));
+  if (!records) {
+    program_free(&prog);
+    return;
+  }
+
+  size_t n = 0, ran = 0, reused = 0, failed = 0;
+  for (size_t i = 0; i < count; i++) {
+    AstNode *stmt = root->data.block_or_group.stmts[i];
+    if (!stmt || stmt->kind != AST_TEST_STMT)
+      continue;
+
+    uint64_t hash = ast_hash(stmt);
+    const TestRecord *prev = find_record(wf, hash);
+    int passed;
+    if (prev) {
+      passed = prev->passed;
+      report_test(runner, stmt, passed, "unchanged");
+      reused++;
+    } else {
+      passed = exec_test(runner, stmt);
+      ran++;
+    }
+    failed += !passed;
+    records[n++] = (TestRecord){hash, passed};
+  }
+  qsort(records, n, sizeof(TestRecord), cmp_record);
+
+  if (wf->loaded)
+    program_free(&wf->prog);
+  free(wf->records);
+  wf->prog = prog;
+  wf->loaded = 1;
+  wf->records = records;
+  wf->record_count = n;
+  watch_deps(w, index, &wf->prog);
+
+  printf("%zu tests: %zu rodados, %zu reusados, %zu falharam (%.2f ms)\n\n",
+         n, ran, reused, failed, now_ms() - t0);
+  fflush(stdout);
+}
+
+static void handle_event(Watcher *w, const struct inotify_event *ev) {
+  if (!ev->len)
+    return;
+
+  WatchedFile *wf = find_file(w, ev->wd, ev->name);
+  if (wf)
+    wf->dirty = 1;
+  for (size_t i = 0; i < w->dep_count; i++) {
+    const WatchedDep *d = &w->deps[i];
+    if (d->wd == ev->wd && strcmp(d->base, ev->name) == 0) {
+      w->files[d->file].dirty = 1;
+      wf = &w->files[d->file];
+    }
+  }
+  if (wf)
+    return;
+
+  // *.modal novo num diretório passado na linha de comando
+  if (!has_modal_ext(ev->name))
+    return;
+  for (size_t i = 0; i < w->dir_count; i++) {
+    if (w->dirs[i].wd == ev->wd) {
+      add_file(w, join_path(w->dirs[i].dir, ev->name));
+      return;
+    }
+  }
+}
+
+static void reload_dirty(Watcher *w) {
+  TestRunner runner;
+  test_runner_init(&runner, NULL, NULL);
+  for (size_t i = 0; i < w->file_count; i++) {
+    if (w->files[i].dirty) {
+      w->files[i].dirty = 0;
+      reload_file(w, &runner, i);
+    }
+  }
+  test_runner_finish(&runner);
+}
+
+// Lê um lote de eventos; timeout_ms < 0 bloqueia. Retorna 0 se nada chegou
+static int read_events(Watcher *w, int timeout_ms) {
+  struct pollfd pfd = {.fd = w->fd, .events = POLLIN};
+  if (poll(&pfd, 1, timeout_ms) <= 0)
+    return 0;
+
+  char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t len = read(w->fd, buf, sizeof(buf));
+  if (len <= 0)
+    return 0;
+
+  for (char *ptr = buf; ptr < buf + len;) {
+    const struct inotify_event *ev = (const struct inotify_event *)ptr;
+    handle_event(w, ev);
+    ptr += sizeof(struct inotify_event) + ev->len;
+  }
+  return 1;
+}
+
+int watch_run(char **paths, int count) {
+  Watcher w = {0};
+  w.fd = inotify_init1(IN_CLOEXEC);
+  if (w.fd < 0) {
+    fprintf(stderr, "watch: inotify indisponível: %s\n", strerror(errno));
+    return 1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    struct stat st;
+    if (stat(paths[i], &st) == 0 && S_ISDIR(st.st_mode))
+      add_dir(&w, paths[i]);
+    else
+      add_file(&w, strdup(paths[i]));
+  }
+
+  if (!w.file_count && !w.dir_count) {
+    fprintf(stderr, "watch: nada pra observar\n");
+    close(w.fd);
+    return 1;
+  }
+
+  printf("Observando %zu arquivo(s). Ctrl-C pra sair.\n\n", w.file_count);
+  reload_dirty(&w);
+
+  for (;;) {
+    if (!read_events(&w, -1))
+      continue;
+    // Um save costuma gerar vários eventos (write + rename); drena o que já
+    // chegou pra reparsear cada arquivo uma vez só
+    while (read_events(&w, 0))
+      ;
+    reload_dirty(&w);
+  }
+}
@@ -0,0 +1,12 @@
+// watch.h
+#ifndef WATCH_H
+#define WATCH_H
+
+// modal --watch <paths>: mantém as ASTs em memória, observa os arquivos via
+// inotify e, a cada save, recarrega só o arquivo alterado (ou quem importa
+// o módulo ou faz #include do arquivo alterado) e roda só os tests cujo
+// hash estrutural mudou. Diretórios observam todo *.modal dentro deles. Só
+// retorna em erro (1)
+int watch_run(char **paths, int count);
+
+#endif
@@ -0,0 +1,224 @@
+#include "modal.h"
+#include "../ast/parser.h"
+#include "compiler/eval.h"
+#include <string.h>
+
+struct ModalUnit {
+  ModalUnit *next;
+  char *source; // NULL no modo stream
+  size_t len;
+  LexemeBlock *lexemes; // modo stream: Token.start aponta pra cá
+  AstNode *root;
+  AstIntern shared; // ctx->hash_cons; vazia sem
+  TypeTable types;  // tipo de cada expressão de root (ast/types.h)
+};
+
+void modal_context_init(ModalContext *ctx, const ModalAllocator *alloc) {
+  *ctx = (ModalContext){
+      .alloc = alloc ? *alloc : *modal_heap_allocator(),
+      .units = NULL,
+      .error_count = 0,
+      .max_errors = 0,
+      .threads = 0,
+  };
+  diag_init(&ctx->diag, &ctx->alloc, NULL, 0);
+  ffi_libs_init(&ctx->natives);
+  include_cache_init(&ctx->includes);
+  strpool_init(&ctx->strings, &ctx->alloc);
+}
+
+void modal_context_reset(ModalContext *ctx) {
+  if (ctx->alloc.reset) {
+    ctx->alloc.reset(ctx->alloc.ud); // arena: tudo some de uma vez
+  } else {
+    diag_free(&ctx->diag);
+    ModalUnit *u = ctx->units;
+    while (u) {
+      ModalUnit *next = u->next;
+      ast_free(&ctx->alloc, u->root);
+      ast_intern_free(&u->shared);
+      types_free(&u->types);
+      tokenizer_free_lexemes(&ctx->alloc, u->lexemes);
+      modal_free(&ctx->alloc, u->source, u->len + 1);
+      modal_free(&ctx->alloc, u, sizeof(ModalUnit));
+      u = next;
+    }
+    strpool_free(&ctx->strings);
+  }
+  ctx->units = NULL;
+  ctx->error_count = 0;
+  diag_init(&ctx->diag, &ctx->alloc, NULL, 0);
+  include_cache_free(&ctx->includes); // malloc: a arena não leva junto
+  include_cache_init(&ctx->includes);
+  strpool_init(&ctx->strings, &ctx->alloc); // com arena já foi no reset
+}
+
+// ASTs antes das libs — por quê? Os AST_EXTERN_FN apontam pra dentro delas
+void modal_context_destroy(ModalContext *ctx) {
+  modal_context_reset(ctx);
+  include_cache_free(&ctx->includes);
+  ffi_close(&ctx->natives);
+}
+
+int modal_link(ModalContext *ctx, const char *path) {
+  return ffi_open(&ctx->natives, path);
+}
+
+// Parseia o que o lexer já aponta; unit e source (se houver) passam a ser
+// do contexto em caso de sucesso
+static AstNode *parse_unit(ModalContext *ctx, ModalUnit *unit,
+                           Tokenizer *lexer, const char *filename) {
+  const ModalAllocator *a = &ctx->alloc;
+
+  Parser parser;
+  parser_init(&parser, lexer, filename);
+  parser.diag.max_errors = ctx->max_errors;
+  parser.natives = &ctx->natives;
+  parser.includes = &ctx->includes;
+  parser.strings = &ctx->strings;
+  parser.types = &unit->types;
+  AstNode *root = parse_program(&parser);
+
+  // diag já copiou as linhas do fonte, sobrevive ao free da cópia
+  ctx->diag = parser.diag;
+
+  if (parser.had_error || !root) {
+    ast_free(a, root);
+    types_free(&unit->types);
+    tokenizer_free_lexemes(a, lexer->lexemes);
+    modal_free(a, unit->source, unit->len + 1);
+    modal_free(a, unit, sizeof(ModalUnit));
+    ctx->error_count = parser.diag.error_count ? (int)parser.diag.error_count
+                                               : 1;
+    return NULL;
+  }
+
+  eval_fold_constants(a, root); // antes do hash do cache, que vê o AST dobrado
+  if (ctx->hash_cons) {
+    unit->shared.types = &unit->types;
+    ast_intern_program(&unit->shared, root);
+  }
+  unit->lexemes = lexer->lexemes;
+  unit->root = root;
+  unit->next = ctx->units;
+  ctx->units = unit;
+  return root;
+}
+
+static ModalUnit *begin_unit(ModalContext *ctx, const char *filename) {
+  ctx->error_count = 0;
+  diag_free(&ctx->diag);
+  diag_init(&ctx->diag, &ctx->alloc, filename, 0);
+
+  ModalUnit *unit = modal_alloc(&ctx->alloc, sizeof(ModalUnit));
+  if (!unit) {
+    ctx->error_count = 1;
+    return NULL;
+  }
+  *unit = (ModalUnit){0};
+  ast_intern_init(&unit->shared, &ctx->alloc);
+  types_init(&unit->types, &ctx->alloc);
+  return unit;
+}
+
+AstNode *modal_parse(ModalContext *ctx, const char *source, size_t len,
+                     const char *filename) {
+  const ModalAllocator *a = &ctx->alloc;
+  ModalUnit *unit = begin_unit(ctx, filename);
+  if (!unit)
+    return NULL;
+
+  char *copy = modal_alloc(a, len + 1);
+  if (!copy) {
+    modal_free(a, unit, sizeof(ModalUnit));
+    ctx->error_count = 1;
+    return NULL;
+  }
+  memcpy(copy, source, len);
+  copy[len] = '\0'; // Tokenizer para no '\0'
+  unit->source = copy;
+  unit->len = len;
+
+  Tokenizer lexer;
+  init(&lexer, copy, a);
+  return parse_unit(ctx, unit, &lexer, filename);
+}
+
+AstNode *modal_parse_fd(ModalContext *ctx, int fd, const char *filename) {
+  const ModalAllocator *a = &ctx->alloc;
+  ModalUnit *unit = begin_unit(ctx, filename);
+  if (!unit)
+    return NULL;
+
+  Tokenizer lexer;
+  if (!init_stream(&lexer, fd, a)) {
+    modal_free(a, unit, sizeof(ModalUnit));
+    ctx->error_count = 1;
+    return NULL;
+  }
+  AstNode *root = parse_unit(ctx, unit, &lexer, filename);
+  tokenizer_close(&lexer); // janela só servia durante o parse
+  return root;
+}
+
+int modal_run_tests(ModalContext *ctx, AstNode *root, TestCache *cache,
+                    FILE *out, TestResults *results) {
+  TestRunner runner;
+  test_runner_init(&runner, cache, out);
+  runner.threads = ctx->threads;
+  runner.coverage = ctx->coverage;
+  runner.profile = ctx->profile;
+  runner.isolate = ctx->isolate;
+  runner.timings = ctx->timings;
+  runner.plan = ctx->plan;
+  runner.shard = ctx->shard;
+  for (const ModalUnit *u = ctx->units; u; u = u->next)
+    if (u->root == root)
+      runner.types = u->types.nodes;
+  run_tests(&runner, root);
+  test_runner_finish(&runner);
+  if (results)
+    *results = runner.results;
+  return runner.results.failed;
+}
+
+int modal_load_program(ModalContext *ctx, Program *prog, const char *path,
+                       const char *iface_dir, const TestCache *cache,
+                       int parse_root) {
+  ProgramOptions opts = {.alloc = &ctx->alloc,
+                         .natives = &ctx->natives,
+                         .max_errors = ctx->max_errors,
+                         .threads = ctx->alloc.reset ? 1 : ctx->threads,
+                         .iface_dir = iface_dir,
+                         .cache = cache,
+                         .parse_root = parse_root,
+                         .hash_cons = ctx->hash_cons,
+                         .parse_all = ctx->plan != NULL};
+  int ok = program_load(prog, path, &opts);
+  ctx->error_count = prog->error_count;
+  return ok;
+}
+
+int modal_run_program_tests(ModalContext *ctx, Program *prog,
+                            TestCache *cache, FILE *out,
+                            TestResults *results) {
+  TestRunner runner;
+  test_runner_init(&runner, cache, out);
+  runner.threads = ctx->threads;
+  runner.coverage = ctx->coverage;
+  runner.profile = ctx->profile;
+  runner.isolate = ctx->isolate;
+  runner.timings = ctx->timings;
+  runner.plan = ctx->plan;
+  runner.shard = ctx->shard;
+  program_run_tests(prog, &runner);
+  test_runner_finish(&runner);
+  if (results)
+    *results = runner.results;
+  return runner.results.failed;
+}
+
+void modal_intern_stats(const ModalContext *ctx, AstInternStats *stats) {
+  for (const ModalUnit *u = ctx->units; u; u = u->next)
+    ast_intern_stats(&u->shared, stats);
+}
@@ -0,0 +1,87 @@
+// modal.h — API pública da libmodal (make libmodal.a)
+#ifndef MODAL_H
+#define MODAL_H
+
+#include "../ast/ast.h"
+#include "../ast/diagnostics.h"
+#include "../ast/preproc.h"
+#include "../builtin/allocators.h"
+#include "runtime/ffi.h"
+#include "compiler/program.h"
+#include "compiler/test_runner.h"
+#include <stddef.h>
+#include <stdio.h>
+
+typedef struct ModalUnit ModalUnit;
+
+// Tudo que uma instância do compilador precisa — por quê? Sem estado global,
+// cada thread do host pode ter seu próprio contexto rodando ao mesmo tempo.
+// Um contexto em si não é thread-safe: uma thread por contexto
+typedef struct {
+  ModalAllocator alloc; // cópia: o host pode descartar o original
+  ModalUnit *units;     // fontes + ASTs vivos, liberados no reset
+  int error_count;      // erros do último modal_parse
+  size_t max_errors;    // 0 = sem limite; o parse para ao atingir
+  int threads;          // workers pros tests com async (0 = nº de CPUs)
+  Diagnostics diag;     // diagnósticos do último modal_parse
+  NativeLibs natives;   // .so pros use "foo.h"; fecham no destroy
+  IncludeCache includes; // #include dos parses; as ASTs apontam pra cá
+  StrPool strings;       // strings com escape dos parses, idem
+  // Contadores do --coverage pros modal_run_*tests (coverage_arm); NULL sem
+  _Atomic uint64_t *coverage;
+  int profile; // pilha pro --profile nos modal_run_*tests (profile.h)
+  int isolate; // --isolate: processos filhos pros tests (isolate.h); 0 sem
+  int hash_cons; // parses seguintes dividem expressões repetidas (intern.h)
+  // --shard/--shards pros modal_run_*tests (shard.h); plan não-NULL faz o
+  // modal_load_program parsear todos os módulos, pro program_shard depois
+  TestTimings *timings;
+  const ShardPlan *plan;
+  int shard;
+} ModalContext;
+
+// alloc NULL usa o heap da libc
+void modal_context_init(ModalContext *ctx, const ModalAllocator *alloc);
+
+// Libera todas as ASTs do contexto (e os #include lidos); com alloc.reset
+// as ASTs saem em O(1) (ex: arena)
+void modal_context_reset(ModalContext *ctx);
+void modal_context_destroy(ModalContext *ctx);
+
+// Abre uma biblioteca compartilhada pras funções dos `use "foo.h"`; vale
+// pros parses seguintes. 0 se falhou (ffi_error diz por quê)
+int modal_link(ModalContext *ctx, const char *path);
+
+// Copia source pro contexto (a AST aponta pra cópia) e parseia. Retorna a
+// raiz ou NULL com ctx->error_count > 0; os erros ficam em ctx->diag pra
+// diag_render/diag_render_json. A raiz vive até o próximo reset/destroy
+AstNode *modal_parse(ModalContext *ctx, const char *source, size_t len,
+                     const char *filename);
+
+// Igual modal_parse, mas lendo de fd (stdin, pipe) em chunks enquanto
+// parseia — o fonte nunca fica inteiro em memória. Não fecha fd
+AstNode *modal_parse_fd(ModalContext *ctx, int fd, const char *filename);
+
+// Roda os tests de root; retorna o número de falhas. cache e out como em
+// TestRunner (NULL = sem cache / stdout); results NULL ignora os totais
+int modal_run_tests(ModalContext *ctx, AstNode *root, TestCache *cache,
+                    FILE *out, TestResults *results);
+
+// Programa a partir do arquivo path, com os módulos que ele importa (use
+// "x.modal"); ondas em paralelo com ctx->threads — arena não é thread-safe,
+// então alloc com reset parseia numa thread só. iface_dir e cache como em
+// ProgramOptions. 0 com erro (ctx->error_count); program_render mostra.
+// program_free antes do destroy do contexto
+int modal_load_program(ModalContext *ctx, Program *prog, const char *path,
+                       const char *iface_dir, const TestCache *cache,
+                       int parse_root);
+
+// modal_run_tests pro programa inteiro; cache tem que ser o mesmo do load
+int modal_run_program_tests(ModalContext *ctx, Program *prog,
+                            TestCache *cache, FILE *out,
+                            TestResults *results);
+
+// --hash-cons dos modal_parse*: soma as tabelas das unidades em stats
+// (programa: program_intern_stats)
+void modal_intern_stats(const ModalContext *ctx, AstInternStats *stats);
+
+#endif
@@ -0,0 +1,141 @@
+#define _GNU_SOURCE // RTLD_DEFAULT
+#include "ffi.h"
+#include <dlfcn.h>
+
+// Chamar por ponteiro de outro tipo é UB pelo padrão, mas nos ABIs abaixo
+// (SysV x86-64, AAPCS64) até 6 inteiros/ponteiros vão um por registrador de
+// 64 bits e o retorno volta em rax/x0: a chamada sai idêntica à de C. Por
+// isso os argumentos já saem estendidos do tamanho declarado (clang conta
+// com isso pra char/short) e o retorno é reduzido de volta
+#if defined(__x86_64__) || defined(__aarch64__)
+#define FFI_NATIVE 1
+#else
+#define FFI_NATIVE 0
+#endif
+
+void ffi_libs_init(NativeLibs *libs) { libs->count = 0; }
+
+int ffi_open(NativeLibs *libs, const char *path) {
+  if (libs->count == FFI_MAX_LIBS)
+    return 0;
+  // RTLD_NOW: símbolo faltando aparece aqui, não no meio de um test
+  void *h = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if (!h)
+    return 0;
+  libs->handles[libs->count++] = h;
+  return 1;
+}
+
+void ffi_close(NativeLibs *libs) {
+  for (size_t i = 0; i < libs->count; i++)
+    dlclose(libs->handles[i]);
+  libs->count = 0;
+}
+
+const char *ffi_error(void) {
+  const char *e = dlerror();
+  return e ? e : "limite de bibliotecas";
+}
+
+void *ffi_lookup(const NativeLibs *libs, const char *symbol) {
+  if (libs)
+    for (size_t i = 0; i < libs->count; i++) {
+      void *fn = dlsym(libs->handles[i], symbol);
+      if (fn)
+        return fn;
+    }
+  return dlsym(RTLD_DEFAULT, symbol);
+}
+
+static int is_float(FfiType t) { return t == FFI_F32 || t == FFI_F64; }
+
+int ffi_signature_ok(FfiType ret, const FfiType *params, size_t count,
+                     const char **why) {
+  if (!FFI_NATIVE) {
+    *why = "chamada nativa não suportada nesta plataforma";
+    return 0;
+  }
+  if (count > FFI_MAX_ARGS) {
+    *why = "mais de 6 argumentos";
+    return 0;
+  }
+  int floats = is_float(ret);
+  for (size_t i = 0; i < count; i++)
+    floats |= is_float(params[i]);
+  if (floats) {
+    *why = "float/double ainda não atravessa a chamada";
+    return 0;
+  }
+  return 1;
+}
+
+int64_t ffi_narrow(FfiType t, int64_t v) {
+  switch (t) {
+  case FFI_VOID:
+    return 0;
+  case FFI_BOOL:
+    return v != 0;
+  case FFI_I8:
+    return (int8_t)v;
+  case FFI_U8:
+    return (uint8_t)v;
+  case FFI_I16:
+    return (int16_t)v;
+  case FFI_U16:
+    return (uint16_t)v;
+  case FFI_I32:
+    return (int32_t)v;
+  case FFI_U32:
+    return (uint32_t)v;
+  default: // 64 bits e ponteiro: como está
+    return v;
+  }
+}
+
+typedef int64_t (*Fn0)(void);
+typedef int64_t (*Fn1)(int64_t);
+typedef int64_t (*Fn2)(int64_t, int64_t);
+typedef int64_t (*Fn3)(int64_t, int64_t, int64_t);
+typedef int64_t (*Fn4)(int64_t, int64_t, int64_t, int64_t);
+typedef int64_t (*Fn5)(int64_t, int64_t, int64_t, int64_t, int64_t);
+typedef int64_t (*Fn6)(int64_t, int64_t, int64_t, int64_t, int64_t, int64_t);
+
+int64_t ffi_call(void *fn, FfiType ret, const FfiType *params, size_t count,
+                 const int64_t *args) {
+  int64_t a[FFI_MAX_ARGS] = {0};
+  for (size_t i = 0; i < count && i < FFI_MAX_ARGS; i++)
+    a[i] = ffi_narrow(params[i], args[i]);
+
+  int64_t r = 0;
+  switch (count) {
+  case 0:
+    r = ((Fn0)fn)();
+    break;
+  case 1:
+    r = ((Fn1)fn)(a[0]);
+    break;
+  case 2:
+    r = ((Fn2)fn)(a[0], a[1]);
+    break;
+  case 3:
+    r = ((Fn3)fn)(a[0], a[1], a[2]);
+    break;
+  case 4:
+    r = ((Fn4)fn)(a[0], a[1], a[2], a[3]);
+    break;
+  case 5:
+    r = ((Fn5)fn)(a[0], a[1], a[2], a[3], a[4]);
+    break;
+  default:
+    r = ((Fn6)fn)(a[0], a[1], a[2], a[3], a[4], a[5]);
+    break;
+  }
+  return ffi_narrow(ret, r); // void: o que sobrou em rax não vale nada
+}
+
+const char *ffi_type_name(FfiType t) {
+  static const char *names[] = {"void", "bool", "i8",  "u8",  "i16",
+                                "u16",  "i32",  "u32", "i64", "u64",
+                                "ptr",  "f32",  "f64"};
+  return names[t];
+}
@@ -0,0 +1,61 @@
+// ffi.h — chamadas diretas pra funções C (use "foo.h")
+#ifndef FFI_H
+#define FFI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Tipos escalares de C como o Modal enxerga. Ponto flutuante existe pros
+// campos de struct (layout); chamada com float/double ainda não atravessa —
+// o avaliador é todo inteiro
+typedef enum {
+  FFI_VOID,
+  FFI_BOOL,
+  FFI_I8,
+  FFI_U8,
+  FFI_I16,
+  FFI_U16,
+  FFI_I32,
+  FFI_U32,
+  FFI_I64,
+  FFI_U64,
+  FFI_PTR,
+  FFI_F32,
+  FFI_F64,
+} FfiType;
+
+// Argumentos inteiros que vão em registrador nos ABIs suportados
+#define FFI_MAX_ARGS 6
+#define FFI_MAX_LIBS 16
+
+// .so abertos com --link; a busca cai no processo (libc etc.) no fim
+typedef struct NativeLibs {
+  void *handles[FFI_MAX_LIBS];
+  size_t count;
+} NativeLibs;
+
+void ffi_libs_init(NativeLibs *libs);
+// 0 se o dlopen falhou (ffi_error diz por quê) ou passou de FFI_MAX_LIBS
+int ffi_open(NativeLibs *libs, const char *path);
+void ffi_close(NativeLibs *libs);
+const char *ffi_error(void);
+
+// Endereço de symbol nas libs (na ordem do --link) e depois no processo;
+// libs NULL procura só no processo. NULL se não achou
+void *ffi_lookup(const NativeLibs *libs, const char *symbol);
+
+// 1 se dá pra chamar com essa assinatura nesta plataforma; senão *why diz
+int ffi_signature_ok(FfiType ret, const FfiType *params, size_t count,
+                     const char **why);
+
+// Converte v como a atribuição de C pra t (trunca e estende o sinal)
+int64_t ffi_narrow(FfiType t, int64_t v);
+
+// Chama fn direto, argumentos em registrador como int64 sem caixa
+// intermediária; o retorno volta convertido por ffi_narrow(ret)
+int64_t ffi_call(void *fn, FfiType ret, const FfiType *params, size_t count,
+                 const int64_t *args);
+
+const char *ffi_type_name(FfiType t); // nome do primitivo Modal ("i32"...)
+
+#endif
@@ -0,0 +1,172 @@
+#include "queue.h"
+#include <stdlib.h>
+
+struct WsArray {
+  WsArray *next_retired;
+  size_t mask;
+  _Atomic(void *) buf[];
+};
+
+static WsArray *ws_array_new(size_t capacity) {
+  WsArray *a = malloc(sizeof(WsArray) + capacity * sizeof(_Atomic(void *)));
+  if (!a)
+    return NULL;
+  a->next_retired = NULL;
+  a->mask = capacity - 1;
+  return a;
+}
+
+int ws_init(WsDeque *d, size_t capacity) {
+  WsArray *a = ws_array_new(capacity);
+  if (!a)
+    return 0;
+  atomic_init(&d->top, 0);
+  atomic_init(&d->bottom, 0);
+  atomic_init(&d->array, a);
+  d->retired = NULL;
+  return 1;
+}
+
+void ws_destroy(WsDeque *d) {
+  free(atomic_load_explicit(&d->array, memory_order_relaxed));
+  while (d->retired) {
+    WsArray *next = d->retired->next_retired;
+    free(d->retired);
+    d->retired = next;
+  }
+}
+
+static WsArray *ws_grow(WsDeque *d, WsArray *old, int64_t top,
+                        int64_t bottom) {
+  WsArray *a = ws_array_new((old->mask + 1) * 2);
+  if (!a)
+    return NULL;
+  for (int64_t i = top; i < bottom; i++) {
+    void *x = atomic_load_explicit(&old->buf[i & old->mask],
+                                   memory_order_relaxed);
+    atomic_store_explicit(&a->buf[i & a->mask], x, memory_order_relaxed);
+  }
+  old->next_retired = d->retired;
+  d->retired = old;
+  atomic_store_explicit(&d->array, a, memory_order_release);
+  return a;
+}
+
+int ws_push(WsDeque *d, void *item) {
+  int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+  int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+  WsArray *a = atomic_load_explicit(&d->array, memory_order_relaxed);
+  if (b - t > (int64_t)a->mask) {
+    a = ws_grow(d, a, t, b);
+    if (!a)
+      return 0;
+  }
+  atomic_store_explicit(&a->buf[b & a->mask], item, memory_order_relaxed);
+  // release no bottom (e não fence + relaxed) publica o item pro acquire do
+  // steal — mesmo custo no x86 e o TSan entende
+  atomic_store_explicit(&d->bottom, b + 1, memory_order_release);
+  return 1;
+}
+
+void *ws_take(WsDeque *d) {
+  int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+  WsArray *a = atomic_load_explicit(&d->array, memory_order_relaxed);
+  atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+  if (t > b) { // vazio
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return NULL;
+  }
+
+  void *x = atomic_load_explicit(&a->buf[b & a->mask], memory_order_relaxed);
+  if (t == b) {
+    // Último item: disputa com os ladrões pelo topo
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed))
+      x = NULL;
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+  }
+  return x;
+}
+
+void *ws_steal(WsDeque *d) {
+  int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+  if (t >= b)
+    return NULL;
+
+  WsArray *a = atomic_load_explicit(&d->array, memory_order_acquire);
+  void *x = atomic_load_explicit(&a->buf[t & a->mask], memory_order_relaxed);
+  if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                               memory_order_seq_cst,
+                                               memory_order_relaxed))
+    return NULL; // outro ladrão (ou o dono) levou
+  return x;
+}
+
+int mpmc_init(MpmcQueue *q, size_t capacity) {
+  q->cells = malloc(capacity * sizeof(MpmcCell));
+  if (!q->cells)
+    return 0;
+  q->mask = capacity - 1;
+  for (size_t i = 0; i < capacity; i++)
+    atomic_init(&q->cells[i].seq, i);
+  atomic_init(&q->enq, 0);
+  atomic_init(&q->deq, 0);
+  return 1;
+}
+
+void mpmc_destroy(MpmcQueue *q) {
+  free(q->cells);
+  q->cells = NULL;
+}
+
+int mpmc_push(MpmcQueue *q, void *item) {
+  size_t pos = atomic_load_explicit(&q->enq, memory_order_relaxed);
+  MpmcCell *cell;
+  for (;;) {
+    cell = &q->cells[pos & q->mask];
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&q->enq, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return 0; // cheia
+    } else {
+      pos = atomic_load_explicit(&q->enq, memory_order_relaxed);
+    }
+  }
+  cell->data = item;
+  atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+  return 1;
+}
+
+void *mpmc_pop(MpmcQueue *q) {
+  size_t pos = atomic_load_explicit(&q->deq, memory_order_relaxed);
+  MpmcCell *cell;
+  for (;;) {
+    cell = &q->cells[pos & q->mask];
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&q->deq, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return NULL; // vazia
+    } else {
+      pos = atomic_load_explicit(&q->deq, memory_order_relaxed);
+    }
+  }
+  void *item = cell->data;
+  atomic_store_explicit(&cell->seq, pos + q->mask + 1, memory_order_release);
+  return item;
+}
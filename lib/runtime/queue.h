@@ -0,0 +1,47 @@
+// queue.h — filas lock-free do scheduler
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Deque de work-stealing (Chase–Lev, versão C11 de Lê et al.). Só o dono
+// faz push/take no fundo; qualquer thread faz steal do topo. Cresce
+// dobrando; arrays antigos ficam numa lista até o destroy — por quê? Um
+// ladrão pode estar lendo o array velho no meio do steal
+typedef struct WsArray WsArray;
+
+typedef struct {
+  _Alignas(64) _Atomic int64_t top;
+  _Alignas(64) _Atomic int64_t bottom;
+  _Atomic(WsArray *) array;
+  WsArray *retired;
+} WsDeque;
+
+int ws_init(WsDeque *d, size_t capacity); // capacity: potência de 2
+void ws_destroy(WsDeque *d);
+int ws_push(WsDeque *d, void *item); // só o dono; 0 se faltou memória
+void *ws_take(WsDeque *d);           // só o dono; NULL se vazio
+void *ws_steal(WsDeque *d);          // qualquer thread; NULL se vazio/perdeu
+
+// Fila MPMC limitada (Vyukov): cada célula tem um número de sequência que
+// diz se está livre pra quem produz ou pronta pra quem consome — sem lock
+typedef struct {
+  _Atomic size_t seq;
+  void *data;
+} MpmcCell;
+
+typedef struct {
+  MpmcCell *cells;
+  size_t mask;
+  _Alignas(64) _Atomic size_t enq;
+  _Alignas(64) _Atomic size_t deq;
+} MpmcQueue;
+
+int mpmc_init(MpmcQueue *q, size_t capacity); // capacity: potência de 2
+void mpmc_destroy(MpmcQueue *q);
+int mpmc_push(MpmcQueue *q, void *item); // 0 se cheia
+void *mpmc_pop(MpmcQueue *q);            // NULL se vazia
+
+#endif
@@ -0,0 +1,308 @@
+#define _GNU_SOURCE // sched_getaffinity/CPU_COUNT
+#include "sched.h"
+#include "queue.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define DEQUE_CAPACITY 256
+#define INJECT_CAPACITY 1024
+#define PARK_TIMEOUT_MS 50 // rede de segurança contra wakeup perdido
+#define REACTOR_POLL_EVERY 64
+
+struct SchedWorker {
+  Scheduler *s;
+  int id;
+  pthread_t thread;
+  WsDeque deque;
+  int epfd;   // reactor local: wakefd + fds esperados pelas corrotinas
+  int wakefd; // eventfd pra acordar o worker estacionado
+  _Atomic int sleeping;
+  _Atomic int io_waiting;
+  unsigned rng;
+  unsigned tick;
+};
+
+struct Scheduler {
+  SchedWorker *workers;
+  int count;
+  MpmcQueue inject; // entrada de fora do pool (sched_run)
+  _Atomic int stop;
+  _Atomic int sleepers;
+  _Atomic unsigned wake_rr;
+
+  pthread_mutex_t run_mu;
+  pthread_cond_t run_cv;
+  int run_done;
+};
+
+void coro_init(Coro *c, CoroStatus (*resume)(SchedWorker *, Coro *),
+               void (*on_done)(Coro *)) {
+  c->resume = resume;
+  c->on_done = on_done;
+  c->parent = NULL;
+  atomic_init(&c->refs, 1);
+}
+
+static void wake_one(Scheduler *s) {
+  if (atomic_load(&s->sleepers) == 0)
+    return;
+  unsigned start = atomic_fetch_add(&s->wake_rr, 1);
+  for (int i = 0; i < s->count; i++) {
+    SchedWorker *w = &s->workers[(start + i) % s->count];
+    if (atomic_exchange(&w->sleeping, 0)) {
+      uint64_t one = 1;
+      ssize_t n = write(w->wakefd, &one, sizeof(one));
+      (void)n; // eventfd só falha se o contador estourar
+      return;
+    }
+  }
+}
+
+static void push_local(SchedWorker *w, Coro *c) {
+  if (!ws_push(&w->deque, c)) {
+    while (!mpmc_push(&w->s->inject, c)) // sem memória pro deque crescer
+      sched_yield();
+  }
+  wake_one(w->s);
+}
+
+void sched_spawn(SchedWorker *w, Coro *child, Coro *parent) {
+  child->parent = parent;
+  atomic_fetch_add(&parent->refs, 1);
+  push_local(w, child);
+}
+
+int sched_join(Coro *c) {
+  // Solta a referência de "rodando"; se era a única, não há filhos e segue.
+  // Senão, depois do fetch_sub c não é mais nossa
+  if (atomic_fetch_sub(&c->refs, 1) == 1) {
+    atomic_store(&c->refs, 1);
+    return 1;
+  }
+  return 0;
+}
+
+int sched_wait_fd(SchedWorker *w, Coro *c, int fd, uint32_t events) {
+  struct epoll_event ev = {.events = events | EPOLLONESHOT, .data.ptr = c};
+  if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, fd, &ev) < 0 &&
+      epoll_ctl(w->epfd, EPOLL_CTL_MOD, fd, &ev) < 0)
+    return 0;
+  atomic_fetch_add(&w->io_waiting, 1);
+  return 1;
+}
+
+// Roda c até suspender; quando termina, retoma o pai se foi o último filho
+// (continuação no mesmo worker, sem passar pela fila)
+static void run_coro(SchedWorker *w, Coro *c) {
+  for (;;) {
+    if (c->resume(w, c) == CORO_SUSPENDED)
+      return;
+
+    Coro *parent = c->parent;
+    c->on_done(c);
+
+    if (!parent) {
+      Scheduler *s = w->s;
+      pthread_mutex_lock(&s->run_mu);
+      s->run_done = 1;
+      pthread_cond_signal(&s->run_cv);
+      pthread_mutex_unlock(&s->run_mu);
+      return;
+    }
+
+    if (atomic_fetch_sub(&parent->refs, 1) == 1) {
+      atomic_store(&parent->refs, 1); // pai volta a rodar, aqui mesmo
+      c = parent;
+      continue;
+    }
+    return;
+  }
+}
+
+static void reactor_poll(SchedWorker *w, int timeout_ms) {
+  struct epoll_event events[16];
+  int n = epoll_wait(w->epfd, events, 16, timeout_ms);
+  for (int i = 0; i < n; i++) {
+    if (events[i].data.ptr == NULL) { // wakefd
+      uint64_t v;
+      ssize_t r = read(w->wakefd, &v, sizeof(v));
+      (void)r;
+      continue;
+    }
+    atomic_fetch_sub(&w->io_waiting, 1);
+    if (!ws_push(&w->deque, events[i].data.ptr))
+      while (!mpmc_push(&w->s->inject, events[i].data.ptr))
+        sched_yield();
+  }
+}
+
+static Coro *find_work(SchedWorker *w) {
+  Coro *c = ws_take(&w->deque);
+  if (c)
+    return c;
+  c = mpmc_pop(&w->s->inject);
+  if (c)
+    return c;
+
+  // Rouba de uma vítima aleatória primeiro — por quê? Espalha a disputa
+  Scheduler *s = w->s;
+  w->rng = w->rng * 1103515245u + 12345u;
+  unsigned start = w->rng >> 16;
+  for (int i = 0; i < s->count; i++) {
+    SchedWorker *victim = &s->workers[(start + i) % s->count];
+    if (victim == w)
+      continue;
+    c = ws_steal(&victim->deque);
+    if (c)
+      return c;
+  }
+  return NULL;
+}
+
+static void *worker_main(void *arg) {
+  SchedWorker *w = arg;
+  Scheduler *s = w->s;
+
+  while (!atomic_load(&s->stop)) {
+    if (atomic_load(&w->io_waiting) && ++w->tick % REACTOR_POLL_EVERY == 0)
+      reactor_poll(w, 0);
+
+    Coro *c = find_work(w);
+    if (c) {
+      run_coro(w, c);
+      continue;
+    }
+
+    // Estaciona: anuncia, confere de novo (evita wakeup perdido) e dorme no
+    // epoll até alguém escrever no wakefd ou um fd ficar pronto
+    atomic_store(&w->sleeping, 1);
+    atomic_fetch_add(&s->sleepers, 1);
+    c = find_work(w);
+    if (c) {
+      atomic_store(&w->sleeping, 0);
+      atomic_fetch_sub(&s->sleepers, 1);
+      run_coro(w, c);
+      continue;
+    }
+    if (!atomic_load(&s->stop))
+      reactor_poll(w, PARK_TIMEOUT_MS);
+    atomic_store(&w->sleeping, 0);
+    atomic_fetch_sub(&s->sleepers, 1);
+  }
+  return NULL;
+}
+
+static int cpu_count(void) {
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    return CPU_COUNT(&set);
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+}
+
+static int worker_init(SchedWorker *w, Scheduler *s, int id) {
+  *w = (SchedWorker){.s = s, .id = id, .epfd = -1, .wakefd = -1};
+  w->rng = 0x9e3779b9u * (unsigned)(id + 1);
+  atomic_init(&w->sleeping, 0);
+  atomic_init(&w->io_waiting, 0);
+  if (!ws_init(&w->deque, DEQUE_CAPACITY))
+    return 0;
+  w->epfd = epoll_create1(EPOLL_CLOEXEC);
+  w->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (w->epfd < 0 || w->wakefd < 0)
+    return 0;
+  struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+  return epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->wakefd, &ev) == 0;
+}
+
+static void worker_fini(SchedWorker *w) {
+  ws_destroy(&w->deque);
+  if (w->epfd >= 0)
+    close(w->epfd);
+  if (w->wakefd >= 0)
+    close(w->wakefd);
+}
+
+Scheduler *sched_create(int threads) {
+  if (threads <= 0)
+    threads = cpu_count();
+
+  Scheduler *s = calloc(1, sizeof(Scheduler));
+  if (!s)
+    return NULL;
+  s->workers = calloc((size_t)threads, sizeof(SchedWorker));
+  if (!s->workers || !mpmc_init(&s->inject, INJECT_CAPACITY)) {
+    free(s->workers);
+    free(s);
+    return NULL;
+  }
+  atomic_init(&s->stop, 0);
+  atomic_init(&s->sleepers, 0);
+  atomic_init(&s->wake_rr, 0);
+  pthread_mutex_init(&s->run_mu, NULL);
+  pthread_cond_init(&s->run_cv, NULL);
+
+  // Todos os workers existem antes de qualquer thread começar a roubar
+  for (int i = 0; i < threads; i++) {
+    if (!worker_init(&s->workers[i], s, i)) {
+      s->count = i + 1;
+      sched_destroy(s);
+      return NULL;
+    }
+  }
+  s->count = threads;
+
+  for (int i = 0; i < threads; i++) {
+    if (pthread_create(&s->workers[i].thread, NULL, worker_main,
+                       &s->workers[i]) != 0) {
+      atomic_store(&s->stop, 1);
+      for (int j = 0; j < i; j++)
+        pthread_join(s->workers[j].thread, NULL);
+      for (int j = 0; j < threads; j++)
+        worker_fini(&s->workers[j]);
+      mpmc_destroy(&s->inject);
+      free(s->workers);
+      free(s);
+      return NULL;
+    }
+  }
+  return s;
+}
+
+void sched_destroy(Scheduler *s) {
+  if (!s)
+    return;
+  atomic_store(&s->stop, 1);
+  for (int i = 0; i < s->count; i++) {
+    uint64_t one = 1;
+    ssize_t n = write(s->workers[i].wakefd, &one, sizeof(one));
+    (void)n;
+  }
+  for (int i = 0; i < s->count; i++) {
+    if (s->workers[i].thread)
+      pthread_join(s->workers[i].thread, NULL);
+    worker_fini(&s->workers[i]);
+  }
+  mpmc_destroy(&s->inject);
+  pthread_mutex_destroy(&s->run_mu);
+  pthread_cond_destroy(&s->run_cv);
+  free(s->workers);
+  free(s);
+}
+
+void sched_run(Scheduler *s, Coro *root) {
+  root->parent = NULL;
+  s->run_done = 0;
+  while (!mpmc_push(&s->inject, root))
+    sched_yield();
+  wake_one(s);
+
+  pthread_mutex_lock(&s->run_mu);
+  while (!s->run_done)
+    pthread_cond_wait(&s->run_cv, &s->run_mu);
+  pthread_mutex_unlock(&s->run_mu);
+}
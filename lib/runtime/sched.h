@@ -0,0 +1,52 @@
+// sched.h — runtime de corrotinas stackless
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+typedef struct Scheduler Scheduler;
+typedef struct SchedWorker SchedWorker;
+typedef struct Coro Coro;
+
+typedef enum {
+  CORO_DONE,
+  CORO_SUSPENDED, // alguém (último filho, reactor) vai reenfileirar
+} CoroStatus;
+
+// Corrotina stackless: o estado fica no objeto que embute Coro (primeiro
+// campo), não numa pilha nativa — por quê? Dezenas de milhares de tarefas
+// em poucas threads sem uma pilha por tarefa. resume continua de onde parou
+struct Coro {
+  CoroStatus (*resume)(SchedWorker *w, Coro *c);
+  void (*on_done)(Coro *c); // chamado uma vez depois de CORO_DONE
+  Coro *parent;
+  // Filhos vivos + 1 enquanto a própria corrotina está rodando. Quem leva o
+  // contador a zero é dono da retomada — por quê? Sem isso o pai suspenso e
+  // o último filho podiam os dois mexer no pai (ou um já liberado)
+  _Atomic int refs;
+};
+
+void coro_init(Coro *c, CoroStatus (*resume)(SchedWorker *, Coro *),
+               void (*on_done)(Coro *));
+
+// threads <= 0 usa o número de CPUs
+Scheduler *sched_create(int threads);
+void sched_destroy(Scheduler *s);
+
+// Roda root (e tudo que ela spawnar) no pool e bloqueia até terminar. Uma
+// chamada por vez por Scheduler
+void sched_run(Scheduler *s, Coro *root);
+
+// Enfileira child como filha de parent no deque local do worker
+void sched_spawn(SchedWorker *w, Coro *child, Coro *parent);
+
+// 1 se não há filhos pendentes (segue rodando); 0 se suspendeu — resume
+// deve retornar CORO_SUSPENDED sem tocar mais em c, o último filho retoma
+int sched_join(Coro *c);
+
+// Reactor: suspende c até fd ficar pronto (events = EPOLLIN/EPOLLOUT).
+// resume deve retornar CORO_SUSPENDED logo depois; 0 se o epoll recusou
+int sched_wait_fd(SchedWorker *w, Coro *c, int fd, uint32_t events);
+
+#endif
@@ -0,0 +1,428 @@
+#include "simd.h"
+#include <string.h>
+
+// Kernels nativos por arquitetura, escolhidos em tempo de execução — por
+// quê? O binário padrão sai com SSE2 só, mas a máquina quase sempre tem
+// AVX2. Sem x86 (ou sem a extensão), cai no laço escalar; -DMODAL_SIMD_SCALAR
+// força o escalar sempre
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) &&        \
+    !defined(MODAL_SIMD_SCALAR)
+#include <immintrin.h>
+#define SIMD_X86 1
+#endif
+
+int simd_lane_count(SimdType type) {
+  switch (type) {
+  case SIMD_I32X4:
+    return 4;
+  case SIMD_I32X8:
+    return 8;
+  case SIMD_I64X2:
+    return 2;
+  case SIMD_I64X4:
+    return 4;
+  }
+  return 0;
+}
+
+static const char *const type_names[] = {"i32x4", "i32x8", "i64x2", "i64x4"};
+
+const char *simd_type_name(SimdType type) { return type_names[type]; }
+
+int simd_type_from_name(const char *name, int len, SimdType *out) {
+  for (int i = 0; i < 4; i++)
+    if (len == 5 && memcmp(name, type_names[i], 5) == 0) {
+      *out = (SimdType)i;
+      return 1;
+    }
+  return 0;
+}
+
+static int is_i32(SimdType type) {
+  return type == SIMD_I32X4 || type == SIMD_I32X8;
+}
+
+static int is_wide(SimdType type) {
+  return type == SIMD_I32X8 || type == SIMD_I64X4;
+}
+
+long long simd_get(const SimdVec *v, int lane) {
+  return is_i32(v->type) ? v->lanes.i32[lane] : v->lanes.i64[lane];
+}
+
+void simd_set(SimdVec *v, int lane, long long value) {
+  if (is_i32(v->type))
+    v->lanes.i32[lane] = (int32_t)(uint32_t)(unsigned long long)value;
+  else
+    v->lanes.i64[lane] = value;
+}
+
+void simd_splat(SimdVec *v, SimdType type, long long value) {
+  memset(v, 0, sizeof(*v));
+  v->type = type;
+  for (int i = 0; i < simd_lane_count(type); i++)
+    simd_set(v, i, value);
+}
+
+// Escalar: referência e fallback. Unsigned no meio — por quê? Overflow de
+// signed é UB em C; nas lanes tem que dar a volta igual ao hardware
+static long long lane_op(SimdOp op, long long a, long long b, int i32) {
+  unsigned long long ua = (unsigned long long)a, ub = (unsigned long long)b;
+  switch (op) {
+  case SIMD_ADD:
+    return (long long)(ua + ub);
+  case SIMD_SUB:
+    return (long long)(ua - ub);
+  case SIMD_MUL:
+    return (long long)(ua * ub);
+  case SIMD_DIV:
+    // INT_MIN / -1 estoura; dá a volta pro próprio INT_MIN
+    if (b == -1)
+      return (long long)(0 - ua);
+    return i32 ? (int32_t)a / (int32_t)b : a / b;
+  case SIMD_EQ:
+    return a == b ? -1 : 0;
+  case SIMD_NE:
+    return a != b ? -1 : 0;
+  case SIMD_LT:
+    return a < b ? -1 : 0;
+  case SIMD_LE:
+    return a <= b ? -1 : 0;
+  case SIMD_GT:
+    return a > b ? -1 : 0;
+  case SIMD_GE:
+    return a >= b ? -1 : 0;
+  case SIMD_AND:
+    return (long long)(ua & ub);
+  }
+  return 0;
+}
+
+static void scalar_binop(SimdOp op, const SimdVec *a, const SimdVec *b,
+                         SimdVec *out) {
+  int i32 = is_i32(a->type);
+  for (int i = 0; i < simd_lane_count(a->type); i++)
+    simd_set(out, i, lane_op(op, simd_get(a, i), simd_get(b, i), i32));
+}
+
+#ifdef SIMD_X86
+// NE/LE/GE são o complemento de EQ/GT/LT — máscara xor tudo-um
+__attribute__((target("avx2"))) static int avx2_binop(SimdOp op,
+                                                      const SimdVec *a,
+                                                      const SimdVec *b,
+                                                      SimdVec *out) {
+  __m256i x = _mm256_load_si256((const __m256i *)a->lanes.i32);
+  __m256i y = _mm256_load_si256((const __m256i *)b->lanes.i32);
+  __m256i r, ones = _mm256_set1_epi32(-1);
+  int i32 = is_i32(a->type);
+  switch (op) {
+  case SIMD_ADD:
+    r = i32 ? _mm256_add_epi32(x, y) : _mm256_add_epi64(x, y);
+    break;
+  case SIMD_SUB:
+    r = i32 ? _mm256_sub_epi32(x, y) : _mm256_sub_epi64(x, y);
+    break;
+  case SIMD_MUL:
+    if (!i32)
+      return 0; // mullo de 64 bits só no AVX-512
+    r = _mm256_mullo_epi32(x, y);
+    break;
+  case SIMD_EQ:
+  case SIMD_NE:
+    r = i32 ? _mm256_cmpeq_epi32(x, y) : _mm256_cmpeq_epi64(x, y);
+    if (op == SIMD_NE)
+      r = _mm256_xor_si256(r, ones);
+    break;
+  case SIMD_GT:
+  case SIMD_LE:
+    r = i32 ? _mm256_cmpgt_epi32(x, y) : _mm256_cmpgt_epi64(x, y);
+    if (op == SIMD_LE)
+      r = _mm256_xor_si256(r, ones);
+    break;
+  case SIMD_LT:
+  case SIMD_GE:
+    r = i32 ? _mm256_cmpgt_epi32(y, x) : _mm256_cmpgt_epi64(y, x);
+    if (op == SIMD_GE)
+      r = _mm256_xor_si256(r, ones);
+    break;
+  case SIMD_AND:
+    r = _mm256_and_si256(x, y);
+    break;
+  default:
+    return 0; // divisão inteira não tem instrução vetorial
+  }
+  _mm256_store_si256((__m256i *)out->lanes.i32, r);
+  return 1;
+}
+
+__attribute__((target("sse4.2"))) static int sse_binop(SimdOp op,
+                                                       const SimdVec *a,
+                                                       const SimdVec *b,
+                                                       SimdVec *out) {
+  __m128i x = _mm_load_si128((const __m128i *)a->lanes.i32);
+  __m128i y = _mm_load_si128((const __m128i *)b->lanes.i32);
+  __m128i r, ones = _mm_set1_epi32(-1);
+  int i32 = is_i32(a->type);
+  switch (op) {
+  case SIMD_ADD:
+    r = i32 ? _mm_add_epi32(x, y) : _mm_add_epi64(x, y);
+    break;
+  case SIMD_SUB:
+    r = i32 ? _mm_sub_epi32(x, y) : _mm_sub_epi64(x, y);
+    break;
+  case SIMD_MUL:
+    if (!i32)
+      return 0;
+    r = _mm_mullo_epi32(x, y);
+    break;
+  case SIMD_EQ:
+  case SIMD_NE:
+    r = i32 ? _mm_cmpeq_epi32(x, y) : _mm_cmpeq_epi64(x, y);
+    if (op == SIMD_NE)
+      r = _mm_xor_si128(r, ones);
+    break;
+  case SIMD_GT:
+  case SIMD_LE:
+    r = i32 ? _mm_cmpgt_epi32(x, y) : _mm_cmpgt_epi64(x, y);
+    if (op == SIMD_LE)
+      r = _mm_xor_si128(r, ones);
+    break;
+  case SIMD_LT:
+  case SIMD_GE:
+    r = i32 ? _mm_cmpgt_epi32(y, x) : _mm_cmpgt_epi64(y, x);
+    if (op == SIMD_GE)
+      r = _mm_xor_si128(r, ones);
+    break;
+  case SIMD_AND:
+    r = _mm_and_si128(x, y);
+    break;
+  default:
+    return 0;
+  }
+  _mm_store_si128((__m128i *)out->lanes.i32, r);
+  return 1;
+}
+
+// Arrays: 4 lanes de 64 bits por iteração, resto no escalar. Sem mul de 64
+// bits no AVX2 — mul e div ficam com o laço escalar
+__attribute__((target("avx2"))) static size_t
+avx2_array_op(SimdOp op, const int64_t *a, const int64_t *b, int64_t *out,
+              size_t n) {
+  const __m256i one = _mm256_set1_epi64x(1);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+    __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+    __m256i r;
+    switch (op) {
+    case SIMD_ADD:
+      r = _mm256_add_epi64(x, y);
+      break;
+    case SIMD_SUB:
+      r = _mm256_sub_epi64(x, y);
+      break;
+    case SIMD_AND:
+      r = _mm256_and_si256(x, y);
+      break;
+    case SIMD_EQ:
+      r = _mm256_and_si256(_mm256_cmpeq_epi64(x, y), one);
+      break;
+    case SIMD_NE:
+      r = _mm256_andnot_si256(_mm256_cmpeq_epi64(x, y), one);
+      break;
+    case SIMD_GT:
+      r = _mm256_and_si256(_mm256_cmpgt_epi64(x, y), one);
+      break;
+    case SIMD_LE:
+      r = _mm256_andnot_si256(_mm256_cmpgt_epi64(x, y), one);
+      break;
+    case SIMD_LT:
+      r = _mm256_and_si256(_mm256_cmpgt_epi64(y, x), one);
+      break;
+    case SIMD_GE:
+      r = _mm256_andnot_si256(_mm256_cmpgt_epi64(y, x), one);
+      break;
+    default:
+      return i;
+    }
+    _mm256_storeu_si256((__m256i *)(out + i), r);
+  }
+  return i;
+}
+
+static size_t native_array_op(SimdOp op, const int64_t *a, const int64_t *b,
+                              int64_t *out, size_t n) {
+  return __builtin_cpu_supports("avx2") ? avx2_array_op(op, a, b, out, n) : 0;
+}
+
+static int native_binop(SimdOp op, const SimdVec *a, const SimdVec *b,
+                        SimdVec *out) {
+  if (is_wide(a->type))
+    return __builtin_cpu_supports("avx2") && avx2_binop(op, a, b, out);
+  return __builtin_cpu_supports("sse4.2") && sse_binop(op, a, b, out);
+}
+#else
+static size_t native_array_op(SimdOp op, const int64_t *a, const int64_t *b,
+                              int64_t *out, size_t n) {
+  (void)op, (void)a, (void)b, (void)out, (void)n;
+  return 0;
+}
+
+static int native_binop(SimdOp op, const SimdVec *a, const SimdVec *b,
+                        SimdVec *out) {
+  (void)op, (void)a, (void)b, (void)out;
+  return 0;
+}
+#endif
+
+int simd_binop(SimdOp op, const SimdVec *a, const SimdVec *b, SimdVec *out) {
+  if (op == SIMD_DIV)
+    for (int i = 0; i < simd_lane_count(b->type); i++)
+      if (simd_get(b, i) == 0)
+        return 0;
+
+  SimdVec r;
+  memset(&r, 0, sizeof(r)); // lanes além da largura ficam zeradas
+  r.type = a->type;
+  if (!native_binop(op, a, b, &r))
+    scalar_binop(op, a, b, &r);
+  *out = r;
+  return 1;
+}
+
+long long simd_reduce(SimdReduce op, const SimdVec *v) {
+  int n = simd_lane_count(v->type);
+  long long acc = simd_get(v, 0);
+  unsigned long long sum = (unsigned long long)acc;
+  int all = acc != 0, any = acc != 0;
+  for (int i = 1; i < n; i++) {
+    long long x = simd_get(v, i);
+    sum += (unsigned long long)x;
+    if (op == SIMD_MIN && x < acc)
+      acc = x;
+    if (op == SIMD_MAX && x > acc)
+      acc = x;
+    all &= x != 0;
+    any |= x != 0;
+  }
+  switch (op) {
+  case SIMD_SUM: {
+    SimdVec wrap; // soma dá a volta na largura da lane, como o add vetorial
+    wrap.type = v->type;
+    simd_set(&wrap, 0, (long long)sum);
+    return simd_get(&wrap, 0);
+  }
+  case SIMD_ALL:
+    return all;
+  case SIMD_ANY:
+    return any;
+  default:
+    return acc;
+  }
+}
+
+void simd_shuffle(const SimdVec *v, const int *idx, SimdVec *out) {
+  SimdVec r;
+  memset(&r, 0, sizeof(r));
+  r.type = v->type;
+  for (int i = 0; i < simd_lane_count(v->type); i++)
+    simd_set(&r, i, simd_get(v, idx[i]));
+  *out = r;
+}
+
+int simd_array_op(SimdOp op, const int64_t *a, const int64_t *b,
+                  int64_t *out, size_t n) {
+  size_t i = native_array_op(op, a, b, out, n);
+  // Switch fora do laço — por quê? mul/div (sem instrução vetorial) são o
+  // caminho quente; um laço apertado por operação
+  switch (op) {
+  case SIMD_MUL:
+    for (; i < n; i++)
+      out[i] = (int64_t)((uint64_t)a[i] * (uint64_t)b[i]);
+    return 1;
+  case SIMD_DIV:
+    for (size_t j = i; j < n; j++)
+      if (b[j] == 0)
+        return 0;
+    for (; i < n; i++)
+      out[i] = b[i] == -1 ? (int64_t)(0 - (uint64_t)a[i]) : a[i] / b[i];
+    return 1;
+  default: {
+    int cmp = op >= SIMD_EQ && op <= SIMD_GE;
+    for (; i < n; i++) {
+      long long r = lane_op(op, a[i], b[i], 0);
+      out[i] = cmp ? r & 1 : r; // escalar: -1/0 -> 1/0
+    }
+    return 1;
+  }
+  }
+}
+
+// Hacker's Delight 10-1 (versão com sinal, 64 bits)
+int simd_divisor_init(SimdDivisor *div, int64_t d) {
+  div->d = d;
+  div->magic = 0;
+  div->shift = 0;
+  if (d == 0)
+    return 0;
+  if (d == 1 || d == -1)
+    return 1; // simd_array_div_by trata à parte
+
+  const uint64_t two63 = 1ULL << 63;
+  uint64_t ad = d < 0 ? 0 - (uint64_t)d : (uint64_t)d;
+  uint64_t t = two63 + ((uint64_t)d >> 63);
+  uint64_t anc = t - 1 - t % ad;
+  uint64_t q1 = two63 / anc, r1 = two63 - q1 * anc;
+  uint64_t q2 = two63 / ad, r2 = two63 - q2 * ad;
+  uint64_t delta;
+  int p = 63;
+  do {
+    p++;
+    q1 *= 2;
+    r1 *= 2;
+    if (r1 >= anc) {
+      q1++;
+      r1 -= anc;
+    }
+    q2 *= 2;
+    r2 *= 2;
+    if (r2 >= ad) {
+      q2++;
+      r2 -= ad;
+    }
+    delta = ad - r2;
+  } while (q1 < delta || (q1 == delta && r1 == 0));
+
+  div->magic = (int64_t)(q2 + 1);
+  if (d < 0)
+    div->magic = (int64_t)(0 - (uint64_t)div->magic);
+  div->shift = p - 64;
+  return 1;
+}
+
+void simd_array_div_by(const int64_t *a, const SimdDivisor *div, int64_t *out,
+                       size_t n) {
+  if (div->d == 1) {
+    for (size_t i = 0; i < n; i++)
+      out[i] = a[i];
+    return;
+  }
+  if (div->d == -1) { // INT64_MIN / -1 dá a volta, igual ao escalar
+    for (size_t i = 0; i < n; i++)
+      out[i] = (int64_t)(0 - (uint64_t)a[i]);
+    return;
+  }
+  int64_t m = div->magic, d = div->d;
+  int s = div->shift;
+  for (size_t i = 0; i < n; i++) {
+    int64_t x = a[i];
+    int64_t q = (int64_t)(((__int128)m * x) >> 64); // mulhs
+    if (d > 0 && m < 0)
+      q += x;
+    else if (d < 0 && m > 0)
+      q -= x;
+    q >>= s;
+    q += (int64_t)((uint64_t)q >> 63); // arredonda pra zero, como C
+    out[i] = q;
+  }
+}
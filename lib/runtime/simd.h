@@ -0,0 +1,71 @@
+// simd.h — vetores de largura fixa do Modal
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Só lanes inteiras por enquanto — o avaliador ainda é todo inteiro
+typedef enum { SIMD_I32X4, SIMD_I32X8, SIMD_I64X2, SIMD_I64X4 } SimdType;
+
+typedef enum {
+  SIMD_ADD,
+  SIMD_SUB,
+  SIMD_MUL,
+  SIMD_DIV,
+  SIMD_EQ, // comparações dão máscara: lane -1 (verdade) ou 0
+  SIMD_NE,
+  SIMD_LT,
+  SIMD_LE,
+  SIMD_GT,
+  SIMD_GE,
+  SIMD_AND, // bit a bit — aplica máscara de comparação
+} SimdOp;
+
+typedef enum { SIMD_SUM, SIMD_MIN, SIMD_MAX, SIMD_ALL, SIMD_ANY } SimdReduce;
+
+// 32 bytes alinhados — por quê? Load/store direto em registrador AVX
+typedef struct {
+  SimdType type;
+  _Alignas(32) union {
+    int32_t i32[8];
+    int64_t i64[4];
+  } lanes;
+} SimdVec;
+
+int simd_lane_count(SimdType type);
+const char *simd_type_name(SimdType type);
+// "i32x4" -> SIMD_I32X4; 0 se o nome não é tipo vetor
+int simd_type_from_name(const char *name, int len, SimdType *out);
+
+long long simd_get(const SimdVec *v, int lane);
+void simd_set(SimdVec *v, int lane, long long value); // trunca pra lane
+void simd_splat(SimdVec *v, SimdType type, long long value);
+
+// Lane a lane, mesmo tipo nos dois lados. Aritmética dá a volta como em
+// complemento de dois; retorna 0 só em divisão por zero
+int simd_binop(SimdOp op, const SimdVec *a, const SimdVec *b, SimdVec *out);
+long long simd_reduce(SimdReduce op, const SimdVec *v);
+// out[i] = v[idx[i]]; idx já validado (0 <= idx < lanes)
+void simd_shuffle(const SimdVec *v, const int *idx, SimdVec *out);
+
+// Mesmas operações sobre arrays de int64 (laço fundido do pipeline: uma
+// chamada por operação por bloco, não por elemento). Aqui comparação dá
+// 1/0, como no escalar; retorna 0 em divisão por zero
+int simd_array_op(SimdOp op, const int64_t *a, const int64_t *b,
+                  int64_t *out, size_t n);
+
+// Divisão por constante sem idiv: multiplica pelo "número mágico" e
+// desloca (Granlund–Montgomery), o que o compilador C faz com x / 3
+typedef struct {
+  int64_t d;
+  int64_t magic;
+  int shift;
+} SimdDivisor;
+
+// 0 se d == 0
+int simd_divisor_init(SimdDivisor *div, int64_t d);
+void simd_array_div_by(const int64_t *a, const SimdDivisor *div, int64_t *out,
+                       size_t n);
+
+#endif
@@ -1,42 +1,445 @@
-#include "ast/parser.h"
-#include "lib/compiler/test_runner.h"
-#include "tokenizer/tokenizer.h"
+#define _POSIX_C_SOURCE 200809L // open/stat/STDIN_FILENO
+#include "ast/layout.h"
+#include "lib/compiler/coverage.h"
+#include "lib/compiler/ir.h"
+#include "lib/compiler/profile.h"
+#include "lib/compiler/watch.h"
+#include "lib/modal.h"
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
-int main(int argc, char **argv) {
-  if (argc < 2) {
-    fprintf(stderr, "Uso: %s arquivo.modal\n", argv[0]);
+static void usage(const char *prog) {
+  fprintf(stderr, "Uso: %s [opções] arquivo.modal\n", prog);
+  fprintf(stderr, "     %s [opções] -   (lê o fonte do stdin em stream)\n",
+          prog);
+  fprintf(stderr, "     %s --watch <arquivos ou diretórios...>\n", prog);
+  fprintf(stderr, "     %s --coverage-report [arquivo]   (padrão: %s)\n", prog,
+          COVERAGE_DEFAULT_PATH);
+  fprintf(stderr, "\nOpções:\n");
+  fprintf(stderr, "  --rerun      roda todos os tests, ignorando o cache\n");
+  fprintf(stderr, "  --no-cache   não lê nem grava o cache de resultados "
+                  "nem as interfaces\n");
+  fprintf(stderr, "  --cache-file <caminho>  (padrão: %s)\n",
+          TEST_CACHE_DEFAULT_PATH);
+  fprintf(stderr, "  --iface-dir <dir>    interfaces dos módulos (padrão: %s)\n",
+          PROGRAM_IFACE_DIR);
+  fprintf(stderr, "  --max-errors <n>     para o parse depois de n erros\n");
+  fprintf(stderr, "  --json-diagnostics   erros como JSON compacto\n");
+  fprintf(stderr, "  --threads <n>        workers pros tests com async\n");
+  fprintf(stderr, "  --isolate            cada test num processo filho, "
+                  "forkado depois do parse\n");
+  fprintf(stderr, "  --isolate-workers <n>  filhos ao mesmo tempo "
+                  "(padrão: nº de CPUs)\n");
+  fprintf(stderr, "  --shards <n>         divide os tests em n processos pelo "
+                  "tempo da última vez\n");
+  fprintf(stderr, "  --shard <i>/<n>      roda só o i-ésimo de n shards "
+                  "(ex: um por máquina de CI)\n");
+  fprintf(stderr, "  --timings-file <caminho>  tempo de cada test "
+                  "(padrão: %s)\n",
+          TIMINGS_DEFAULT_PATH);
+  fprintf(stderr, "  --test-time          tempo só dos tests, sem parse, no "
+                  "stderr\n");
+  fprintf(stderr, "  --layout-report      offsets e padding de cada struct\n");
+  fprintf(stderr, "  --dump-ir            IR em SSA de cada test, já otimizada\n");
+  fprintf(stderr, "  --hash-cons          expressões repetidas viram um nó só, "
+                  "com memo (relatório no fim)\n");
+  fprintf(stderr, "  --link <lib.so>      biblioteca pras funções de use "
+                  "\"foo.h\" (repetível)\n");
+  fprintf(stderr, "  --coverage           conta blocos e statements dos tests "
+                  "(sem cache)\n");
+  fprintf(stderr, "  --coverage-file <caminho>  (padrão: %s)\n",
+          COVERAGE_DEFAULT_PATH);
+  fprintf(stderr, "  --profile            amostra a pilha dos tests pra "
+                  "flamegraph (sem cache)\n");
+  fprintf(stderr, "  --profile-file <caminho>   (padrão: %s)\n",
+          PROFILE_DEFAULT_PATH);
+  fprintf(stderr, "  --profile-hz <n>     amostras por segundo de CPU "
+                  "(padrão: %d)\n",
+          PROFILE_DEFAULT_HZ);
+}
+
+// Plano depois do parse, com todos os tests na mão. Sem memória o --shards
+// roda com a fila única do --isolate; o --shard i/N não tem como saber
+// quais são os seus, então não roda nada
+static int plan_shards(ModalContext *ctx, ShardPlan *plan, int nbins,
+                       int tests_ok) {
+  if (!ctx->plan)
+    return 1;
+  if (tests_ok && shard_plan(plan, nbins)) {
+    shard_report(plan, ctx->shard - 1, stderr);
     return 1;
   }
+  fprintf(stderr, "sem memória pro plano dos shards\n");
+  ctx->plan = NULL;
+  return !ctx->shard;
+}
+
+// Contadores só depois de todos os slots; sem memória roda sem cobertura
+static void arm_coverage(ModalContext *ctx, Coverage *cov, int slots_ok) {
+  if (slots_ok && coverage_arm(cov))
+    ctx->coverage = cov->counts;
+  else
+    fprintf(stderr, "aviso: sem memória pro --coverage\n");
+}
+
+// Timer ligado só em volta dos tests: parse e relatório ficam de fora
+static void run_profiled(ModalContext *ctx, Profiler *prof, int tests_ok) {
+  if (tests_ok && profiler_start(prof))
+    ctx->profile = 1;
+  else
+    fprintf(stderr, "aviso: --profile não ligou\n");
+}
 
-  FILE *f = fopen(argv[1], "rb");
-  if (!f)
+// Com --json-diagnostics vira um registro no mesmo array — por quê? Quem lê
+// o stderr como JSON engasga com uma linha de texto solta
+static void unreadable(const char *path, int json) {
+  if (json)
+    diag_render_json_error(path, "não consegui ler o arquivo", stderr);
+  else
+    fprintf(stderr, "não consegui ler %s\n", path);
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// --test-time: de fora, o relógio do processo mede o parse junto — e num
+// workload grande ele é quase tudo (bench/coverage.sh lê essa linha)
+static void report_test_time(uint64_t start) {
+  if (start)
+    fprintf(stderr, "tempo dos tests: %.3f ms\n",
+            (double)(now_ns() - start) / 1e6);
+}
+
+static void finish_profile(ModalContext *ctx, Profiler *prof,
+                           const char *path) {
+  if (!ctx->profile)
+    return;
+  profiler_stop(prof);
+  ctx->profile = 0;
+  FILE *out = fopen(path, "w");
+  int ok = out && profiler_write(prof, out);
+  if (out)
+    ok = (fclose(out) == 0) && ok;
+  if (!ok) {
+    fprintf(stderr, "aviso: não consegui gravar %s\n", path);
+    return;
+  }
+  uint64_t samples, dropped;
+  profiler_totals(prof, &samples, &dropped);
+  fprintf(stderr, "perfil: %llu amostras em %s", (unsigned long long)samples,
+          path);
+  if (dropped)
+    fprintf(stderr, " (%llu perdidas)", (unsigned long long)dropped);
+  fputc('\n', stderr);
+}
+
+int main(int argc, char **argv) {
+  const char *path = NULL;
+  const char *cache_path = TEST_CACHE_DEFAULT_PATH;
+  const char *iface_dir = PROGRAM_IFACE_DIR;
+  int use_cache = 1;
+  int rerun = 0;
+  size_t max_errors = 0;
+  int json_diag = 0;
+  int threads = 0;
+  int isolate = 0;
+  int isolate_workers = 0;
+  int shard = 0, nshards = 0, shards = 0;
+  const char *timings_path = TIMINGS_DEFAULT_PATH;
+  int test_time = 0;
+  int report_layout = 0;
+  int dump_ir = 0;
+  int hash_cons = 0;
+  const char *links[FFI_MAX_LIBS];
+  size_t nlinks = 0;
+  int coverage = 0;
+  const char *coverage_path = COVERAGE_DEFAULT_PATH;
+  int profile = 0;
+  int profile_hz = 0;
+  const char *profile_path = PROFILE_DEFAULT_PATH;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--watch") == 0) {
+      if (i + 1 >= argc) {
+        usage(argv[0]);
+        return 1;
+      }
+      return watch_run(argv + i + 1, argc - i - 1);
+    } else if (strcmp(argv[i], "--coverage-report") == 0) {
+      const char *file = i + 1 < argc ? argv[i + 1] : COVERAGE_DEFAULT_PATH;
+      if (!coverage_report(file, stdout)) {
+        fprintf(stderr, "não consegui ler a cobertura em %s\n", file);
+        return 1;
+      }
+      return 0;
+    } else if (strcmp(argv[i], "--coverage") == 0) {
+      coverage = 1;
+    } else if (strcmp(argv[i], "--coverage-file") == 0 && i + 1 < argc) {
+      coverage_path = argv[++i];
+    } else if (strcmp(argv[i], "--profile") == 0) {
+      profile = 1;
+    } else if (strcmp(argv[i], "--profile-file") == 0 && i + 1 < argc) {
+      profile_path = argv[++i];
+    } else if (strcmp(argv[i], "--profile-hz") == 0 && i + 1 < argc) {
+      profile_hz = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--rerun") == 0) {
+      rerun = 1;
+    } else if (strcmp(argv[i], "--no-cache") == 0) {
+      use_cache = 0;
+    } else if (strcmp(argv[i], "--cache-file") == 0 && i + 1 < argc) {
+      cache_path = argv[++i];
+    } else if (strcmp(argv[i], "--iface-dir") == 0 && i + 1 < argc) {
+      iface_dir = argv[++i];
+    } else if (strcmp(argv[i], "--max-errors") == 0 && i + 1 < argc) {
+      max_errors = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--json-diagnostics") == 0) {
+      json_diag = 1;
+    } else if (strcmp(argv[i], "--test-time") == 0) {
+      test_time = 1;
+    } else if (strcmp(argv[i], "--layout-report") == 0) {
+      report_layout = 1;
+    } else if (strcmp(argv[i], "--dump-ir") == 0) {
+      dump_ir = 1;
+    } else if (strcmp(argv[i], "--hash-cons") == 0) {
+      hash_cons = 1;
+    } else if (strcmp(argv[i], "--link") == 0 && i + 1 < argc) {
+      if (nlinks == FFI_MAX_LIBS) {
+        fprintf(stderr, "no máximo %d --link\n", FFI_MAX_LIBS);
+        return 1;
+      }
+      links[nlinks++] = argv[++i];
+    } else if (strcmp(argv[i], "--isolate") == 0) {
+      isolate = 1;
+    } else if (strcmp(argv[i], "--isolate-workers") == 0 && i + 1 < argc) {
+      isolate_workers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+      shards = atoi(argv[++i]);
+      if (shards < 1) {
+        fprintf(stderr, "--shards precisa de n >= 1\n");
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--shard") == 0 && i + 1 < argc) {
+      char end;
+      if (sscanf(argv[++i], "%d/%d%c", &shard, &nshards, &end) != 2 ||
+          shard < 1 || shard > nshards) {
+        fprintf(stderr, "--shard espera i/n com 1 <= i <= n: %s\n", argv[i]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--timings-file") == 0 && i + 1 < argc) {
+      timings_path = argv[++i];
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+      fprintf(stderr, "opção desconhecida: %s\n", argv[i]);
+      usage(argv[0]);
+      return 1;
+    } else {
+      path = argv[i];
+    }
+  }
+
+  if (!path) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (shard && shards) {
+    fprintf(stderr, "--shard e --shards não combinam: --shards já roda "
+                    "todos os shards aqui\n");
     return 1;
-  fseek(f, 0, SEEK_END);
-  long size = ftell(f);
-  fseek(f, 0, SEEK_SET);
-  char *buffer = malloc(size + 1);
-  fread(buffer, 1, size, f);
-  buffer[size] = '\0';
-  fclose(f);
+  }
 
-  Tokenizer lexer;
-  init(&lexer, buffer);
+  ModalContext ctx;
+  modal_context_init(&ctx, NULL);
+  ctx.max_errors = max_errors;
+  ctx.threads = threads;
+  ctx.hash_cons = hash_cons;
+  for (size_t i = 0; i < nlinks; i++)
+    if (!modal_link(&ctx, links[i])) {
+      fprintf(stderr, "--link %s: %s\n", links[i], ffi_error());
+      modal_context_destroy(&ctx);
+      return 1;
+    }
 
-  Parser parser;
-  parser_init(&parser, &lexer, argv[1]);
+  // Cobertura e perfil rodam e parseiam tudo — por quê? Test que sai do
+  // cache não passa pelo executor
+  if (coverage || profile)
+    use_cache = 0;
+  // Contador e pilha de amostra vivem na memória do processo: o que o
+  // filho contasse morria com ele
+  if (isolate && (coverage || profile))
+    fprintf(stderr, "aviso: --isolate ignorado com --coverage/--profile\n");
+  else if (isolate)
+    ctx.isolate = isolate_workers > 0
+                      ? isolate_workers
+                      : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (shards && (coverage || profile)) {
+    fprintf(stderr, "aviso: --shards ignorado com --coverage/--profile\n");
+    shards = 0;
+  } else if (shards) {
+    ctx.isolate = shards; // um filho por shard, cada um com a sua fila
+  }
+  if (ctx.isolate < 0)
+    ctx.isolate = 1;
+  int nbins = shards ? shards : nshards;
+  ShardPlan plan;
+  shard_init(&plan);
+  if (nbins) {
+    ctx.plan = &plan;
+    ctx.shard = shard;
+  }
+  Coverage cov;
+  coverage_init(&cov);
+  Profiler *prof = profile ? profiler_create(profile_hz) : NULL;
+  if (profile && !prof)
+    fprintf(stderr, "aviso: sem memória pro --profile\n");
+
+  TestCache cache;
+  if (use_cache) {
+    test_cache_load(&cache, cache_path);
+    cache.refresh = rerun;
+    cache.scope = ast_hash_bytes(path, strlen(path));
+  }
+  TestCache *tests = use_cache ? &cache : NULL;
+  // Tempos andam com o cache. --shard i/N planeja só com o arquivo, sem o
+  // cache, e grava o que mediu em <arquivo>.i — por quê? Os n processos têm que chegar no
+  // mesmo plano, e o shard que termina antes mudaria os dois pros que ainda
+  // vão ler; a próxima rodada sem --shard junta tudo
+  TestTimings timings;
+  if (use_cache) {
+    timings_load(&timings, timings_path, shard);
+    timings.scope = cache.scope;
+    ctx.timings = &timings;
+  }
+  const TestTimings *known = use_cache ? &timings : NULL;
+  const TestCache *planned = shard ? NULL : tests;
+  int status = 0;
 
-  AstNode *root = parse_program(&parser);
+  // "-" ou pipe (ex: modal <(gerador)): lê em stream, parse anda junto com
+  // quem escreve — um arquivo só, sem módulos
+  struct stat st;
+  int stream = strcmp(path, "-") == 0 ||
+               (stat(path, &st) == 0 && !S_ISREG(st.st_mode));
+  if (stream) {
+    int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY);
+    const char *name = fd == STDIN_FILENO ? "<stdin>" : path;
+    AstNode *root = fd < 0 ? NULL : modal_parse_fd(&ctx, fd, name);
+    if (fd > STDIN_FILENO)
+      close(fd);
+    if (fd < 0)
+      unreadable(path, json_diag);
+    else if (json_diag)
+      diag_render_json(&ctx.diag, stderr);
+    else if (ctx.diag.count || ctx.diag.dropped)
+      diag_render(&ctx.diag, stderr);
 
-  if (parser.had_error) {
-    fprintf(stderr, "erros falhou com erros.\n");
+    if (!root) {
+      if (fd >= 0 && !json_diag) // o JSON já disse tudo
+        fprintf(stderr, "erros falhou com erros.\n");
+      status = 1;
+    } else {
+      printf("AST root kind: %d\n", root->kind);
+      if (report_layout)
+        layout_report(root, stdout);
+      if (dump_ir)
+        ir_report(root, stdout);
+      if (coverage)
+        arm_coverage(&ctx, &cov, coverage_add(&cov, root, name, NULL, 0));
+      if (prof)
+        run_profiled(&ctx, prof, profiler_add(prof, root, name));
+      if (plan_shards(&ctx, &plan, nbins,
+                      shard_add(&plan, root, known, planned))) {
+        uint64_t start = test_time ? now_ns() : 0;
+        if (modal_run_tests(&ctx, root, tests, NULL, NULL))
+          status = 1; // test falhou: CI tem que ver, com --shard ou não
+        report_test_time(start);
+        if (tests && !shard) {
+          test_cache_prune(tests);
+          timings_prune(&timings);
+        }
+      } else {
+        status = 1;
+      }
+      finish_profile(&ctx, prof, profile_path);
+      if (hash_cons) {
+        AstInternStats stats = {0};
+        modal_intern_stats(&ctx, &stats);
+        ast_intern_report(&stats, stderr);
+      }
+    }
   } else {
-    printf("AST root kind: %d\n", root ? root->kind : 0);
-    run_tests(root);
+    // Arquivo: ele e os use "x.modal" dele, com interface em iface_dir
+    Program prog;
+    int ok = modal_load_program(&ctx, &prog, path,
+                                use_cache ? iface_dir : NULL, tests,
+                                report_layout || dump_ir);
+    program_render(&prog, stderr, json_diag);
+
+    if (!prog.count) {
+      unreadable(path, json_diag);
+      status = 1;
+    } else if (!ok) {
+      if (!json_diag)
+        fprintf(stderr, "erros falhou com erros.\n");
+      status = 1;
+    } else {
+      AstNode *root = program_root(&prog);
+      if (root)
+        printf("AST root kind: %d\n", root->kind);
+      if (report_layout)
+        layout_report(root, stdout);
+      if (dump_ir)
+        ir_report(root, stdout);
+      if (coverage)
+        arm_coverage(&ctx, &cov, program_cover(&prog, &cov));
+      if (prof)
+        run_profiled(&ctx, prof, program_profile(&prog, prof));
+      if (plan_shards(&ctx, &plan, nbins,
+                      program_shard(&prog, &plan, known, planned))) {
+        uint64_t start = test_time ? now_ns() : 0;
+        if (modal_run_program_tests(&ctx, &prog, tests, NULL, NULL))
+          status = 1;
+        report_test_time(start);
+        if (tests && !shard) { // --shard i/N não viu os tests dos outros
+          test_cache_prune(tests);
+          timings_prune(&timings);
+        }
+      } else {
+        status = 1;
+      }
+      finish_profile(&ctx, prof, profile_path); // as ASTs ainda vivem
+      if (hash_cons) {
+        AstInternStats stats = {0};
+        program_intern_stats(&prog, &stats);
+        ast_intern_report(&stats, stderr);
+      }
+    }
+    program_free(&prog);
+  }
+
+  if (use_cache) {
+    if (!test_cache_save(&cache))
+      fprintf(stderr, "aviso: não consegui gravar %s\n", cache_path);
+    test_cache_free(&cache);
+    if (ctx.timings && !timings_save(&timings))
+      fprintf(stderr, "aviso: não consegui gravar %s\n", timings_path);
+    timings_free(&timings);
   }
+  shard_free(&plan);
+  if (ctx.coverage && !coverage_save(&cov, coverage_path))
+    fprintf(stderr, "aviso: não consegui gravar %s\n", coverage_path);
+  coverage_free(&cov);
+  profiler_destroy(prof);
 
-  ast_free(root);
-  free(buffer);
-  return parser.had_error ? 1 : 0;
+  if (ctx.error_count)
+    status = 1;
+  modal_context_destroy(&ctx);
+  return status;
 }
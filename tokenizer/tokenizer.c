@@ -1,8 +1,18 @@
 // tokenizer.c
+#define _POSIX_C_SOURCE 200809L // ssize_t/read no modo stream
 #include "tokenizer.h"
 #include <ctype.h>
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+
+// Miolo de string 16 bytes por vez — SSE2 é o mínimo do x86-64, sem
+// despacho em runtime; fora de x86 (ou -DMODAL_SIMD_SCALAR), 8 por vez
+#if defined(__SSE2__) && !defined(MODAL_SIMD_SCALAR)
+#include <emmintrin.h>
+#define LEXER_SSE2 1
+#endif
 
 const char *kind_to_string(Kind kind) {
   switch (kind) {
@@ -33,6 +43,7 @@ static const Keyword keywords[] = {
     {"use", 3, USE},     {"comptime", 8, COMPTIME}, {"union", 5, UNION},
     {"asm", 3, ASM},     {"volatile", 8, VOLATILE}, {"async", 5, ASYNC},
     {"await", 5, AWAIT}, {"and", 3, AND},           {"or", 2, OR},
+    {"struct", 6, STRUCT},
 };
 
 static Kind get_keyword(const char *s, int len) {
@@ -44,14 +55,64 @@ static Kind get_keyword(const char *s, int len) {
   return IDENTIFIER;
 }
 
-char peek(Tokenizer *t) {
-  printf("%.s", t->buffer);
+// Modo stream: garante n bytes à frente de pos (ou EOF). Compacta a janela
+// descartando o que veio antes do token em andamento — por quê? Token nunca
+// é cortado no meio, e o resto do fonte não precisa ficar residente
+static void stream_fill(Tokenizer *t, int64_t n) {
+  while (!t->eof && t->len - t->pos < n) {
+    int64_t keep = t->tok_start >= 0 ? t->tok_start : t->pos;
+
+    if (t->cap - t->len < TOKENIZER_CHUNK && keep > 0) {
+      memmove(t->window, t->window + keep, (size_t)(t->len - keep));
+      t->base += keep;
+      t->len -= keep;
+      t->pos -= keep;
+      if (t->tok_start >= 0)
+        t->tok_start -= keep;
+    }
+
+    if (t->cap - t->len < TOKENIZER_CHUNK) {
+      // Token maior que a janela (string/comentário gigante): cresce
+      size_t cap = (size_t)t->cap * 2;
+      char *window =
+          modal_realloc(t->alloc, t->window, (size_t)t->cap + 1, cap + 1);
+      if (!window) {
+        t->eof = 1; // sem memória: trata como fim do fonte
+        break;
+      }
+      t->window = window;
+      t->cap = (int64_t)cap;
+    }
+
+    ssize_t got = read(t->fd, t->window + t->len, TOKENIZER_CHUNK);
+    if (got < 0 && errno == EINTR)
+      continue;
+    if (got <= 0) {
+      t->eof = 1;
+      break;
+    }
+    t->len += got;
+  }
+
+  t->window[t->len] = '\0'; // peek vê '\0' no fim, igual ao modo buffer
+  t->buffer = t->window;
+}
+
+static inline char peek(Tokenizer *t) {
+  if (t->fd >= 0 && t->pos >= t->len)
+    stream_fill(t, 1);
   return t->buffer[t->pos];
 }
 
-char peek_next(Tokenizer *t) { return t->buffer[t->pos + 1]; }
+static inline char peek_next(Tokenizer *t) {
+  if (t->fd >= 0 && t->pos + 1 >= t->len)
+    stream_fill(t, 2);
+  if (t->buffer[t->pos] == '\0')
+    return '\0'; // não lê depois do terminador
+  return t->buffer[t->pos + 1];
+}
 
-char advance(Tokenizer *t) {
+static char advance(Tokenizer *t) {
   char c = t->buffer[t->pos++];
   if (c == '\n') {
     t->line++;
@@ -69,29 +130,190 @@ Token token_make(Kind kind, const char *start, int len, int line, int col) {
       .len = len,
       .line = line,
       .col = col,
+      .offset = 0,
   };
 }
 
-void init(Tokenizer *t, const char *buffer) {
-  t->buffer = buffer;
+struct LexemeBlock {
+  LexemeBlock *next;
+  size_t cap;
+  size_t used;
+  char data[];
+};
+
+// Cópia estável do lexema — no modo stream a janela anda, e AST/erros
+// guardam Token.start
+static const char *stable_lexeme(Tokenizer *t, const char *s, int len) {
+  LexemeBlock *b = t->lexemes;
+  if (!b || b->cap - b->used < (size_t)len) {
+    size_t cap = (size_t)len > TOKENIZER_CHUNK ? (size_t)len : TOKENIZER_CHUNK;
+    b = modal_alloc(t->alloc, sizeof(LexemeBlock) + cap);
+    if (!b)
+      return s;
+    b->next = t->lexemes;
+    b->cap = cap;
+    b->used = 0;
+    t->lexemes = b;
+  }
+  char *out = b->data + b->used;
+  memcpy(out, s, (size_t)len);
+  b->used += (size_t)len;
+  return out;
+}
+
+// Primeiro '"', '\\', '\n' ou '\0' a partir de pos, sem ler depois de len —
+// por quê? String longa (mensagem de test, tabela) é a maior parte do fonte
+// e o laço de um caractere por vez é o gargalo. Quem para fica pro laço
+// normal: escape, linha nova (conta linha) e o fim da janela (stream_fill)
+static int64_t string_run(const Tokenizer *t) {
+  const char *s = t->buffer;
+  int64_t i = t->pos, end = t->len;
+#ifdef LEXER_SSE2
+  const __m128i quote = _mm_set1_epi8('"'), slash = _mm_set1_epi8('\\'),
+                nl = _mm_set1_epi8('\n'), nul = _mm_setzero_si128();
+  for (; i + 16 <= end; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+    __m128i hit = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, slash)),
+        _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, nul)));
+    int mask = _mm_movemask_epi8(hit);
+    if (mask)
+      return i + __builtin_ctz((unsigned)mask);
+  }
+#else
+  const uint64_t ones = 0x0101010101010101, high = 0x8080808080808080;
+  for (; i + 8 <= end; i += 8) {
+    uint64_t v;
+    memcpy(&v, s + i, 8);
+    uint64_t q = v ^ (ones * '"'), b = v ^ (ones * '\\'),
+             n = v ^ (ones * '\n');
+    // byte zero em v, q, b ou n: algum dos quatro apareceu
+    uint64_t z = ((v - ones) & ~v) | ((q - ones) & ~q) | ((b - ones) & ~b) |
+                 ((n - ones) & ~n);
+    if (z & high)
+      break; // o laço de baixo acha qual
+  }
+#endif
+  for (; i < end; i++) {
+    char c = s[i];
+    if (c == '"' || c == '\\' || c == '\n' || c == '\0')
+      return i;
+  }
+  return end;
+}
+
+// O '-' de 1e-5 é do número; o de 0xE-1 não (hex não tem expoente)
+static int exponent_sign(const Tokenizer *t, char c) {
+  if ((c != '+' && c != '-') || t->tok_start < 0)
+    return 0;
+  char prev = t->buffer[t->pos - 1];
+  const char *first = t->buffer + t->tok_start;
+  int hex = first[0] == '0' && (first[1] == 'x' || first[1] == 'X');
+  return (prev == 'e' || prev == 'E') && !hex;
+}
+
+// Fecha o token que começou em tok_start
+static Token emit(Tokenizer *t, Kind kind, int line, int col) {
+  int64_t start = t->tok_start >= 0 ? t->tok_start : t->pos;
+  int len = (int)(t->pos - start);
+  const char *text = t->buffer + start;
+  if (t->fd >= 0 && len > 0)
+    text = stable_lexeme(t, text, len);
+
+  Token tok = token_make(kind, text, len, line, col);
+  tok.offset = t->base + start;
+  t->tok_start = -1;
+  return tok;
+}
+
+static void init_common(Tokenizer *t, const ModalAllocator *alloc) {
+  t->alloc = alloc ? alloc : modal_heap_allocator();
   t->pos = 0;
   t->line = 1;
   t->col = 1;
   t->state = START;
+  t->fd = -1;
+  t->window = NULL;
+  t->cap = t->len = t->base = 0;
+  t->tok_start = -1;
+  t->eof = 0;
+  t->lexemes = NULL;
+}
+
+void init(Tokenizer *t, const char *buffer, const ModalAllocator *alloc) {
+  init_common(t, alloc);
+  t->buffer = buffer;
+  t->len = (int64_t)strlen(buffer); // limite das leituras largas
+}
+
+int init_stream(Tokenizer *t, int fd, const ModalAllocator *alloc) {
+  init_common(t, alloc);
+  t->fd = fd;
+  t->cap = 2 * TOKENIZER_CHUNK;
+  t->window = modal_alloc(t->alloc, (size_t)t->cap + 1);
+  if (!t->window)
+    return 0;
+  t->window[0] = '\0';
+  t->buffer = t->window;
+  return 1;
+}
+
+void tokenizer_close(Tokenizer *t) {
+  if (t->window)
+    modal_free(t->alloc, t->window, (size_t)t->cap + 1);
+  t->window = NULL;
+}
+
+void tokenizer_free_lexemes(const ModalAllocator *a, LexemeBlock *blocks) {
+  while (blocks) {
+    LexemeBlock *next = blocks->next;
+    modal_free(a, blocks, sizeof(LexemeBlock) + blocks->cap);
+    blocks = next;
+  }
+}
+
+int tokenizer_line_at(const Tokenizer *t, const Token *tok,
+                      const char **line_start, int *line_len) {
+  int64_t off = tok->offset - t->base;
+  int64_t end_of_data = t->fd >= 0 ? t->len : INT64_MAX;
+  if (!tok->start || off < 0 || off > end_of_data)
+    return 0; // já saiu da janela
+
+  const char *pos = t->buffer + off;
+  const char *s = pos;
+  while (s > t->buffer && *(s - 1) != '\n')
+    s--; // volta até começo da linha (ou da janela)
+  const char *e = pos;
+  while (*e && *e != '\n')
+    e++; // até fim
+  *line_start = s;
+  *line_len = (int)(e - s);
+  return 1;
 }
 
 Token next(Tokenizer *t) {
-  const char *start = NULL;
   int start_line = 0;
   int start_col = 0;
 
+  // Marca o início do token atual — por quê? Offset (não ponteiro) sobrevive
+  // à compactação da janela no modo stream
+#define MARK_START()                                                           \
+  do {                                                                         \
+    t->tok_start = t->pos;                                                     \
+    start_line = t->line;                                                      \
+    start_col = t->col;                                                        \
+  } while (0)
+
   // printf("%s", t->buffer);
 
   for (;;) {
     char c = peek(t);
 
     if (!c) {
-      return token_make(TOK_EOF, t->buffer + t->pos, 0, t->line, t->col);
+      if (t->tok_start >= 0)
+        break; // token pela metade quando o fonte acabou
+      t->state = START;
+      return emit(t, TOK_EOF, t->line, t->col);
     }
     // Debugger to token validation purposes (experimental)
     // printf("token: '%c' (code %d)\npos=%d\n\n", c, (int)c, t->pos);
@@ -99,10 +321,8 @@ Token next(Tokenizer *t) {
     switch (t->state) {
     case START:
       if (c == '"') {
-        start = t->buffer + t->pos;
-        start_line = t->line;
-        start_col = t->col;
-        t->state = START;
+        MARK_START();
+        t->state = STRING_LIT;
 
         advance(t);
 
@@ -115,7 +335,16 @@ Token next(Tokenizer *t) {
       }
       // printf("START: c='%c' code=%d\n", c, (int)c);
 
+      if (c == 'f' && peek_next(t) == '"') {
+        MARK_START();
+        t->state = FSTRING;
+        advance(t);
+        advance(t);
+        continue;
+      }
+
       if (isalpha(c) || c == '_') {
+        MARK_START();
         t->state = STATE_IDENTIFIER;
         advance(t);
         continue;
@@ -127,10 +356,7 @@ Token next(Tokenizer *t) {
       }
 
       if (c == '#') {
-        const char *start = t->buffer + t->pos;
-        int start_line = t->line;
-        int start_col = t->col;
-        int len = 0;
+        MARK_START();
 
         // Consome até o fim da linha lógica (respeitando \ no final da linha)
         for (;;) {
@@ -141,22 +367,18 @@ Token next(Tokenizer *t) {
 
           if (curr == '\\' && peek_next(t) == '\n') {
             advance(t);
-            t->line++;
-            len += 2;
+            advance(t); // o \n conta linha no advance
             continue;
           }
 
           advance(t);
-          len++;
         }
 
         t->state = START; // volta pro estado normal
-        return token_make((Kind)PREPROC, start, len, start_line, start_col);
+        return emit(t, DIRECTIVE, start_line, start_col);
       }
 
-      start = t->buffer + t->pos;
-      start_line = t->line;
-      start_col = t->col;
+      MARK_START();
 
       if (isdigit(c)) {
         t->state = INT;
@@ -166,6 +388,7 @@ Token next(Tokenizer *t) {
 
       if (c == '-' && peek_next(t) == '-') {
         t->state = LINE_COMMENT;
+        t->tok_start = -1; // comentário não vira token, janela pode andar
         advance(t);
         advance(t);
         continue;
@@ -173,6 +396,7 @@ Token next(Tokenizer *t) {
 
       if (c == '-' && peek_next(t) == '{') {
         t->state = BLOCK_COMMENT;
+        t->tok_start = -1;
         advance(t);
         advance(t);
         continue;
@@ -181,135 +405,136 @@ Token next(Tokenizer *t) {
       advance(t);
       switch (c) {
       case '(':
-        printf("STATE: '('\ntoken: '%c'\n\n", c);
-        return token_make(LPAREN, start, 1, start_line, start_col);
+        return emit(t, LPAREN, start_line, start_col);
       case ')':
-        return token_make(RPAREN, start, 1, start_line, start_col);
+        return emit(t, RPAREN, start_line, start_col);
       case '{':
-        return token_make(LBRACE, start, 1, start_line, start_col);
+        return emit(t, LBRACE, start_line, start_col);
       case '}':
-        return token_make(RBRACE, start, 1, start_line, start_col);
+        return emit(t, RBRACE, start_line, start_col);
       case '?':
         if (peek(t) == '?') {
           advance(t);
           if (peek(t) == '=') {
             advance(t);
-            return token_make(QQ_EQ, start, 3, start_line, start_col);
+            return emit(t, QQ_EQ, start_line, start_col);
           }
-          return token_make(QQ, start, 2, start_line, start_col);
+          return emit(t, QQ, start_line, start_col);
         }
         if (peek(t) == '.') {
           advance(t);
-          return token_make(Q_DOT, start, 2, start_line, start_col);
+          return emit(t, Q_DOT, start_line, start_col);
         }
-        return token_make(QUESTION, start, 1, start_line, start_col);
+        return emit(t, QUESTION, start_line, start_col);
       case '.':
         if (peek(t) == '.' && peek_next(t) == '.') {
           advance(t);
           advance(t);
-          return token_make(ELLIPSIS, start, 3, start_line, start_col);
+          return emit(t, ELLIPSIS, start_line, start_col);
         }
         if (peek(t) == '.') {
           advance(t);
-          return token_make(DOTDOT, start, 2, start_line, start_col);
+          return emit(t, DOTDOT, start_line, start_col);
         }
         break;
       case '-':
         if (peek(t) == '>') {
           advance(t);
-          return token_make(ARROW, start, 2, start_line, start_col);
+          return emit(t, ARROW, start_line, start_col);
         }
         break;
       case ':':
         if (peek(t) == ':') {
           advance(t);
-          return token_make(DCOLON, start, 2, start_line, start_col);
+          return emit(t, DCOLON, start_line, start_col);
         }
         break;
       case '|':
-        return token_make(PIPE, start, 1, start_line, start_col);
+        return emit(t, PIPE, start_line, start_col);
+      case '=':
+      case '!':
+      case '<':
+      case '>':
+        // == != <= >= num token só — por quê? Sozinho, '=' é atribuição
+        if (peek(t) == '=')
+          advance(t);
+        break;
       }
 
-      return token_make(OPERATOR, start, 1, start_line, start_col);
+      return emit(t, OPERATOR, start_line, start_col);
 
     case STATE_IDENTIFIER:
       if (isalnum(c) || c == '_') {
         advance(t);
         continue;
       }
-      int len = (int)((t->buffer + t->pos) - start);
       t->state = START;
-      return token_make(get_keyword(start, len), start, len, start_line,
-                        start_col);
+      {
+        Token tok = emit(t, IDENTIFIER, start_line, start_col);
+        tok.kind = get_keyword(tok.start, tok.len);
+        return tok;
+      }
 
+    // Guloso como o pp-number de C: 0x1F, 1_000, 2.5e-3 e até 12abc viram
+    // um token só — por quê? ast/literal.c valida e aponta o dígito errado,
+    // em vez do parser ver NUMBER seguido de IDENTIFIER
     case INT:
-      if (isdigit(c)) {
+    case FLOAT:
+      if (isalnum(c) || c == '_' || exponent_sign(t, c)) {
         advance(t);
         continue;
       }
-      if (c == '.') {
+      if (t->state == INT && c == '.' && peek_next(t) != '.') { // 0..n é range
         t->state = FLOAT;
         advance(t);
         continue;
       }
-      {
-        int len = (int)((t->buffer + t->pos) - start);
-        t->state = START;
-        return token_make(NUMBER, start, len, start_line, start_col);
+      t->state = START;
+      return emit(t, NUMBER, start_line, start_col);
+
+    case STRING_LIT:
+      if (c != '"' && c != '\\' && c != '\n' && c != '\0') {
+        // c não para o string_run: anda pelo menos 1. Sem '\n' no trecho,
+        // só a coluna muda
+        int64_t stop = string_run(t);
+        t->col += (int)(stop - t->pos);
+        t->pos = stop;
+        continue;
       }
-
-    case FLOAT:
-      if (isdigit(c)) {
+      if (c == '\\') {
         advance(t);
+        if (peek(t) != '\0')
+          advance(t); // escape: pula o próximo, inclusive '"'
         continue;
       }
-      {
-        int len = (int)((t->buffer + t->pos) - start);
+      advance(t);
+      if (c == '"') {
         t->state = START;
-        return token_make(NUMBER, start, len, start_line, start_col);
-      }
-    case STRING_LIT: {
-      const char *buf = t->buffer;
-      int pos = t->pos;
-      printf("%c", pos);
-
-      while (buf[pos] != '\0' && buf[pos] != '"') {
-        if (buf[pos] == '\\') {
-          pos++;
-          t->col++;
-          if (buf[pos] != '\0') {
-            if (buf[pos] == 'n') {
-              pos++;
-              t->col++;
-            } else {
-              pos++;
-              t->col++;
-            }
-          }
-        } else {
-          if (buf[pos] == '\n') {
-            t->line++;
-            t->col = 1;
-          } else {
-            t->col++;
-          }
-          pos++;
-        }
+        return emit(t, STRING, start_line, start_col);
       }
+      continue;
 
-      // Update tokenizer position
-      t->pos = pos;
-
-      // Consume closing quote if present
-      if (buf[pos] == '"') {
-        t->pos++;
-        t->col++;
+    // Só acha o fim: os buracos viram tokens no parser, que sabe de onde
+    // eles vieram. '"' dentro de buraco fecha o token (e o parser acusa o
+    // '{' aberto) — por quê? Um '}' esquecido não engole o resto do arquivo
+    case FSTRING:
+    case FSTRING_HOLE:
+      advance(t);
+      if (c == '"') {
+        t->state = START;
+        return emit(t, FORMAT, start_line, start_col);
+      }
+      if (t->state == FSTRING_HOLE) {
+        if (c == '}')
+          t->state = FSTRING;
+      } else if (c == '\\' || (c == '{' && peek(t) == '{')) {
+        if (peek(t) != '\0')
+          advance(t); // escape ou {{: o segundo não conta
+      } else if (c == '{') {
+        t->state = FSTRING_HOLE;
       }
+      continue;
 
-      int len = (int)((buf + t->pos) - start);
-      t->state = START;
-      return token_make(STRING, start, len, start_line, start_col);
-    }
     case LINE_COMMENT:
       if (c == '\n' || c == '\0') {
         t->state = START;
@@ -330,7 +555,28 @@ Token next(Tokenizer *t) {
     default:
       advance(t);
       t->state = START;
-      return token_make(UNKNOWN, start, 1, start_line, start_col);
+      return emit(t, UNKNOWN, start_line, start_col);
     }
   }
+
+  // Fecha o token pendente no EOF (ex: `assert 1` sem \n no fim, string
+  // sem '"' final)
+  State pending = t->state;
+  t->state = START;
+  switch (pending) {
+  case STATE_IDENTIFIER: {
+    Token tok = emit(t, IDENTIFIER, start_line, start_col);
+    tok.kind = get_keyword(tok.start, tok.len);
+    return tok;
+  }
+  case INT:
+  case FLOAT:
+    return emit(t, NUMBER, start_line, start_col);
+  case FSTRING:
+  case FSTRING_HOLE:
+    return emit(t, FORMAT, start_line, start_col);
+  default:
+    return emit(t, STRING, start_line, start_col);
+  }
+#undef MARK_START
 }
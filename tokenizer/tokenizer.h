@@ -1,9 +1,15 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include "../builtin/allocators.h"
 #include <stddef.h>
+#include <stdint.h>
 #define MODAL_VERSION "0.0.1"
 
+// Leitura do modo stream: quanto pedir ao fd por vez (a janela residente é
+// 2x isso, e só cresce se um único token não couber)
+#define TOKENIZER_CHUNK (64 * 1024)
+
 typedef enum {
   TOK_EOF,
   LPAREN,
@@ -23,6 +29,7 @@ typedef enum {
   USE,
   COMPTIME,
   UNION,
+  STRUCT,
   ASM,
   VOLATILE,
   ASYNC,
@@ -39,6 +46,8 @@ typedef enum {
   DOTDOT,
   ARROW,
   STRING,
+  DIRECTIVE, // linha # inteira (com continuações \); ast/preproc.c executa
+  FORMAT,    // f"x = {x}" inteira; ast/parse_format.c separa os buracos
 } Kind;
 
 typedef enum {
@@ -48,7 +57,8 @@ typedef enum {
   CHAR,
   INT,
   FLOAT,
-  FSTRING,
+  FSTRING,      // texto de f"...": como STRING_LIT, mas '{' abre buraco
+  FSTRING_HOLE, // dentro de {...}: só '}' e '"' importam
   STRING_LIT,
   STATE_IDENTIFIER,
   BLOCK_COMMENT,
@@ -65,14 +75,27 @@ typedef struct {
   int len;
   int line;
   int col;
+  int64_t offset; // posição absoluta no fonte (64 bits: fonte > 2 GiB)
 } Token;
 
+typedef struct LexemeBlock LexemeBlock;
+
 typedef struct {
-  const char *buffer;
-  int pos;
+  const char *buffer; // fonte inteiro, ou a janela atual no modo stream
+  const ModalAllocator *alloc; // do contexto dono — nada global
+  int64_t pos;                 // dentro de buffer
   int line;
   int col;
   State state;
+
+  // Modo stream (fd >= 0): só [base, base + len) do fonte está residente
+  int fd;
+  char *window;
+  int64_t cap, len; // len vale nos dois modos: bytes válidos em buffer
+  int64_t base;      // offset absoluto de buffer[0]
+  int64_t tok_start; // início do token em andamento (-1 = nenhum)
+  int eof;
+  LexemeBlock *lexemes; // cópias dos lexemas; sobrevivem ao tokenizer
 } Tokenizer;
 
 typedef struct {
@@ -82,7 +105,19 @@ typedef struct {
 } Keyword;
 
 Token token_make(Kind kind, const char *start, int len, int line, int col);
-void init(Tokenizer *t, const char *buffer);
+void init(Tokenizer *t, const char *buffer, const ModalAllocator *alloc);
 Token next(Tokenizer *t);
 
+// Lê de fd em chunks de TOKENIZER_CHUNK conforme o parser pede tokens, com
+// memória constante pro fonte. Token.start aponta pra cópias em t->lexemes
+// (a janela anda); retorna 0 se faltou memória
+int init_stream(Tokenizer *t, int fd, const ModalAllocator *alloc);
+// Libera a janela; os lexemas ficam (a AST aponta pra eles)
+void tokenizer_close(Tokenizer *t);
+void tokenizer_free_lexemes(const ModalAllocator *a, LexemeBlock *blocks);
+
+// Linha do fonte onde tok está, se ainda residente; 0 se já saiu da janela
+int tokenizer_line_at(const Tokenizer *t, const Token *tok,
+                      const char **line_start, int *line_len);
+
 #endif